@@ -0,0 +1,257 @@
+/*
+ * CPU topology and placement of the keyhunt threads
+ *
+ * Refer to affinity.h for documentation on the public interfaces.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+#if defined(__linux__)
+#include <sched.h>
+#include <dirent.h>
+#endif
+
+#include "affinity.h"
+
+int affinity_parse_list(const char *str, std::vector<int> &list)
+{
+  const char *p = str;
+  char *end;
+  long first, last;
+  list.clear();
+  while (*p != '\0' && *p != '\n') {
+    first = strtol(p, &end, 10);
+    if (end == p || first < 0) {
+      return 1;
+    }
+    last = first;
+    p = end;
+    if (*p == '-') {
+      p++;
+      last = strtol(p, &end, 10);
+      if (end == p || last < first) {
+        return 1;
+      }
+      p = end;
+    }
+    for (long i = first; i <= last; i++) {
+      list.push_back((int)i);
+    }
+    if (*p == ',') {
+      p++;
+    }
+    else if (*p != '\0' && *p != '\n') {
+      return 1;
+    }
+  }
+  return list.empty();
+}
+
+#if defined(__linux__)
+
+/* First integer of a sysfs file, -1 if it doesn't exist */
+static int affinity_readint(const char *path)
+{
+  FILE *file = fopen(path, "r");
+  int value = -1;
+  if (file != NULL) {
+    if (fscanf(file, "%i", &value) != 1) {
+      value = -1;
+    }
+    fclose(file);
+  }
+  return value;
+}
+
+static int affinity_readlist(const char *path, std::vector<int> &list)
+{
+  char line[4096];
+  FILE *file = fopen(path, "r");
+  if (file == NULL) {
+    return 1;
+  }
+  if (fgets(line, sizeof(line), file) == NULL) {
+    fclose(file);
+    return 1;
+  }
+  fclose(file);
+  return affinity_parse_list(line, list);
+}
+
+int affinity_read(struct affinity_topology *topology)
+{
+  struct affinity_cpu entry;
+  std::vector<int> list;
+  char path[256];
+  cpu_set_t allowed;
+  struct dirent *item;
+  DIR *dir;
+  int node;
+
+  topology->cpus.clear();
+  topology->nodes = 1;
+  if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+    return 1;
+  }
+  for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+    if (!CPU_ISSET(cpu, &allowed)) {
+      continue;
+    }
+    entry.cpu = cpu;
+    entry.node = 0;
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%i/topology/physical_package_id", cpu);
+    entry.package = std::max(affinity_readint(path), 0);
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%i/topology/core_id", cpu);
+    entry.core = affinity_readint(path);
+    if (entry.core < 0) {
+      entry.core = cpu;
+    }
+    entry.smt = 0;
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%i/topology/thread_siblings_list", cpu);
+    if (affinity_readlist(path, list) == 0) {
+      entry.smt = std::find(list.begin(), list.end(), cpu) - list.begin();
+    }
+    topology->cpus.push_back(entry);
+  }
+  dir = opendir("/sys/devices/system/node");
+  if (dir != NULL) {
+    while ((item = readdir(dir)) != NULL) {
+      if (sscanf(item->d_name, "node%i", &node) != 1) {
+        continue;
+      }
+      snprintf(path, sizeof(path), "/sys/devices/system/node/node%i/cpulist", node);
+      if (affinity_readlist(path, list) != 0) {
+        continue;
+      }
+      for (size_t i = 0; i < list.size(); i++) {
+        struct affinity_cpu *cpu = affinity_find(topology, list[i]);
+        if (cpu != NULL) {
+          cpu->node = node;
+          topology->nodes = std::max(topology->nodes, node + 1);
+        }
+      }
+    }
+    closedir(dir);
+  }
+  return topology->cpus.empty();
+}
+
+int affinity_pin(int cpu)
+{
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  return sched_setaffinity(0, sizeof(set), &set) != 0;
+}
+
+int affinity_unpin(struct affinity_topology *topology)
+{
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (size_t i = 0; i < topology->cpus.size(); i++) {
+    CPU_SET(topology->cpus[i].cpu, &set);
+  }
+  return sched_setaffinity(0, sizeof(set), &set) != 0;
+}
+
+#else
+
+int affinity_read(struct affinity_topology *topology)
+{
+  topology->cpus.clear();
+  topology->nodes = 1;
+  return 1;
+}
+
+int affinity_pin(int cpu)
+{
+  (void)cpu;
+  return 1;
+}
+
+int affinity_unpin(struct affinity_topology *topology)
+{
+  (void)topology;
+  return 1;
+}
+
+#endif
+
+struct affinity_cpu *affinity_find(struct affinity_topology *topology, int cpu)
+{
+  for (size_t i = 0; i < topology->cpus.size(); i++) {
+    if (topology->cpus[i].cpu == cpu) {
+      return &topology->cpus[i];
+    }
+  }
+  return NULL;
+}
+
+static bool affinity_compact(const struct affinity_cpu &a, const struct affinity_cpu &b)
+{
+  if (a.node != b.node) return a.node < b.node;
+  if (a.package != b.package) return a.package < b.package;
+  if (a.core != b.core) return a.core < b.core;
+  return a.smt < b.smt;
+}
+
+static bool affinity_cores(const struct affinity_cpu &a, const struct affinity_cpu &b)
+{
+  if (a.smt != b.smt) return a.smt < b.smt;
+  return affinity_compact(a, b);
+}
+
+int affinity_map(struct affinity_topology *topology, const char *policy, int threads, std::vector<int> &map)
+{
+  std::vector<struct affinity_cpu> order = topology->cpus;
+  std::vector<std::vector<struct affinity_cpu> > nodes;
+  std::vector<int> list;
+  size_t i, j;
+
+  map.clear();
+  if (order.empty()) {
+    return 1;
+  }
+  if (strcmp(policy, "compact") == 0) {
+    std::sort(order.begin(), order.end(), affinity_compact);
+  }
+  else if (strcmp(policy, "cores") == 0) {
+    std::sort(order.begin(), order.end(), affinity_cores);
+  }
+  else if (strcmp(policy, "scatter") == 0) {
+    /* Physical cores first, one of each node in turn */
+    std::sort(order.begin(), order.end(), affinity_cores);
+    nodes.resize(topology->nodes);
+    for (i = 0; i < order.size(); i++) {
+      nodes[order[i].node].push_back(order[i]);
+    }
+    order.clear();
+    for (j = 0; order.size() < topology->cpus.size(); j++) {
+      for (i = 0; i < nodes.size(); i++) {
+        if (j < nodes[i].size()) {
+          order.push_back(nodes[i][j]);
+        }
+      }
+    }
+  }
+  else {
+    if (affinity_parse_list(policy, list) != 0) {
+      return 1;
+    }
+    order.clear();
+    for (i = 0; i < list.size(); i++) {
+      struct affinity_cpu *cpu = affinity_find(topology, list[i]);
+      if (cpu == NULL) {
+        return 1;
+      }
+      order.push_back(*cpu);
+    }
+  }
+  for (int t = 0; t < threads; t++) {
+    map.push_back(order[t % order.size()].cpu);
+  }
+  return 0;
+}
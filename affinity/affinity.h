@@ -0,0 +1,55 @@
+/*
+ * CPU topology and placement of the keyhunt threads
+ *
+ * The topology is read from sysfs (no libnuma), only the CPUs allowed to the
+ * process are used. The policies are:
+ *
+ *     compact    Fill the cores of a node one after another, siblings of SMT together
+ *     scatter    Round robin over the NUMA nodes and the physical cores
+ *     cores      One thread per physical core, the SMT siblings only after all the cores
+ *     0,2,4-7    Explicit list of CPUs, thread i goes to the CPU i of the list
+ */
+
+#ifndef _AFFINITY_H
+#define _AFFINITY_H
+
+#include <vector>
+
+struct affinity_cpu
+{
+  int cpu;
+  int node;
+  int package;
+  int core;             // core_id inside the package
+  int smt;              // Index of the CPU in its thread siblings
+};
+
+struct affinity_topology
+{
+  std::vector<struct affinity_cpu> cpus;
+  int nodes;
+};
+
+/* Parse a list like "0-3,8,10-11", return 0 on success */
+int affinity_parse_list(const char *str, std::vector<int> &list);
+
+/* Read the topology of the CPUs allowed to this process, return 0 on success */
+int affinity_read(struct affinity_topology *topology);
+
+/*
+ * CPU of each of 'threads' threads with the policy or the explicit list.
+ * Return 0 on success, 1 if the policy is invalid or has a CPU that is not
+ * in the topology.
+ */
+int affinity_map(struct affinity_topology *topology, const char *policy, int threads, std::vector<int> &map);
+
+/* Topology entry of the CPU, NULL if it is not allowed */
+struct affinity_cpu *affinity_find(struct affinity_topology *topology, int cpu);
+
+/* Pin the calling thread to the CPU, return 0 on success */
+int affinity_pin(int cpu);
+
+/* Allow the calling thread to run in all the CPUs of the topology again */
+int affinity_unpin(struct affinity_topology *topology);
+
+#endif
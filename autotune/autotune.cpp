@@ -0,0 +1,288 @@
+/*
+ * Probe of the host and plan of the keyhunt parameters for --autotune
+ *
+ * Refer to autotune.h for documentation on the public interfaces.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+#include <vector>
+
+#if defined(_WIN64) && !defined(__CYGWIN__)
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "autotune.h"
+#include "../bloom/bloom.h"
+
+#if defined(__linux__)
+
+/* Value in kB of a line of /proc/meminfo, 0 if it isn't there */
+static uint64_t autotune_meminfo(const char *name)
+{
+  char line[256];
+  unsigned long long value = 0;
+  size_t length = strlen(name);
+  FILE *file = fopen("/proc/meminfo", "r");
+  if (file == NULL) {
+    return 0;
+  }
+  while (fgets(line, sizeof(line), file) != NULL) {
+    if (strncmp(line, name, length) == 0 && line[length] == ':') {
+      if (sscanf(line + length + 1, "%llu", &value) != 1) {
+        value = 0;
+      }
+      break;
+    }
+  }
+  fclose(file);
+  return (uint64_t)value * 1024;
+}
+
+static void autotune_caches(struct autotune_host *host)
+{
+  char path[256], text[64];
+  unsigned long long size;
+  int level;
+  FILE *file;
+  for (int i = 0; i < 16; i++) {
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%i/type", i);
+    file = fopen(path, "r");
+    if (file == NULL) {
+      break;
+    }
+    if (fgets(text, sizeof(text), file) == NULL) {
+      text[0] = '\0';
+    }
+    fclose(file);
+    if (strncmp(text, "Instruction", 11) == 0) {
+      continue;
+    }
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%i/level", i);
+    file = fopen(path, "r");
+    if (file == NULL) {
+      continue;
+    }
+    if (fscanf(file, "%i", &level) != 1) {
+      level = 0;
+    }
+    fclose(file);
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%i/size", i);
+    file = fopen(path, "r");
+    if (file == NULL) {
+      continue;
+    }
+    /* The size is like 32K or 16M */
+    if (fscanf(file, "%llu%63s", &size, text) < 1) {
+      size = 0;
+      text[0] = '\0';
+    }
+    fclose(file);
+    if (text[0] == 'K') {
+      size *= 1024;
+    }
+    else if (text[0] == 'M') {
+      size *= 1048576;
+    }
+    if (level == 2) {
+      host->l2 = size;
+    }
+    else if (level == 3) {
+      host->l3 = size;
+    }
+  }
+}
+
+#endif
+
+int autotune_probe(struct autotune_host *host)
+{
+  memset(host, 0, sizeof(struct autotune_host));
+#if defined(_WIN64) && !defined(__CYGWIN__)
+  MEMORYSTATUSEX status;
+  SYSTEM_INFO sysinfo;
+  status.dwLength = sizeof(status);
+  if (GlobalMemoryStatusEx(&status)) {
+    host->memory = status.ullAvailPhys;
+  }
+  GetSystemInfo(&sysinfo);
+  host->page = sysinfo.dwPageSize;
+  host->cpus = sysinfo.dwNumberOfProcessors;
+#else
+  host->page = sysconf(_SC_PAGESIZE);
+  host->cpus = sysconf(_SC_NPROCESSORS_ONLN);
+#if defined(__linux__)
+  host->memory = autotune_meminfo("MemAvailable");
+  if (host->memory == 0) {
+    host->memory = autotune_meminfo("MemFree");   // Kernels older than 3.14
+  }
+  host->huge_page = autotune_meminfo("Hugepagesize");
+  autotune_caches(host);
+#else
+  host->memory = (uint64_t)sysconf(_SC_AVPHYS_PAGES) * host->page;
+#endif
+#endif
+  if (host->cpus < 1) {
+    host->cpus = 1;
+  }
+  return host->memory == 0;
+}
+
+void autotune_hostname(char *name, int length)
+{
+#if defined(_WIN64) && !defined(__CYGWIN__)
+  DWORD size = length;
+  if (!GetComputerNameA(name, &size)) {
+    snprintf(name, length, "localhost");
+  }
+#else
+  if (gethostname(name, length) != 0) {
+    snprintf(name, length, "localhost");
+  }
+#endif
+  name[length - 1] = '\0';
+  for (char *c = name; *c != '\0'; c++) {
+    if (*c == ' ' || *c == '\t') {
+      *c = '_';   // The profile file is split by spaces
+    }
+  }
+}
+
+/* Bytes of the 256 parts of a bloom filter like bloom_init3 */
+static uint64_t autotune_bloom_bytes(uint64_t items)
+{
+  long double bpe = -log(AUTOTUNE_BLOOM_ERROR) / 0.480453013918201;  // ln(2)^2
+  uint64_t bits = (uint64_t)((long double)items * bpe);
+  return 256 * (bits / 8 + ((bits % 8) ? 1 : 0));
+}
+
+/* Elements of each of the 256 parts, with the minimum of keyhunt */
+static uint64_t autotune_bloom_items(uint64_t m, uint64_t minimum)
+{
+  if (m / 256 > minimum) {
+    return m / 256 + ((m % 256) ? 1 : 0);
+  }
+  return 1000;
+}
+
+uint64_t autotune_cache(struct autotune_host *host)
+{
+  if (host->l2 == 0 && host->l3 == 0) {
+    return AUTOTUNE_PREFILTER_CACHE;
+  }
+  return host->l2 + host->l3 / host->cpus;
+}
+
+int autotune_prefilter(uint64_t items, uint64_t cache)
+{
+  int mb = 1;
+  while (mb < AUTOTUNE_PREFILTER_MAX_MB && (uint64_t)mb * 1048576 * 8 / AUTOTUNE_PREFILTER_BITS < items &&
+         (uint64_t)mb * 2 * 1048576 <= cache) {
+    mb *= 2;
+  }
+  return mb;
+}
+
+void autotune_bsgs_plan(uint64_t sqrt_n, int k, size_t entry, int prefilter, uint64_t cache, struct autotune_bsgs *plan)
+{
+  plan->m = sqrt_n * (uint64_t)k;
+  plan->m2 = plan->m / 32 + ((plan->m % 32) ? 1 : 0);
+  plan->m3 = plan->m2 / 32 + ((plan->m2 % 32) ? 1 : 0);
+  plan->bloom[0] = autotune_bloom_bytes(autotune_bloom_items(plan->m, 10000));
+  plan->bloom[1] = autotune_bloom_bytes(autotune_bloom_items(plan->m2, 1000));
+  plan->bloom[2] = autotune_bloom_bytes(autotune_bloom_items(plan->m3, 1000));
+  plan->table = plan->m3 * entry;
+  /*
+   * Like initPrefilter, the automatic size is only made for a bloom filter
+   * bigger than the cache, and none with less than BLOOM_PREFILTER_MIN_BITS
+   * for each element
+   */
+  plan->prefilter = (uint64_t)(prefilter < 0 ? autotune_prefilter(plan->m, cache) : prefilter) * 1048576;
+  if ((prefilter < 0 && plan->bloom[0] < plan->prefilter * 16) || plan->prefilter * 8 < plan->m * BLOOM_PREFILTER_MIN_BITS) {
+    plan->prefilter = 0;
+  }
+  plan->total = plan->bloom[0] + plan->bloom[1] + plan->bloom[2] + plan->table + plan->prefilter;
+}
+
+int autotune_bsgs_fit(uint64_t sqrt_n, size_t entry, int prefilter, uint64_t cache, uint64_t bytes, uint64_t max_m3, int max_k)
+{
+  struct autotune_bsgs plan;
+  int low = 0, high = max_k, middle;
+  /* The memory grows with k, the biggest k that fits is between low and high */
+  while (low < high) {
+    middle = low + (high - low + 1) / 2;
+    autotune_bsgs_plan(sqrt_n, middle, entry, prefilter, cache, &plan);
+    if (plan.total <= bytes && plan.m3 <= max_m3) {
+      low = middle;
+    }
+    else {
+      high = middle - 1;
+    }
+  }
+  return low;
+}
+
+int autotune_load(const char *file, const char *host, const char *mode, struct autotune_profile *profile)
+{
+  char line[1024], line_host[256], line_mode[64];
+  struct autotune_profile entry;
+  int found = 0;
+  FILE *fd = fopen(file, "r");
+  if (fd == NULL) {
+    return 1;
+  }
+  while (fgets(line, sizeof(line), fd) != NULL) {
+    if (line[0] == '#') {
+      continue;
+    }
+    if (sscanf(line, "%255s %63s %i %i %i %lf", line_host, line_mode, &entry.threads, &entry.k, &entry.prefilter, &entry.rate) == 6 &&
+        strcmp(line_host, host) == 0 && strcmp(line_mode, mode) == 0 && entry.threads > 0 && entry.k > 0 && entry.prefilter >= 0) {
+      *profile = entry;   // The last line of the host and mode is the good one
+      found = 1;
+    }
+  }
+  fclose(fd);
+  return !found;
+}
+
+int autotune_save(const char *file, const char *host, const char *mode, struct autotune_profile *profile)
+{
+  std::vector<std::string> lines;
+  std::string temporal = std::string(file) + ".tmp";
+  char line[1024], line_host[256], line_mode[64];
+  FILE *fd = fopen(file, "r");
+  if (fd != NULL) {
+    while (fgets(line, sizeof(line), fd) != NULL) {
+      if (line[0] != '#' && sscanf(line, "%255s %63s", line_host, line_mode) == 2 &&
+          strcmp(line_host, host) == 0 && strcmp(line_mode, mode) == 0) {
+        continue;
+      }
+      if (line[0] != '#') {
+        lines.push_back(line);
+      }
+    }
+    fclose(fd);
+  }
+  fd = fopen(temporal.c_str(), "w");
+  if (fd == NULL) {
+    return 1;
+  }
+  fprintf(fd, "# host mode threads k prefilter_mb bench_keys/s\n");
+  for (size_t i = 0; i < lines.size(); i++) {
+    fputs(lines[i].c_str(), fd);
+  }
+  fprintf(fd, "%s %s %i %i %i %.6g\n", host, mode, profile->threads, profile->k, profile->prefilter, profile->rate);
+  if (fclose(fd) != 0) {
+    remove(temporal.c_str());
+    return 1;
+  }
+#if defined(_WIN64) && !defined(__CYGWIN__)
+  remove(file);
+#endif
+  return rename(temporal.c_str(), file) != 0;
+}
@@ -0,0 +1,99 @@
+/*
+ * Probe of the host and plan of the keyhunt parameters for --autotune
+ *
+ * The host probe reads the available memory, the page sizes and the cache
+ * sizes. The BSGS plan is the same arithmetic of keyhunt for the three bloom
+ * filters (bsgs_m, bsgs_m2, bsgs_m3) and the bP table, so the biggest -k that
+ * fits in the memory is found without allocating anything.
+ *
+ * The profile file keeps one line for each host and mode:
+ *
+ *     # host mode threads k prefilter_mb bench_keys/s
+ *     node01 bsgs 16 512 16 3.1e+15
+ *     node01 address 32 1 16 9.8e+07
+ *
+ * The keys/s are of the --bench children that choose the threads, bsgs is
+ * measured with the bloom filter of --bench bsgs and not with the -k of the
+ * profile.
+ */
+
+#ifndef _AUTOTUNE_H
+#define _AUTOTUNE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define AUTOTUNE_BLOOM_ERROR 0.000001   // Error of the three bsgs bloom filters
+#define AUTOTUNE_PREFILTER_BITS 8       // Bits of the prefilter for each element
+#define AUTOTUNE_PREFILTER_MAX_MB 16
+#define AUTOTUNE_PREFILTER_CACHE 4194304  // Cache of each core when it is unknown
+
+struct autotune_host
+{
+  uint64_t memory;      // Available memory in bytes
+  uint64_t page;        // Page size
+  uint64_t huge_page;   // Size of the huge pages, 0 if there are none
+  uint64_t l2;          // Cache sizes in bytes, 0 if unknown
+  uint64_t l3;
+  int cpus;
+};
+
+struct autotune_profile
+{
+  int threads;
+  int k;
+  int prefilter;        // Size of the prefilter in MB
+  double rate;          // keys/s of the --bench child with the threads
+};
+
+struct autotune_bsgs
+{
+  uint64_t m;           // Elements of the first, second and third bloom filter
+  uint64_t m2;
+  uint64_t m3;          // Elements of the bP table
+  uint64_t bloom[3];    // Bytes of each bloom filter (all its 256 parts)
+  uint64_t table;       // Bytes of the bP table
+  uint64_t prefilter;   // Bytes of the prefilter, 0 if it isn't made
+  uint64_t total;
+};
+
+/* Probe the host, return 0 on success */
+int autotune_probe(struct autotune_host *host);
+
+/* Name of the host for the profile file */
+void autotune_hostname(char *name, int length);
+
+/* Cache of one core for the prefilter, its L2 and its part of the L3 */
+uint64_t autotune_cache(struct autotune_host *host);
+
+/*
+ * Size in MB of the prefilter for 'items' elements, the power of two with
+ * AUTOTUNE_PREFILTER_BITS for each one, between 1 and AUTOTUNE_PREFILTER_MAX_MB
+ * and not bigger than 'cache'
+ */
+int autotune_prefilter(uint64_t items, uint64_t cache);
+
+/*
+ * Sizes of bsgs with the square root of N and the k factor, 'entry' is the
+ * size of one element of the bP table, 0 if the table is not in memory.
+ * 'prefilter' is the MB of --prefilter, -1 to size it for bsgs_m with the
+ * 'cache' of autotune_cache like keyhunt does
+ */
+void autotune_bsgs_plan(uint64_t sqrt_n, int k, size_t entry, int prefilter, uint64_t cache, struct autotune_bsgs *plan);
+
+/* Biggest k (up to max_k) whose plan fits in 'bytes', 0 if not even k = 1 fits */
+int autotune_bsgs_fit(uint64_t sqrt_n, size_t entry, int prefilter, uint64_t cache, uint64_t bytes, uint64_t max_m3, int max_k);
+
+/** ***************************************************************************
+ * Read the profile of the host and mode from the file.
+ *
+ * Return:
+ *     0 - on success
+ *     1 - the file can't be read or there is no line for the host and mode
+ */
+int autotune_load(const char *file, const char *host, const char *mode, struct autotune_profile *profile);
+
+/* Replace the line of the host and mode in the file, return 0 on success */
+int autotune_save(const char *file, const char *host, const char *mode, struct autotune_profile *profile);
+
+#endif
@@ -0,0 +1,364 @@
+/*
+ * Microbenchmarks of the kernels used by keyhunt
+ *
+ * Every kernel is called in a loop until it runs for BENCH_MIN_SECONDS, the
+ * results are printed in JSON with the ns per operation and the operations
+ * per second, together with the instruction sets of the build and of the CPU
+ * so the results of different builds and hosts can be compared:
+ *
+ *     make -s bench > bench.json
+ *     make -s bench ARCH_FLAGS="-march=znver4 -mavx512f" > bench-zen5.json
+ *
+ * The functions of keyhunt.cpp (searchbinary, bsgs_searchbinary and
+ * KECCAK_256) are linked from keyhunt.cpp built with main renamed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <chrono>
+#include <vector>
+
+#include "../secp256k1/SECP256k1.h"
+#include "../secp256k1/Point.h"
+#include "../secp256k1/Int.h"
+#include "../secp256k1/IntGroup.h"
+#include "../bloom/bloom.h"
+#include "../hash/sha256.h"
+#include "../hash/ripemd160.h"
+#include "../hash/hash160.h"
+#include "../include/simd_features.h"
+
+#define BENCH_MIN_SECONDS 0.25
+#define BENCH_GROUP_SIZE 1024
+#define BENCH_TABLE_ITEMS ((int64_t)1 << 22)
+
+/* Same layout of the tables of keyhunt.cpp */
+struct address_value
+{
+  uint8_t value[20];
+};
+
+#pragma pack(push,1)
+struct bsgs_xvalue
+{
+  uint8_t value[6];
+  uint8_t index[5];
+};
+#pragma pack(pop)
+
+int searchbinary(struct address_value *buffer, char *data, int64_t array_length);
+int bsgs_searchbinary(struct bsgs_xvalue *arr, char *data, int64_t array_length, uint64_t *r_value);
+void KECCAK_256(uint8_t *source, size_t size, uint8_t *dst);
+
+struct bench_result
+{
+  const char *name;
+  const char *backend;
+  double ns;              // Per operation
+};
+
+static std::vector<struct bench_result> results;
+static volatile uint64_t sink;
+static uint64_t state = 0x9e3779b97f4a7c15ULL;
+
+static uint64_t bench_random()
+{
+  uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+static void bench_fill(uint8_t *data, size_t length)
+{
+  uint64_t r;
+  size_t i;
+  for (i = 0; i < length; i += 8) {
+    r = bench_random();
+    memcpy(data + i, &r, length - i < 8 ? length - i : 8);
+  }
+}
+
+/* Call f until it runs for BENCH_MIN_SECONDS, each call is 'ops' operations */
+template <typename F>
+static void bench_run(const char *name, const char *backend, int ops, F f)
+{
+  struct bench_result result;
+  uint64_t calls, i;
+  double seconds;
+
+  f();
+  calls = 1;
+  for (;;) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (i = 0; i < calls; i++) {
+      f();
+    }
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (seconds >= BENCH_MIN_SECONDS) {
+      break;
+    }
+    calls *= 2;
+  }
+  result.name = name;
+  result.backend = backend;
+  result.ns = seconds * 1e9 / ((double)calls * ops);
+  results.push_back(result);
+  fprintf(stderr, "[+] %-32s %-8s %10.2f ns/op\n", name, backend, result.ns);
+}
+
+static void bench_field(Secp256K1 *secp)
+{
+  Int a, b, group[BENCH_GROUP_SIZE];
+  IntGroup grp(BENCH_GROUP_SIZE);
+  Point p, q;
+  int i;
+
+  a.Rand(256);
+  b.Rand(256);
+  a.Mod(&secp->order);
+  b.Mod(&secp->order);
+  bench_run("Int::ModMulK1", "scalar", 1, [&]() { a.ModMulK1(&b); });
+  bench_run("Int::ModSquareK1", "scalar", 1, [&]() { a.ModSquareK1(&a); });
+  bench_run("Int::ModInv", "scalar", 1, [&]() { a.ModInv(); });
+  for (i = 0; i < BENCH_GROUP_SIZE; i++) {
+    group[i].Rand(256);
+    group[i].Mod(&secp->order);
+  }
+  grp.Set(group);
+  /* Per element, the batch is one inversion and 3 multiplications per element */
+  bench_run("IntGroup::ModInv/1024", "scalar", BENCH_GROUP_SIZE, [&]() { grp.ModInv(); });
+
+  bench_run("Secp256K1::ComputePublicKey", "scalar", 1, [&]() {
+    p = secp->ComputePublicKey(&a);
+    a.AddOne();
+  });
+  q = secp->ComputePublicKey(&b);
+  bench_run("Secp256K1::AddDirect", "scalar", 1, [&]() { p = secp->AddDirect(p, q); });
+  sink = p.x.bits64[0];
+}
+
+static void bench_hash(Secp256K1 *secp)
+{
+  uint32_t blocks[8][32];
+  uint8_t input[8][64], digest[8][32], h[8][20], *hp[8];
+  uint64_t *xp[8];
+  uint8_t prefix[8] = {2, 2, 2, 2, 3, 3, 3, 3};
+  Point k[8];
+  Int key;
+  int i, backend;
+
+  for (i = 0; i < 8; i++) {
+    bench_fill((uint8_t *)blocks[i], sizeof(blocks[i]));
+    blocks[i][8] = (blocks[i][8] & 0xff000000u) | 0x00800000u;
+    memset(&blocks[i][9], 0, 6 * sizeof(uint32_t));
+    blocks[i][15] = 0x108;
+    bench_fill(input[i], 32);
+    key.Rand(256);
+    key.Mod(&secp->order);
+    k[i] = secp->ComputePublicKey(&key);
+    xp[i] = k[i].x.bits64;
+    hp[i] = h[i];
+  }
+
+  bench_run("sha256_1B", "sse", 4, [&]() {
+    sha256sse_1B(blocks[0], blocks[1], blocks[2], blocks[3], digest[0], digest[1], digest[2], digest[3]);
+  });
+  bench_run("sha256_2B", "sse", 4, [&]() {
+    sha256sse_2B(blocks[0], blocks[1], blocks[2], blocks[3], digest[0], digest[1], digest[2], digest[3]);
+  });
+  if (simd_has_sha_ni()) {
+    bench_run("sha256_1B", "sha-ni", 4, [&]() {
+      sha256shani_1B(blocks[0], blocks[1], blocks[2], blocks[3], digest[0], digest[1], digest[2], digest[3]);
+    });
+    bench_run("sha256_2B", "sha-ni", 4, [&]() {
+      sha256shani_2B(blocks[0], blocks[1], blocks[2], blocks[3], digest[0], digest[1], digest[2], digest[3]);
+    });
+  }
+  if (simd_has_avx2()) {
+    bench_run("sha256_8_1B", "avx2", 8, [&]() {
+      sha256avx2_1B(blocks[0], blocks[1], blocks[2], blocks[3], blocks[4], blocks[5], blocks[6], blocks[7],
+        digest[0], digest[1], digest[2], digest[3], digest[4], digest[5], digest[6], digest[7]);
+    });
+  }
+  bench_run("ripemd160_32", "sse", 4, [&]() {
+    ripemd160sse_32(input[0], input[1], input[2], input[3], h[0], h[1], h[2], h[3]);
+  });
+  if (simd_has_avx2()) {
+    bench_run("ripemd160_8_32", "avx2", 8, [&]() {
+      ripemd160avx2_32(input[0], input[1], input[2], input[3], input[4], input[5], input[6], input[7],
+        h[0], h[1], h[2], h[3], h[4], h[5], h[6], h[7]);
+    });
+  }
+
+  /* The GetHash160 functions use the backends selected at startup like keyhunt */
+  sha256_select(false);
+  sha256_select8(false);
+  ripemd160_select(false);
+  backend = hash160_select(false);
+  bench_run("hash160_8_33", backend == HASH160_BACKEND_AVX2 ? "avx2" : "separate", 8, [&]() {
+    hash160_8_33(xp, prefix, hp);
+  });
+  if (simd_has_avx2() && backend != HASH160_BACKEND_AVX2) {
+    bench_run("hash160_8_33", "avx2", 8, [&]() { hash160avx2_33(xp, prefix, hp); });
+  }
+  bench_run("Secp256K1::GetHash160/compressed", "selected", 4, [&]() {
+    secp->GetHash160(P2PKH, true, k[0], k[1], k[2], k[3], h[0], h[1], h[2], h[3]);
+  });
+  bench_run("Secp256K1::GetHash160/uncompressed", "selected", 4, [&]() {
+    secp->GetHash160(P2PKH, false, k[0], k[1], k[2], k[3], h[0], h[1], h[2], h[3]);
+  });
+  bench_run("Secp256K1::GetHash160/8", "selected", 8, [&]() {
+    secp->GetHash160(P2PKH, true, k[0], k[1], k[2], k[3], k[4], k[5], k[6], k[7],
+      h[0], h[1], h[2], h[3], h[4], h[5], h[6], h[7]);
+  });
+  bench_run("Secp256K1::GetHash160_fromX/8", "selected", 8, [&]() {
+    secp->GetHash160_fromX(P2PKH, &k[0].x, &k[1].x, &k[2].x, &k[3].x,
+      h[0], h[1], h[2], h[3], h[4], h[5], h[6], h[7]);
+  });
+  bench_run("KECCAK_256/64", "scalar", 1, [&]() { KECCAK_256(input[0], 64, digest[0]); });
+  sink = h[0][0] + digest[0][0];
+}
+
+/* Lookups of random values, almost all of them are negatives like in the search */
+static void bench_bloom()
+{
+  static const char *names[3][2] = {
+    {"bloom_check/64K/hashed", "bloom_check/64K/keyed"},
+    {"bloom_check/1M/hashed", "bloom_check/1M/keyed"},
+    {"bloom_check/16M/hashed", "bloom_check/16M/keyed"}
+  };
+  uint64_t entries[3] = {(uint64_t)1 << 16, (uint64_t)1 << 20, (uint64_t)1 << 24};
+  struct bloom bloom;
+  uint8_t buffer[32];
+  uint64_t i, hits;
+  int s, mode;
+
+  for (s = 0; s < 3; s++) {
+    for (mode = BLOOM_HASHED; mode <= BLOOM_KEYED; mode++) {
+      if (bloom_init3(&bloom, entries[s], 0.000001, mode) != 0) {
+        fprintf(stderr, "[E] error bloom_init3 for %" PRIu64 " elements\n", entries[s]);
+        exit(EXIT_FAILURE);
+      }
+      for (i = 0; i < entries[s]; i++) {
+        bench_fill(buffer, 32);
+        bloom_add(&bloom, buffer, 32);
+      }
+      hits = 0;
+      bench_run(names[s][mode], "scalar", 1, [&]() {
+        bench_fill(buffer, 32);
+        hits += bloom_check(&bloom, buffer, 32);
+      });
+      sink = hits;
+      bloom_free(&bloom);
+    }
+  }
+}
+
+static int bench_compare_address(const void *a, const void *b)
+{
+  return memcmp(a, b, 20);
+}
+
+static int bench_compare_xvalue(const void *a, const void *b)
+{
+  return memcmp(a, b, 6);
+}
+
+static void bench_search()
+{
+  struct address_value *addresses;
+  struct bsgs_xvalue *xvalues;
+  uint8_t data[32];
+  uint64_t index, found;
+  int64_t i;
+
+  addresses = (struct address_value *)malloc(BENCH_TABLE_ITEMS * sizeof(struct address_value));
+  xvalues = (struct bsgs_xvalue *)malloc(BENCH_TABLE_ITEMS * sizeof(struct bsgs_xvalue));
+  if (addresses == NULL || xvalues == NULL) {
+    fprintf(stderr, "[E] error malloc for the tables\n");
+    exit(EXIT_FAILURE);
+  }
+  for (i = 0; i < BENCH_TABLE_ITEMS; i++) {
+    bench_fill(addresses[i].value, 20);
+    bench_fill(xvalues[i].value, 6);
+    memset(xvalues[i].index, 0, 5);
+  }
+  qsort(addresses, BENCH_TABLE_ITEMS, sizeof(struct address_value), bench_compare_address);
+  qsort(xvalues, BENCH_TABLE_ITEMS, sizeof(struct bsgs_xvalue), bench_compare_xvalue);
+  found = 0;
+  bench_run("searchbinary/4M", "scalar", 1, [&]() {
+    bench_fill(data, 20);
+    found += searchbinary(addresses, (char *)data, BENCH_TABLE_ITEMS);
+  });
+  bench_run("bsgs_searchbinary/4M", "scalar", 1, [&]() {
+    bench_fill(data, 32);
+    found += bsgs_searchbinary(xvalues, (char *)data, BENCH_TABLE_ITEMS, &index);
+  });
+  sink = found;
+  free(addresses);
+  free(xvalues);
+}
+
+static const char *bench_bool(bool value)
+{
+  return value ? "true" : "false";
+}
+
+int main()
+{
+  Secp256K1 *secp;
+  size_t i;
+
+  simd_detect_features();
+  secp = new Secp256K1();
+  secp->Init();
+
+  bench_field(secp);
+  bench_hash(secp);
+  bench_bloom();
+  bench_search();
+
+  printf("{\n");
+  printf("  \"compiler\": \"%s\",\n", __VERSION__);
+  printf("  \"build\": {\"sse2\": %s, \"ssse3\": %s, \"avx2\": %s, \"avx512f\": %s, \"sha\": %s},\n",
+#ifdef __SSE2__
+    bench_bool(true),
+#else
+    bench_bool(false),
+#endif
+#ifdef __SSSE3__
+    bench_bool(true),
+#else
+    bench_bool(false),
+#endif
+#ifdef __AVX2__
+    bench_bool(true),
+#else
+    bench_bool(false),
+#endif
+#ifdef __AVX512F__
+    bench_bool(true),
+#else
+    bench_bool(false),
+#endif
+#ifdef __SHA__
+    bench_bool(true)
+#else
+    bench_bool(false)
+#endif
+  );
+  printf("  \"cpu\": {\"avx2\": %s, \"avx512f\": %s, \"sha_ni\": %s, \"zen5\": %s},\n",
+    bench_bool(simd_has_avx2()), bench_bool(simd_has_avx512f()), bench_bool(simd_has_sha_ni()), bench_bool(simd_is_zen5()));
+  printf("  \"results\": [\n");
+  for (i = 0; i < results.size(); i++) {
+    printf("    {\"name\": \"%s\", \"backend\": \"%s\", \"ns_per_op\": %.3f, \"ops_per_s\": %.0f}%s\n",
+      results[i].name, results[i].backend, results[i].ns, 1e9 / results[i].ns, i + 1 < results.size() ? "," : "");
+  }
+  printf("  ]\n");
+  printf("}\n");
+  delete secp;
+  return 0;
+}
@@ -46,6 +46,12 @@ inline static int test_bit_set_bit(uint8_t *bf, uint64_t bit, int set_bit)
   }
 }
 
+inline static int test_bit_set_bit_atomic(uint8_t *bf, uint64_t bit)
+{
+  uint8_t mask = 1 << (bit % 8);
+  return (__atomic_fetch_or(&bf[bit >> 3], mask, __ATOMIC_RELAXED) & mask) != 0;
+}
+
 inline static int test_bit(uint8_t *bf, uint64_t bit)
 {
   uint64_t byte = bit >> 3;
@@ -58,6 +64,37 @@ inline static int test_bit(uint8_t *bf, uint64_t bit)
   }
 }
 
+/* Map a 64 bit probe to [0, bits) without a division */
+inline static uint64_t bloom_reduce(uint64_t x, uint64_t bits)
+{
+#if defined(_MSC_VER)
+  return __umulh(x, bits);
+#else
+  return (uint64_t)(((unsigned __int128)x * bits) >> 64);
+#endif
+}
+
+/* The two values of the double hashing a + b*i */
+inline static void bloom_probes(struct bloom * bloom, const void * buffer, int len, uint64_t *a, uint64_t *b)
+{
+  if (bloom->mode == BLOOM_KEYED && len >= 16) {
+    memcpy(a, (const uint8_t *)buffer + len - 16, sizeof(uint64_t));
+    memcpy(b, (const uint8_t *)buffer + len - 8, sizeof(uint64_t));
+  } else {
+    *a = XXH64(buffer, len, 0x59f2815b16f81798);
+    *b = XXH64(buffer, len, *a);
+  }
+}
+
+/* Position of the probe i, the hashed filters keep the modulo of the saved files */
+inline static uint64_t bloom_position(struct bloom * bloom, uint64_t a, uint64_t b, uint8_t i)
+{
+  if (bloom->mode == BLOOM_KEYED) {
+    return bloom_reduce(a + b*i, bloom->bits);
+  }
+  return (a + b*i) % bloom->bits;
+}
+
 static int bloom_check_add(struct bloom * bloom, const void * buffer, int len, int add)
 {
   if (bloom->ready == 0) {
@@ -65,12 +102,12 @@ static int bloom_check_add(struct bloom * bloom, const void * buffer, int len, i
     return -1;
   }
   uint8_t hits = 0;
-  uint64_t a = XXH64(buffer, len, 0x59f2815b16f81798);
-  uint64_t b = XXH64(buffer, len, a);
+  uint64_t a, b;
   uint64_t x;
   uint8_t i;
+  bloom_probes(bloom, buffer, len, &a, &b);
   for (i = 0; i < bloom->hashes; i++) {
-    x = (a + b*i) % bloom->bits;
+    x = bloom_position(bloom, a, b, i);
     if (test_bit_set_bit(bloom->bf, x, add)) {
       hits++;
     } else if (!add) {
@@ -91,12 +128,18 @@ int bloom_init(struct bloom * bloom, uint64_t entries, long double error)
 }
 
 int bloom_init2(struct bloom * bloom, uint64_t entries, long double error)
+{
+  return bloom_init3(bloom, entries, error, BLOOM_HASHED);
+}
+
+int bloom_init3(struct bloom * bloom, uint64_t entries, long double error, uint8_t mode)
 {
   memset(bloom, 0, sizeof(struct bloom));
-  if (entries < 1000 || error <= 0 || error >= 1) {
+  if (entries < 1000 || error <= 0 || error >= 1 || mode > BLOOM_KEYED) {
     return 1;
   }
   bloom->entries = entries;
+  bloom->mode = mode;
   bloom->error = error;
 
   long double num = -log(bloom->error);
@@ -132,12 +175,12 @@ int bloom_check(struct bloom * bloom, const void * buffer, int len)
     return -1;
   }
   uint8_t hits = 0;
-  uint64_t a = XXH64(buffer, len, 0x59f2815b16f81798);
-  uint64_t b = XXH64(buffer, len, a);
+  uint64_t a, b;
   uint64_t x;
   uint8_t i;
+  bloom_probes(bloom, buffer, len, &a, &b);
   for (i = 0; i < bloom->hashes; i++) {
-    x = (a + b*i) % bloom->bits;
+    x = bloom_position(bloom, a, b, i);
     if (test_bit(bloom->bf, x)) {
       hits++;
     } else {
@@ -156,11 +199,28 @@ int bloom_add(struct bloom * bloom, const void * buffer, int len)
   return bloom_check_add(bloom, buffer, len, 1);
 }
 
+int bloom_add_atomic(struct bloom * bloom, const void * buffer, int len)
+{
+  if (bloom->ready == 0) {
+    printf("bloom at %p not initialized!\n", (void *)bloom);
+    return -1;
+  }
+  uint8_t hits = 0;
+  uint64_t a, b;
+  uint8_t i;
+  bloom_probes(bloom, buffer, len, &a, &b);
+  for (i = 0; i < bloom->hashes; i++) {
+    hits += test_bit_set_bit_atomic(bloom->bf, bloom_position(bloom, a, b, i));
+  }
+  return hits == bloom->hashes;
+}
+
 void bloom_print(struct bloom * bloom)
 {
   printf("bloom at %p\n", (void *)bloom);
   if (!bloom->ready) { printf(" *** NOT READY ***\n"); }
   printf(" ->version = %d.%d\n", bloom->major, bloom->minor);
+  printf(" ->mode = %s\n", bloom->mode == BLOOM_KEYED ? "keyed" : "hashed");
   printf(" ->entries = %" PRIu64 "\n", bloom->entries);
   printf(" ->error = %Lf\n", bloom->error);
   printf(" ->bits = %" PRIu64 "\n", bloom->bits);
@@ -186,6 +246,109 @@ int bloom_reset(struct bloom * bloom)
   memset(bloom->bf, 0, bloom->bytes);
   return 0;
 }
+/* Finalizer of MurmurHash3, its high bits don't follow the high bits of x */
+inline static uint64_t bloom_mix(uint64_t x)
+{
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdULL;
+  x ^= x >> 33;
+  x *= 0xc4ceb9fe1a85ec53ULL;
+  x ^= x >> 33;
+  return x;
+}
+
+/*
+ * Line and bits of the element in the prefilter, 9 bits of b for each hash.
+ * The first probe of BLOOM_KEYED is the high bits of a, so the line is taken
+ * from a mixed
+ */
+inline static uint64_t * bloom_prefilter_line(struct bloom_prefilter * prefilter, const void * buffer, int len, uint64_t *b)
+{
+  uint64_t a;
+  memcpy(&a, (const uint8_t *)buffer + len - 16, sizeof(uint64_t));
+  memcpy(b, (const uint8_t *)buffer + len - 8, sizeof(uint64_t));
+  return prefilter->bf + bloom_reduce(bloom_mix(a), prefilter->lines) * (BLOOM_PREFILTER_LINE / sizeof(uint64_t));
+}
+
+int bloom_prefilter_init(struct bloom_prefilter * prefilter, uint64_t entries, uint64_t bytes)
+{
+  double bpe;
+  int hashes;
+  memset(prefilter, 0, sizeof(struct bloom_prefilter));
+  if (entries == 0 || bytes < BLOOM_PREFILTER_LINE) {
+    return 1;
+  }
+  prefilter->entries = entries;
+  prefilter->lines = bytes / BLOOM_PREFILTER_LINE;
+  prefilter->bytes = prefilter->lines * BLOOM_PREFILTER_LINE;
+
+  bpe = (double)(prefilter->bytes * 8) / (double)entries;
+  hashes = (int)(0.693147180559945 * bpe + 0.5);  // ln(2)
+  if (hashes < 1) {
+    hashes = 1;
+  }
+  if (hashes > 7) {
+    hashes = 7;
+  }
+  prefilter->hashes = (uint8_t)hashes;
+
+#if defined(_WIN64) && !defined(__CYGWIN__)
+  prefilter->bf = (uint64_t *)_aligned_malloc(prefilter->bytes, BLOOM_PREFILTER_LINE);
+  if (prefilter->bf == NULL) {
+    return 1;
+  }
+#else
+  if (posix_memalign((void **)&prefilter->bf, BLOOM_PREFILTER_LINE, prefilter->bytes) != 0) {
+    prefilter->bf = NULL;
+    return 1;
+  }
+#endif
+  memset(prefilter->bf, 0, prefilter->bytes);
+  prefilter->ready = 1;
+  return 0;
+}
+
+void bloom_prefilter_add(struct bloom_prefilter * prefilter, const void * buffer, int len)
+{
+  uint64_t *line, b;
+  uint16_t bit;
+  uint8_t i;
+  line = bloom_prefilter_line(prefilter, buffer, len, &b);
+  for (i = 0; i < prefilter->hashes; i++) {
+    bit = (b >> (9 * i)) & 511;
+    __atomic_fetch_or(&line[bit >> 6], (uint64_t)1 << (bit & 63), __ATOMIC_RELAXED);
+  }
+}
+
+int bloom_check_prefiltered(struct bloom_prefilter * prefilter, struct bloom * bloom, const void * buffer, int len)
+{
+  uint64_t *line, b;
+  uint16_t bit;
+  uint8_t i;
+  if (prefilter->ready) {
+    line = bloom_prefilter_line(prefilter, buffer, len, &b);
+    for (i = 0; i < prefilter->hashes; i++) {
+      bit = (b >> (9 * i)) & 511;
+      if (!(line[bit >> 6] & ((uint64_t)1 << (bit & 63)))) {
+        return 0;
+      }
+    }
+  }
+  return bloom_check(bloom, buffer, len);
+}
+
+void bloom_prefilter_free(struct bloom_prefilter * prefilter)
+{
+  if (prefilter->ready) {
+#if defined(_WIN64) && !defined(__CYGWIN__)
+    _aligned_free(prefilter->bf);
+#else
+    free(prefilter->bf);
+#endif
+  }
+  prefilter->ready = 0;
+}
+
 /*
 int bloom_save(struct bloom * bloom, char * filename)
 {
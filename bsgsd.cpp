@@ -52,7 +52,22 @@ struct checksumsha256	{
 	char backup[32];
 };
 
+/*
+	bP table entry: 6 bytes of the X value and the 40 bit index of the point,
+	packed to 11 bytes per entry without padding.
+*/
+#define BSGS_XINDEX_BYTES 5
+#define BSGS_XINDEX_MAX 0xFFFFFFFFFFULL
+
+#pragma pack(push,1)
 struct bsgs_xvalue	{
+	uint8_t value[6];
+	uint8_t index[BSGS_XINDEX_BYTES];
+};
+#pragma pack(pop)
+
+/* Entry of the old keyhunt_bsgs_2_*.tbl files, only used to migrate them */
+struct bsgs_xvalue_v2	{
 	uint8_t value[6];
 	uint64_t index;
 };
@@ -106,7 +121,11 @@ void bsgs_heapify(struct bsgs_xvalue *arr, int64_t n, int64_t i);
 int64_t bsgs_partition(struct bsgs_xvalue *arr, int64_t n);
 
 int bsgs_searchbinary(struct bsgs_xvalue *arr,char *data,int64_t array_length,uint64_t *r_value);
+void bsgs_setindex(struct bsgs_xvalue *entry,uint64_t index);
+uint64_t bsgs_getindex(struct bsgs_xvalue *entry);
 int bsgs_secondcheck(Int *start_range,uint32_t a,Int *privatekey);
+int bsgs_checkqueue(Int *start_range,uint32_t *queue,uint32_t length,Int *privatekey);
+void bsgs_batchx(Point &Q,std::vector<Point> &AMP,Int *x,bool *equal);
 int bsgs_thirdcheck(Int *start_range,uint32_t a,Int *privatekey);
 
 
@@ -177,6 +196,7 @@ int FLAGREADEDFILE2 = 0;
 int FLAGREADEDFILE3 = 0;
 int FLAGREADEDFILE4 = 0;
 int FLAGUPDATEFILE1 = 0;
+int FLAGUPDATEFILE3 = 0;
 
 
 int FLAGBITRANGE = 0;
@@ -217,9 +237,6 @@ struct checksumsha256 *bloom_bP_checksums;
 struct checksumsha256 *bloom_bPx2nd_checksums;
 struct checksumsha256 *bloom_bPx3rd_checksums;
 
-pthread_mutex_t *bloom_bP_mutex;
-pthread_mutex_t *bloom_bPx2nd_mutex;
-pthread_mutex_t *bloom_bPx3rd_mutex;
 
 
 
@@ -553,15 +570,12 @@ int main(int argc, char **argv)	{
 		bloom_bP_checksums = (struct checksumsha256*)calloc(256,sizeof(struct checksumsha256));
 		checkpointer((void *)bloom_bP_checksums,__FILE__,"calloc","bloom_bP_checksums" ,__LINE__ -1 );
 		
-		bloom_bP_mutex = (pthread_mutex_t*) calloc(256,sizeof(pthread_mutex_t));
-		checkpointer((void *)bloom_bP_mutex,__FILE__,"calloc","bloom_bP_mutex" ,__LINE__ -1 );
 		
 
 		fflush(stdout);
 		bloom_bP_totalbytes = 0;
 		for(i=0; i< 256; i++)	{
-			pthread_mutex_init(&bloom_bP_mutex[i],NULL);
-			if(bloom_init2(&bloom_bP[i],itemsbloom,0.000001)	== 1){
+			if(bloom_init3(&bloom_bP[i],itemsbloom,0.000001,BLOOM_KEYED)	== 1){
 				fprintf(stderr,"[E] error bloom_init _ %i\n",i);
 				exit(0);
 			}
@@ -572,16 +586,13 @@ int main(int argc, char **argv)	{
 
 		printf("[+] Bloom filter for %" PRIu64 " elements ",bsgs_m2);
 		
-		bloom_bPx2nd_mutex = (pthread_mutex_t*) calloc(256,sizeof(pthread_mutex_t));
-		checkpointer((void *)bloom_bPx2nd_mutex,__FILE__,"calloc","bloom_bPx2nd_mutex" ,__LINE__ -1 );
 		bloom_bPx2nd = (struct bloom*)calloc(256,sizeof(struct bloom));
 		checkpointer((void *)bloom_bPx2nd,__FILE__,"calloc","bloom_bPx2nd" ,__LINE__ -1 );
 		bloom_bPx2nd_checksums = (struct checksumsha256*) calloc(256,sizeof(struct checksumsha256));
 		checkpointer((void *)bloom_bPx2nd_checksums,__FILE__,"calloc","bloom_bPx2nd_checksums" ,__LINE__ -1 );
 		bloom_bP2_totalbytes = 0;
 		for(i=0; i< 256; i++)	{
-			pthread_mutex_init(&bloom_bPx2nd_mutex[i],NULL);
-			if(bloom_init2(&bloom_bPx2nd[i],itemsbloom2,0.000001)	== 1){
+			if(bloom_init3(&bloom_bPx2nd[i],itemsbloom2,0.000001,BLOOM_KEYED)	== 1){
 				fprintf(stderr,"[E] error bloom_init _ %i\n",i);
 				exit(0);
 			}
@@ -590,8 +601,6 @@ int main(int argc, char **argv)	{
 		printf(": %.2f MB\n",(float)((float)(uint64_t)bloom_bP2_totalbytes/(float)(uint64_t)1048576));
 		
 
-		bloom_bPx3rd_mutex = (pthread_mutex_t*) calloc(256,sizeof(pthread_mutex_t));
-		checkpointer((void *)bloom_bPx3rd_mutex,__FILE__,"calloc","bloom_bPx3rd_mutex" ,__LINE__ -1 );
 		bloom_bPx3rd = (struct bloom*)calloc(256,sizeof(struct bloom));
 		checkpointer((void *)bloom_bPx3rd,__FILE__,"calloc","bloom_bPx3rd" ,__LINE__ -1 );
 		bloom_bPx3rd_checksums = (struct checksumsha256*) calloc(256,sizeof(struct checksumsha256));
@@ -600,8 +609,7 @@ int main(int argc, char **argv)	{
 		printf("[+] Bloom filter for %" PRIu64 " elements ",bsgs_m3);
 		bloom_bP3_totalbytes = 0;
 		for(i=0; i< 256; i++)	{
-			pthread_mutex_init(&bloom_bPx3rd_mutex[i],NULL);
-			if(bloom_init2(&bloom_bPx3rd[i],itemsbloom3,0.000001)	== 1){
+			if(bloom_init3(&bloom_bPx3rd[i],itemsbloom3,0.000001,BLOOM_KEYED)	== 1){
 				fprintf(stderr,"[E] error bloom_init %i\n",i);
 				exit(0);
 			}
@@ -674,6 +682,10 @@ int main(int argc, char **argv)	{
 			BSGS_AMP3[i].Reduce();
 		}
 
+		if(bsgs_m3 > BSGS_XINDEX_MAX)	{
+			fprintf(stderr,"[E] Too many bP Points for the bP Table, use a lower -k value\n");
+			exit(0);
+		}
 		bytes = (uint64_t)bsgs_m3 * (uint64_t) sizeof(struct bsgs_xvalue);
 		printf("[+] Allocating %.2f MB for %" PRIu64  " bP Points\n",(double)(bytes/1048576),bsgs_m3);
 		
@@ -748,6 +760,7 @@ int main(int argc, char **argv)	{
 						}
 						memcpy(&bloom_bP[i],&oldbloom_bP,sizeof(struct bloom));//We only need to copy the part data to the new bloom size, not from the old size
 						bloom_bP[i].bf = (uint8_t*)bf_ptr;	/* Restoring the bf pointer*/
+						bloom_bP[i].mode = BLOOM_HASHED;	/* The old files are always hashed, their byte of the mode is cleared by oldbloom_init but the old format doesn't define it */
 						
 						readed = fread(bloom_bP[i].bf,bloom_bP[i].bytes,1,fd_aux1);
 						if(readed != 1)	{
@@ -841,7 +854,7 @@ int main(int argc, char **argv)	{
 			}
 			
 			/*Reading file for bPtable */
-			snprintf(buffer_bloom_file,1024,"keyhunt_bsgs_2_%" PRIu64 ".tbl",bsgs_m3);
+			snprintf(buffer_bloom_file,1024,"keyhunt_bsgs_8_%" PRIu64 ".tbl",bsgs_m3);
 			fd_aux3 = fopen(buffer_bloom_file,"rb");
 			if(fd_aux3 != NULL)	{
 				printf("[+] Reading bP Table from file %s .",buffer_bloom_file);
@@ -865,6 +878,52 @@ int main(int argc, char **argv)	{
 			}
 			else	{
 				FLAGREADEDFILE3 = 0;
+				/* Old bP Table with 16 bytes per entry, it is converted to the packed layout */
+				snprintf(buffer_bloom_file,1024,"keyhunt_bsgs_2_%" PRIu64 ".tbl",bsgs_m3);
+				fd_aux3 = fopen(buffer_bloom_file,"rb");
+				if(fd_aux3 != NULL)	{
+					struct bsgs_xvalue_v2 *oldbPtable;
+					uint64_t oldchunk,oldread,oldj;
+					CSHA256 oldsha;
+					printf("[+] Reading old bP Table from file %s .",buffer_bloom_file);
+					fflush(stdout);
+					oldbPtable = (struct bsgs_xvalue_v2*) malloc(THREADBPWORKLOAD * sizeof(struct bsgs_xvalue_v2));
+					checkpointer((void *)oldbPtable,__FILE__,"malloc","oldbPtable" ,__LINE__ -1 );
+					oldread = 0;
+					while(oldread < bsgs_m3)	{
+						oldchunk = (bsgs_m3 - oldread > THREADBPWORKLOAD) ? THREADBPWORKLOAD : bsgs_m3 - oldread;
+						rsize = fread(oldbPtable,oldchunk * sizeof(struct bsgs_xvalue_v2),1,fd_aux3);
+						if(rsize != 1)	{
+							fprintf(stderr,"[E] Error reading the file %s\n",buffer_bloom_file);
+							exit(0);
+						}
+						oldsha.Write((unsigned char*)oldbPtable,oldchunk * sizeof(struct bsgs_xvalue_v2));
+						for(oldj = 0; oldj < oldchunk; oldj++)	{
+							memcpy(bPtable[oldread + oldj].value,oldbPtable[oldj].value,BSGS_XVALUE_RAM);
+							bsgs_setindex(&bPtable[oldread + oldj],oldbPtable[oldj].index);
+						}
+						oldread += oldchunk;
+					}
+					free(oldbPtable);
+					oldsha.Finalize((unsigned char*)checksum_backup);
+					rsize = fread(checksum,32,1,fd_aux3);
+					if(rsize != 1)	{
+						fprintf(stderr,"[E] Error reading the file %s\n",buffer_bloom_file);
+						exit(0);
+					}
+					if(FLAGSKIPCHECKSUM == 0)	{
+						if(memcmp(checksum,checksum_backup,32) != 0)	{
+							fprintf(stderr,"[E] Error checksum file mismatch! %s\n",buffer_bloom_file);
+							exit(0);
+						}
+					}
+					sha256((uint8_t*)bPtable,bytes,(uint8_t*)checksum);
+					memcpy(checksum_backup,checksum,32);
+					printf("... Done!\n");
+					fclose(fd_aux3);
+					FLAGUPDATEFILE3 = 1;	/* Flag to migrate the data to the new File keyhunt_bsgs_8_ */
+					FLAGREADEDFILE3 = 1;
+				}
 			}
 			
 			/*Reading file for 3rd bloom filter */
@@ -1147,7 +1206,7 @@ int main(int argc, char **argv)	{
 			printf("Done!\n");
 			fflush(stdout);
 		}
-		if(FLAGSAVEREADFILE || FLAGUPDATEFILE1 )	{
+		if(FLAGSAVEREADFILE || FLAGUPDATEFILE1 || FLAGUPDATEFILE3)	{
 			if(!FLAGREADEDFILE1 || FLAGUPDATEFILE1)	{
 				snprintf(buffer_bloom_file,1024,"keyhunt_bsgs_4_%" PRIu64 ".blm",bsgs_m);
 				
@@ -1229,9 +1288,12 @@ int main(int argc, char **argv)	{
 				}
 			}
 			
-			if(!FLAGREADEDFILE3)	{
+			if(!FLAGREADEDFILE3 || FLAGUPDATEFILE3)	{
 				/* Writing file for bPtable */
-				snprintf(buffer_bloom_file,1024,"keyhunt_bsgs_2_%" PRIu64 ".tbl",bsgs_m3);
+				if(FLAGUPDATEFILE3)	{
+					printf("[W] Updating old file into a new one\n");
+				}
+				snprintf(buffer_bloom_file,1024,"keyhunt_bsgs_8_%" PRIu64 ".tbl",bsgs_m3);
 				fd_aux3 = fopen(buffer_bloom_file,"wb");
 				if(fd_aux3 != NULL)	{
 					printf("[+] Writing bP Table to file %s .. ",buffer_bloom_file);
@@ -1248,6 +1310,9 @@ int main(int argc, char **argv)	{
 					}
 					printf("Done!\n");
 					fclose(fd_aux3);	
+					if(FLAGUPDATEFILE3)	{
+						printf("[W] Unused file detected keyhunt_bsgs_2_%" PRIu64 ".tbl you can delete it without worry\n",bsgs_m3);
+					}
 				}
 				else	{
 					fprintf(stderr,"[E] Error can't create the file %s\n",buffer_bloom_file);
@@ -1556,7 +1621,7 @@ int bsgs_searchbinary(struct bsgs_xvalue *buffer,char *data,int64_t array_length
 		half = (max - min)/2;
 		rcmp = memcmp(data+16,buffer[current+half].value,BSGS_XVALUE_RAM);
 		if(rcmp == 0)	{
-			*r_value = buffer[current+half].index;
+			*r_value = bsgs_getindex(&buffer[current+half]);
 			r = 1;
 		}
 		else	{
@@ -1572,10 +1637,27 @@ int bsgs_searchbinary(struct bsgs_xvalue *buffer,char *data,int64_t array_length
 	return r;
 }
 
+void bsgs_setindex(struct bsgs_xvalue *entry,uint64_t index)	{
+	int k;
+	for(k = 0; k < BSGS_XINDEX_BYTES; k++)	{
+		entry->index[k] = (uint8_t)(index >> (8*k));
+	}
+}
+
+uint64_t bsgs_getindex(struct bsgs_xvalue *entry)	{
+	uint64_t index = 0;
+	int k;
+	for(k = 0; k < BSGS_XINDEX_BYTES; k++)	{
+		index |= (uint64_t)entry->index[k] << (8*k);
+	}
+	return index;
+}
+
 void *thread_process_bsgs(void *vargp)	{
 
 	FILE *filekey;
 	char xpoint_raw[32],*aux_c,*hextemp;
+	uint32_t bsgs_queue[CPU_GRP_SIZE],candidates;
 	Int base_key,keyfound;
 	Point base_point,point_aux,point_found;
 	uint32_t r, cycles;
@@ -1763,38 +1845,36 @@ pn.y.ModAdd(&GSn[i].y);
 
 				pts[0] = pn;
 				
-				for(int i = 0; i<CPU_GRP_SIZE && bsgs_found == 0; i++) {
-					
+				candidates = 0;
+				for(int i = 0; i<CPU_GRP_SIZE; i++) {
 					pts[i].x.Get32Bytes((unsigned char*)xpoint_raw);
-					
-					r = bloom_check(&bloom_bP[((unsigned char)xpoint_raw[0])],xpoint_raw,32);
-					
-					if(r) {
-						r = bsgs_secondcheck(&base_key,((j*1024) + i),&keyfound);
-						if(r)	{
-							hextemp = keyfound.GetBase16();
-							printf("[+] Thread Key found privkey %s   \n",hextemp);
-							point_found = secp->ComputePublicKey(&keyfound);
-							aux_c = secp->GetPublicKeyHex(OriginalPointsBSGScompressed,point_found);
-							printf("[+] Publickey %s\n",aux_c);
-							pthread_mutex_lock(&write_keys);
-
-							filekey = fopen("KEYFOUNDKEYFOUND.txt","a");
-							if(filekey != NULL)	{
-								fprintf(filekey,"Key found privkey %s\nPublickey %s\n",hextemp,aux_c);
-								fclose(filekey);
-							}
-							BSGSkeyfound.Set(&keyfound);
-							pthread_mutex_unlock(&write_keys);
-							free(hextemp);
-							free(aux_c);
-							bsgs_found = 1;
-
-						} //End if second check
-						
-					}//End if first check
-					
-				}// For for pts variable
+					if(bloom_check(&bloom_bP[((unsigned char)xpoint_raw[0])],xpoint_raw,32)) {
+						bsgs_queue[candidates++] = (j*1024) + i;
+					}
+				}
+				if(candidates > 0 && bsgs_found == 0) {
+					r = bsgs_checkqueue(&base_key,bsgs_queue,candidates,&keyfound);
+					if(r)	{
+						hextemp = keyfound.GetBase16();
+						printf("[+] Thread Key found privkey %s   \n",hextemp);
+						point_found = secp->ComputePublicKey(&keyfound);
+						aux_c = secp->GetPublicKeyHex(OriginalPointsBSGScompressed,point_found);
+						printf("[+] Publickey %s\n",aux_c);
+						pthread_mutex_lock(&write_keys);
+
+						filekey = fopen("KEYFOUNDKEYFOUND.txt","a");
+						if(filekey != NULL)	{
+							fprintf(filekey,"Key found privkey %s\nPublickey %s\n",hextemp,aux_c);
+							fclose(filekey);
+						}
+						BSGSkeyfound.Set(&keyfound);
+						pthread_mutex_unlock(&write_keys);
+						free(hextemp);
+						free(aux_c);
+						bsgs_found = 1;
+
+					} //End if second check
+				}//End if first check
 				
 				// Next start point (startP += (bsSize*GRP_SIZE).G)
 				
@@ -1824,6 +1904,47 @@ pn.y.ModAdd(&GSn[i].y);
 	pthread_exit(NULL);
 }
 
+/*
+	bsgs_checkqueue drain the first bloom filter hits of one group of points,
+	each one is checked with bsgs_secondcheck until the key is found.
+*/
+int bsgs_checkqueue(Int *start_range,uint32_t *queue,uint32_t length,Int *privatekey)	{
+	int found = 0;
+	for(uint32_t i = 0; i < length && !found; i++)	{
+		found = bsgs_secondcheck(start_range,queue[i],privatekey);
+	}
+	return found;
+}
+
+/*
+	X values of Q + AMP[i] for the 32 AMP points, all the slopes share one
+	inversion. If Q.x is equal to AMP[i].x the sum is the infinity or 2Q,
+	those are marked in equal[i] and x[i] is not valid.
+*/
+void bsgs_batchx(Point &Q,std::vector<Point> &AMP,Int *x,bool *equal)	{
+	Int dx[32];
+	Int dy,_s,_p;
+	IntGroup grp(32);
+	int i;
+	grp.Set(dx);
+	for(i = 0; i < 32; i++)	{
+		dx[i].ModSub(&AMP[i].x,&Q.x);
+		equal[i] = dx[i].IsZero();
+		if(equal[i])	{
+			dx[i].SetInt32(1);	// Keep the batch inversion valid
+		}
+	}
+	grp.ModInv();
+	for(i = 0; i < 32; i++)	{
+		dy.ModSub(&AMP[i].y,&Q.y);
+		_s.ModMulK1(&dy,&dx[i]);		// s = (p2.y-p1.y)*inverse(p2.x-p1.x);
+		_p.ModSquareK1(&_s);			// _p = pow2(s)
+		x[i].Set(&_p);
+		x[i].ModSub(&Q.x);
+		x[i].ModSub(&AMP[i].x);			// rx = pow2(s) - p1.x - p2.x;
+	}
+}
+
 /*
 	The bsgs_secondcheck function is made to perform a second BSGS search in a Range of less size.
 	This funtion is made with the especific purpouse to USE a smaller bPtable in RAM.
@@ -1831,8 +1952,10 @@ pn.y.ModAdd(&GSn[i].y);
 int bsgs_secondcheck(Int *start_range,uint32_t a,Int *privatekey)	{
 	int i = 0,found = 0,r = 0;
 	Int base_key;
+	Int x[32];
+	bool equal[32];
 	Point base_point,point_aux;
-	Point BSGS_Q, BSGS_S,BSGS_Q_AMP;
+	Point BSGS_Q;
 	char xpoint_raw[32];
 	
 	base_key.Set(&BSGS_M_double);
@@ -1842,20 +1965,21 @@ int bsgs_secondcheck(Int *start_range,uint32_t a,Int *privatekey)	{
 	base_point = secp->ComputePublicKey(&base_key);
 	point_aux = secp->Negation(base_point);
 	/*
-		BSGS_S = Q - base_key
+		BSGS_Q = Q - base_key
 				 Q is the target Key
 		base_key is the Start range + a*BSGS_M
 	*/
 	
-	BSGS_S = secp->AddDirect(OriginalPointsBSGS,point_aux);
-	BSGS_Q.Set(BSGS_S);
+	BSGS_Q = secp->AddDirect(OriginalPointsBSGS,point_aux);
+	bsgs_batchx(BSGS_Q,BSGS_AMP2,x,equal);
 	do {
-		BSGS_Q_AMP = secp->AddDirect(BSGS_Q,BSGS_AMP2[i]);
-		BSGS_S.Set(BSGS_Q_AMP);
-		BSGS_S.x.Get32Bytes((unsigned char *) xpoint_raw);
-		
-		r = bloom_check(&bloom_bPx2nd[(uint8_t) xpoint_raw[0]],xpoint_raw,32);
-
+		if(equal[i])	{
+			r = 1;	// Special case, let the third check find it
+		}
+		else	{
+			x[i].Get32Bytes((unsigned char *) xpoint_raw);
+			r = bloom_check(&bloom_bPx2nd[(uint8_t) xpoint_raw[0]],xpoint_raw,32);
+		}
 		if(r)	{
 			found = bsgs_thirdcheck(&base_key,i,privatekey);
 		}
@@ -1868,8 +1992,10 @@ int bsgs_thirdcheck(Int *start_range,uint32_t a,Int *privatekey)	{
 	uint64_t j = 0;
 	int i = 0,found = 0,r = 0;
 	Int base_key,calculatedkey;
+	Int x[32];
+	bool equal[32];
 	Point base_point,point_aux;
-	Point BSGS_Q, BSGS_S,BSGS_Q_AMP;
+	Point BSGS_Q;
 	char xpoint_raw[32];
 
 	base_key.SetInt32(a);
@@ -1879,53 +2005,52 @@ int bsgs_thirdcheck(Int *start_range,uint32_t a,Int *privatekey)	{
 	base_point = secp->ComputePublicKey(&base_key);
 	point_aux = secp->Negation(base_point);
 	
-	BSGS_S = secp->AddDirect(OriginalPointsBSGS,point_aux);
-	BSGS_Q.Set(BSGS_S);
+	BSGS_Q = secp->AddDirect(OriginalPointsBSGS,point_aux);
+	bsgs_batchx(BSGS_Q,BSGS_AMP3,x,equal);
 	
 	do {
-		BSGS_Q_AMP = secp->AddDirect(BSGS_Q,BSGS_AMP3[i]);
-		BSGS_S.Set(BSGS_Q_AMP);
-		BSGS_S.x.Get32Bytes((unsigned char *)xpoint_raw);
-		r = bloom_check(&bloom_bPx3rd[(uint8_t)xpoint_raw[0]],xpoint_raw,32);
-		if(r)	{
-			r = bsgs_searchbinary(bPtable,xpoint_raw,bsgs_m3,&j);
-			if(r)	{
+		if(equal[i])	{
+			/*
+				The sum of the negated values of each other is the infinity,
+				so Q is the key of this step
+			*/
+			if(BSGS_Q.y.IsEqual(&BSGS_AMP3[i].y) == false)	{
 				calcualteindex(i,&calculatedkey);
 				privatekey->Set(&calculatedkey);
-				privatekey->Add((uint64_t)(j+1));
 				privatekey->Add(&base_key);
-				
-				point_aux = secp->ComputePublicKey(privatekey);
-				
-				if(point_aux.x.IsEqual(&OriginalPointsBSGS.x))	{
-					found = 1;
-				}
-				else	{
+				found = 1;
+			}
+		}
+		else	{
+			x[i].Get32Bytes((unsigned char *)xpoint_raw);
+			r = bloom_check(&bloom_bPx3rd[(uint8_t)xpoint_raw[0]],xpoint_raw,32);
+			if(r)	{
+				r = bsgs_searchbinary(bPtable,xpoint_raw,bsgs_m3,&j);
+				if(r)	{
 					calcualteindex(i,&calculatedkey);
 					privatekey->Set(&calculatedkey);
-					privatekey->Sub((uint64_t)(j+1));
+					privatekey->Add((uint64_t)(j+1));
 					privatekey->Add(&base_key);
 					
 					point_aux = secp->ComputePublicKey(privatekey);
+					
 					if(point_aux.x.IsEqual(&OriginalPointsBSGS.x))	{
 						found = 1;
 					}
+					else	{
+						calcualteindex(i,&calculatedkey);
+						privatekey->Set(&calculatedkey);
+						privatekey->Sub((uint64_t)(j+1));
+						privatekey->Add(&base_key);
+						
+						point_aux = secp->ComputePublicKey(privatekey);
+						if(point_aux.x.IsEqual(&OriginalPointsBSGS.x))	{
+							found = 1;
+						}
+					}
 				}
 			}
 		}
-		else	{
-			/*
-				For some reason the AddDirect don't return 000000... value when the publickeys are the negated values from each other
-				Why JLP?
-				This is is an special case
-			*/
-			if(BSGS_Q.x.IsEqual(&BSGS_AMP3[i].x))	{
-				calcualteindex(i,&calculatedkey);
-				privatekey->Set(&calculatedkey);
-				privatekey->Add(&base_key);
-				found = 1;
-			}
-		}
 		i++;
 	}while(i < 32 && !found);
 
@@ -2075,23 +2200,17 @@ void *thread_bPload(void *vargp)	{
 			if(i_counter < bsgs_m3)	{
 				if(!FLAGREADEDFILE3)	{
 					memcpy(bPtable[i_counter].value,rawvalue+16,BSGS_XVALUE_RAM);
-					bPtable[i_counter].index = i_counter;
+					bsgs_setindex(&bPtable[i_counter],i_counter);
 				}
 				if(!FLAGREADEDFILE4)	{
-					pthread_mutex_lock(&bloom_bPx3rd_mutex[bloom_bP_index]);
-					bloom_add(&bloom_bPx3rd[bloom_bP_index], rawvalue, BSGS_BUFFERXPOINTLENGTH);
-					pthread_mutex_unlock(&bloom_bPx3rd_mutex[bloom_bP_index]);
+					bloom_add_atomic(&bloom_bPx3rd[bloom_bP_index], rawvalue, BSGS_BUFFERXPOINTLENGTH);
 				}
 			}
 			if(i_counter < bsgs_m2 && !FLAGREADEDFILE2)	{
-				pthread_mutex_lock(&bloom_bPx2nd_mutex[bloom_bP_index]);
-				bloom_add(&bloom_bPx2nd[bloom_bP_index], rawvalue, BSGS_BUFFERXPOINTLENGTH);
-				pthread_mutex_unlock(&bloom_bPx2nd_mutex[bloom_bP_index]);
+				bloom_add_atomic(&bloom_bPx2nd[bloom_bP_index], rawvalue, BSGS_BUFFERXPOINTLENGTH);
 			}
 			if(i_counter < to && !FLAGREADEDFILE1 )	{
-				pthread_mutex_lock(&bloom_bP_mutex[bloom_bP_index]);
-				bloom_add(&bloom_bP[bloom_bP_index], rawvalue ,BSGS_BUFFERXPOINTLENGTH);
-				pthread_mutex_unlock(&bloom_bP_mutex[bloom_bP_index]);
+				bloom_add_atomic(&bloom_bP[bloom_bP_index], rawvalue, BSGS_BUFFERXPOINTLENGTH);
 			}
 			i_counter++;
 		}
@@ -2228,18 +2347,14 @@ void *thread_bPload_2blooms(void *vargp)	{
 			if(i_counter < bsgs_m3)	{
 				if(!FLAGREADEDFILE3)	{
 					memcpy(bPtable[i_counter].value,rawvalue+16,BSGS_XVALUE_RAM);
-					bPtable[i_counter].index = i_counter;
+					bsgs_setindex(&bPtable[i_counter],i_counter);
 				}
 				if(!FLAGREADEDFILE4)	{
-					pthread_mutex_lock(&bloom_bPx3rd_mutex[bloom_bP_index]);
-					bloom_add(&bloom_bPx3rd[bloom_bP_index], rawvalue, BSGS_BUFFERXPOINTLENGTH);
-					pthread_mutex_unlock(&bloom_bPx3rd_mutex[bloom_bP_index]);
+					bloom_add_atomic(&bloom_bPx3rd[bloom_bP_index], rawvalue, BSGS_BUFFERXPOINTLENGTH);
 				}
 			}
 			if(i_counter < bsgs_m2 && !FLAGREADEDFILE2)	{
-				pthread_mutex_lock(&bloom_bPx2nd_mutex[bloom_bP_index]);
-				bloom_add(&bloom_bPx2nd[bloom_bP_index], rawvalue, BSGS_BUFFERXPOINTLENGTH);
-				pthread_mutex_unlock(&bloom_bPx2nd_mutex[bloom_bP_index]);
+				bloom_add_atomic(&bloom_bPx2nd[bloom_bP_index], rawvalue, BSGS_BUFFERXPOINTLENGTH);
 			}
 			i_counter++;
 		}
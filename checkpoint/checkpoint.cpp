@@ -0,0 +1,358 @@
+/*
+ * Checkpoint of the work done by keyhunt
+ *
+ * Refer to checkpoint.h for documentation on the public interfaces.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "checkpoint.h"
+#include "../hash/sha256.h"
+#include "../util.h"
+
+#define CHECKPOINT_MAGIC "KHCKPT01"
+
+struct checkpoint_header
+{
+  char magic[8];
+  uint32_t random;
+  uint32_t reserved;
+  uint8_t range_start[32];
+  uint8_t range_end[32];
+  uint8_t chunk[32];
+  uint64_t intervals;
+  uint64_t chunks;        // Bits of the visited bitmap, 0 if there is no bitmap
+};
+
+static void checkpoint_lock(struct checkpoint *cp)
+{
+#if defined(_WIN64) && !defined(__CYGWIN__)
+  WaitForSingleObject(cp->mutex, INFINITE);
+#else
+  pthread_mutex_lock(&cp->mutex);
+#endif
+}
+
+static void checkpoint_unlock(struct checkpoint *cp)
+{
+#if defined(_WIN64) && !defined(__CYGWIN__)
+  ReleaseMutex(cp->mutex);
+#else
+  pthread_mutex_unlock(&cp->mutex);
+#endif
+}
+
+/* End of the chunk that start in 'from', never after the end of the range */
+static void checkpoint_chunkend(struct checkpoint *cp, Int *from, Int *end)
+{
+  end->Set(from);
+  end->Add(&cp->chunk);
+  if (end->IsGreater(&cp->range_end)) {
+    end->Set(&cp->range_end);
+  }
+}
+
+static uint64_t checkpoint_index(struct checkpoint *cp, Int *from)
+{
+  Int offset;
+  offset.Set(from);
+  offset.Sub(&cp->range_start);
+  offset.Div(&cp->chunk);
+  return offset.GetInt64();
+}
+
+int checkpoint_init(struct checkpoint *cp, const char *filename, Int *start, Int *end, Int *chunk, int random)
+{
+  Int chunks;
+  snprintf(cp->filename, sizeof(cp->filename), "%s", filename);
+  cp->range_start.Set(start);
+  cp->range_end.Set(end);
+  cp->chunk.Set(chunk);
+  cp->random = random;
+  cp->intervals.clear();
+  cp->chunks = 0;
+  cp->visited = NULL;
+  cp->taken = NULL;
+  cp->taken_count = 0;
+#if defined(_WIN64) && !defined(__CYGWIN__)
+  cp->mutex = CreateMutex(NULL, FALSE, NULL);
+#else
+  pthread_mutex_init(&cp->mutex, NULL);
+#endif
+  if (random) {
+    chunks.Set(end);
+    chunks.Sub(start);
+    chunks.Add(chunk);
+    chunks.SubOne();
+    chunks.Div(chunk);
+    if (chunks.GetBitLength() <= 63 && chunks.GetInt64() <= CHECKPOINT_MAX_BITMAP) {
+      cp->chunks = chunks.GetInt64();
+      cp->visited = (uint8_t *)calloc((cp->chunks + 7) / 8, 1);
+      cp->taken = (uint8_t *)calloc((cp->chunks + 7) / 8, 1);
+      if (cp->visited == NULL || cp->taken == NULL) {
+        return 1;
+      }
+    }
+  }
+  return 0;
+}
+
+int checkpoint_load(struct checkpoint *cp)
+{
+  struct checkpoint_header header;
+  struct checkpoint_interval interval;
+  uint8_t raw[64], checksum[32], checksum_file[32];
+  Int value;
+  uint64_t i, j;
+  FILE *fd;
+  CSHA256 sha;
+
+  fd = fopen(cp->filename, "rb");
+  if (fd == NULL) {
+    return 1;
+  }
+  if (fread(&header, sizeof(struct checkpoint_header), 1, fd) != 1 || memcmp(header.magic, CHECKPOINT_MAGIC, 8) != 0) {
+    fclose(fd);
+    return 2;
+  }
+  sha.Write((unsigned char *)&header, sizeof(struct checkpoint_header));
+  value.Set32Bytes(header.range_start);
+  if (!value.IsEqual(&cp->range_start)) {
+    fclose(fd);
+    return 3;
+  }
+  value.Set32Bytes(header.range_end);
+  if (!value.IsEqual(&cp->range_end)) {
+    fclose(fd);
+    return 3;
+  }
+  value.Set32Bytes(header.chunk);
+  if (!value.IsEqual(&cp->chunk) || header.chunks != cp->chunks) {
+    fclose(fd);
+    return 3;
+  }
+  cp->intervals.clear();
+  for (i = 0; i < header.intervals; i++) {
+    if (fread(raw, 64, 1, fd) != 1) {
+      fclose(fd);
+      return 4;
+    }
+    sha.Write(raw, 64);
+    interval.start.Set32Bytes(raw);
+    interval.end.Set32Bytes(raw + 32);
+    cp->intervals.push_back(interval);
+  }
+  if (cp->chunks) {
+    if (fread(cp->visited, (cp->chunks + 7) / 8, 1, fd) != 1) {
+      fclose(fd);
+      return 4;
+    }
+    sha.Write(cp->visited, (cp->chunks + 7) / 8);
+    memcpy(cp->taken, cp->visited, (cp->chunks + 7) / 8);
+    cp->taken_count = 0;
+    for (j = 0; j < cp->chunks; j++) {
+      if (cp->taken[j >> 3] & (1 << (j & 7))) {
+        cp->taken_count++;
+      }
+    }
+  }
+  sha.Finalize(checksum);
+  if (fread(checksum_file, 32, 1, fd) != 1 || memcmp(checksum, checksum_file, 32) != 0) {
+    fclose(fd);
+    return 5;
+  }
+  fclose(fd);
+  return 0;
+}
+
+int checkpoint_save(struct checkpoint *cp)
+{
+  struct checkpoint_header header;
+  uint8_t raw[64], checksum[32];
+  char tmpname[1040];
+  uint64_t i;
+  FILE *fd;
+  CSHA256 sha;
+  int rv = 0;
+
+  snprintf(tmpname, sizeof(tmpname), "%s.tmp", cp->filename);
+  fd = fopen(tmpname, "wb");
+  if (fd == NULL) {
+    return 1;
+  }
+  memset(&header, 0, sizeof(struct checkpoint_header));
+  memcpy(header.magic, CHECKPOINT_MAGIC, 8);
+  header.random = cp->random;
+  cp->range_start.Get32Bytes(header.range_start);
+  cp->range_end.Get32Bytes(header.range_end);
+  cp->chunk.Get32Bytes(header.chunk);
+  header.chunks = cp->chunks;
+
+  checkpoint_lock(cp);
+  header.intervals = cp->intervals.size();
+  if (fwrite(&header, sizeof(struct checkpoint_header), 1, fd) != 1) {
+    rv = 2;
+  }
+  sha.Write((unsigned char *)&header, sizeof(struct checkpoint_header));
+  for (i = 0; i < header.intervals && rv == 0; i++) {
+    cp->intervals[i].start.Get32Bytes(raw);
+    cp->intervals[i].end.Get32Bytes(raw + 32);
+    if (fwrite(raw, 64, 1, fd) != 1) {
+      rv = 2;
+    }
+    sha.Write(raw, 64);
+  }
+  if (cp->chunks && rv == 0) {
+    if (fwrite(cp->visited, (cp->chunks + 7) / 8, 1, fd) != 1) {
+      rv = 2;
+    }
+    sha.Write(cp->visited, (cp->chunks + 7) / 8);
+  }
+  checkpoint_unlock(cp);
+
+  sha.Finalize(checksum);
+  if (rv == 0 && fwrite(checksum, 32, 1, fd) != 1) {
+    rv = 2;
+  }
+  if (rv == 0 && syncfile(fd) != 0) {
+    rv = 2;
+  }
+  if (fclose(fd) != 0 && rv == 0) {
+    rv = 2;
+  }
+  if (rv != 0) {
+    remove(tmpname);
+    return rv;
+  }
+#if defined(_WIN64) && !defined(__CYGWIN__)
+  remove(cp->filename);
+#endif
+  if (rename(tmpname, cp->filename) != 0) {
+    return 3;
+  }
+  /* The new name is only on the disk after the sync of its directory */
+  if (syncdir(cp->filename) != 0) {
+    return 3;
+  }
+  return 0;
+}
+
+void checkpoint_done(struct checkpoint *cp, Int *from)
+{
+  struct checkpoint_interval merged;
+  uint64_t index;
+  size_t i, j;
+
+  checkpoint_lock(cp);
+  if (cp->random) {
+    if (cp->chunks) {
+      index = checkpoint_index(cp, from);
+      if (index < cp->chunks) {
+        cp->visited[index >> 3] |= 1 << (index & 7);
+      }
+    }
+  }
+  else {
+    merged.start.Set(from);
+    checkpoint_chunkend(cp, from, &merged.end);
+    /* First interval that is not completely before the new one */
+    i = 0;
+    while (i < cp->intervals.size() && cp->intervals[i].end.IsLower(&merged.start)) {
+      i++;
+    }
+    /* Merge all the intervals that overlap or touch the new one */
+    j = i;
+    while (j < cp->intervals.size() && cp->intervals[j].start.IsLowerOrEqual(&merged.end)) {
+      if (cp->intervals[j].start.IsLower(&merged.start)) {
+        merged.start.Set(&cp->intervals[j].start);
+      }
+      if (cp->intervals[j].end.IsGreater(&merged.end)) {
+        merged.end.Set(&cp->intervals[j].end);
+      }
+      j++;
+    }
+    cp->intervals.erase(cp->intervals.begin() + i, cp->intervals.begin() + j);
+    cp->intervals.insert(cp->intervals.begin() + i, merged);
+  }
+  checkpoint_unlock(cp);
+}
+
+bool checkpoint_isdone(struct checkpoint *cp, Int *from)
+{
+  Int end;
+  bool r = false;
+  size_t i;
+
+  checkpoint_chunkend(cp, from, &end);
+  checkpoint_lock(cp);
+  for (i = 0; i < cp->intervals.size() && !r; i++) {
+    if (cp->intervals[i].start.IsLowerOrEqual(from) && cp->intervals[i].end.IsGreaterOrEqual(&end)) {
+      r = true;
+    }
+  }
+  checkpoint_unlock(cp);
+  return r;
+}
+
+bool checkpoint_random(struct checkpoint *cp, Int *from)
+{
+  Int random;
+  uint64_t index = 0;
+  int tries;
+  bool found = false;
+
+  checkpoint_lock(cp);
+  if (cp->chunks == 0) {
+    from->Rand(&cp->range_start, &cp->range_end);
+    checkpoint_unlock(cp);
+    return true;
+  }
+  if (cp->taken_count < cp->chunks) {
+    for (tries = 0; tries < 64 && !found; tries++) {
+      random.Rand(64);
+      index = random.GetInt64() % cp->chunks;
+      found = !(cp->taken[index >> 3] & (1 << (index & 7)));
+    }
+    /* Almost all the range is done, look for the next free chunk */
+    while (!found) {
+      index = (index + 1) % cp->chunks;
+      found = !(cp->taken[index >> 3] & (1 << (index & 7)));
+    }
+    cp->taken[index >> 3] |= 1 << (index & 7);
+    cp->taken_count++;
+    from->Set(&cp->chunk);
+    from->Mult(index);
+    from->Add(&cp->range_start);
+  }
+  checkpoint_unlock(cp);
+  return found;
+}
+
+void checkpoint_total(struct checkpoint *cp, Int *total)
+{
+  Int aux;
+  uint64_t i, count;
+
+  total->SetInt32(0);
+  checkpoint_lock(cp);
+  if (cp->random) {
+    count = 0;
+    for (i = 0; i < cp->chunks; i++) {
+      if (cp->visited[i >> 3] & (1 << (i & 7))) {
+        count++;
+      }
+    }
+    total->Set(&cp->chunk);
+    total->Mult(count);
+  }
+  else {
+    for (i = 0; i < cp->intervals.size(); i++) {
+      aux.Set(&cp->intervals[i].end);
+      aux.Sub(&cp->intervals[i].start);
+      total->Add(&aux);
+    }
+  }
+  checkpoint_unlock(cp);
+}
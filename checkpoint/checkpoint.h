@@ -0,0 +1,97 @@
+/*
+ * Checkpoint of the work done by keyhunt
+ *
+ * Sequential modes record the finished chunks as a set of merged intervals
+ * [start,end), random modes record a bitmap of the visited chunks of the
+ * range. The file is written with a temporary name and renamed, so a crash
+ * while saving never destroys the previous checkpoint.
+ */
+
+#ifndef _CHECKPOINT_H
+#define _CHECKPOINT_H
+
+#include <stdint.h>
+#include <vector>
+
+#if defined(_WIN64) && !defined(__CYGWIN__)
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#include "../secp256k1/Int.h"
+
+/* Bigger ranges (in number of chunks) don't keep the visited bitmap */
+#define CHECKPOINT_MAX_BITMAP ((uint64_t)1 << 28)
+
+struct checkpoint_interval
+{
+  Int start;
+  Int end;
+};
+
+struct checkpoint
+{
+  char filename[1024];
+  Int range_start;
+  Int range_end;
+  Int chunk;
+  int random;
+  std::vector<struct checkpoint_interval> intervals;   // Sorted and merged
+  uint64_t chunks;        // Number of chunks of the range, only for the bitmap
+  uint8_t *visited;       // Chunks already finished
+  uint8_t *taken;         // Chunks finished or in process by some thread
+  uint64_t taken_count;
+#if defined(_WIN64) && !defined(__CYGWIN__)
+  HANDLE mutex;
+#else
+  pthread_mutex_t mutex;
+#endif
+};
+
+/** ***************************************************************************
+ * Initialize the checkpoint for the range [start,end) walked in chunks of
+ * 'chunk' keys. With 'random' the visited bitmap is used if the range has
+ * less than CHECKPOINT_MAX_BITMAP chunks.
+ *
+ * Return:
+ *     0 - on success
+ *     1 - on failure
+ */
+int checkpoint_init(struct checkpoint *cp, const char *filename, Int *start, Int *end, Int *chunk, int random);
+
+/** ***************************************************************************
+ * Load the checkpoint file, the range and chunk of the file must match.
+ *
+ * Return:
+ *     0   - on success
+ *     1   - the file doesn't exist
+ *     > 1 - on failure
+ */
+int checkpoint_load(struct checkpoint *cp);
+
+/** ***************************************************************************
+ * Save the checkpoint file
+ *
+ * Return:
+ *     0   - on success
+ *     > 0 - on failure
+ */
+int checkpoint_save(struct checkpoint *cp);
+
+/* Mark the chunk [from,from+chunk) as finished */
+void checkpoint_done(struct checkpoint *cp, Int *from);
+
+/* Return true if the chunk [from,from+chunk) was already finished */
+bool checkpoint_isdone(struct checkpoint *cp, Int *from);
+
+/*
+ * Random modes: set 'from' to the start of a random chunk not taken yet.
+ * Return false when all the chunks of the range are taken.
+ */
+bool checkpoint_random(struct checkpoint *cp, Int *from);
+
+/* Number of keys already finished */
+void checkpoint_total(struct checkpoint *cp, Int *total);
+
+#endif
@@ -0,0 +1,393 @@
+/*
+ * Cluster protocol between the coordinator and the keyhunt workers
+ *
+ * Refer to cluster.h for documentation on the public interfaces.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#include "cluster.h"
+
+#define CLUSTER_RECONNECT 3
+
+static int cluster_unixpath(const char *endpoint, struct sockaddr_un *address)
+{
+  if (strncmp(endpoint, "unix:", 5) != 0) {
+    return 0;
+  }
+  memset(address, 0, sizeof(struct sockaddr_un));
+  address->sun_family = AF_UNIX;
+  snprintf(address->sun_path, sizeof(address->sun_path), "%s", endpoint + 5);
+  return 1;
+}
+
+/* Split "host:port", the host is optional for listening sockets */
+static int cluster_hostport(const char *endpoint, char *host, int length, char **port)
+{
+  const char *colon = strrchr(endpoint, ':');
+  if (colon == NULL || colon - endpoint >= length) {
+    return 0;
+  }
+  memcpy(host, endpoint, colon - endpoint);
+  host[colon - endpoint] = '\0';
+  *port = (char *)colon + 1;
+  return 1;
+}
+
+int cluster_listen(const char *endpoint)
+{
+  struct sockaddr_un unix_address;
+  struct addrinfo hints, *result;
+  char host[256], *port;
+  int fd, opt = 1;
+
+  if (cluster_unixpath(endpoint, &unix_address)) {
+    unlink(unix_address.sun_path);
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+      return -1;
+    }
+    if (bind(fd, (struct sockaddr *)&unix_address, sizeof(unix_address)) < 0 || listen(fd, 64) < 0) {
+      close(fd);
+      return -1;
+    }
+    return fd;
+  }
+  if (!cluster_hostport(endpoint, host, sizeof(host), &port)) {
+    return -1;
+  }
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_flags = AI_PASSIVE;
+  if (getaddrinfo(host[0] ? host : NULL, port, &hints, &result) != 0) {
+    return -1;
+  }
+  fd = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+  if (fd < 0) {
+    freeaddrinfo(result);
+    return -1;
+  }
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+  if (bind(fd, result->ai_addr, result->ai_addrlen) < 0 || listen(fd, 64) < 0) {
+    freeaddrinfo(result);
+    close(fd);
+    return -1;
+  }
+  freeaddrinfo(result);
+  return fd;
+}
+
+int cluster_connect(const char *endpoint)
+{
+  struct sockaddr_un unix_address;
+  struct addrinfo hints, *result;
+  char host[256], *port;
+  int fd, opt = 1;
+
+  if (cluster_unixpath(endpoint, &unix_address)) {
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+      return -1;
+    }
+    if (connect(fd, (struct sockaddr *)&unix_address, sizeof(unix_address)) < 0) {
+      close(fd);
+      return -1;
+    }
+    return fd;
+  }
+  if (!cluster_hostport(endpoint, host, sizeof(host), &port) || host[0] == '\0') {
+    return -1;
+  }
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  if (getaddrinfo(host, port, &hints, &result) != 0) {
+    return -1;
+  }
+  fd = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+  if (fd < 0) {
+    freeaddrinfo(result);
+    return -1;
+  }
+  if (connect(fd, result->ai_addr, result->ai_addrlen) < 0) {
+    freeaddrinfo(result);
+    close(fd);
+    return -1;
+  }
+  freeaddrinfo(result);
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+  return fd;
+}
+
+int cluster_sendline(int fd, const char *line)
+{
+  char buffer[CLUSTER_LINE + 1];
+  int length, sent, r;
+  length = snprintf(buffer, sizeof(buffer), "%s\n", line);
+  if (length <= 0 || length > CLUSTER_LINE) {
+    return 1;
+  }
+  sent = 0;
+  while (sent < length) {
+    r = send(fd, buffer + sent, length - sent, MSG_NOSIGNAL);
+    if (r <= 0) {
+      return 1;
+    }
+    sent += r;
+  }
+  return 0;
+}
+
+int cluster_readline(int fd, char *line, int length)
+{
+  int i = 0;
+  char c;
+  while (i < length - 1) {
+    if (recv(fd, &c, 1, 0) != 1) {
+      return -1;
+    }
+    if (c == '\n') {
+      break;
+    }
+    if (c != '\r') {
+      line[i++] = c;
+    }
+  }
+  line[i] = '\0';
+  return i;
+}
+
+/* Send the request and read the reply, reconnect if the connection was lost. The caller holds the io mutex */
+static int cluster_request(struct cluster_worker *w, const char *request, char *reply)
+{
+  int tries;
+  for (tries = 0; tries <= CLUSTER_RECONNECT; tries++) {
+    if (w->fd < 0) {
+      sleep(CLUSTER_WAIT_SECONDS);
+      w->fd = cluster_connect(w->endpoint);
+      if (w->fd < 0) {
+        continue;
+      }
+    }
+    if (cluster_sendline(w->fd, request) == 0 && cluster_readline(w->fd, reply, CLUSTER_LINE) >= 0) {
+      return 0;
+    }
+    fprintf(stderr, "[W] Lost connection with the coordinator %s\n", w->endpoint);
+    close(w->fd);
+    w->fd = -1;
+  }
+  return 1;
+}
+
+/* Ask for a new lease, return 0 with a new lease, 1 on error, 2 if there is no more work, 3 to wait */
+static int cluster_newlease(struct cluster_worker *w, struct cluster_lease *lease)
+{
+  char request[CLUSTER_LINE], reply[CLUSTER_LINE];
+  char str_from[CLUSTER_LINE], str_to[CLUSTER_LINE];
+  unsigned long long id;
+  int r;
+
+  snprintf(request, sizeof(request), "LEASE %" PRIu64, w->id);
+  pthread_mutex_lock(&w->io);
+  r = cluster_request(w, request, reply);
+  pthread_mutex_unlock(&w->io);
+  if (r != 0) {
+    return 1;
+  }
+  if (strcmp(reply, "DONE") == 0) {
+    return 2;
+  }
+  if (strcmp(reply, "WAIT") == 0) {
+    return 3;
+  }
+  if (sscanf(reply, "LEASE %llu %1000s %1000s", &id, str_from, str_to) != 3) {
+    fprintf(stderr, "[E] Invalid reply from the coordinator: %s\n", reply);
+    return 1;
+  }
+  lease->id = id;
+  lease->from.SetBase16(str_from);
+  lease->cursor.Set(&lease->from);
+  lease->to.SetBase16(str_to);
+  lease->pending = 0;
+  return 0;
+}
+
+int cluster_worker_init(struct cluster_worker *w, const char *endpoint, Int *from, Int *to)
+{
+  struct cluster_lease lease;
+  char request[CLUSTER_LINE], reply[CLUSTER_LINE], host[256];
+  unsigned long long id;
+  int r;
+
+  snprintf(w->endpoint, sizeof(w->endpoint), "%s", endpoint);
+  w->done = 0;
+  w->fetching = 0;
+  w->leases.clear();
+  pthread_mutex_init(&w->mutex, NULL);
+  pthread_cond_init(&w->fetched, NULL);
+  pthread_mutex_init(&w->io, NULL);
+  w->fd = cluster_connect(endpoint);
+  if (w->fd < 0) {
+    return 1;
+  }
+  if (gethostname(host, sizeof(host)) != 0) {
+    snprintf(host, sizeof(host), "worker");
+  }
+  host[sizeof(host) - 1] = '\0';
+  snprintf(request, sizeof(request), "HELLO %s-%i", host, (int)getpid());
+  if (cluster_request(w, request, reply) != 0 || sscanf(reply, "WELCOME %llu", &id) != 1) {
+    return 1;
+  }
+  w->id = id;
+  do {
+    r = cluster_newlease(w, &lease);
+    if (r == 3) {
+      sleep(CLUSTER_WAIT_SECONDS);
+    }
+  } while (r == 3);
+  if (r == 0) {
+    w->leases.push_back(lease);
+    from->Set(&lease.from);
+    to->Set(&lease.to);
+  }
+  if (r == 2) {
+    w->done = 1;
+  }
+  return r;
+}
+
+bool cluster_nextchunk(struct cluster_worker *w, Int *chunk, Int *from, uint64_t *lease)
+{
+  struct cluster_lease *current, fetched;
+  Int end;
+  int r;
+
+  pthread_mutex_lock(&w->mutex);
+  while (!w->done) {
+    if (!w->leases.empty()) {
+      current = &w->leases.back();
+      if (current->cursor.IsLower(&current->to)) {
+        end.Set(&current->cursor);
+        end.Add(chunk);
+        if (end.IsGreater(&current->to)) {
+          /* The last chunk is moved back to end with the lease */
+          end.Set(&current->to);
+          end.Sub(chunk);
+          if (end.IsLower(&current->from)) {
+            fprintf(stderr, "[E] The lease %" PRIu64 " is smaller than the chunk of the threads, use a lower -n value in the worker\n", current->id);
+            w->done = 1;
+            break;
+          }
+          from->Set(&end);
+          current->cursor.Set(&current->to);
+        }
+        else {
+          from->Set(&current->cursor);
+          current->cursor.Set(&end);
+        }
+        current->pending++;
+        *lease = current->id;
+        pthread_mutex_unlock(&w->mutex);
+        return true;
+      }
+    }
+    if (w->fetching) {
+      pthread_cond_wait(&w->fetched, &w->mutex);
+      continue;
+    }
+    /* The other threads keep working in their chunks while this one wait for the coordinator */
+    w->fetching = 1;
+    pthread_mutex_unlock(&w->mutex);
+    r = cluster_newlease(w, &fetched);
+    if (r == 3) {
+      /* All the work is leased, maybe some lease expire later */
+      sleep(CLUSTER_WAIT_SECONDS);
+    }
+    pthread_mutex_lock(&w->mutex);
+    w->fetching = 0;
+    switch (r) {
+      case 0:
+        w->leases.push_back(fetched);
+        break;
+      case 1:
+        fprintf(stderr, "[E] Can't get a new lease from the coordinator %s\n", w->endpoint);
+        w->done = 1;
+        break;
+      case 2:
+        w->done = 1;
+        break;
+    }
+    pthread_cond_broadcast(&w->fetched);
+  }
+  pthread_cond_broadcast(&w->fetched);
+  pthread_mutex_unlock(&w->mutex);
+  return false;
+}
+
+void cluster_chunkdone(struct cluster_worker *w, uint64_t lease)
+{
+  char request[CLUSTER_LINE], reply[CLUSTER_LINE];
+  bool complete = false;
+  size_t i;
+
+  pthread_mutex_lock(&w->mutex);
+  for (i = 0; i < w->leases.size(); i++) {
+    if (w->leases[i].id == lease) {
+      w->leases[i].pending--;
+      if (w->leases[i].pending == 0 && !w->leases[i].cursor.IsLower(&w->leases[i].to)) {
+        w->leases.erase(w->leases.begin() + i);
+        complete = true;
+      }
+      break;
+    }
+  }
+  pthread_mutex_unlock(&w->mutex);
+  if (complete) {
+    snprintf(request, sizeof(request), "COMPLETE %" PRIu64 " %" PRIu64, w->id, lease);
+    pthread_mutex_lock(&w->io);
+    if (cluster_request(w, request, reply) != 0) {
+      fprintf(stderr, "[E] Can't report the lease %" PRIu64 " to the coordinator\n", lease);
+    }
+    pthread_mutex_unlock(&w->io);
+  }
+}
+
+void cluster_heartbeat(struct cluster_worker *w, Int *keys)
+{
+  char request[CLUSTER_LINE], reply[CLUSTER_LINE];
+  char *str_keys;
+
+  str_keys = keys->GetBase16();
+  snprintf(request, sizeof(request), "HEARTBEAT %" PRIu64 " %s", w->id, str_keys);
+  free(str_keys);
+  pthread_mutex_lock(&w->io);
+  if (cluster_request(w, request, reply) != 0) {
+    fprintf(stderr, "[E] Can't send the heartbeat to the coordinator\n");
+  }
+  pthread_mutex_unlock(&w->io);
+}
+
+void cluster_found(struct cluster_worker *w, Int *key)
+{
+  char request[CLUSTER_LINE], reply[CLUSTER_LINE];
+  char *str_key;
+
+  str_key = key->GetBase16();
+  snprintf(request, sizeof(request), "FOUND %" PRIu64 " %s", w->id, str_key);
+  free(str_key);
+  pthread_mutex_lock(&w->io);
+  if (cluster_request(w, request, reply) != 0) {
+    fprintf(stderr, "[E] Can't report the key found to the coordinator\n");
+  }
+  pthread_mutex_unlock(&w->io);
+}
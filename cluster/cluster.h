@@ -0,0 +1,101 @@
+/*
+ * Cluster protocol between the coordinator and the keyhunt workers
+ *
+ * The coordinator split the key range in leases and give them to the
+ * workers, every message is a single text line and every request has a
+ * single line reply:
+ *
+ *     HELLO <name>                      -> WELCOME <worker>
+ *     LEASE <worker>                    -> LEASE <lease> <from> <to> | WAIT | DONE
+ *     COMPLETE <worker> <lease>         -> OK
+ *     HEARTBEAT <worker> <keys>         -> OK | UNKNOWN
+ *     FOUND <worker> <privatekey>       -> OK
+ *
+ * <from>, <to>, <keys> and <privatekey> are hexadecimal, <keys> is the total
+ * number of keys checked by the worker since it start. The leases of a worker
+ * without heartbeat in the lease timeout are given to other workers.
+ *
+ * The endpoint is "host:port" for TCP or "unix:/path" for a Unix socket.
+ */
+
+#ifndef _CLUSTER_H
+#define _CLUSTER_H
+
+#include <stdint.h>
+#include <pthread.h>
+#include <vector>
+
+#include "../secp256k1/Int.h"
+
+#define CLUSTER_LINE 1024
+#define CLUSTER_HEARTBEAT_SECONDS 10
+#define CLUSTER_WAIT_SECONDS 5
+
+struct cluster_lease
+{
+  uint64_t id;
+  Int from;
+  Int to;
+  Int cursor;           // Start of the next chunk to give to a thread
+  uint64_t pending;     // Chunks given to threads and not finished yet
+};
+
+struct cluster_worker
+{
+  int fd;
+  uint64_t id;
+  int done;             // The coordinator doesn't have more work
+  char endpoint[256];
+  std::vector<struct cluster_lease> leases;
+  int fetching;         // A thread is asking for a new lease
+  pthread_mutex_t mutex;        // Leases
+  pthread_cond_t fetched;       // The new lease was asked
+  pthread_mutex_t io;           // Socket, it isn't held with the mutex of the leases
+};
+
+/* Open a listening socket for the endpoint, return -1 on error */
+int cluster_listen(const char *endpoint);
+
+/* Connect to the endpoint, return -1 on error */
+int cluster_connect(const char *endpoint);
+
+/* Send one line, the '\n' is added here. Return 0 on success */
+int cluster_sendline(int fd, const char *line);
+
+/*
+ * Read one line without the '\n', return the length of the line or -1 if the
+ * connection was closed or on error
+ */
+int cluster_readline(int fd, char *line, int length);
+
+/** ***************************************************************************
+ * Connect to the coordinator and take the first lease, its range is
+ * copied to 'from' and 'to'.
+ *
+ * Return:
+ *     0 - on success
+ *     1 - can't connect or protocol error
+ *     2 - the coordinator doesn't have work
+ */
+int cluster_worker_init(struct cluster_worker *w, const char *endpoint, Int *from, Int *to);
+
+/*
+ * Set 'from' to the next chunk of 'chunk' keys and 'lease' to the lease of
+ * the chunk, ask for a new lease when the current is exhausted. If the lease
+ * isn't a multiple of the chunk its last chunk is moved back to end with the
+ * lease, so some keys are checked twice but never out of the lease. Only one
+ * thread ask for the lease, the others wait for it. Return false when there
+ * is no more work or the lease is smaller than the chunk.
+ */
+bool cluster_nextchunk(struct cluster_worker *w, Int *chunk, Int *from, uint64_t *lease);
+
+/* The chunk of the lease is finished, the lease is reported with its last chunk */
+void cluster_chunkdone(struct cluster_worker *w, uint64_t lease);
+
+/* Report the total of keys checked by this worker */
+void cluster_heartbeat(struct cluster_worker *w, Int *keys);
+
+/* Report a private key found */
+void cluster_found(struct cluster_worker *w, Int *key);
+
+#endif
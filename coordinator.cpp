@@ -0,0 +1,499 @@
+/*
+Develop by Alberto
+email: albertobsd@gmail.com
+*/
+
+/*
+	Coordinator for a cluster of keyhunt workers, it split the range in leases
+	and give them to the workers started with --worker, see cluster/cluster.h
+	for the protocol.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+#include <inttypes.h>
+#include <unistd.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+
+#include "secp256k1/Int.h"
+#include "util.h"
+#include "cluster/cluster.h"
+
+#define LEASE_ACTIVE 0
+#define LEASE_DONE 1
+#define LEASE_EXPIRED 2
+
+#define DEFAULT_ENDPOINT "127.0.0.1:8090"
+#define DEFAULT_TIMEOUT 60
+
+struct lease	{
+	uint64_t id;
+	uint64_t worker;
+	int state;
+	Int from;
+	Int to;
+};
+
+struct worker	{
+	uint64_t id;
+	char name[256];
+	time_t last_seen;
+	time_t last_heartbeat;
+	Int keys;				// Keys reported in the last heartbeat
+	Int speed;				// keys/s between the last two heartbeats
+	int alive;
+};
+
+struct client	{
+	int fd;
+	int length;
+	char buffer[CLUSTER_LINE];
+};
+
+void menu();
+void process_line(int fd,char *line);
+void expire_leases(time_t now);
+void print_stats();
+bool all_done();
+struct worker *find_worker(uint64_t id);
+void checkpointer(void *ptr,const char *file,const char *function,const  char *name,int line);
+
+const char *version = "0.2.230519 Satoshi Quest";
+
+std::vector<struct lease> leases;
+std::vector<struct worker> workers;
+std::vector<size_t> requeue;		// Index in leases of the expired leases to give again
+std::vector<struct client> clients;
+
+Int n_range_start;
+Int n_range_end;
+Int LEASE_SIZE;
+Int CURSOR;
+Int keys_done;
+
+uint64_t next_lease_id = 1;
+uint64_t next_worker_id = 1;
+int LEASE_TIMEOUT = DEFAULT_TIMEOUT;
+int STATS_SECONDS = 30;
+int FLAGFINISH = 0;
+
+int main(int argc, char **argv)	{
+	struct pollfd *fds;
+	struct client new_client;
+	char *endpoint = (char*)DEFAULT_ENDPOINT;
+	char *range_start = NULL,*range_end = NULL,*str_N = NULL,*hextemp,*nl;
+	char bit_range_str_min[68],bit_range_str_max[68];
+	time_t now,last_stats;
+	int c,listen_fd,fd,r,bitrange,FLAGRANGE = 0,FLAGBITRANGE = 0;
+	size_t i,nfds;
+	Tokenizer t;
+
+	signal(SIGPIPE,SIG_IGN);
+	printf("[+] Version %s, developed by AlbertoBSD\n",version);
+
+	while ((c = getopt(argc, argv, "hb:e:l:n:r:s:")) != -1) {
+		switch(c) {
+			case 'h':
+				menu();
+			break;
+			case 'b':
+				bitrange = strtol(optarg,NULL,10);
+				if(bitrange > 0 && bitrange <=256 )	{
+					Int MPZAUX;
+					MPZAUX.SetInt32(1);
+					MPZAUX.ShiftL(bitrange-1);
+					hextemp = MPZAUX.GetBase16();
+					snprintf(bit_range_str_min,68,"%s",hextemp);
+					free(hextemp);
+					MPZAUX.SetInt32(1);
+					MPZAUX.ShiftL(bitrange);
+					hextemp = MPZAUX.GetBase16();
+					snprintf(bit_range_str_max,68,"%s",hextemp);
+					free(hextemp);
+					FLAGBITRANGE = 1;
+				}
+				else	{
+					fprintf(stderr,"[E] invalid bits param: %s.\n",optarg);
+					exit(EXIT_FAILURE);
+				}
+			break;
+			case 'e':
+				endpoint = optarg;
+			break;
+			case 'l':
+				LEASE_TIMEOUT = strtol(optarg,NULL,10);
+				if(LEASE_TIMEOUT <= 0)	{
+					LEASE_TIMEOUT = DEFAULT_TIMEOUT;
+				}
+			break;
+			case 'n':
+				str_N = optarg;
+			break;
+			case 'r':
+				stringtokenizer(optarg,&t);
+				if(t.n == 2 && isValidHex(t.tokens[0]) && isValidHex(t.tokens[1]))	{
+					range_start = strdup(t.tokens[0]);
+					range_end = strdup(t.tokens[1]);
+					FLAGRANGE = 1;
+				}
+				else	{
+					fprintf(stderr,"[E] Invalid range, use -r start:end in hexadecimal\n");
+					exit(EXIT_FAILURE);
+				}
+				freetokenizer(&t);
+			break;
+			case 's':
+				STATS_SECONDS = strtol(optarg,NULL,10);
+			break;
+			default:
+				fprintf(stderr,"[E] Unknow opcion -%c\n",c);
+				exit(EXIT_FAILURE);
+			break;
+		}
+	}
+	if(FLAGRANGE)	{
+		n_range_start.SetBase16(range_start);
+		n_range_end.SetBase16(range_end);
+	}
+	else if(FLAGBITRANGE)	{
+		n_range_start.SetBase16(bit_range_str_min);
+		n_range_end.SetBase16(bit_range_str_max);
+	}
+	else	{
+		fprintf(stderr,"[E] The coordinator needs the range, use -r or -b\n");
+		exit(EXIT_FAILURE);
+	}
+	if(!n_range_start.IsLower(&n_range_end))	{
+		fprintf(stderr,"[E] The start of the range must be lower than the end\n");
+		exit(EXIT_FAILURE);
+	}
+	if(str_N != NULL)	{
+		if(str_N[0] == '0' && str_N[1] == 'x')	{
+			LEASE_SIZE.SetBase16(str_N+2);
+		}
+		else	{
+			LEASE_SIZE.SetBase10(str_N);
+		}
+	}
+	else	{
+		LEASE_SIZE.SetInt64(0x100000000000ULL);
+	}
+	if(LEASE_SIZE.IsZero())	{
+		fprintf(stderr,"[E] Invalid lease size\n");
+		exit(EXIT_FAILURE);
+	}
+	CURSOR.Set(&n_range_start);
+	keys_done.SetInt32(0);
+
+	hextemp = n_range_start.GetBase16();
+	printf("[+] Range from : 0x%s\n",hextemp);
+	free(hextemp);
+	hextemp = n_range_end.GetBase16();
+	printf("[+] Range to   : 0x%s\n",hextemp);
+	free(hextemp);
+	hextemp = LEASE_SIZE.GetBase16();
+	printf("[+] Lease size : 0x%s, timeout %i seconds\n",hextemp,LEASE_TIMEOUT);
+	free(hextemp);
+
+	listen_fd = cluster_listen(endpoint);
+	if(listen_fd < 0)	{
+		fprintf(stderr,"[E] Can't listen in %s\n",endpoint);
+		exit(EXIT_FAILURE);
+	}
+	printf("[+] Listening in %s\n",endpoint);
+	fflush(stdout);
+
+	last_stats = time(NULL);
+	do	{
+		nfds = clients.size() + 1;
+		fds = (struct pollfd*) calloc(nfds,sizeof(struct pollfd));
+		checkpointer((void *)fds,__FILE__,"calloc","fds" ,__LINE__ -1 );
+		fds[0].fd = listen_fd;
+		fds[0].events = POLLIN;
+		for(i = 0; i < clients.size(); i++)	{
+			fds[i+1].fd = clients[i].fd;
+			fds[i+1].events = POLLIN;
+		}
+		r = poll(fds,nfds,1000);
+		if(r > 0)	{
+			for(i = clients.size(); i > 0; i--)	{
+				if(fds[i].revents == 0)	{
+					continue;
+				}
+				/* Read what is available and process the complete lines */
+				struct client *cl = &clients[i-1];
+				r = recv(cl->fd,cl->buffer + cl->length,CLUSTER_LINE - 1 - cl->length,0);
+				if(r <= 0)	{
+					close(cl->fd);
+					clients.erase(clients.begin() + (i-1));
+					continue;
+				}
+				cl->length += r;
+				cl->buffer[cl->length] = '\0';
+				while((nl = strchr(cl->buffer,'\n')) != NULL)	{
+					*nl = '\0';
+					process_line(cl->fd,cl->buffer);
+					cl->length -= (nl + 1) - cl->buffer;
+					memmove(cl->buffer,nl + 1,cl->length + 1);
+				}
+				if(cl->length == CLUSTER_LINE - 1)	{
+					fprintf(stderr,"[W] Line too long from client, closing the connection\n");
+					close(cl->fd);
+					clients.erase(clients.begin() + (i-1));
+				}
+			}
+			if(fds[0].revents & POLLIN)	{
+				fd = accept(listen_fd,NULL,NULL);
+				if(fd >= 0)	{
+					new_client.fd = fd;
+					new_client.length = 0;
+					new_client.buffer[0] = '\0';
+					clients.push_back(new_client);
+				}
+			}
+		}
+		free(fds);
+		now = time(NULL);
+		expire_leases(now);
+		if(STATS_SECONDS > 0 && now - last_stats >= STATS_SECONDS)	{
+			print_stats();
+			last_stats = now;
+		}
+		if(all_done() && !FLAGFINISH)	{
+			FLAGFINISH = 1;
+			print_stats();
+			printf("[+] All the range was processed, waiting for the workers to disconnect\n");
+			fflush(stdout);
+		}
+	}while(!FLAGFINISH || !clients.empty());
+	close(listen_fd);
+	printf("[+] End\n");
+	return 0;
+}
+
+void process_line(int fd,char *line)	{
+	char reply[CLUSTER_LINE];
+	char *str_from,*str_to;
+	struct lease new_lease;
+	struct worker new_worker;
+	struct worker *w;
+	Int keys,elapsed;
+	uint64_t id,worker_id;
+	time_t now = time(NULL);
+	size_t i;
+	FILE *keys_file;
+	Tokenizer t;
+
+	stringtokenizer(line,&t);
+	if(t.n == 0)	{
+		freetokenizer(&t);
+		return;
+	}
+	snprintf(reply,CLUSTER_LINE,"ERROR");
+	if(strcmp(t.tokens[0],"HELLO") == 0 && t.n == 2)	{
+		new_worker.id = next_worker_id++;
+		snprintf(new_worker.name,256,"%s",t.tokens[1]);
+		new_worker.last_seen = now;
+		new_worker.last_heartbeat = now;
+		new_worker.keys.SetInt32(0);
+		new_worker.speed.SetInt32(0);
+		new_worker.alive = 1;
+		workers.push_back(new_worker);
+		printf("[+] Worker %" PRIu64 " %s connected\n",new_worker.id,new_worker.name);
+		snprintf(reply,CLUSTER_LINE,"WELCOME %" PRIu64,new_worker.id);
+	}
+	else if(t.n >= 2 && (w = find_worker(strtoull(t.tokens[1],NULL,10))) != NULL)	{
+		worker_id = w->id;
+		w->last_seen = now;
+		w->alive = 1;
+		if(strcmp(t.tokens[0],"LEASE") == 0)	{
+			new_lease.worker = worker_id;
+			new_lease.state = LEASE_ACTIVE;
+			if(!requeue.empty())	{
+				new_lease.from.Set(&leases[requeue.back()].from);
+				new_lease.to.Set(&leases[requeue.back()].to);
+				requeue.pop_back();
+			}
+			else if(CURSOR.IsLower(&n_range_end))	{
+				new_lease.from.Set(&CURSOR);
+				CURSOR.Add(&LEASE_SIZE);
+				/*
+					The rest of the range is given with the last lease, so no lease
+					is smaller than LEASE_SIZE and the workers don't go out of it
+				*/
+				keys.Set(&CURSOR);
+				keys.Add(&LEASE_SIZE);
+				if(keys.IsGreater(&n_range_end))	{
+					CURSOR.Set(&n_range_end);
+				}
+				new_lease.to.Set(&CURSOR);
+			}
+			else	{
+				/* Nothing to give now, but the active leases can expire */
+				snprintf(reply,CLUSTER_LINE,all_done() ? "DONE" : "WAIT");
+				cluster_sendline(fd,reply);
+				freetokenizer(&t);
+				return;
+			}
+			new_lease.id = next_lease_id++;
+			leases.push_back(new_lease);
+			str_from = new_lease.from.GetBase16();
+			str_to = new_lease.to.GetBase16();
+			printf("[+] Lease %" PRIu64 " 0x%s:0x%s to worker %" PRIu64 "\n",new_lease.id,str_from,str_to,worker_id);
+			snprintf(reply,CLUSTER_LINE,"LEASE %" PRIu64 " %s %s",new_lease.id,str_from,str_to);
+			free(str_from);
+			free(str_to);
+		}
+		else if(strcmp(t.tokens[0],"COMPLETE") == 0 && t.n == 3)	{
+			id = strtoull(t.tokens[2],NULL,10);
+			for(i = 0; i < leases.size(); i++)	{
+				if(leases[i].id == id && leases[i].worker == worker_id && leases[i].state != LEASE_DONE)	{
+					if(leases[i].state == LEASE_EXPIRED)	{
+						/* It was late but the work is done, don't give it again */
+						for(size_t j = 0; j < requeue.size(); j++)	{
+							if(requeue[j] == i)	{
+								requeue.erase(requeue.begin() + j);
+								break;
+							}
+						}
+					}
+					leases[i].state = LEASE_DONE;
+					keys.Set(&leases[i].to);
+					keys.Sub(&leases[i].from);
+					keys_done.Add(&keys);
+					printf("[+] Lease %" PRIu64 " completed by worker %" PRIu64 "\n",id,worker_id);
+				}
+			}
+			snprintf(reply,CLUSTER_LINE,"OK");
+		}
+		else if(strcmp(t.tokens[0],"HEARTBEAT") == 0 && t.n == 3 && isValidHex(t.tokens[2]))	{
+			keys.SetBase16(t.tokens[2]);
+			if(now > w->last_heartbeat && keys.IsGreaterOrEqual(&w->keys))	{
+				w->speed.Set(&keys);
+				w->speed.Sub(&w->keys);
+				elapsed.SetInt64(now - w->last_heartbeat);
+				w->speed.Div(&elapsed);
+			}
+			w->keys.Set(&keys);
+			w->last_heartbeat = now;
+			snprintf(reply,CLUSTER_LINE,"OK");
+		}
+		else if(strcmp(t.tokens[0],"FOUND") == 0 && t.n == 3)	{
+			printf("[+] Worker %" PRIu64 " %s found the key %s\n",worker_id,w->name,t.tokens[2]);
+			keys_file = fopen("KEYFOUNDKEYFOUND.txt","a+");
+			if(keys_file != NULL)	{
+				fprintf(keys_file,"Key found by worker %s\nPrivate Key: %s\n",w->name,t.tokens[2]);
+				fclose(keys_file);
+			}
+			snprintf(reply,CLUSTER_LINE,"OK");
+		}
+	}
+	else	{
+		snprintf(reply,CLUSTER_LINE,"UNKNOWN");
+	}
+	fflush(stdout);
+	cluster_sendline(fd,reply);
+	freetokenizer(&t);
+}
+
+struct worker *find_worker(uint64_t id)	{
+	for(size_t i = 0; i < workers.size(); i++)	{
+		if(workers[i].id == id)	{
+			return &workers[i];
+		}
+	}
+	return NULL;
+}
+
+/*
+	A worker without messages in LEASE_TIMEOUT seconds is dead, all its active
+	leases are queued again to be given to other workers
+*/
+void expire_leases(time_t now)	{
+	struct worker *w;
+	for(size_t i = 0; i < workers.size(); i++)	{
+		if(workers[i].alive && now - workers[i].last_seen > LEASE_TIMEOUT)	{
+			workers[i].alive = 0;
+			workers[i].speed.SetInt32(0);
+			printf("[W] Worker %" PRIu64 " %s without heartbeat in %i seconds\n",workers[i].id,workers[i].name,LEASE_TIMEOUT);
+		}
+	}
+	for(size_t i = 0; i < leases.size(); i++)	{
+		if(leases[i].state == LEASE_ACTIVE)	{
+			w = find_worker(leases[i].worker);
+			if(w == NULL || !w->alive)	{
+				leases[i].state = LEASE_EXPIRED;
+				requeue.push_back(i);
+				printf("[W] Lease %" PRIu64 " expired, it will be given again\n",leases[i].id);
+			}
+		}
+	}
+	fflush(stdout);
+}
+
+bool all_done()	{
+	if(CURSOR.IsLower(&n_range_end) || !requeue.empty())	{
+		return false;
+	}
+	for(size_t i = 0; i < leases.size(); i++)	{
+		if(leases[i].state == LEASE_ACTIVE)	{
+			return false;
+		}
+	}
+	return true;
+}
+
+void print_stats()	{
+	Int total_speed,range;
+	char *str_speed,*str_done,*str_range;
+	int active_workers = 0,active_leases = 0;
+	for(size_t i = 0; i < workers.size(); i++)	{
+		if(workers[i].alive)	{
+			active_workers++;
+			total_speed.Add(&workers[i].speed);
+		}
+	}
+	for(size_t i = 0; i < leases.size(); i++)	{
+		if(leases[i].state == LEASE_ACTIVE)	{
+			active_leases++;
+		}
+	}
+	range.Set(&n_range_end);
+	range.Sub(&n_range_start);
+	str_speed = total_speed.GetBase10();
+	str_done = keys_done.GetBase10();
+	str_range = range.GetBase10();
+	printf("[+] Workers %i, active leases %i, done %s of %s keys, %s keys/s\n",active_workers,active_leases,str_done,str_range,str_speed);
+	fflush(stdout);
+	free(str_speed);
+	free(str_done);
+	free(str_range);
+}
+
+void checkpointer(void *ptr,const char *file,const char *function,const  char *name,int line)	{
+	if(ptr == NULL)	{
+		fprintf(stderr,"[E] error in file %s, %s pointer %s on line %i\n",file,function,name,line);
+		exit(EXIT_FAILURE);
+	}
+}
+
+void menu()	{
+	printf("\nUsage:\n");
+	printf("-h          show this help\n");
+	printf("-b bits     Range of the keys with this number of bits\n");
+	printf("-r SR:EN    StarRange:EndRange in hexadecimal\n");
+	printf("-n number   Size of each lease, a multiple of the -n value of the workers, default: 0x100000000000\n");
+	printf("-e endpoint Listen in host:port or unix:/path, default: %s\n",DEFAULT_ENDPOINT);
+	printf("-l seconds  Lease timeout, the leases of a worker without heartbeat are given to other workers, default: %i\n",DEFAULT_TIMEOUT);
+	printf("-s seconds  Stats output every s seconds, default: 30\n");
+	printf("\nExample:\n\n");
+	printf("./coordinator -b 66 -n 0x1000000000 -e 0.0.0.0:8090\n");
+	printf("./keyhunt -m address -f tests/66.txt -l compress -t 8 --worker 192.168.0.10:8090\n\n");
+	exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,110 @@
+/*
+ * Hash160 of compressed public keys
+ *
+ * Refer to hash160.h for documentation on the public interfaces.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+
+#include "hash160.h"
+#include "sha256.h"
+#include "ripemd160.h"
+#include "../include/simd_features.h"
+
+// Block of SHA256 of the compressed key, x is the 8 words of Int::bits
+#define BLOCKPREFIX(b, x, fix) \
+(b)[0] = ((x)[7] >> 8) | ((uint32_t)(fix) << 24); \
+(b)[1] = ((x)[6] >> 8) | ((x)[7] << 24); \
+(b)[2] = ((x)[5] >> 8) | ((x)[6] << 24); \
+(b)[3] = ((x)[4] >> 8) | ((x)[5] << 24); \
+(b)[4] = ((x)[3] >> 8) | ((x)[4] << 24); \
+(b)[5] = ((x)[2] >> 8) | ((x)[3] << 24); \
+(b)[6] = ((x)[1] >> 8) | ((x)[2] << 24); \
+(b)[7] = ((x)[0] >> 8) | ((x)[1] << 24); \
+(b)[8] = 0x00800000 | ((x)[0] << 24); \
+(b)[9] = 0; \
+(b)[10] = 0; \
+(b)[11] = 0; \
+(b)[12] = 0; \
+(b)[13] = 0; \
+(b)[14] = 0; \
+(b)[15] = 0x108;
+
+// The selected 8 way SHA256 and RIPEMD160 with the digests in memory
+static void hash160_8_33_separate(uint64_t **x, const uint8_t *prefix, uint8_t **h) {
+
+#ifdef WIN64
+  __declspec(align(32)) unsigned char sh[8][64];
+#else
+  unsigned char sh[8][64] __attribute__((aligned(32)));
+#endif
+  uint32_t b[8][16];
+
+  for (int i = 0; i < 8; i++) {
+    BLOCKPREFIX(b[i], (uint32_t *)x[i], prefix[i]);
+  }
+  sha256_8_1B(b[0], b[1], b[2], b[3], b[4], b[5], b[6], b[7], sh[0], sh[1], sh[2], sh[3], sh[4], sh[5], sh[6], sh[7]);
+  ripemd160_8_32(sh[0], sh[1], sh[2], sh[3], sh[4], sh[5], sh[6], sh[7], h[0], h[1], h[2], h[3], h[4], h[5], h[6], h[7]);
+
+}
+
+hash160_8way_t hash160_8_33 = hash160_8_33_separate;
+
+// Hashes per second of one 8 way function
+static double hash160_rate(hash160_8way_t f, uint64_t **x, const uint8_t *prefix) {
+
+  uint8_t d[8][20], *h[8];
+  const int rounds = 1 << 14;
+  for (int i = 0; i < 8; i++)
+    h[i] = d[i];
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (int i = 0; i < rounds; i++) {
+    f(x, prefix, h);
+    x[0][0] ^= d[0][0];
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  return seconds > 0 ? (8.0 * rounds) / seconds : 0;
+
+}
+
+int hash160_select(bool verbose) {
+
+  uint64_t limbs[8][4], *x[8];
+  uint8_t prefix[8], da[8][20], db[8][20], *ha[8], *hb[8];
+  double rate_separate, rate_avx2;
+  int i;
+
+  hash160_8_33 = hash160_8_33_separate;
+  simd_detect_features();
+  if (!simd_has_avx2()) {
+    return HASH160_BACKEND_SEPARATE;
+  }
+  for (i = 0; i < 8; i++) {
+    limbs[i][0] = 0x9e3779b97f4a7c15ULL * (i + 1);
+    limbs[i][1] = 0xbf58476d1ce4e5b9ULL * (i + 3);
+    limbs[i][2] = 0x94d049bb133111ebULL * (i + 5);
+    limbs[i][3] = 0xd6e8feb86659fd93ULL * (i + 7);
+    x[i] = limbs[i];
+    prefix[i] = 0x02 + (i & 1);
+    ha[i] = da[i];
+    hb[i] = db[i];
+  }
+  hash160_8_33_separate(x, prefix, ha);
+  hash160avx2_33(x, prefix, hb);
+  if (memcmp(da, db, sizeof(da)) != 0) {
+    fprintf(stderr, "[W] Hash160 AVX2 results don't match, using separate functions\n");
+    return HASH160_BACKEND_SEPARATE;
+  }
+  rate_separate = hash160_rate(hash160_8_33_separate, x, prefix);
+  rate_avx2 = hash160_rate(hash160avx2_33, x, prefix);
+  if (verbose)
+    printf("[+] Hash160 8 way: fused avx2 %.1f Mh/s, separate %.1f Mh/s\n", rate_avx2 / 1e6, rate_separate / 1e6);
+  if (rate_avx2 > rate_separate) {
+    hash160_8_33 = hash160avx2_33;
+    return HASH160_BACKEND_AVX2;
+  }
+  return HASH160_BACKEND_SEPARATE;
+
+}
@@ -0,0 +1,28 @@
+/*
+ * Hash160 (RIPEMD160 of SHA256) of compressed public keys from the x
+ * coordinate, the x is given as the 4 little endian limbs of Int::bits64.
+ */
+
+#ifndef HASH160_H
+#define HASH160_H
+
+#include <stdint.h>
+
+// Fused AVX2 kernel, only valid if simd_has_avx2()
+void hash160avx2_33(uint64_t **x, const uint8_t *prefix, uint8_t **h);
+
+// 8 keys, the prefix is 0x02 or 0x03 and the 20 bytes hashes are stored in h
+typedef void (*hash160_8way_t)(uint64_t **x, const uint8_t *prefix, uint8_t **h);
+extern hash160_8way_t hash160_8_33;
+
+#define HASH160_BACKEND_SEPARATE 0
+#define HASH160_BACKEND_AVX2 1
+
+/*
+ * Compare the fused kernel with sha256_8_1B followed by ripemd160_8_32, call
+ * it after sha256_select8() and ripemd160_select(). Return the backend of
+ * hash160_8_33.
+ */
+int hash160_select(bool verbose);
+
+#endif // HASH160_H
@@ -0,0 +1,521 @@
+/*
+ * Hash160 (RIPEMD160 of SHA256) of 8 compressed public keys with AVX2
+ *
+ * The message of SHA256 is built from the 32 bit words of the x coordinate
+ * (Int::bits64) without the big endian serialization, the SHA256 state is
+ * byte swapped in the registers and it's the message of RIPEMD160, nothing
+ * is stored between both hashes. The constant words of the padding are
+ * folded by the compiler.
+ *
+ * The file is compiled with -mavx2, the caller must check simd_has_avx2()
+ * before using it.
+ */
+
+#include "hash160.h"
+#include <immintrin.h>
+#include <string.h>
+#include <stdint.h>
+
+namespace _hash160avx2
+{
+
+  static const uint32_t _sha256_init[8] = {
+      0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+      0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+  };
+
+  static const uint32_t _ripemd160_init[5] = {
+      0x67452301ul, 0xEFCDAB89ul, 0x98BADCFEul, 0x10325476ul, 0xC3D2E1F0ul
+  };
+
+  // Transpose the 8x8 matrix of words, row i become the column i
+  static inline void Transpose(__m256i &r0, __m256i &r1, __m256i &r2, __m256i &r3,
+    __m256i &r4, __m256i &r5, __m256i &r6, __m256i &r7) {
+
+    __m256i t0 = _mm256_unpacklo_epi32(r0, r1);
+    __m256i t1 = _mm256_unpackhi_epi32(r0, r1);
+    __m256i t2 = _mm256_unpacklo_epi32(r2, r3);
+    __m256i t3 = _mm256_unpackhi_epi32(r2, r3);
+    __m256i t4 = _mm256_unpacklo_epi32(r4, r5);
+    __m256i t5 = _mm256_unpackhi_epi32(r4, r5);
+    __m256i t6 = _mm256_unpacklo_epi32(r6, r7);
+    __m256i t7 = _mm256_unpackhi_epi32(r6, r7);
+
+    __m256i u0 = _mm256_unpacklo_epi64(t0, t2);
+    __m256i u1 = _mm256_unpackhi_epi64(t0, t2);
+    __m256i u2 = _mm256_unpacklo_epi64(t1, t3);
+    __m256i u3 = _mm256_unpackhi_epi64(t1, t3);
+    __m256i u4 = _mm256_unpacklo_epi64(t4, t6);
+    __m256i u5 = _mm256_unpackhi_epi64(t4, t6);
+    __m256i u6 = _mm256_unpacklo_epi64(t5, t7);
+    __m256i u7 = _mm256_unpackhi_epi64(t5, t7);
+
+    r0 = _mm256_permute2x128_si256(u0, u4, 0x20);
+    r1 = _mm256_permute2x128_si256(u1, u5, 0x20);
+    r2 = _mm256_permute2x128_si256(u2, u6, 0x20);
+    r3 = _mm256_permute2x128_si256(u3, u7, 0x20);
+    r4 = _mm256_permute2x128_si256(u0, u4, 0x31);
+    r5 = _mm256_permute2x128_si256(u1, u5, 0x31);
+    r6 = _mm256_permute2x128_si256(u2, u6, 0x31);
+    r7 = _mm256_permute2x128_si256(u3, u7, 0x31);
+
+  }
+
+  // SHA256 of one block, the message words are w0..w15 and the digest is s[0..7]
+
+#define Maj(b,c,d) _mm256_or_si256(_mm256_and_si256(b, c), _mm256_and_si256(d, _mm256_or_si256(b, c)) )
+#define Ch(b,c,d)  _mm256_xor_si256(_mm256_and_si256(b, c) , _mm256_andnot_si256(b , d) )
+#define ROR(x,n)   _mm256_or_si256( _mm256_srli_epi32(x, n) , _mm256_slli_epi32(x, 32 - n) )
+#define SHR(x,n)   _mm256_srli_epi32(x, n)
+
+  /* SHA256 Functions */
+#define	S0(x) (_mm256_xor_si256(ROR((x), 2) , _mm256_xor_si256(ROR((x), 13), ROR((x), 22))))
+#define	S1(x) (_mm256_xor_si256(ROR((x), 6) , _mm256_xor_si256(ROR((x), 11), ROR((x), 25))))
+#define	s0(x) (_mm256_xor_si256(ROR((x), 7) , _mm256_xor_si256(ROR((x), 18), SHR((x), 3))))
+#define	s1(x) (_mm256_xor_si256(ROR((x), 17), _mm256_xor_si256(ROR((x), 19), SHR((x), 10))))
+
+#define add4(x0, x1, x2, x3) _mm256_add_epi32(_mm256_add_epi32(x0, x1), _mm256_add_epi32(x2, x3))
+#define add3(x0, x1, x2 ) _mm256_add_epi32(_mm256_add_epi32(x0, x1), x2)
+#define add5(x0, x1, x2, x3, x4) _mm256_add_epi32(add3(x0, x1, x2), _mm256_add_epi32(x3, x4))
+
+
+#define	Round(a, b, c, d, e, f, g, h, i, w)                 \
+    T1 = add5(h, S1(e), Ch(e, f, g), _mm256_set1_epi32(i), w);	\
+    d = _mm256_add_epi32(d, T1);                               \
+    T2 = _mm256_add_epi32(S0(a), Maj(a, b, c));                \
+    h = _mm256_add_epi32(T1, T2);
+
+#define WMIX() \
+  w0 = add4(s1(w14), w9, s0(w1), w0); \
+  w1 = add4(s1(w15), w10, s0(w2), w1); \
+  w2 = add4(s1(w0), w11, s0(w3), w2); \
+  w3 = add4(s1(w1), w12, s0(w4), w3); \
+  w4 = add4(s1(w2), w13, s0(w5), w4); \
+  w5 = add4(s1(w3), w14, s0(w6), w5); \
+  w6 = add4(s1(w4), w15, s0(w7), w6); \
+  w7 = add4(s1(w5), w0, s0(w8), w7); \
+  w8 = add4(s1(w6), w1, s0(w9), w8); \
+  w9 = add4(s1(w7), w2, s0(w10), w9); \
+  w10 = add4(s1(w8), w3, s0(w11), w10); \
+  w11 = add4(s1(w9), w4, s0(w12), w11); \
+  w12 = add4(s1(w10), w5, s0(w13), w12); \
+  w13 = add4(s1(w11), w6, s0(w14), w13); \
+  w14 = add4(s1(w12), w7, s0(w15), w14); \
+  w15 = add4(s1(w13), w8, s0(w0), w15);
+
+  static inline void Sha256(__m256i *s, __m256i w0, __m256i w1, __m256i w2, __m256i w3,
+    __m256i w4, __m256i w5, __m256i w6, __m256i w7,
+    __m256i w8, __m256i w9, __m256i w10, __m256i w11,
+    __m256i w12, __m256i w13, __m256i w14, __m256i w15) {
+
+    __m256i a,b,c,d,e,f,g,h;
+    __m256i T1, T2;
+
+    for (int i = 0; i < 8; i++)
+      s[i] = _mm256_set1_epi32(_sha256_init[i]);
+    a = s[0];
+    b = s[1];
+    c = s[2];
+    d = s[3];
+    e = s[4];
+    f = s[5];
+    g = s[6];
+    h = s[7];
+
+    Round(a, b, c, d, e, f, g, h, 0x428A2F98, w0);
+    Round(h, a, b, c, d, e, f, g, 0x71374491, w1);
+    Round(g, h, a, b, c, d, e, f, 0xB5C0FBCF, w2);
+    Round(f, g, h, a, b, c, d, e, 0xE9B5DBA5, w3);
+    Round(e, f, g, h, a, b, c, d, 0x3956C25B, w4);
+    Round(d, e, f, g, h, a, b, c, 0x59F111F1, w5);
+    Round(c, d, e, f, g, h, a, b, 0x923F82A4, w6);
+    Round(b, c, d, e, f, g, h, a, 0xAB1C5ED5, w7);
+    Round(a, b, c, d, e, f, g, h, 0xD807AA98, w8);
+    Round(h, a, b, c, d, e, f, g, 0x12835B01, w9);
+    Round(g, h, a, b, c, d, e, f, 0x243185BE, w10);
+    Round(f, g, h, a, b, c, d, e, 0x550C7DC3, w11);
+    Round(e, f, g, h, a, b, c, d, 0x72BE5D74, w12);
+    Round(d, e, f, g, h, a, b, c, 0x80DEB1FE, w13);
+    Round(c, d, e, f, g, h, a, b, 0x9BDC06A7, w14);
+    Round(b, c, d, e, f, g, h, a, 0xC19BF174, w15);
+
+    WMIX()
+
+    Round(a, b, c, d, e, f, g, h, 0xE49B69C1, w0);
+    Round(h, a, b, c, d, e, f, g, 0xEFBE4786, w1);
+    Round(g, h, a, b, c, d, e, f, 0x0FC19DC6, w2);
+    Round(f, g, h, a, b, c, d, e, 0x240CA1CC, w3);
+    Round(e, f, g, h, a, b, c, d, 0x2DE92C6F, w4);
+    Round(d, e, f, g, h, a, b, c, 0x4A7484AA, w5);
+    Round(c, d, e, f, g, h, a, b, 0x5CB0A9DC, w6);
+    Round(b, c, d, e, f, g, h, a, 0x76F988DA, w7);
+    Round(a, b, c, d, e, f, g, h, 0x983E5152, w8);
+    Round(h, a, b, c, d, e, f, g, 0xA831C66D, w9);
+    Round(g, h, a, b, c, d, e, f, 0xB00327C8, w10);
+    Round(f, g, h, a, b, c, d, e, 0xBF597FC7, w11);
+    Round(e, f, g, h, a, b, c, d, 0xC6E00BF3, w12);
+    Round(d, e, f, g, h, a, b, c, 0xD5A79147, w13);
+    Round(c, d, e, f, g, h, a, b, 0x06CA6351, w14);
+    Round(b, c, d, e, f, g, h, a, 0x14292967, w15);
+
+    WMIX()
+
+    Round(a, b, c, d, e, f, g, h, 0x27B70A85, w0);
+    Round(h, a, b, c, d, e, f, g, 0x2E1B2138, w1);
+    Round(g, h, a, b, c, d, e, f, 0x4D2C6DFC, w2);
+    Round(f, g, h, a, b, c, d, e, 0x53380D13, w3);
+    Round(e, f, g, h, a, b, c, d, 0x650A7354, w4);
+    Round(d, e, f, g, h, a, b, c, 0x766A0ABB, w5);
+    Round(c, d, e, f, g, h, a, b, 0x81C2C92E, w6);
+    Round(b, c, d, e, f, g, h, a, 0x92722C85, w7);
+    Round(a, b, c, d, e, f, g, h, 0xA2BFE8A1, w8);
+    Round(h, a, b, c, d, e, f, g, 0xA81A664B, w9);
+    Round(g, h, a, b, c, d, e, f, 0xC24B8B70, w10);
+    Round(f, g, h, a, b, c, d, e, 0xC76C51A3, w11);
+    Round(e, f, g, h, a, b, c, d, 0xD192E819, w12);
+    Round(d, e, f, g, h, a, b, c, 0xD6990624, w13);
+    Round(c, d, e, f, g, h, a, b, 0xF40E3585, w14);
+    Round(b, c, d, e, f, g, h, a, 0x106AA070, w15);
+
+    WMIX()
+
+    Round(a, b, c, d, e, f, g, h, 0x19A4C116, w0);
+    Round(h, a, b, c, d, e, f, g, 0x1E376C08, w1);
+    Round(g, h, a, b, c, d, e, f, 0x2748774C, w2);
+    Round(f, g, h, a, b, c, d, e, 0x34B0BCB5, w3);
+    Round(e, f, g, h, a, b, c, d, 0x391C0CB3, w4);
+    Round(d, e, f, g, h, a, b, c, 0x4ED8AA4A, w5);
+    Round(c, d, e, f, g, h, a, b, 0x5B9CCA4F, w6);
+    Round(b, c, d, e, f, g, h, a, 0x682E6FF3, w7);
+    Round(a, b, c, d, e, f, g, h, 0x748F82EE, w8);
+    Round(h, a, b, c, d, e, f, g, 0x78A5636F, w9);
+    Round(g, h, a, b, c, d, e, f, 0x84C87814, w10);
+    Round(f, g, h, a, b, c, d, e, 0x8CC70208, w11);
+    Round(e, f, g, h, a, b, c, d, 0x90BEFFFA, w12);
+    Round(d, e, f, g, h, a, b, c, 0xA4506CEB, w13);
+    Round(c, d, e, f, g, h, a, b, 0xBEF9A3F7, w14);
+    Round(b, c, d, e, f, g, h, a, 0xC67178F2, w15);
+
+    s[0] = _mm256_add_epi32(a, s[0]);
+    s[1] = _mm256_add_epi32(b, s[1]);
+    s[2] = _mm256_add_epi32(c, s[2]);
+    s[3] = _mm256_add_epi32(d, s[3]);
+    s[4] = _mm256_add_epi32(e, s[4]);
+    s[5] = _mm256_add_epi32(f, s[5]);
+    s[6] = _mm256_add_epi32(g, s[6]);
+    s[7] = _mm256_add_epi32(h, s[7]);
+
+  }
+
+#undef Maj
+#undef Ch
+#undef ROR
+#undef SHR
+#undef S0
+#undef S1
+#undef s0
+#undef s1
+#undef add3
+#undef add4
+#undef add5
+#undef Round
+#undef WMIX
+
+  // RIPEMD160 of 32 bytes, the message words are w[0..7] and the digest is s[0..4]
+
+#define ROL(x,n) _mm256_or_si256( _mm256_slli_epi32(x, n) , _mm256_srli_epi32(x, 32 - n) )
+
+#ifdef WIN64
+
+#define not(x) _mm256_andnot_si256(x, _mm256_cmpeq_epi32(_mm256_setzero_si256(), _mm256_setzero_si256()))
+#define f1(x,y,z) _mm256_xor_si256(x, _mm256_xor_si256(y, z))
+#define f2(x,y,z) _mm256_or_si256(_mm256_and_si256(x,y),_mm256_andnot_si256(x,z))
+#define f3(x,y,z) _mm256_xor_si256(_mm256_or_si256(x,not(y)),z)
+#define f4(x,y,z) _mm256_or_si256(_mm256_and_si256(x,z),_mm256_andnot_si256(z,y))
+#define f5(x,y,z) _mm256_xor_si256(x,_mm256_or_si256(y,not(z)))
+
+#else
+
+#define f1(x,y,z) _mm256_xor_si256(x, _mm256_xor_si256(y, z))
+#define f2(x,y,z) _mm256_or_si256(_mm256_and_si256(x,y),_mm256_andnot_si256(x,z))
+#define f3(x,y,z) _mm256_xor_si256(_mm256_or_si256(x,~(y)),z)
+#define f4(x,y,z) _mm256_or_si256(_mm256_and_si256(x,z),_mm256_andnot_si256(z,y))
+#define f5(x,y,z) _mm256_xor_si256(x,_mm256_or_si256(y,~(z)))
+
+#endif
+
+
+#define add3(x0, x1, x2 ) _mm256_add_epi32(_mm256_add_epi32(x0, x1), x2)
+#define add4(x0, x1, x2, x3) _mm256_add_epi32(_mm256_add_epi32(x0, x1), _mm256_add_epi32(x2, x3))
+
+#define Round(a,b,c,d,e,f,x,k,r) \
+  u = add4(a,f,x,_mm256_set1_epi32(k)); \
+  a = _mm256_add_epi32(ROL(u, r),e); \
+  c = ROL(c, 10);
+
+#define R11(a,b,c,d,e,x,r) Round(a, b, c, d, e, f1(b, c, d), x, 0, r)
+#define R21(a,b,c,d,e,x,r) Round(a, b, c, d, e, f2(b, c, d), x, 0x5A827999ul, r)
+#define R31(a,b,c,d,e,x,r) Round(a, b, c, d, e, f3(b, c, d), x, 0x6ED9EBA1ul, r)
+#define R41(a,b,c,d,e,x,r) Round(a, b, c, d, e, f4(b, c, d), x, 0x8F1BBCDCul, r)
+#define R51(a,b,c,d,e,x,r) Round(a, b, c, d, e, f5(b, c, d), x, 0xA953FD4Eul, r)
+#define R12(a,b,c,d,e,x,r) Round(a, b, c, d, e, f5(b, c, d), x, 0x50A28BE6ul, r)
+#define R22(a,b,c,d,e,x,r) Round(a, b, c, d, e, f4(b, c, d), x, 0x5C4DD124ul, r)
+#define R32(a,b,c,d,e,x,r) Round(a, b, c, d, e, f3(b, c, d), x, 0x6D703EF3ul, r)
+#define R42(a,b,c,d,e,x,r) Round(a, b, c, d, e, f2(b, c, d), x, 0x7A6D76E9ul, r)
+#define R52(a,b,c,d,e,x,r) Round(a, b, c, d, e, f1(b, c, d), x, 0, r)
+
+  static inline void Ripemd160(__m256i *s, __m256i *w) {
+
+    for (int i = 0; i < 5; i++)
+      s[i] = _mm256_set1_epi32(_ripemd160_init[i]);
+    __m256i a1 = s[0];
+    __m256i b1 = s[1];
+    __m256i c1 = s[2];
+    __m256i d1 = s[3];
+    __m256i e1 = s[4];
+    __m256i a2 = a1;
+    __m256i b2 = b1;
+    __m256i c2 = c1;
+    __m256i d2 = d1;
+    __m256i e2 = e1;
+    __m256i u;
+
+    w[8] = _mm256_set1_epi32(0x80);
+    w[9] = _mm256_setzero_si256();
+    w[10] = _mm256_setzero_si256();
+    w[11] = _mm256_setzero_si256();
+    w[12] = _mm256_setzero_si256();
+    w[13] = _mm256_setzero_si256();
+    w[14] = _mm256_set1_epi32(32 << 3);
+    w[15] = _mm256_setzero_si256();
+
+    R11(a1, b1, c1, d1, e1, w[0], 11);
+    R12(a2, b2, c2, d2, e2, w[5], 8);
+    R11(e1, a1, b1, c1, d1, w[1], 14);
+    R12(e2, a2, b2, c2, d2, w[14], 9);
+    R11(d1, e1, a1, b1, c1, w[2], 15);
+    R12(d2, e2, a2, b2, c2, w[7], 9);
+    R11(c1, d1, e1, a1, b1, w[3], 12);
+    R12(c2, d2, e2, a2, b2, w[0], 11);
+    R11(b1, c1, d1, e1, a1, w[4], 5);
+    R12(b2, c2, d2, e2, a2, w[9], 13);
+    R11(a1, b1, c1, d1, e1, w[5], 8);
+    R12(a2, b2, c2, d2, e2, w[2], 15);
+    R11(e1, a1, b1, c1, d1, w[6], 7);
+    R12(e2, a2, b2, c2, d2, w[11], 15);
+    R11(d1, e1, a1, b1, c1, w[7], 9);
+    R12(d2, e2, a2, b2, c2, w[4], 5);
+    R11(c1, d1, e1, a1, b1, w[8], 11);
+    R12(c2, d2, e2, a2, b2, w[13], 7);
+    R11(b1, c1, d1, e1, a1, w[9], 13);
+    R12(b2, c2, d2, e2, a2, w[6], 7);
+    R11(a1, b1, c1, d1, e1, w[10], 14);
+    R12(a2, b2, c2, d2, e2, w[15], 8);
+    R11(e1, a1, b1, c1, d1, w[11], 15);
+    R12(e2, a2, b2, c2, d2, w[8], 11);
+    R11(d1, e1, a1, b1, c1, w[12], 6);
+    R12(d2, e2, a2, b2, c2, w[1], 14);
+    R11(c1, d1, e1, a1, b1, w[13], 7);
+    R12(c2, d2, e2, a2, b2, w[10], 14);
+    R11(b1, c1, d1, e1, a1, w[14], 9);
+    R12(b2, c2, d2, e2, a2, w[3], 12);
+    R11(a1, b1, c1, d1, e1, w[15], 8);
+    R12(a2, b2, c2, d2, e2, w[12], 6);
+
+    R21(e1, a1, b1, c1, d1, w[7], 7);
+    R22(e2, a2, b2, c2, d2, w[6], 9);
+    R21(d1, e1, a1, b1, c1, w[4], 6);
+    R22(d2, e2, a2, b2, c2, w[11], 13);
+    R21(c1, d1, e1, a1, b1, w[13], 8);
+    R22(c2, d2, e2, a2, b2, w[3], 15);
+    R21(b1, c1, d1, e1, a1, w[1], 13);
+    R22(b2, c2, d2, e2, a2, w[7], 7);
+    R21(a1, b1, c1, d1, e1, w[10], 11);
+    R22(a2, b2, c2, d2, e2, w[0], 12);
+    R21(e1, a1, b1, c1, d1, w[6], 9);
+    R22(e2, a2, b2, c2, d2, w[13], 8);
+    R21(d1, e1, a1, b1, c1, w[15], 7);
+    R22(d2, e2, a2, b2, c2, w[5], 9);
+    R21(c1, d1, e1, a1, b1, w[3], 15);
+    R22(c2, d2, e2, a2, b2, w[10], 11);
+    R21(b1, c1, d1, e1, a1, w[12], 7);
+    R22(b2, c2, d2, e2, a2, w[14], 7);
+    R21(a1, b1, c1, d1, e1, w[0], 12);
+    R22(a2, b2, c2, d2, e2, w[15], 7);
+    R21(e1, a1, b1, c1, d1, w[9], 15);
+    R22(e2, a2, b2, c2, d2, w[8], 12);
+    R21(d1, e1, a1, b1, c1, w[5], 9);
+    R22(d2, e2, a2, b2, c2, w[12], 7);
+    R21(c1, d1, e1, a1, b1, w[2], 11);
+    R22(c2, d2, e2, a2, b2, w[4], 6);
+    R21(b1, c1, d1, e1, a1, w[14], 7);
+    R22(b2, c2, d2, e2, a2, w[9], 15);
+    R21(a1, b1, c1, d1, e1, w[11], 13);
+    R22(a2, b2, c2, d2, e2, w[1], 13);
+    R21(e1, a1, b1, c1, d1, w[8], 12);
+    R22(e2, a2, b2, c2, d2, w[2], 11);
+
+    R31(d1, e1, a1, b1, c1, w[3], 11);
+    R32(d2, e2, a2, b2, c2, w[15], 9);
+    R31(c1, d1, e1, a1, b1, w[10], 13);
+    R32(c2, d2, e2, a2, b2, w[5], 7);
+    R31(b1, c1, d1, e1, a1, w[14], 6);
+    R32(b2, c2, d2, e2, a2, w[1], 15);
+    R31(a1, b1, c1, d1, e1, w[4], 7);
+    R32(a2, b2, c2, d2, e2, w[3], 11);
+    R31(e1, a1, b1, c1, d1, w[9], 14);
+    R32(e2, a2, b2, c2, d2, w[7], 8);
+    R31(d1, e1, a1, b1, c1, w[15], 9);
+    R32(d2, e2, a2, b2, c2, w[14], 6);
+    R31(c1, d1, e1, a1, b1, w[8], 13);
+    R32(c2, d2, e2, a2, b2, w[6], 6);
+    R31(b1, c1, d1, e1, a1, w[1], 15);
+    R32(b2, c2, d2, e2, a2, w[9], 14);
+    R31(a1, b1, c1, d1, e1, w[2], 14);
+    R32(a2, b2, c2, d2, e2, w[11], 12);
+    R31(e1, a1, b1, c1, d1, w[7], 8);
+    R32(e2, a2, b2, c2, d2, w[8], 13);
+    R31(d1, e1, a1, b1, c1, w[0], 13);
+    R32(d2, e2, a2, b2, c2, w[12], 5);
+    R31(c1, d1, e1, a1, b1, w[6], 6);
+    R32(c2, d2, e2, a2, b2, w[2], 14);
+    R31(b1, c1, d1, e1, a1, w[13], 5);
+    R32(b2, c2, d2, e2, a2, w[10], 13);
+    R31(a1, b1, c1, d1, e1, w[11], 12);
+    R32(a2, b2, c2, d2, e2, w[0], 13);
+    R31(e1, a1, b1, c1, d1, w[5], 7);
+    R32(e2, a2, b2, c2, d2, w[4], 7);
+    R31(d1, e1, a1, b1, c1, w[12], 5);
+    R32(d2, e2, a2, b2, c2, w[13], 5);
+
+    R41(c1, d1, e1, a1, b1, w[1], 11);
+    R42(c2, d2, e2, a2, b2, w[8], 15);
+    R41(b1, c1, d1, e1, a1, w[9], 12);
+    R42(b2, c2, d2, e2, a2, w[6], 5);
+    R41(a1, b1, c1, d1, e1, w[11], 14);
+    R42(a2, b2, c2, d2, e2, w[4], 8);
+    R41(e1, a1, b1, c1, d1, w[10], 15);
+    R42(e2, a2, b2, c2, d2, w[1], 11);
+    R41(d1, e1, a1, b1, c1, w[0], 14);
+    R42(d2, e2, a2, b2, c2, w[3], 14);
+    R41(c1, d1, e1, a1, b1, w[8], 15);
+    R42(c2, d2, e2, a2, b2, w[11], 14);
+    R41(b1, c1, d1, e1, a1, w[12], 9);
+    R42(b2, c2, d2, e2, a2, w[15], 6);
+    R41(a1, b1, c1, d1, e1, w[4], 8);
+    R42(a2, b2, c2, d2, e2, w[0], 14);
+    R41(e1, a1, b1, c1, d1, w[13], 9);
+    R42(e2, a2, b2, c2, d2, w[5], 6);
+    R41(d1, e1, a1, b1, c1, w[3], 14);
+    R42(d2, e2, a2, b2, c2, w[12], 9);
+    R41(c1, d1, e1, a1, b1, w[7], 5);
+    R42(c2, d2, e2, a2, b2, w[2], 12);
+    R41(b1, c1, d1, e1, a1, w[15], 6);
+    R42(b2, c2, d2, e2, a2, w[13], 9);
+    R41(a1, b1, c1, d1, e1, w[14], 8);
+    R42(a2, b2, c2, d2, e2, w[9], 12);
+    R41(e1, a1, b1, c1, d1, w[5], 6);
+    R42(e2, a2, b2, c2, d2, w[7], 5);
+    R41(d1, e1, a1, b1, c1, w[6], 5);
+    R42(d2, e2, a2, b2, c2, w[10], 15);
+    R41(c1, d1, e1, a1, b1, w[2], 12);
+    R42(c2, d2, e2, a2, b2, w[14], 8);
+
+    R51(b1, c1, d1, e1, a1, w[4], 9);
+    R52(b2, c2, d2, e2, a2, w[12], 8);
+    R51(a1, b1, c1, d1, e1, w[0], 15);
+    R52(a2, b2, c2, d2, e2, w[15], 5);
+    R51(e1, a1, b1, c1, d1, w[5], 5);
+    R52(e2, a2, b2, c2, d2, w[10], 12);
+    R51(d1, e1, a1, b1, c1, w[9], 11);
+    R52(d2, e2, a2, b2, c2, w[4], 9);
+    R51(c1, d1, e1, a1, b1, w[7], 6);
+    R52(c2, d2, e2, a2, b2, w[1], 12);
+    R51(b1, c1, d1, e1, a1, w[12], 8);
+    R52(b2, c2, d2, e2, a2, w[5], 5);
+    R51(a1, b1, c1, d1, e1, w[2], 13);
+    R52(a2, b2, c2, d2, e2, w[8], 14);
+    R51(e1, a1, b1, c1, d1, w[10], 12);
+    R52(e2, a2, b2, c2, d2, w[7], 6);
+    R51(d1, e1, a1, b1, c1, w[14], 5);
+    R52(d2, e2, a2, b2, c2, w[6], 8);
+    R51(c1, d1, e1, a1, b1, w[1], 12);
+    R52(c2, d2, e2, a2, b2, w[2], 13);
+    R51(b1, c1, d1, e1, a1, w[3], 13);
+    R52(b2, c2, d2, e2, a2, w[13], 6);
+    R51(a1, b1, c1, d1, e1, w[8], 14);
+    R52(a2, b2, c2, d2, e2, w[14], 5);
+    R51(e1, a1, b1, c1, d1, w[11], 11);
+    R52(e2, a2, b2, c2, d2, w[0], 15);
+    R51(d1, e1, a1, b1, c1, w[6], 8);
+    R52(d2, e2, a2, b2, c2, w[3], 13);
+    R51(c1, d1, e1, a1, b1, w[15], 5);
+    R52(c2, d2, e2, a2, b2, w[9], 11);
+    R51(b1, c1, d1, e1, a1, w[13], 6);
+    R52(b2, c2, d2, e2, a2, w[11], 11);
+
+    __m256i t = s[0];
+    s[0] = add3(s[1],c1,d2);
+    s[1] = add3(s[2],d1,e2);
+    s[2] = add3(s[3],e1,a2);
+    s[3] = add3(s[4],a1,b2);
+    s[4] = add3(t,b1,c2);
+  }
+
+} // end namespace
+
+void hash160avx2_33(uint64_t **x, const uint8_t *prefix, uint8_t **h) {
+
+  __m256i v0, v1, v2, v3, v4, v5, v6, v7, p;
+  __m256i s[8], w[16];
+#ifdef WIN64
+  __declspec(align(32)) uint32_t r[5][8];
+#else
+  uint32_t r[5][8] __attribute__ ((aligned (32)));
+#endif
+
+  // v[i] is the word i of the x coordinate of each lane, the least significant is v0
+  v0 = _mm256_loadu_si256((__m256i *)x[0]);
+  v1 = _mm256_loadu_si256((__m256i *)x[1]);
+  v2 = _mm256_loadu_si256((__m256i *)x[2]);
+  v3 = _mm256_loadu_si256((__m256i *)x[3]);
+  v4 = _mm256_loadu_si256((__m256i *)x[4]);
+  v5 = _mm256_loadu_si256((__m256i *)x[5]);
+  v6 = _mm256_loadu_si256((__m256i *)x[6]);
+  v7 = _mm256_loadu_si256((__m256i *)x[7]);
+  _hash160avx2::Transpose(v0, v1, v2, v3, v4, v5, v6, v7);
+  p = _mm256_set_epi32(prefix[7], prefix[6], prefix[5], prefix[4], prefix[3], prefix[2], prefix[1], prefix[0]);
+
+  // Same block as KEYBUFFPREFIX: prefix, x in big endian, padding of 33 bytes
+  _hash160avx2::Sha256(s,
+    _mm256_or_si256(_mm256_srli_epi32(v7, 8), _mm256_slli_epi32(p, 24)),
+    _mm256_or_si256(_mm256_srli_epi32(v6, 8), _mm256_slli_epi32(v7, 24)),
+    _mm256_or_si256(_mm256_srli_epi32(v5, 8), _mm256_slli_epi32(v6, 24)),
+    _mm256_or_si256(_mm256_srli_epi32(v4, 8), _mm256_slli_epi32(v5, 24)),
+    _mm256_or_si256(_mm256_srli_epi32(v3, 8), _mm256_slli_epi32(v4, 24)),
+    _mm256_or_si256(_mm256_srli_epi32(v2, 8), _mm256_slli_epi32(v3, 24)),
+    _mm256_or_si256(_mm256_srli_epi32(v1, 8), _mm256_slli_epi32(v2, 24)),
+    _mm256_or_si256(_mm256_srli_epi32(v0, 8), _mm256_slli_epi32(v1, 24)),
+    _mm256_or_si256(_mm256_set1_epi32(0x00800000), _mm256_slli_epi32(v0, 24)),
+    _mm256_setzero_si256(), _mm256_setzero_si256(), _mm256_setzero_si256(),
+    _mm256_setzero_si256(), _mm256_setzero_si256(), _mm256_setzero_si256(),
+    _mm256_set1_epi32(0x108));
+
+  // The RIPEMD160 message is the SHA256 digest, little endian words of the big endian state
+  const __m256i bswap = _mm256_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3,
+                                        12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+  for (int i = 0; i < 8; i++)
+    w[i] = _mm256_shuffle_epi8(s[i], bswap);
+  _hash160avx2::Ripemd160(s, w);
+
+  for (int i = 0; i < 5; i++)
+    _mm256_store_si256((__m256i *)r[i], s[i]);
+  for (int j = 0; j < 8; j++) {
+    ((uint32_t *)h[j])[0] = r[0][j];
+    ((uint32_t *)h[j])[1] = r[1][j];
+    ((uint32_t *)h[j])[2] = r[2][j];
+    ((uint32_t *)h[j])[3] = r[3][j];
+    ((uint32_t *)h[j])[4] = r[4][j];
+  }
+
+}
@@ -22,6 +22,9 @@
 #include <inttypes.h>
 #include <string.h>
 #include <string>
+#include <chrono>
+
+#include "../include/simd_features.h"
 
 /// Internal RIPEMD-160 implementation.
 namespace _ripemd160 {
@@ -319,3 +322,62 @@ std::string ripemd160_hex(unsigned char *digest) {
   return std::string(buf);
 
 }
+
+// 8 hashes with two calls of the SSE function
+static void ripemd160_8_32_sse(uint8_t *i0, uint8_t *i1, uint8_t *i2, uint8_t *i3,
+  uint8_t *i4, uint8_t *i5, uint8_t *i6, uint8_t *i7,
+  uint8_t *d0, uint8_t *d1, uint8_t *d2, uint8_t *d3,
+  uint8_t *d4, uint8_t *d5, uint8_t *d6, uint8_t *d7) {
+  ripemd160sse_32(i0, i1, i2, i3, d0, d1, d2, d3);
+  ripemd160sse_32(i4, i5, i6, i7, d4, d5, d6, d7);
+}
+
+ripemd160_8way_t ripemd160_8_32 = ripemd160_8_32_sse;
+
+// Hashes per second of one 8 way function
+static double ripemd160_rate8(ripemd160_8way_t f, unsigned char (*b)[64]) {
+
+  unsigned char d[8][20];
+  const int rounds = 1 << 14;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (int i = 0; i < rounds; i++) {
+    f(b[0], b[1], b[2], b[3], b[4], b[5], b[6], b[7], d[0], d[1], d[2], d[3], d[4], d[5], d[6], d[7]);
+    b[0][0] ^= d[0][0];
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  return seconds > 0 ? (8.0 * rounds) / seconds : 0;
+
+}
+
+int ripemd160_select(bool verbose) {
+
+  unsigned char blocks[8][64], da[8][20], db[8][20];
+  double rate_sse, rate_avx2;
+  int i;
+
+  ripemd160_8_32 = ripemd160_8_32_sse;
+  simd_detect_features();
+  if (!simd_has_avx2()) {
+    return RIPEMD160_BACKEND_SSE;
+  }
+  for (i = 0; i < 8 * 64; i++)
+    blocks[i / 64][i % 64] = (unsigned char)(i * 151 + 7);
+  ripemd160_8_32_sse(blocks[0], blocks[1], blocks[2], blocks[3], blocks[4], blocks[5], blocks[6], blocks[7],
+    da[0], da[1], da[2], da[3], da[4], da[5], da[6], da[7]);
+  ripemd160avx2_32(blocks[0], blocks[1], blocks[2], blocks[3], blocks[4], blocks[5], blocks[6], blocks[7],
+    db[0], db[1], db[2], db[3], db[4], db[5], db[6], db[7]);
+  if (memcmp(da, db, sizeof(da)) != 0) {
+    fprintf(stderr, "[W] RIPEMD160 AVX2 results don't match, using sse\n");
+    return RIPEMD160_BACKEND_SSE;
+  }
+  rate_sse = ripemd160_rate8(ripemd160_8_32_sse, blocks);
+  rate_avx2 = ripemd160_rate8(ripemd160avx2_32, blocks);
+  if (verbose)
+    printf("[+] RIPEMD160 8 way: avx2 %.1f Mh/s, sse %.1f Mh/s\n", rate_avx2 / 1e6, rate_sse / 1e6);
+  if (rate_avx2 > rate_sse) {
+    ripemd160_8_32 = ripemd160avx2_32;
+    return RIPEMD160_BACKEND_AVX2;
+  }
+  return RIPEMD160_BACKEND_SSE;
+
+}
@@ -44,6 +44,25 @@ void ripemd160_32(unsigned char *input, unsigned char *digest);
 void ripemd160sse_32(uint8_t *i0, uint8_t *i1, uint8_t *i2, uint8_t *i3,
   uint8_t *d0, uint8_t *d1, uint8_t *d2, uint8_t *d3);
 void ripemd160sse_test();
+
+// AVX2 (8-way parallel), only valid if simd_has_avx2(). The input is not padded
+void ripemd160avx2_32(uint8_t *i0, uint8_t *i1, uint8_t *i2, uint8_t *i3,
+  uint8_t *i4, uint8_t *i5, uint8_t *i6, uint8_t *i7,
+  uint8_t *d0, uint8_t *d1, uint8_t *d2, uint8_t *d3,
+  uint8_t *d4, uint8_t *d5, uint8_t *d6, uint8_t *d7);
+
+// 8 hashes of 32 bytes, the input buffers must have 64 bytes for the padding
+typedef void (*ripemd160_8way_t)(uint8_t *i0, uint8_t *i1, uint8_t *i2, uint8_t *i3,
+  uint8_t *i4, uint8_t *i5, uint8_t *i6, uint8_t *i7,
+  uint8_t *d0, uint8_t *d1, uint8_t *d2, uint8_t *d3,
+  uint8_t *d4, uint8_t *d5, uint8_t *d6, uint8_t *d7);
+extern ripemd160_8way_t ripemd160_8_32;
+
+#define RIPEMD160_BACKEND_SSE 0
+#define RIPEMD160_BACKEND_AVX2 1
+
+/* Use AVX2 for ripemd160_8_32 if the CPU support it and it's faster than SSE */
+int ripemd160_select(bool verbose);
 std::string ripemd160_hex(unsigned char *digest);
 
 // AVX-512 optimized functions (8-way parallel)
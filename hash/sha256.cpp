@@ -21,7 +21,10 @@
 #include <inttypes.h>
 #include <string>
 
+#include <chrono>
+
 #include "sha256.h"
+#include "../include/simd_features.h"
 
 #define BSWAP
 
@@ -357,23 +360,33 @@ inline uint32_t _rotr(uint32_t x, uint8_t r) {
 } // namespace sha256
 
 
-////// SHA-256
+// Backend of CSHA256 and of the single hash functions
+static bool sha256_use_shani = false;
 
-class CSHA256
-{
-private:
-    uint32_t s[8];
-    unsigned char buf[64];
-    uint64_t bytes;
+sha256_4way_t sha256_1B = sha256sse_1B;
+sha256_4way_t sha256_2B = sha256sse_2B;
 
-public:
-    static const size_t OUTPUT_SIZE = 32;
+// 8 blocks with two calls of the 4 way functions
+static void sha256_8_1B_4way(uint32_t *i0, uint32_t *i1, uint32_t *i2, uint32_t *i3,
+  uint32_t *i4, uint32_t *i5, uint32_t *i6, uint32_t *i7,
+  uint8_t *d0, uint8_t *d1, uint8_t *d2, uint8_t *d3,
+  uint8_t *d4, uint8_t *d5, uint8_t *d6, uint8_t *d7) {
+  sha256_1B(i0, i1, i2, i3, d0, d1, d2, d3);
+  sha256_1B(i4, i5, i6, i7, d4, d5, d6, d7);
+}
 
-    CSHA256();
-    void Write(const unsigned char* data, size_t len);
-    void Finalize(unsigned char hash[OUTPUT_SIZE]);
+static void sha256_8_2B_4way(uint32_t *i0, uint32_t *i1, uint32_t *i2, uint32_t *i3,
+  uint32_t *i4, uint32_t *i5, uint32_t *i6, uint32_t *i7,
+  uint8_t *d0, uint8_t *d1, uint8_t *d2, uint8_t *d3,
+  uint8_t *d4, uint8_t *d5, uint8_t *d6, uint8_t *d7) {
+  sha256_2B(i0, i1, i2, i3, d0, d1, d2, d3);
+  sha256_2B(i4, i5, i6, i7, d4, d5, d6, d7);
+}
+
+sha256_8way_t sha256_8_1B = sha256_8_1B_4way;
+sha256_8way_t sha256_8_2B = sha256_8_2B_4way;
 
-};
+////// SHA-256
 
 CSHA256::CSHA256() {
     bytes = 0;
@@ -396,9 +409,18 @@ void CSHA256::Write(const unsigned char* data, size_t len)
     memcpy(buf + bufsize, data, 64 - bufsize);
     bytes += 64 - bufsize;
     data += 64 - bufsize;
-    _sha256::Transform(s, buf);
+    if (sha256_use_shani)
+      sha256shani_blocks(s, buf, 1);
+    else
+      _sha256::Transform(s, buf);
     bufsize = 0;
   }
+  if (sha256_use_shani && end >= data + 64) {
+    size_t blocks = (end - data) / 64;
+    sha256shani_blocks(s, data, blocks);
+    bytes += blocks * 64;
+    data += blocks * 64;
+  }
   while (end >= data + 64) {
     // Process full chunks directly from the source.
     _sha256::Transform(s, data);
@@ -447,7 +469,10 @@ void sha256_33(unsigned char *input, unsigned char *digest) {
   _sha256::Initialize(s);
   memcpy(input + 33, _sha256::pad, 23);
   memcpy(input + 56, sizedesc_33, 8);
-  _sha256::Transform(s, input);
+  if (sha256_use_shani)
+    sha256shani_blocks(s, input, 1);
+  else
+    _sha256::Transform(s, input);
 
   WRITEBE32(digest, s[0]);
   WRITEBE32(digest + 4, s[1]);
@@ -469,8 +494,12 @@ void sha256_65(unsigned char *input, unsigned char *digest) {
   memcpy(input + 120, sizedesc_65, 8);
 
   _sha256::Initialize(s);
-  _sha256::Transform(s, input);
-  _sha256::Transform(s, input+64);
+  if (sha256_use_shani) {
+    sha256shani_blocks(s, input, 2);
+  } else {
+    _sha256::Transform(s, input);
+    _sha256::Transform(s, input+64);
+  }
 
   WRITEBE32(digest, s[0]);
   WRITEBE32(digest + 4, s[1]);
@@ -525,3 +554,167 @@ bool sha256_file(const char* file_name, uint8_t* checksum) {
 	fclose(file);
 	return true;
 }
+
+// Hashes per second of one 4 way function
+static double sha256_rate(sha256_4way_t f, uint32_t *b) {
+
+#ifdef WIN64
+  __declspec(align(16)) unsigned char d[4][32];
+#else
+  unsigned char d[4][32] __attribute__((aligned(16)));
+#endif
+  const int rounds = 1 << 15;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (int i = 0; i < rounds; i++) {
+    f(b, b + 32, b + 64, b + 96, d[0], d[1], d[2], d[3]);
+    b[0] ^= d[0][0];  // Keep every call dependent of the previous one
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  return seconds > 0 ? (4.0 * rounds) / seconds : 0;
+
+}
+
+// Compare both backends with the same blocks
+static bool sha256_same(sha256_4way_t a, sha256_4way_t b, uint32_t *blocks) {
+
+#ifdef WIN64
+  __declspec(align(16)) unsigned char da[4][32];
+  __declspec(align(16)) unsigned char db[4][32];
+#else
+  unsigned char da[4][32] __attribute__((aligned(16)));
+  unsigned char db[4][32] __attribute__((aligned(16)));
+#endif
+  a(blocks, blocks + 32, blocks + 64, blocks + 96, da[0], da[1], da[2], da[3]);
+  b(blocks, blocks + 32, blocks + 64, blocks + 96, db[0], db[1], db[2], db[3]);
+  return memcmp(da, db, sizeof(da)) == 0;
+
+}
+
+int sha256_select(bool verbose) {
+
+  uint32_t blocks[128];
+  unsigned char digest[32], expected[32];
+  double rate_sse, rate_shani;
+  int i;
+
+  sha256_1B = sha256sse_1B;
+  sha256_2B = sha256sse_2B;
+  sha256_use_shani = false;
+  simd_detect_features();
+  if (!simd_has_sha_ni()) {
+    return SHA256_BACKEND_SSE;
+  }
+
+  // 4 streams of 2 blocks, each one with the padding of a 65 bytes message
+  for (i = 0; i < 128; i++)
+    blocks[i] = 0x9e3779b9u * (i + 1);
+  for (i = 0; i < 4; i++) {
+    blocks[i * 32 + 16] = (blocks[i * 32 + 16] & 0xff000000u) | 0x00800000u;
+    memset(&blocks[i * 32 + 17], 0, 14 * sizeof(uint32_t));
+    blocks[i * 32 + 31] = 0x208;
+  }
+  sha256((unsigned char *)"abc", 3, expected);
+  sha256_use_shani = true;
+  sha256((unsigned char *)"abc", 3, digest);
+  sha256_use_shani = false;
+  if (memcmp(digest, expected, 32) != 0 || !sha256_same(sha256sse_1B, sha256shani_1B, blocks) ||
+      !sha256_same(sha256sse_2B, sha256shani_2B, blocks)) {
+    fprintf(stderr, "[W] SHA-NI results don't match, using sse\n");
+    return SHA256_BACKEND_SSE;
+  }
+  // The single hash functions have no multi-buffer version, SHA-NI always wins
+  sha256_use_shani = true;
+
+  rate_sse = sha256_rate(sha256sse_1B, blocks);
+  rate_shani = sha256_rate(sha256shani_1B, blocks);
+  if (rate_shani > rate_sse)
+    sha256_1B = sha256shani_1B;
+  if (verbose)
+    printf("[+] SHA256 1 block: sha-ni %.1f Mh/s, sse %.1f Mh/s\n", rate_shani / 1e6, rate_sse / 1e6);
+
+  rate_sse = sha256_rate(sha256sse_2B, blocks);
+  rate_shani = sha256_rate(sha256shani_2B, blocks);
+  if (rate_shani > rate_sse)
+    sha256_2B = sha256shani_2B;
+  if (verbose)
+    printf("[+] SHA256 2 blocks: sha-ni %.1f Mh/s, sse %.1f Mh/s\n", rate_shani / 1e6, rate_sse / 1e6);
+  return sha256_1B == sha256shani_1B ? SHA256_BACKEND_SHANI : SHA256_BACKEND_SSE;
+
+}
+
+// Hashes per second of one 8 way function
+static double sha256_rate8(sha256_8way_t f, uint32_t *b) {
+
+#ifdef WIN64
+  __declspec(align(32)) unsigned char d[8][32];
+#else
+  unsigned char d[8][32] __attribute__((aligned(32)));
+#endif
+  const int rounds = 1 << 14;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (int i = 0; i < rounds; i++) {
+    f(b, b + 32, b + 64, b + 96, b + 128, b + 160, b + 192, b + 224,
+      d[0], d[1], d[2], d[3], d[4], d[5], d[6], d[7]);
+    b[0] ^= d[0][0];
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  return seconds > 0 ? (8.0 * rounds) / seconds : 0;
+
+}
+
+static bool sha256_same8(sha256_8way_t a, sha256_8way_t b, uint32_t *blocks) {
+
+#ifdef WIN64
+  __declspec(align(32)) unsigned char da[8][32];
+  __declspec(align(32)) unsigned char db[8][32];
+#else
+  unsigned char da[8][32] __attribute__((aligned(32)));
+  unsigned char db[8][32] __attribute__((aligned(32)));
+#endif
+  a(blocks, blocks + 32, blocks + 64, blocks + 96, blocks + 128, blocks + 160, blocks + 192, blocks + 224,
+    da[0], da[1], da[2], da[3], da[4], da[5], da[6], da[7]);
+  b(blocks, blocks + 32, blocks + 64, blocks + 96, blocks + 128, blocks + 160, blocks + 192, blocks + 224,
+    db[0], db[1], db[2], db[3], db[4], db[5], db[6], db[7]);
+  return memcmp(da, db, sizeof(da)) == 0;
+
+}
+
+int sha256_select8(bool verbose) {
+
+  uint32_t blocks[256];
+  double rate_4way, rate_avx2;
+  int i;
+
+  sha256_8_1B = sha256_8_1B_4way;
+  sha256_8_2B = sha256_8_2B_4way;
+  simd_detect_features();
+  if (!simd_has_avx2()) {
+    return sha256_1B == sha256shani_1B ? SHA256_BACKEND_SHANI : SHA256_BACKEND_SSE;
+  }
+
+  for (i = 0; i < 256; i++)
+    blocks[i] = 0x9e3779b9u * (i + 1);
+  if (!sha256_same8(sha256_8_1B_4way, sha256avx2_1B, blocks) ||
+      !sha256_same8(sha256_8_2B_4way, sha256avx2_2B, blocks)) {
+    fprintf(stderr, "[W] SHA256 AVX2 results don't match, using 4 way functions\n");
+    return sha256_1B == sha256shani_1B ? SHA256_BACKEND_SHANI : SHA256_BACKEND_SSE;
+  }
+
+  rate_4way = sha256_rate8(sha256_8_1B_4way, blocks);
+  rate_avx2 = sha256_rate8(sha256avx2_1B, blocks);
+  if (rate_avx2 > rate_4way)
+    sha256_8_1B = sha256avx2_1B;
+  if (verbose)
+    printf("[+] SHA256 8x1 block: avx2 %.1f Mh/s, 4 way %.1f Mh/s\n", rate_avx2 / 1e6, rate_4way / 1e6);
+
+  rate_4way = sha256_rate8(sha256_8_2B_4way, blocks);
+  rate_avx2 = sha256_rate8(sha256avx2_2B, blocks);
+  if (rate_avx2 > rate_4way)
+    sha256_8_2B = sha256avx2_2B;
+  if (verbose)
+    printf("[+] SHA256 8x2 blocks: avx2 %.1f Mh/s, 4 way %.1f Mh/s\n", rate_avx2 / 1e6, rate_4way / 1e6);
+  if (sha256_8_1B == sha256avx2_1B)
+    return SHA256_BACKEND_AVX2;
+  return sha256_1B == sha256shani_1B ? SHA256_BACKEND_SHANI : SHA256_BACKEND_SSE;
+
+}
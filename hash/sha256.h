@@ -23,6 +23,23 @@
 #include <stdint.h>
 #include <inttypes.h>
 
+/* Incremental SHA-256, for data that don't fit in a single buffer */
+class CSHA256
+{
+private:
+    uint32_t s[8];
+    unsigned char buf[64];
+    uint64_t bytes;
+
+public:
+    static const size_t OUTPUT_SIZE = 32;
+
+    CSHA256();
+    void Write(const unsigned char* data, size_t len);
+    void Finalize(unsigned char hash[OUTPUT_SIZE]);
+
+};
+
 void sha256(uint8_t *input,size_t length, uint8_t *digest);
 void sha256_33(uint8_t *input, uint8_t *digest);
 void sha256_65(uint8_t *input, uint8_t *digest);
@@ -37,6 +54,56 @@ void sha256sse_checksum(uint32_t *i0, uint32_t *i1, uint32_t *i2, uint32_t *i3,
 std::string sha256_hex(unsigned char *digest);
 void sha256sse_test();
 
+// SHA extensions (SHA-NI), only valid if simd_has_sha_ni()
+void sha256shani_blocks(uint32_t *s, const unsigned char *data, size_t blocks);
+void sha256shani_1B(uint32_t *i0, uint32_t *i1, uint32_t *i2, uint32_t *i3,
+  uint8_t *d0, uint8_t *d1, uint8_t *d2, uint8_t *d3);
+void sha256shani_2B(uint32_t *i0, uint32_t *i1, uint32_t *i2, uint32_t *i3,
+  uint8_t *d0, uint8_t *d1, uint8_t *d2, uint8_t *d3);
+
+// 4 blocks already padded, the implementation is selected by sha256_select()
+typedef void (*sha256_4way_t)(uint32_t *i0, uint32_t *i1, uint32_t *i2, uint32_t *i3,
+  uint8_t *d0, uint8_t *d1, uint8_t *d2, uint8_t *d3);
+extern sha256_4way_t sha256_1B;
+extern sha256_4way_t sha256_2B;
+
+#define SHA256_BACKEND_SSE 0
+#define SHA256_BACKEND_SHANI 1
+
+/*
+ * Detect the SHA extensions and measure them against the SSE multi-buffer
+ * functions, the fastest is used for the 1 and 2 block functions. Return
+ * the backend of sha256_1B.
+ */
+int sha256_select(bool verbose);
+
+// AVX2 (8-way parallel), only valid if simd_has_avx2()
+void sha256avx2_1B(uint32_t *i0, uint32_t *i1, uint32_t *i2, uint32_t *i3,
+  uint32_t *i4, uint32_t *i5, uint32_t *i6, uint32_t *i7,
+  uint8_t *d0, uint8_t *d1, uint8_t *d2, uint8_t *d3,
+  uint8_t *d4, uint8_t *d5, uint8_t *d6, uint8_t *d7);
+void sha256avx2_2B(uint32_t *i0, uint32_t *i1, uint32_t *i2, uint32_t *i3,
+  uint32_t *i4, uint32_t *i5, uint32_t *i6, uint32_t *i7,
+  uint8_t *d0, uint8_t *d1, uint8_t *d2, uint8_t *d3,
+  uint8_t *d4, uint8_t *d5, uint8_t *d6, uint8_t *d7);
+
+// 8 blocks already padded, the implementation is selected by sha256_select8()
+typedef void (*sha256_8way_t)(uint32_t *i0, uint32_t *i1, uint32_t *i2, uint32_t *i3,
+  uint32_t *i4, uint32_t *i5, uint32_t *i6, uint32_t *i7,
+  uint8_t *d0, uint8_t *d1, uint8_t *d2, uint8_t *d3,
+  uint8_t *d4, uint8_t *d5, uint8_t *d6, uint8_t *d7);
+extern sha256_8way_t sha256_8_1B;
+extern sha256_8way_t sha256_8_2B;
+
+#define SHA256_BACKEND_AVX2 2
+
+/*
+ * Measure the AVX2 functions against two calls of sha256_1B/sha256_2B, call
+ * it after sha256_select(). Return SHA256_BACKEND_AVX2 if sha256_8_1B use
+ * AVX2 else the backend of sha256_1B.
+ */
+int sha256_select8(bool verbose);
+
 // AVX-512 optimized functions (8-way parallel)
 #ifdef __AVX512F__
 void sha256avx512_8x(
@@ -0,0 +1,194 @@
+/*
+ * SHA256 with the x86 SHA extensions (sha256rnds2, sha256msg1, sha256msg2)
+ *
+ * The blocks of the 4-way functions use the same input as sha256sse_1B and
+ * sha256sse_2B: 16 words already padded, each word is the big endian value
+ * of 4 bytes of the message. Two independent streams are processed at the
+ * same time to hide the latency of sha256rnds2.
+ *
+ * The functions are compiled with the target attribute, the caller must
+ * check simd_has_sha_ni() before using them.
+ */
+
+#include "sha256.h"
+#include <immintrin.h>
+#include <string.h>
+#include <stdint.h>
+
+#define SHANI_TARGET __attribute__((target("sha,sse4.1,ssse3")))
+
+namespace _sha256shani
+{
+
+  static const uint32_t _init[8] = {
+      0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+      0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+  };
+
+  static const uint32_t K[64] __attribute__ ((aligned (16))) = {
+      0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+      0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+      0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+      0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+      0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+      0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+      0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+      0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+  };
+
+  // Convert the state words to the ABEF/CDGH layout of sha256rnds2
+  SHANI_TARGET static inline void Load(const uint32_t *s, __m128i &abef, __m128i &cdgh) {
+    __m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&s[0]), 0xB1);    // CDAB
+    cdgh = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&s[4]), 0x1B);           // EFGH
+    abef = _mm_alignr_epi8(tmp, cdgh, 8);                                                // ABEF
+    cdgh = _mm_blend_epi16(cdgh, tmp, 0xF0);                                             // CDGH
+  }
+
+  SHANI_TARGET static inline void Store(uint32_t *s, __m128i abef, __m128i cdgh) {
+    __m128i tmp = _mm_shuffle_epi32(abef, 0x1B);                                         // FEBA
+    cdgh = _mm_shuffle_epi32(cdgh, 0xB1);                                                // DCHG
+    _mm_storeu_si128((__m128i *)&s[0], _mm_blend_epi16(tmp, cdgh, 0xF0));                // DCBA
+    _mm_storeu_si128((__m128i *)&s[4], _mm_alignr_epi8(cdgh, tmp, 8));                   // EFGH
+  }
+
+// 4 rounds of two streams with the message words m and n, k is the index of the first round
+#define QROUND(a, c, m, b, d, n, k) \
+  k4 = _mm_load_si128((const __m128i *)&K[k]); \
+  t = _mm_add_epi32(m, k4); \
+  u = _mm_add_epi32(n, k4); \
+  c = _mm_sha256rnds2_epu32(c, a, t); \
+  d = _mm_sha256rnds2_epu32(d, b, u); \
+  a = _mm_sha256rnds2_epu32(a, c, _mm_shuffle_epi32(t, 0x0E)); \
+  b = _mm_sha256rnds2_epu32(b, d, _mm_shuffle_epi32(u, 0x0E));
+
+// Next 4 message words from W[i-4]=m0, W[i-3]=m1, W[i-2]=m2, W[i-1]=m3, stored in m0
+#define SCHEDULE(m0, m1, m2, m3) \
+  m0 = _mm_sha256msg2_epu32(_mm_add_epi32(_mm_sha256msg1_epu32(m0, m1), _mm_alignr_epi8(m3, m2, 4)), m3);
+
+#define QROUNDS(a, c, m0, m1, m2, m3, b, d, n0, n1, n2, n3, k) \
+  SCHEDULE(m0, m1, m2, m3) SCHEDULE(n0, n1, n2, n3) QROUND(a, c, m0, b, d, n0, k) \
+  SCHEDULE(m1, m2, m3, m0) SCHEDULE(n1, n2, n3, n0) QROUND(a, c, m1, b, d, n1, k + 4) \
+  SCHEDULE(m2, m3, m0, m1) SCHEDULE(n2, n3, n0, n1) QROUND(a, c, m2, b, d, n2, k + 8) \
+  SCHEDULE(m3, m0, m1, m2) SCHEDULE(n3, n0, n1, n2) QROUND(a, c, m3, b, d, n3, k + 12)
+
+/*
+ * The 64 rounds of one block of two streams. The rounds are unrolled with
+ * separate registers, with arrays the compiler may use 256/512 bit
+ * registers for the message and the legacy encoded SHA instructions after
+ * them pay the AVX/SSE transition penalty.
+ */
+#define ROUNDS(a, c, m0, m1, m2, m3, b, d, n0, n1, n2, n3) \
+  QROUND(a, c, m0, b, d, n0, 0) QROUND(a, c, m1, b, d, n1, 4) \
+  QROUND(a, c, m2, b, d, n2, 8) QROUND(a, c, m3, b, d, n3, 12) \
+  QROUNDS(a, c, m0, m1, m2, m3, b, d, n0, n1, n2, n3, 16) \
+  QROUNDS(a, c, m0, m1, m2, m3, b, d, n0, n1, n2, n3, 32) \
+  QROUNDS(a, c, m0, m1, m2, m3, b, d, n0, n1, n2, n3, 48)
+
+// The same rounds for one stream
+#define QROUND1(a, c, m, k) \
+  t = _mm_add_epi32(m, _mm_load_si128((const __m128i *)&K[k])); \
+  c = _mm_sha256rnds2_epu32(c, a, t); \
+  a = _mm_sha256rnds2_epu32(a, c, _mm_shuffle_epi32(t, 0x0E));
+
+#define QROUNDS1(a, c, m0, m1, m2, m3, k) \
+  SCHEDULE(m0, m1, m2, m3) QROUND1(a, c, m0, k) \
+  SCHEDULE(m1, m2, m3, m0) QROUND1(a, c, m1, k + 4) \
+  SCHEDULE(m2, m3, m0, m1) QROUND1(a, c, m2, k + 8) \
+  SCHEDULE(m3, m0, m1, m2) QROUND1(a, c, m3, k + 12)
+
+#define ROUNDS1(a, c, m0, m1, m2, m3) \
+  QROUND1(a, c, m0, 0) QROUND1(a, c, m1, 4) QROUND1(a, c, m2, 8) QROUND1(a, c, m3, 12) \
+  QROUNDS1(a, c, m0, m1, m2, m3, 16) \
+  QROUNDS1(a, c, m0, m1, m2, m3, 32) \
+  QROUNDS1(a, c, m0, m1, m2, m3, 48)
+
+  // One block of two streams, w0 and w1 are the 16 message words of each block
+  SHANI_TARGET static inline void Transform2(__m128i &a0, __m128i &c0, __m128i &a1, __m128i &c1, const uint32_t *w0, const uint32_t *w1) {
+    __m128i save_a0 = a0, save_c0 = c0, save_a1 = a1, save_c1 = c1;
+    __m128i k4, t, u;
+    __m128i m0 = _mm_loadu_si128((const __m128i *)(w0 + 0));
+    __m128i m1 = _mm_loadu_si128((const __m128i *)(w0 + 4));
+    __m128i m2 = _mm_loadu_si128((const __m128i *)(w0 + 8));
+    __m128i m3 = _mm_loadu_si128((const __m128i *)(w0 + 12));
+    __m128i n0 = _mm_loadu_si128((const __m128i *)(w1 + 0));
+    __m128i n1 = _mm_loadu_si128((const __m128i *)(w1 + 4));
+    __m128i n2 = _mm_loadu_si128((const __m128i *)(w1 + 8));
+    __m128i n3 = _mm_loadu_si128((const __m128i *)(w1 + 12));
+
+    ROUNDS(a0, c0, m0, m1, m2, m3, a1, c1, n0, n1, n2, n3)
+    a0 = _mm_add_epi32(a0, save_a0);
+    c0 = _mm_add_epi32(c0, save_c0);
+    a1 = _mm_add_epi32(a1, save_a1);
+    c1 = _mm_add_epi32(c1, save_c1);
+  }
+
+  // Blocks of one stream, the message are bytes
+  SHANI_TARGET static void Transform(uint32_t *s, const unsigned char *data, size_t blocks) {
+    const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+    __m128i a, c, save_a, save_c, m0, m1, m2, m3, t;
+
+    Load(s, a, c);
+    while (blocks--) {
+      save_a = a;
+      save_c = c;
+      m0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 0)), mask);
+      m1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 16)), mask);
+      m2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 32)), mask);
+      m3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 48)), mask);
+      ROUNDS1(a, c, m0, m1, m2, m3)
+      a = _mm_add_epi32(a, save_a);
+      c = _mm_add_epi32(c, save_c);
+      data += 64;
+    }
+    Store(s, a, c);
+  }
+
+  // Big endian digest of the ABEF/CDGH state, only 128 bit registers are used
+  // to avoid the AVX/SSE transition penalty of the legacy SHA instructions
+  SHANI_TARGET static inline void Digest(__m128i abef, __m128i cdgh, unsigned char *d) {
+    const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+    __m128i tmp = _mm_shuffle_epi32(abef, 0x1B);                                         // FEBA
+    cdgh = _mm_shuffle_epi32(cdgh, 0xB1);                                                // DCHG
+    _mm_storeu_si128((__m128i *)d, _mm_shuffle_epi8(_mm_blend_epi16(tmp, cdgh, 0xF0), mask));
+    _mm_storeu_si128((__m128i *)(d + 16), _mm_shuffle_epi8(_mm_alignr_epi8(cdgh, tmp, 8), mask));
+  }
+
+}
+
+void sha256shani_blocks(uint32_t *s, const unsigned char *data, size_t blocks) {
+  _sha256shani::Transform(s, data, blocks);
+}
+
+SHANI_TARGET void sha256shani_1B(uint32_t *i0, uint32_t *i1, uint32_t *i2, uint32_t *i3,
+  uint8_t *d0, uint8_t *d1, uint8_t *d2, uint8_t *d3) {
+
+  __m128i a0, c0, a1, c1, a2, c2, a3, c3;
+  _sha256shani::Load(_sha256shani::_init, a0, c0);
+  a1 = a2 = a3 = a0;
+  c1 = c2 = c3 = c0;
+  _sha256shani::Transform2(a0, c0, a1, c1, i0, i1);
+  _sha256shani::Transform2(a2, c2, a3, c3, i2, i3);
+  _sha256shani::Digest(a0, c0, d0);
+  _sha256shani::Digest(a1, c1, d1);
+  _sha256shani::Digest(a2, c2, d2);
+  _sha256shani::Digest(a3, c3, d3);
+
+}
+
+SHANI_TARGET void sha256shani_2B(uint32_t *i0, uint32_t *i1, uint32_t *i2, uint32_t *i3,
+  uint8_t *d0, uint8_t *d1, uint8_t *d2, uint8_t *d3) {
+
+  __m128i a0, c0, a1, c1, a2, c2, a3, c3;
+  _sha256shani::Load(_sha256shani::_init, a0, c0);
+  a1 = a2 = a3 = a0;
+  c1 = c2 = c3 = c0;
+  _sha256shani::Transform2(a0, c0, a1, c1, i0, i1);
+  _sha256shani::Transform2(a2, c2, a3, c3, i2, i3);
+  _sha256shani::Transform2(a0, c0, a1, c1, i0 + 16, i1 + 16);
+  _sha256shani::Transform2(a2, c2, a3, c3, i2 + 16, i3 + 16);
+  _sha256shani::Digest(a0, c0, d0);
+  _sha256shani::Digest(a1, c1, d1);
+  _sha256shani::Digest(a2, c2, d2);
+  _sha256shani::Digest(a3, c3, d3);
+
+}
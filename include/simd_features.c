@@ -73,6 +73,7 @@ void simd_detect_features(void) {
     g_cpu_features.avx512cd = (info[1] & (1 << 28)) != 0;
     g_cpu_features.avx512bw = (info[1] & (1 << 30)) != 0;
     g_cpu_features.avx512vl = (info[1] & (1 << 31)) != 0;
+    g_cpu_features.sha_ni = (info[1] & (1 << 29)) != 0;
     
     // ECX features (info[2])
     g_cpu_features.avx512vnni = (info[2] & (1 << 11)) != 0;
@@ -132,6 +133,10 @@ void simd_detect_features(void) {
     #if defined(__AVX512VL__)
     g_cpu_features.avx512vl = true;
     #endif
+    
+    #if defined(__SHA__)
+    g_cpu_features.sha_ni = true;
+    #endif
 }
 
 #endif  // HAS_CPUID
@@ -156,6 +161,10 @@ bool simd_has_avx512_full(void) {
            g_cpu_features.avx512vl;
 }
 
+bool simd_has_sha_ni(void) {
+    return g_cpu_features.sha_ni;
+}
+
 bool simd_is_zen5(void) {
     return g_cpu_features.is_zen5;
 }
@@ -175,6 +184,7 @@ void simd_print_features(void) {
     printf("  AVX-512BW: %s\n", g_cpu_features.avx512bw ? "Yes" : "No");
     printf("  AVX-512VL: %s\n", g_cpu_features.avx512vl ? "Yes" : "No");
     printf("  AVX-512 Full: %s\n", simd_has_avx512_full() ? "Yes" : "No");
+    printf("  SHA-NI: %s\n", g_cpu_features.sha_ni ? "Yes" : "No");
 }
 
 #ifdef SIMD_TEST_MAIN
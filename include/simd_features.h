@@ -26,6 +26,7 @@ typedef struct {
     bool avx512cd;       // AVX-512 Conflict Detection
     bool avx512vnni;     // AVX-512 Vector Neural Network Instructions
     bool avx512bf16;     // AVX-512 BFLOAT16 Instructions
+    bool sha_ni;         // SHA extensions (sha256rnds2, sha256msg1/2)
     bool is_zen5;        // AMD Zen5 architecture detected
     bool is_intel;
     bool is_amd;
@@ -42,6 +43,7 @@ bool simd_has_sse2(void);
 bool simd_has_avx2(void);
 bool simd_has_avx512f(void);
 bool simd_has_avx512_full(void);  // Checks for F+DQ+BW+VL
+bool simd_has_sha_ni(void);
 bool simd_is_zen5(void);
 
 // Print detected features (for debugging)
@@ -0,0 +1,208 @@
+/*
+ * Distinguished points table for the kangaroo mode of keyhunt
+ *
+ * Refer to dptable.h for documentation on the public interfaces.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dptable.h"
+#include "../hash/sha256.h"
+#include "../util.h"
+
+#define DPTABLE_MAGIC "KHDPTBL1"
+#define DPTABLE_CHUNK 65536
+
+struct dpheader
+{
+  char magic[8];
+  uint32_t dpbits;
+  uint32_t jumpbits;
+  uint64_t count;
+};
+
+int dptable_init(struct dptable *dp, uint64_t entries, uint32_t dpbits, uint32_t jumpbits)
+{
+  memset(dp, 0, sizeof(struct dptable));
+  dp->slots = 65536;
+  while (dp->slots < entries * 2) {
+    dp->slots <<= 1;
+  }
+  dp->mask = dp->slots - 1;
+  dp->limit = dp->slots - (dp->slots >> 3);
+  dp->dpbits = dpbits;
+  dp->jumpbits = jumpbits;
+  dp->table = (struct dpentry *)calloc(dp->slots, sizeof(struct dpentry));
+  if (dp->table == NULL) {
+    return 1;
+  }
+  return 0;
+}
+
+int dptable_add(struct dptable *dp, uint64_t x, uint64_t owner, const uint64_t *distance, struct dpentry *collision)
+{
+  struct dpentry *entry;
+  uint64_t slot, current, expected, entry_owner;
+  if (x == 0) {
+    x = 1;   // 0 is reserved for empty slots
+  }
+  if (__atomic_load_n(&dp->entries, __ATOMIC_RELAXED) >= dp->limit) {
+    return DPTABLE_FULL;
+  }
+  slot = x & dp->mask;
+  for (;;) {
+    entry = &dp->table[slot];
+    current = __atomic_load_n(&entry->x, __ATOMIC_ACQUIRE);
+    if (current == 0) {
+      expected = 0;
+      if (__atomic_compare_exchange_n(&entry->x, &expected, x, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        memcpy(entry->distance, distance, sizeof(entry->distance));
+        __atomic_store_n(&entry->owner, owner, __ATOMIC_RELEASE);
+        __atomic_fetch_add(&dp->entries, 1, __ATOMIC_RELAXED);
+        return DPTABLE_ADDED;
+      }
+      current = expected;   // Other thread took the slot first
+    }
+    if (current == x) {
+      do {
+        entry_owner = __atomic_load_n(&entry->owner, __ATOMIC_ACQUIRE);
+      } while (entry_owner == 0);
+      collision->x = x;
+      collision->owner = entry_owner;
+      memcpy(collision->distance, entry->distance, sizeof(entry->distance));
+      return DPTABLE_COLLISION;
+    }
+    slot = (slot + 1) & dp->mask;
+  }
+}
+
+int dptable_save(struct dptable *dp, const char *filename)
+{
+  struct dpheader header;
+  struct dpentry entry;
+  uint8_t checksum[32];
+  char tmpname[1024];
+  uint64_t i;
+  FILE *fd;
+  CSHA256 sha;
+
+  snprintf(tmpname, sizeof(tmpname), "%s.tmp", filename);
+  fd = fopen(tmpname, "wb");
+  if (fd == NULL) {
+    return 1;
+  }
+  memcpy(header.magic, DPTABLE_MAGIC, 8);
+  header.dpbits = dp->dpbits;
+  header.jumpbits = dp->jumpbits;
+  header.count = 0;
+  if (fwrite(&header, sizeof(struct dpheader), 1, fd) != 1) {
+    fclose(fd);
+    return 2;
+  }
+  for (i = 0; i < dp->slots; i++) {
+    entry.owner = __atomic_load_n(&dp->table[i].owner, __ATOMIC_ACQUIRE);
+    if (entry.owner == 0) {
+      continue;
+    }
+    entry.x = dp->table[i].x;
+    memcpy(entry.distance, dp->table[i].distance, sizeof(entry.distance));
+    if (fwrite(&entry, sizeof(struct dpentry), 1, fd) != 1) {
+      fclose(fd);
+      return 2;
+    }
+    sha.Write((unsigned char *)&entry, sizeof(struct dpentry));
+    header.count++;
+  }
+  sha.Finalize(checksum);
+  if (fwrite(checksum, 32, 1, fd) != 1) {
+    fclose(fd);
+    return 2;
+  }
+  /* Now we know the real number of entries */
+  if (fseek(fd, 0, SEEK_SET) != 0 || fwrite(&header, sizeof(struct dpheader), 1, fd) != 1 || syncfile(fd) != 0) {
+    fclose(fd);
+    return 2;
+  }
+  if (fclose(fd) != 0) {
+    return 2;
+  }
+#if defined(_WIN64) && !defined(__CYGWIN__)
+  remove(filename);
+#endif
+  if (rename(tmpname, filename) != 0 || syncdir(filename) != 0) {
+    return 3;
+  }
+  return 0;
+}
+
+int dptable_load(struct dptable *dp, const char *filename, dptable_callback callback)
+{
+  struct dpheader header;
+  struct dpentry *buffer;
+  uint8_t checksum[32], checksum_file[32];
+  uint64_t readed, chunk, i;
+  FILE *fd;
+  CSHA256 sha;
+  int pass, rv = 0;
+
+  fd = fopen(filename, "rb");
+  if (fd == NULL) {
+    return 1;
+  }
+  if (fread(&header, sizeof(struct dpheader), 1, fd) != 1 || memcmp(header.magic, DPTABLE_MAGIC, 8) != 0) {
+    fclose(fd);
+    return 2;
+  }
+  if (header.dpbits != dp->dpbits || header.jumpbits != dp->jumpbits) {
+    fclose(fd);
+    return 3;
+  }
+  buffer = (struct dpentry *)malloc(DPTABLE_CHUNK * sizeof(struct dpentry));
+  if (buffer == NULL) {
+    fclose(fd);
+    return 4;
+  }
+  /* The first pass only checks the file, no entry of a damaged file is given to the callback */
+  for (pass = 0; pass < 2 && rv == 0; pass++) {
+    if (pass == 1 && fseek(fd, sizeof(struct dpheader), SEEK_SET) != 0) {
+      rv = 5;
+    }
+    readed = 0;
+    while (readed < header.count && rv == 0) {
+      chunk = (header.count - readed > DPTABLE_CHUNK) ? DPTABLE_CHUNK : header.count - readed;
+      if (fread(buffer, sizeof(struct dpentry), chunk, fd) != chunk) {
+        rv = 5;
+      }
+      else {
+        if (pass == 0) {
+          sha.Write((unsigned char *)buffer, chunk * sizeof(struct dpentry));
+        }
+        else {
+          for (i = 0; i < chunk; i++) {
+            callback(&buffer[i]);
+          }
+        }
+        readed += chunk;
+      }
+    }
+    if (pass == 0 && rv == 0) {
+      sha.Finalize(checksum);
+      if (fread(checksum_file, 32, 1, fd) != 1 || memcmp(checksum, checksum_file, 32) != 0) {
+        rv = 6;
+      }
+    }
+  }
+  free(buffer);
+  fclose(fd);
+  return rv;
+}
+
+void dptable_free(struct dptable *dp)
+{
+  free(dp->table);
+  dp->table = NULL;
+  dp->entries = 0;
+}
@@ -0,0 +1,83 @@
+/*
+ * Distinguished points table for the kangaroo mode of keyhunt
+ *
+ * Open addressing hash table, threads insert into it without locks: the
+ * slot is claimed with a compare and swap over the X value and the owner
+ * is published last, so a reader never sees a half written entry.
+ */
+
+#ifndef _DPTABLE_H
+#define _DPTABLE_H
+
+#include <stdint.h>
+
+#define DPTABLE_TAME 1
+
+#define DPTABLE_ADDED 0
+#define DPTABLE_COLLISION 1
+#define DPTABLE_FULL -1
+
+struct dpentry
+{
+  uint64_t x;             // 64 bits of the X value of the point, 0 is an empty slot
+  uint64_t owner;         // 0 while the entry is being written, DPTABLE_TAME or the id of the wild target
+  uint64_t distance[3];   // 192 bits distance walked by the kangaroo
+};
+
+struct dptable
+{
+  uint64_t slots;         // Always a power of two
+  uint64_t mask;
+  uint64_t limit;         // Max number of entries before the table is considered full
+  uint64_t entries;
+  uint32_t dpbits;
+  uint32_t jumpbits;
+  struct dpentry *table;
+};
+
+typedef void (*dptable_callback)(struct dpentry *entry);
+
+/** ***************************************************************************
+ * Initialize the table for at least the given number of entries.
+ *
+ * Return:
+ *     0 - on success
+ *     1 - on failure
+ */
+int dptable_init(struct dptable *dp, uint64_t entries, uint32_t dpbits, uint32_t jumpbits);
+
+/** ***************************************************************************
+ * Add a distinguished point to the table, safe to call from many threads.
+ *
+ * Return:
+ *     DPTABLE_ADDED     - the point was added
+ *     DPTABLE_COLLISION - the X value was already in the table, the stored
+ *                         entry is copied into 'collision'
+ *     DPTABLE_FULL      - there is no more room in the table
+ */
+int dptable_add(struct dptable *dp, uint64_t x, uint64_t owner, const uint64_t *distance, struct dpentry *collision);
+
+/** ***************************************************************************
+ * Save all the entries of the table into a file, the file is written with a
+ * temporary name and renamed at the end, so a previous file is never lost.
+ *
+ * Return:
+ *     0   - on success
+ *     > 0 - on failure
+ */
+int dptable_save(struct dptable *dp, const char *filename);
+
+/** ***************************************************************************
+ * Read a file previously saved with dptable_save() and call 'callback' for
+ * every entry on it, only after the checksum of the whole file is verified.
+ * The dpbits and jumpbits of the file must match the ones of the table.
+ *
+ * Return:
+ *     0   - on success
+ *     > 0 - on failure
+ */
+int dptable_load(struct dptable *dp, const char *filename, dptable_callback callback);
+
+void dptable_free(struct dptable *dp);
+
+#endif
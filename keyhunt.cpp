@@ -9,12 +9,21 @@ email: albertobsd@gmail.com
 #include <string.h>
 #include <math.h>
 #include <time.h>
+#include <chrono>
 #include <vector>
+#include <algorithm>
 #include <inttypes.h>
 #include "base58/libbase58.h"
 #include "rmd160/rmd160.h"
 #include "oldbloom/oldbloom.h"
 #include "bloom/bloom.h"
+#include "kangaroo/dptable.h"
+#include "checkpoint/checkpoint.h"
+#include "cluster/cluster.h"
+#include "metrics/metrics.h"
+#include "affinity/affinity.h"
+#include "autotune/autotune.h"
+#include "results/results.h"
 #include "sha3/sha3.h"
 #include "util.h"
 
@@ -26,12 +35,15 @@ email: albertobsd@gmail.com
 
 #include "hash/sha256.h"
 #include "hash/ripemd160.h"
+#include "hash/hash160.h"
 
 #if defined(_WIN64) && !defined(__CYGWIN__)
 #include "getopt.h"
 #include <windows.h>
 #else
 #include <unistd.h>
+#include <fcntl.h>
+#include <getopt.h>
 #include <pthread.h>
 #include <sys/random.h>
 #endif
@@ -55,6 +67,7 @@ email: albertobsd@gmail.com
 #define MODE_PUB2RMD 4
 #define MODE_MINIKEYS 5
 #define MODE_VANITY 6
+#define MODE_KANGAROO 7
 
 #define SEARCH_UNCOMPRESS 0
 #define SEARCH_COMPRESS 1
@@ -67,7 +80,22 @@ struct checksumsha256	{
 	char backup[32];
 };
 
+/*
+	bP table entry: 6 bytes of the X value and the 40 bit index of the point,
+	packed to 11 bytes per entry without padding.
+*/
+#define BSGS_XINDEX_BYTES 5
+#define BSGS_XINDEX_MAX 0xFFFFFFFFFFULL
+
+#pragma pack(push,1)
 struct bsgs_xvalue	{
+	uint8_t value[6];
+	uint8_t index[BSGS_XINDEX_BYTES];
+};
+#pragma pack(pop)
+
+/* Entry of the old keyhunt_bsgs_2_*.tbl files, only used to migrate them */
+struct bsgs_xvalue_v2	{
 	uint8_t value[6];
 	uint64_t index;
 };
@@ -82,6 +110,16 @@ struct tothread {
 	char *rpt;  //rng per thread
 };
 
+/*
+	Walker of the sequential modes, the points of a chunk are only computed
+	with point additions, the key is rebuilt from the base and the offset
+	when it is needed.
+*/
+struct group_walker	{
+	Int base;			// First key of the chunk
+	uint64_t offset;	// Keys walked from the base
+};
+
 struct bPload	{
 	uint32_t threadid;
 	uint64_t from;
@@ -155,11 +193,16 @@ void bsgs_heapify(struct bsgs_xvalue *arr, int64_t n, int64_t i);
 int64_t bsgs_partition(struct bsgs_xvalue *arr, int64_t n);
 
 int bsgs_searchbinary(struct bsgs_xvalue *arr,char *data,int64_t array_length,uint64_t *r_value);
-int bsgs_secondcheck(Int *start_range,uint32_t a,uint32_t k_index,Int *privatekey);
-int bsgs_thirdcheck(Int *start_range,uint32_t a,uint32_t k_index,Int *privatekey);
+void bsgs_setindex(struct bsgs_xvalue *entry,uint64_t index);
+uint64_t bsgs_getindex(struct bsgs_xvalue *entry);
+int bsgs_secondcheck(struct worker_context *ctx,Int *base_key,Int *x,bool *equal,uint32_t k_index,Int *privatekey);
+int bsgs_checkqueue(struct worker_context *ctx,Int *start_range,uint32_t *queue,uint32_t length,uint32_t k_index,Int *privatekey);
+void bsgs_batchx(IntGroup *grp,Int *dx,Point *Q,int n,int size,std::vector<Point> &AMP,Int *x,bool *equal);
+int bsgs_thirdcheck(struct worker_context *ctx,Int *start_range,uint32_t a,uint32_t k_index,Int *privatekey);
+void bsgs_foundkey(Int *keyfound,uint32_t k);
 
 void sha256sse_22(uint8_t *src0, uint8_t *src1, uint8_t *src2, uint8_t *src3, uint8_t *dst0, uint8_t *dst1, uint8_t *dst2, uint8_t *dst3);
-void sha256sse_23(uint8_t *src0, uint8_t *src1, uint8_t *src2, uint8_t *src3, uint8_t *dst0, uint8_t *dst1, uint8_t *dst2, uint8_t *dst3);
+void sha256sse_23(uint8_t *src0, uint8_t *src1, uint8_t *src2, uint8_t *src3, uint8_t *src4, uint8_t *src5, uint8_t *src6, uint8_t *src7, uint8_t *dst0, uint8_t *dst1, uint8_t *dst2, uint8_t *dst3, uint8_t *dst4, uint8_t *dst5, uint8_t *dst6, uint8_t *dst7);
 
 bool vanityrmdmatch(unsigned char *rmdhash);
 void writevanitykey(bool compress,Int *key);
@@ -167,7 +210,14 @@ int addvanity(char *target);
 int minimum_same_bytes(unsigned char* A,unsigned char* B, int length);
 
 void writekey(bool compressed,Int *key);
+
+void walker_start(struct group_walker *w,Int *base,Point *center);
+void walker_key(struct group_walker *w,uint64_t k,Int *key);
+bool walker_check(struct group_walker *w,Point *center);
 void writekeyeth(Int *key);
+void results_begin();
+void results_hit(int kind,bool compressed,Int *key,uint32_t target);
+void results_text(struct results_record *record,struct results_output *output);
 
 void checkpointer(void *ptr,const char *file,const char *function,const  char *name,int line);
 
@@ -181,15 +231,49 @@ bool forceReadFileAddressEth(char *fileName);
 bool forceReadFileXPoint(char *fileName);
 bool processOneVanity();
 
-bool initBloomFilter(struct bloom *bloom_arg,uint64_t items_bloom);
+bool initBloomFilter(struct bloom *bloom_arg,uint64_t items_bloom,uint8_t mode);
+bool initPrefilter(struct bloom_prefilter *prefilter_arg,uint64_t items,uint64_t filter_bytes);
+bool readPrefilterFile(struct bloom_prefilter *prefilter_arg,const char *fileName);
+void writePrefilterFile(struct bloom_prefilter *prefilter_arg,const char *fileName);
+bool bsgs_progress_load(uint8_t *done,uint64_t chunks);
+void bsgs_progress_save(uint8_t *done,uint64_t chunks);
+bool bsgs_disktable_open(const char *fileName);
+int bsgs_searchdisk(char *data,uint64_t *r_value);
 
 void writeFileIfNeeded(const char *fileName);
 
 void calcualteindex(int i,Int *key);
+
+void kangaroo_init();
+void kangaroo_spawn(Point *kangaroo,Int *distance,int target);
+int kangaroo_dp(uint64_t x,uint64_t owner,Int *distance);
+int kangaroo_target(uint64_t owner);
+bool kangaroo_solve(Int *tame,Int *wild,int target);
+void kangaroo_loadentry(struct dpentry *entry);
+void kangaroo_savefile();
+
+void init_checkpoint(const char *fileName,Int *chunk);
+void save_checkpoint();
+
+void get_total_keys(Int *total);
+void get_step_keys(Int *keys);
+const struct bench_mode *bench_find(const char *name);
+bool bench_measure(const struct bench_mode *bench,const char *program,int threads,int seconds,double *thread_rate);
+double bench_scale(double rate,int *prefix);
+void bench_sweep(const char *program,const char *mode);
+void autotune(const char *program);
+void bench_report(uint64_t second);
+void profile_print();
+void worker_alloc(struct worker_context *ctx,int group,int points,int queue);
+void worker_alloc_xy(struct worker_context *ctx,int points,bool with_y);
+void worker_place();
+void worker_pin(struct worker_context *ctx);
+void stats_collect(struct metrics_snapshot *snapshot,uint64_t second,Int *total);
+void stats_print(struct metrics_snapshot *snapshot);
+void stats_printbase();
 #if defined(_WIN64) && !defined(__CYGWIN__)
 DWORD WINAPI thread_process_vanity(LPVOID vargp);
 DWORD WINAPI thread_process_minikeys(LPVOID vargp);
-DWORD WINAPI thread_process(LPVOID vargp);
 DWORD WINAPI thread_process_bsgs(LPVOID vargp);
 DWORD WINAPI thread_process_bsgs_backward(LPVOID vargp);
 DWORD WINAPI thread_process_bsgs_both(LPVOID vargp);
@@ -197,10 +281,10 @@ DWORD WINAPI thread_process_bsgs_random(LPVOID vargp);
 DWORD WINAPI thread_process_bsgs_dance(LPVOID vargp);
 DWORD WINAPI thread_bPload(LPVOID vargp);
 DWORD WINAPI thread_bPload_2blooms(LPVOID vargp);
+DWORD WINAPI thread_process_kangaroo(LPVOID vargp);
 #else
 void *thread_process_vanity(void *vargp);
 void *thread_process_minikeys(void *vargp);	
-void *thread_process(void *vargp);
 void *thread_process_bsgs(void *vargp);
 void *thread_process_bsgs_backward(void *vargp);
 void *thread_process_bsgs_both(void *vargp);
@@ -208,7 +292,21 @@ void *thread_process_bsgs_random(void *vargp);
 void *thread_process_bsgs_dance(void *vargp);
 void *thread_bPload(void *vargp);
 void *thread_bPload_2blooms(void *vargp);
+void *thread_process_kangaroo(void *vargp);
+#endif
+
+#if defined(_WIN64) && !defined(__CYGWIN__)
+typedef DWORD (WINAPI *thread_function)(LPVOID);
+#else
+typedef void *(*thread_function)(void *);
+#endif
+template<int MODE,int CRYPTO,int SEARCH,bool ENDOMORPHISM,bool EXACT>
+#if defined(_WIN64) && !defined(__CYGWIN__)
+DWORD WINAPI thread_process(LPVOID vargp);
+#else
+void *thread_process(void *vargp);
 #endif
+thread_function thread_process_select();
 
 char *pubkeytopubaddress(char *pkey,int length);
 void pubkeytopubaddress_dst(char *pkey,int length,char *dst);
@@ -220,12 +318,11 @@ void increment_minikey_N(char *rawbuffer);
 void KECCAK_256(uint8_t *source, size_t size,uint8_t *dst);
 void generate_binaddress_eth(Point &publickey,unsigned char *dst_address);
 
-int THREADOUTPUT = 0;
 char *bit_range_str_min;
 char *bit_range_str_max;
 
 const char *bsgs_modes[5] = {"sequential","backward","both","random","dance"};
-const char *modes[7] = {"xpoint","address","bsgs","rmd160","pub2rmd","minikeys","vanity"};
+const char *modes[8] = {"xpoint","address","bsgs","rmd160","pub2rmd","minikeys","vanity","kangaroo"};
 const char *cryptos[3] = {"btc","eth","all"};
 const char *publicsearch[3] = {"uncompress","compress","both"};
 const char *default_fileName = "addresses.txt";
@@ -235,12 +332,14 @@ HANDLE* tid = NULL;
 HANDLE write_keys;
 HANDLE write_random;
 HANDLE bsgs_thread;
+HANDLE kangaroo_save;
 HANDLE *bPload_mutex = NULL;
 #else
 pthread_t *tid = NULL;
 pthread_mutex_t write_keys;
 pthread_mutex_t write_random;
 pthread_mutex_t bsgs_thread;
+pthread_mutex_t kangaroo_save;
 pthread_mutex_t *bPload_mutex = NULL;
 #endif
 
@@ -263,9 +362,8 @@ char **vanity_address_targets = NULL;
 struct bloom *vanity_bloom = NULL;
 
 struct bloom bloom;
+struct bloom_prefilter bloom_prefilter;
 
-uint64_t *steps = NULL;
-unsigned int *ends = NULL;
 uint64_t N = 0;
 
 uint64_t N_SEQUENTIAL_MAX = 0x100000000;
@@ -294,6 +392,7 @@ int FLAGREADEDFILE2 = 0;
 int FLAGREADEDFILE3 = 0;
 int FLAGREADEDFILE4 = 0;
 int FLAGUPDATEFILE1 = 0;
+int FLAGUPDATEFILE3 = 0;
 
 
 int FLAGSTRIDE = 0;
@@ -337,24 +436,29 @@ struct oldbloom oldbloom_bP;
 struct bloom *bloom_bP;
 struct bloom *bloom_bPx2nd; //2nd Bloom filter check
 struct bloom *bloom_bPx3rd; //3rd Bloom filter check
+struct bloom_prefilter bloom_bP_prefilter;	//In front of the 256 filters of bloom_bP
 
 struct checksumsha256 *bloom_bP_checksums;
 struct checksumsha256 *bloom_bPx2nd_checksums;
 struct checksumsha256 *bloom_bPx3rd_checksums;
 
-#if defined(_WIN64) && !defined(__CYGWIN__)
-std::vector<HANDLE> bloom_bP_mutex;
-std::vector<HANDLE> bloom_bPx2nd_mutex;
-std::vector<HANDLE> bloom_bPx3rd_mutex;
-#else
-pthread_mutex_t *bloom_bP_mutex;
-pthread_mutex_t *bloom_bPx2nd_mutex;
-pthread_mutex_t *bloom_bPx3rd_mutex;
-#endif
 
 
 
 
+/*
+The bsgs-tables program is keyhunt built with BSGS_TABLES, it only make the files
+*/
+#ifdef BSGS_TABLES
+const int FLAGTABLESONLY = 1;
+#else
+const int FLAGTABLESONLY = 0;
+#endif
+
+#define BSGS_PROGRESS_MAGIC "KHBSGSP2"	/* 2: lines of the prefilter of KHPREF02 */
+#define BSGS_PROGRESS_SECONDS 600
+#define BSGS_PROGRESS_BLOCK 1048576
+
 uint64_t bloom_bP_totalbytes = 0;
 uint64_t bloom_bP2_totalbytes = 0;
 uint64_t bloom_bP3_totalbytes = 0;
@@ -364,15 +468,294 @@ uint64_t bsgs_m3;
 uint64_t bsgs_aux;
 uint32_t bsgs_point_number;
 
+/*
+Kangaroo Variables, the targets are the same of BSGS (OriginalPointsBSGS, bsgs_found)
+*/
+#define KANGAROO_JUMPS 32
+#define KANGAROO_SAVE_SECONDS 300
+struct dptable kangaroo_dptable;
+Point KANGAROO_JUMPP[KANGAROO_JUMPS];	//Jump points, KANGAROO_JUMPD[i] * G
+Int KANGAROO_JUMPD[KANGAROO_JUMPS];		//Jump distances
+Int KANGAROO_HALF;						//Half of the range, max start distance of the wild kangaroos
+std::vector<Point> KangarooWildStart;	//Targets moved to the start of the range: Target - range_start * G
+uint64_t *kangaroo_wild_id;
+#define KANGAROO_MAX_DPBITS 60		/* The mask is taken from one 64 bits word of X */
+#define KANGAROO_MAX_RANGEBITS 190	/* The distances of the DP table are 192 bits, a kangaroo walks a bit more than the range */
+uint64_t KANGAROO_DPMASK = 0;
+uint32_t KANGAROO_DPBITS = 0;
+volatile uint32_t KANGAROO_TARGET = 0;
+int FLAGDPBITS = 0;
+int FLAGDPFULL = 0;
+char kangaroo_file[1024];
+
+/*
+Checkpoint Variables
+*/
+#define CHECKPOINT_DEFAULT_SECONDS 60
+#define OPT_RESUME 256
+#define OPT_CHECKPOINT 257
+#define OPT_WORKER 258
+#define OPT_EXACTRANGE 259
+#define OPT_PREFILTER 260
+#define OPT_DISKTABLE 261
+#define OPT_BENCH 262
+#define OPT_BENCHRUN 263
+#define OPT_PROFILE 264
+#define OPT_METRICS 265
+#define OPT_METRICSFILE 266
+#define OPT_AFFINITY 267
+#define OPT_AUTOTUNE 268
+#define OPT_AUTOTUNEFILE 269
+#define OPT_HITSFILE 270
+struct checkpoint keyhunt_checkpoint;
+int FLAGCHECKPOINT = 0;
+int FLAGRESUME = 0;
+uint64_t CHECKPOINT_SECONDS = CHECKPOINT_DEFAULT_SECONDS;
+
+/*
+Cluster worker Variables, the ranges are leases of the coordinator
+*/
+struct cluster_worker keyhunt_worker;
+int FLAGWORKER = 0;
+char *str_worker;
+Int WORKER_CHUNK;
+
+/*
+Only hash the compressed publickey with the parity of the key, the negated
+keys n-k are never in a puzzle range
+*/
+int FLAGEXACTRANGE = 0;
+
+/*
+Size in MB of the prefilter checked before the big bloom filters, -1 to use
+the default size only when the bloom filter is much bigger than the cache
+*/
+#define PREFILTER_DEFAULT_MB 4
+#define PREFILTER_MAX_MB 16		/* Bigger than the cache of one core it is one more read from the RAM */
+#define PREFILTER_MAGIC "KHPREF02"	/* 02: the line is taken from the mixed bits of the element */
+int PREFILTER_MB = -1;
+int PREFILTER_AUTO_MB = PREFILTER_DEFAULT_MB;	/* Size used with -1, --autotune sets it from the cache of each core or 0 to disable it */
+
+/*
+The bP table stays in the file keyhunt_bsgs_8_*.tbl and it is only read after
+a hit of the third bloom filter, in RAM there is only the first value of each
+block of the file (fence pointers). The values don't divide a page, so a block
+can cross two pages and the read is the aligned window of pages around it
+*/
+#define BSGS_DISK_PAGE 4096
+#define BSGS_DISK_BLOCK (BSGS_DISK_PAGE / sizeof(struct bsgs_xvalue))
+
+#define BSGS_BATCH 8	/* Candidates of the first bloom filter checked with one inversion */
+int FLAGDISKTABLE = 0;
+uint64_t bPtable_blocks = 0;
+uint8_t *bPtable_fence = NULL;
+#if defined(_WIN64) && !defined(__CYGWIN__)
+HANDLE bPtable_disk = INVALID_HANDLE_VALUE;
+#else
+int bPtable_disk = -1;
+#endif
+
+/*
+--bench runs this program again for each number of threads with a fixed range
+and the targets of the tests directory, the child (--bench-run) prints the
+steps of each thread after BENCH_WARMUP seconds of work and exits
+*/
+#define BENCH_WARMUP 2
+#define BENCH_DEFAULT_SECONDS 10
+
+struct bench_mode	{
+	const char *name;
+	const char *file;
+	const char *args;
+};
+
+const struct bench_mode bench_modes[] = {
+	{"address","tests/1to32.txt","-m address -f tests/1to32.txt -l compress -r 8000000000000000:ffffffffffffffff"},
+	{"rmd160","tests/1to32.rmd","-m rmd160 -f tests/1to32.rmd -l compress -r 8000000000000000:ffffffffffffffff"},
+	{"xpoint","tests/1to63_65.txt","-m xpoint -f tests/1to63_65.txt -r 8000000000000000:ffffffffffffffff"},
+	{"bsgs","tests/125.txt","-m bsgs -f tests/125.txt -b 125 -n 0x1000000000 -k 16"},	/* Same bloom of -k 1 with the default -n, but each step is 2^36 keys */
+	{"minikeys","tests/minikeys.txt","-m minikeys -f tests/minikeys.txt -C SG64GZqySYwBm9KxE1wJ28 -n 0x10000"},
+	{"vanity","tests/vanitytargets.txt","-m vanity -f tests/vanitytargets.txt -l compress -r 8000000000000000:ffffffffffffffff"},
+	{"eth","tests/1to32.eth","-m address -c eth -f tests/1to32.eth -r 8000000000000000:ffffffffffffffff"},
+	{NULL,NULL,NULL}
+};
+
+const char *str_bench = NULL;
+int FLAGBENCHRUN = 0;
+int FLAGTHREADS = 0;
+int BENCH_SECONDS = BENCH_DEFAULT_SECONDS;
+uint64_t *bench_steps = NULL;
+std::chrono::steady_clock::time_point bench_start;	/* Time of the steps taken after the warmup */
+
+/*
+--autotune measures the speed of the mode with 1, 2, 4 ... threads, the
+physical cores and all the CPUs (the same children of --bench), plans the
+bsgs -k with the available memory and the prefilter with the cache of each core.
+--autotune-file keeps the result of each host and mode, later runs with the
+same file use it without measuring again. The -t, -k and --prefilter given
+in the command line are never changed
+*/
+#define AUTOTUNE_SECONDS 3
+#define AUTOTUNE_MEMORY 75		/* Percent of the available memory for the bsgs filters and table */
+#define AUTOTUNE_TIE 2		/* Percent, the less threads win if the speed is within it */
+#define AUTOTUNE_MAX_K (1 << 30)
+int FLAGAUTOTUNE = 0;
+int FLAGKFACTOR = 0;
+const char *str_autotunefile = NULL;
+
+/*
+--profile counts the cycles (rdtsc) of each stage of the main loop of the
+threads, every thread has its own counters so the hot loop never writes to a
+shared cache line. The search stage is nested inside the bloom stage
+*/
+#define PROFILE_INVERSION 0
+#define PROFILE_POINTS 1
+#define PROFILE_HASH 2
+#define PROFILE_BLOOM 3
+#define PROFILE_SEARCH 4
+#define PROFILE_STAGES 5
+
+struct profile_counters	{
+	std::atomic<uint64_t> cycles[PROFILE_STAGES];	/* Only written by its thread, see metrics_add */
+	uint8_t padding[128 - PROFILE_STAGES * sizeof(uint64_t)];
+};
+
+int FLAGPROFILE = 0;
+thread_local struct profile_counters *profile_thread = NULL;
+thread_local struct metrics_thread *stats_thread = NULL;
+
+/*
+The keys found by the search threads go to the ring of the thread, the writer
+thread makes the publickeys and addresses and writes the files, see
+results/results.h. --hits-file also appends them as JSON lines
+*/
+const char *results_kinds[4] = {"address","eth","vanity","bsgs"};
+const char *str_hitsfile = NULL;
+struct results_writer results;
+thread_local struct results_ring *results_thread = NULL;
+
+/*
+Everything that a search thread writes is in its context, aligned to the
+cache line so two threads never write the same line, the globals are only
+read during the search except the cursors of the ranges. The buffers are
+allocated by the thread itself in worker_alloc, the first touch puts them in
+the NUMA node of the thread
+*/
+/*
+--affinity pins each thread to a CPU (see affinity/affinity.h), when the
+threads are in more than one NUMA node each node has its own copy of the
+read only tables of the threads
+*/
+struct node_tables	{
+	std::vector<Point> *Gn;
+	Point *_2Gn;
+	std::vector<Point> *GSn;	/* Only copied in bsgs, the other modes don't make it */
+	Point *_2GSn;
+	Secp256K1 *secp;
+};
+
+const char *str_affinity = NULL;
+struct affinity_topology topology;
+std::vector<int> affinity_cpus;		/* CPU of each thread, empty without --affinity */
+std::vector<struct node_tables> tables;
+
+struct alignas(METRICS_CACHE_LINE) worker_context	{
+	struct metrics_thread stats;		/* Read by the stats of main */
+	struct profile_counters profile;
+	std::atomic<int> end;
+	IntGroup *grp;
+	Int *dx;
+	Point *pts;
+	Int *x;		/* Coordinates of the batch, see group_points */
+	Int *y;
+	uint32_t *queue;	/* Candidates of the first bloom filter of bsgs */
+	IntGroup *grp2;		/* Inversion of the second check of BSGS_BATCH candidates */
+	Int *dx2;
+	Int *x2;		/* x of the 32 points of each candidate */
+	bool *equal2;
+	IntGroup *grp3;		/* Inversion of the third check */
+	Int *dx3;
+	int cpu;		/* -1 if the thread is not pinned */
+	struct node_tables *tables;
+};
+
+struct worker_context *workers = NULL;
+
+/* x86intrin.h collides with the intrinsics defined in Int.h */
+#if defined(_WIN64) && !defined(__CYGWIN__)
+#define profile_rdtsc() __rdtsc()
+#else
+#define profile_rdtsc() __builtin_ia32_rdtsc()
+#endif
+
+/*
+--metrics serves the stats of the threads in Prometheus format and
+--metrics-file appends them as JSON lines every -s seconds, see metrics/metrics.h
+*/
+#define METRICS_FILE_DEFAULT_SECONDS 30
+const char *str_metrics = NULL;
+const char *str_metricsfile = NULL;
+FILE *metrics_file = NULL;
+double stats_range = 0;		/* Keys of the range for the progress, 0 if it is not sequential */
+uint64_t *stats_previous = NULL;
+
+static inline uint64_t profile_tsc()	{
+	return profile_thread != NULL ? profile_rdtsc() : 0;
+}
+
+/* Add the cycles since *start to the stage and start the next stage */
+static inline void profile_stage(int stage,uint64_t *start)	{
+	uint64_t now;
+	if(profile_thread != NULL)	{
+		now = profile_rdtsc();
+		metrics_add(&profile_thread->cycles[stage],now - *start);
+		*start = now;
+	}
+}
+
+/* Hits of the filters, always counted for the metrics */
+static inline void stats_count(int counter)	{
+	if(stats_thread != NULL)	{
+		metrics_add(&stats_thread->hits[counter],1);
+	}
+}
+
+const struct option long_options[] = {
+	{"resume",no_argument,NULL,OPT_RESUME},
+	{"checkpoint",required_argument,NULL,OPT_CHECKPOINT},
+	{"worker",required_argument,NULL,OPT_WORKER},
+	{"exact-range",no_argument,NULL,OPT_EXACTRANGE},
+	{"prefilter",required_argument,NULL,OPT_PREFILTER},
+	{"disk-table",no_argument,NULL,OPT_DISKTABLE},
+	{"bench",required_argument,NULL,OPT_BENCH},
+	{"bench-run",required_argument,NULL,OPT_BENCHRUN},
+	{"profile",no_argument,NULL,OPT_PROFILE},
+	{"metrics",required_argument,NULL,OPT_METRICS},
+	{"metrics-file",required_argument,NULL,OPT_METRICSFILE},
+	{"affinity",required_argument,NULL,OPT_AFFINITY},
+	{"autotune",no_argument,NULL,OPT_AUTOTUNE},
+	{"autotune-file",required_argument,NULL,OPT_AUTOTUNEFILE},
+	{"hits-file",required_argument,NULL,OPT_HITSFILE},
+	{NULL,0,NULL,0}
+};
+
 const char *str_limits_prefixs[7] = {"Mkeys/s","Gkeys/s","Tkeys/s","Pkeys/s","Ekeys/s","Zkeys/s","Ykeys/s"};
-const char *str_limits[7] = {"1000000","1000000000","1000000000000","1000000000000000","1000000000000000000","1000000000000000000000","1000000000000000000000000"};
-Int int_limits[7];
 
 
 
 
 Int BSGS_GROUP_SIZE;
-Int BSGS_CURRENT;
+/*
+Cursors of the sequential modes, the only globals written during the search
+(with the mutex, once per chunk), each one in its own cache line
+*/
+struct alignas(METRICS_CACHE_LINE) range_cursor	{
+	Int value;
+};
+struct range_cursor range_cursors[3];
+Int &BSGS_CURRENT = range_cursors[0].value;
+Int &BSGS_TOP = range_cursors[1].value;		/* Top of the range in the bsgs modes backward, both and dance */
+Int &RANGE_CURRENT = range_cursors[2].value;
 Int BSGS_R;
 Int BSGS_AUX;
 Int BSGS_N;
@@ -413,9 +796,9 @@ Int lambda,lambda2,beta,beta2;
 Secp256K1 *secp;
 
 int main(int argc, char **argv)	{
-	char buffer[2048];
 	char rawvalue[32];
 	struct tothread *tt;	//tothread
+	thread_function search_thread;	//thread_process of the flags
 	Tokenizer t,tokenizerbsgs;	//tokenizer
 	char *fileName = NULL;
 	char *hextemp = NULL;
@@ -423,29 +806,31 @@ int main(int argc, char **argv)	{
 	char *aux2 = NULL;
 	char *pointx_str = NULL;
 	char *pointy_str = NULL;
-	char *str_seconds = NULL;
-	char *str_total = NULL;
-	char *str_pretotal = NULL;
-	char *str_divpretotal = NULL;
 	char *bf_ptr = NULL;
 	char *bPload_threads_available;
 	FILE *fd,*fd_aux1,*fd_aux2,*fd_aux3;
 	uint64_t i,BASE,PERTHREAD_R,itemsbloom,itemsbloom2,itemsbloom3;
 	uint32_t finished;
 	int readed,continue_flag,check_flag,c,salir,index_value,j;
-	Int total,pretotal,debugcount_mpz,seconds,div_pretotal,int_aux,int_r,int_q,int58;
+	Int total,seconds,int_aux,int_r,int_q,int58,aux_chunk;
+	struct metrics_snapshot snapshot;
+	uint64_t metrics_seconds;
 	struct bPload *bPload_temp_ptr;
 	size_t rsize;
+	uint8_t *bP_done;
+	time_t progress_time;
 	
 #if defined(_WIN64) && !defined(__CYGWIN__)
 	DWORD s;
 	write_keys = CreateMutex(NULL, FALSE, NULL);
 	write_random = CreateMutex(NULL, FALSE, NULL);
 	bsgs_thread = CreateMutex(NULL, FALSE, NULL);
+	kangaroo_save = CreateMutex(NULL, FALSE, NULL);
 #else
 	pthread_mutex_init(&write_keys,NULL);
 	pthread_mutex_init(&write_random,NULL);
 	pthread_mutex_init(&bsgs_thread,NULL);
+	pthread_mutex_init(&kangaroo_save,NULL);
 	int s;
 #endif
 
@@ -486,8 +871,70 @@ int main(int argc, char **argv)	{
 	
 	printf("[+] Version %s, developed by AlbertoBSD\n",version);
 
-	while ((c = getopt(argc, argv, "deh6MqRSB:b:c:C:E:f:I:k:l:m:N:n:p:r:s:t:v:G:8:z:")) != -1) {
+	while ((c = getopt_long(argc, argv, "deh6MqRSB:b:c:C:D:E:f:I:k:l:m:N:n:p:r:s:t:v:G:8:z:",long_options,NULL)) != -1) {
 		switch(c) {
+			case OPT_RESUME:
+				FLAGRESUME = 1;
+				FLAGCHECKPOINT = 1;
+			break;
+			case OPT_CHECKPOINT:
+				CHECKPOINT_SECONDS = strtoull(optarg,NULL,10);
+				if(CHECKPOINT_SECONDS == 0)	{
+					fprintf(stderr,"[E] Invalid checkpoint interval: %s\n",optarg);
+					exit(EXIT_FAILURE);
+				}
+				FLAGCHECKPOINT = 1;
+				printf("[+] Checkpoint every %" PRIu64 " seconds\n",CHECKPOINT_SECONDS);
+			break;
+			case OPT_WORKER:
+				FLAGWORKER = 1;
+				str_worker = optarg;
+			break;
+			case OPT_EXACTRANGE:
+				FLAGEXACTRANGE = 1;
+			break;
+			case OPT_PREFILTER:
+				PREFILTER_MB = strtol(optarg,NULL,10);
+				if(PREFILTER_MB < 0 || PREFILTER_MB > PREFILTER_MAX_MB)	{
+					fprintf(stderr,"[E] Invalid prefilter size: %s, valid values are 1 to %i MB or 0 to disable it\n",optarg,PREFILTER_MAX_MB);
+					exit(EXIT_FAILURE);
+				}
+			break;
+			case OPT_DISKTABLE:
+				FLAGDISKTABLE = 1;
+			break;
+			case OPT_BENCH:
+				str_bench = optarg;
+			break;
+			case OPT_BENCHRUN:
+				FLAGBENCHRUN = 1;
+				BENCH_SECONDS = strtol(optarg,NULL,10);
+				if(BENCH_SECONDS <= 0)	{
+					fprintf(stderr,"[E] Invalid benchmark seconds: %s\n",optarg);
+					exit(EXIT_FAILURE);
+				}
+			break;
+			case OPT_PROFILE:
+				FLAGPROFILE = 1;
+			break;
+			case OPT_METRICS:
+				str_metrics = optarg;
+			break;
+			case OPT_METRICSFILE:
+				str_metricsfile = optarg;
+			break;
+			case OPT_AFFINITY:
+				str_affinity = optarg;
+			break;
+			case OPT_AUTOTUNE:
+				FLAGAUTOTUNE = 1;
+			break;
+			case OPT_AUTOTUNEFILE:
+				str_autotunefile = optarg;
+			break;
+			case OPT_HITSFILE:
+				str_hitsfile = optarg;
+			break;
 			case 'h':
 				menu();
 			break;
@@ -572,6 +1019,15 @@ int main(int argc, char **argv)	{
 				}
 				
 			break;
+			case 'D':
+				KANGAROO_DPBITS = strtol(optarg,NULL,10);
+				if(KANGAROO_DPBITS > KANGAROO_MAX_DPBITS)	{
+					fprintf(stderr,"[E] invalid DP bits param: %s.\n",optarg);
+					exit(EXIT_FAILURE);
+				}
+				FLAGDPBITS = 1;
+				printf("[+] Distinguished point bits %u\n",KANGAROO_DPBITS);
+			break;
 			case 'd':
 				FLAGDEBUG = 1;
 				printf("[+] Flag DEBUG enabled\n");
@@ -597,6 +1053,7 @@ int main(int argc, char **argv)	{
 				if(KFACTOR <= 0)	{
 					KFACTOR = 1;
 				}
+				FLAGKFACTOR = 1;
 				printf("[+] K factor %i\n",KFACTOR);
 			break;
 
@@ -621,7 +1078,7 @@ int main(int argc, char **argv)	{
 				printf("[+] Matrix screen\n");
 			break;
 			case 'm':
-				switch(indexOf(optarg,modes,7)) {
+				switch(indexOf(optarg,modes,8)) {
 					case MODE_XPOINT: //xpoint
 						FLAGMODE = MODE_XPOINT;
 						printf("[+] Mode xpoint\n");
@@ -648,6 +1105,10 @@ int main(int argc, char **argv)	{
 						FLAGMODE = MODE_MINIKEYS;
 						printf("[+] Mode minikeys\n");
 					break;
+					case MODE_KANGAROO:
+						FLAGMODE = MODE_KANGAROO;
+						printf("[+] Mode kangaroo\n");
+					break;
 					case MODE_VANITY:
 						FLAGMODE = MODE_VANITY;
 						printf("[+] Mode vanity\n");
@@ -732,6 +1193,7 @@ int main(int argc, char **argv)	{
 				if(NTHREADS <= 0)	{
 					NTHREADS = 1;
 				}
+				FLAGTHREADS = 1;
 				printf((NTHREADS > 1) ? "[+] Threads : %u\n": "[+] Thread : %u\n",NTHREADS);
 			break;
 			case 'v':
@@ -777,6 +1239,56 @@ int main(int argc, char **argv)	{
 		}
 	}
 	
+	if(str_bench != NULL)	{
+		bench_sweep(argv[0],str_bench);
+		exit(EXIT_SUCCESS);
+	}
+	if(FLAGAUTOTUNE || str_autotunefile != NULL)	{
+		autotune(argv[0]);
+	}
+	if(str_metrics != NULL)	{
+		if(metrics_server_start(str_metrics,NTHREADS) != 0)	{
+			fprintf(stderr,"[E] Can't listen in the metrics endpoint %s\n",str_metrics);
+			exit(EXIT_FAILURE);
+		}
+		printf("[+] Metrics endpoint %s\n",str_metrics);
+	}
+	if(str_metricsfile != NULL)	{
+		metrics_file = fopen(str_metricsfile,"a");
+		if(metrics_file == NULL)	{
+			fprintf(stderr,"[E] Can't open the file %s\n",str_metricsfile);
+			exit(EXIT_FAILURE);
+		}
+	}
+	if(str_affinity != NULL)	{
+		if(affinity_read(&topology) != 0)	{
+			fprintf(stderr,"[E] Can't read the CPU topology, --affinity is only available in Linux\n");
+			exit(EXIT_FAILURE);
+		}
+		if(affinity_map(&topology,str_affinity,NTHREADS,affinity_cpus) != 0)	{
+			fprintf(stderr,"[E] Invalid affinity %s, valid values: compact, scatter, cores or a list of CPUs like 0,2,4-7\n",str_affinity);
+			exit(EXIT_FAILURE);
+		}
+		printf("[+] Affinity %s, %i CPUs in %i NUMA node%s, thread:CPU",str_affinity,(int)topology.cpus.size(),topology.nodes,(topology.nodes > 1) ? "s" : "");
+		for(i = 0; i < (uint64_t)NTHREADS; i++)	{
+			printf(" %i:%i",(int)i,affinity_cpus[i]);
+		}
+		printf("\n");
+	}
+	
+	if(sha256_select(FLAGDEBUG) == SHA256_BACKEND_SHANI)	{
+		printf("[+] SHA256 with SHA-NI\n");
+	}
+	if(sha256_select8(FLAGDEBUG) == SHA256_BACKEND_AVX2)	{
+		printf("[+] SHA256 8 way with AVX2\n");
+	}
+	if(ripemd160_select(FLAGDEBUG) == RIPEMD160_BACKEND_AVX2)	{
+		printf("[+] RIPEMD160 8 way with AVX2\n");
+	}
+	if(hash160_select(FLAGDEBUG) == HASH160_BACKEND_AVX2)	{
+		printf("[+] Hash160 with the fused AVX2 kernel\n");
+	}
+	
 	if(  FLAGBSGSMODE == MODE_BSGS && FLAGENDOMORPHISM)	{
 		fprintf(stderr,"[E] Endomorphism doesn't work with BSGS\n");
 		exit(EXIT_FAILURE);
@@ -801,6 +1313,11 @@ int main(int argc, char **argv)	{
 		stride.Set(&ONE);
 	}
 	init_generator();
+#ifdef BSGS_TABLES
+	/* The tables only depend of -n and -k, not of the publickeys */
+	FLAGMODE = MODE_BSGS;
+	FLAGSAVEREADFILE = 1;
+#endif
 	if(FLAGMODE == MODE_BSGS )	{
 		printf("[+] Mode BSGS %s\n",bsgs_modes[FLAGBSGSMODE]);
 	}
@@ -813,6 +1330,37 @@ int main(int argc, char **argv)	{
 		FLAGCRYPTO = CRYPTO_BTC;
 		printf("[+] Setting search for btc adddress\n");
 	}
+	if(FLAGEXACTRANGE)	{
+		if((FLAGMODE != MODE_ADDRESS && FLAGMODE != MODE_RMD160) || FLAGCRYPTO != CRYPTO_BTC || FLAGSEARCH != SEARCH_COMPRESS || FLAGENDOMORPHISM)	{
+			fprintf(stderr,"[E] --exact-range only works with -l compress in btc address and rmd160 modes without endomorphism\n");
+			exit(EXIT_FAILURE);
+		}
+		printf("[+] Exact range, only the publickey with the parity of the key is hashed\n");
+	}
+	if(FLAGWORKER)	{
+		if(FLAGRANDOM || FLAGCHECKPOINT || FLAGMODE == MODE_MINIKEYS || FLAGMODE == MODE_KANGAROO || (FLAGMODE == MODE_BSGS && FLAGBSGSMODE != 0))	{
+			fprintf(stderr,"[E] --worker only works with sequential address, rmd160, xpoint, vanity and bsgs modes, without checkpoint\n");
+			exit(EXIT_FAILURE);
+		}
+		printf("[+] Worker of the coordinator %s\n",str_worker);
+		switch(cluster_worker_init(&keyhunt_worker,str_worker,&n_range_start,&n_range_end))	{
+			case 0:
+			break;
+			case 2:
+				printf("[+] The coordinator doesn't have more work\n");
+				exit(EXIT_SUCCESS);
+			break;
+			default:
+				fprintf(stderr,"[E] Can't get a lease from the coordinator %s\n",str_worker);
+				exit(EXIT_FAILURE);
+			break;
+		}
+		/* The first lease is the range for the checks of all the modes */
+		range_start = n_range_start.GetBase16();
+		range_end = n_range_end.GetBase16();
+		FLAGRANGE = 1;
+		FLAGBITRANGE = 0;
+	}
 	if(FLAGRANGE) {
 		n_range_start.SetBase16(range_start);
 		if(n_range_start.IsZero())	{
@@ -951,15 +1499,21 @@ int main(int argc, char **argv)	{
 			break;
 		}
 		
-		if(FLAGMODE != MODE_VANITY && !FLAGREADEDFILE1)	{
+		if(FLAGMODE != MODE_VANITY && FLAGMODE != MODE_KANGAROO && !FLAGREADEDFILE1)	{
 			printf("[+] Sorting data ...");
 			_sort(addressTable,N);
 			printf(" done! %" PRIu64 " values were loaded and sorted\n",N);
 			writeFileIfNeeded(fileName);
 		}
+		if(FLAGMODE != MODE_VANITY && FLAGMODE != MODE_KANGAROO && initPrefilter(&bloom_prefilter,N,bloom.bytes))	{
+			/* The table have the same 20 bytes that were added to the bloom filter */
+			for(i = 0; i < N; i++)	{
+				bloom_prefilter_add(&bloom_prefilter,addressTable[i].value,sizeof(struct address_value));
+			}
+		}
 	}
 	
-	if(FLAGMODE == MODE_BSGS )	{
+	if(FLAGMODE == MODE_KANGAROO || (FLAGMODE == MODE_BSGS && !FLAGTABLESONLY))	{
 		printf("[+] Opening file %s\n",fileName);
 		fd = fopen(fileName,"rb");
 		if(fd == NULL)	{
@@ -1042,6 +1596,12 @@ int main(int argc, char **argv)	{
 			fprintf(stderr,"[E] The file don't have any valid publickeys\n");
 			exit(EXIT_FAILURE);
 		}
+	}
+	if(FLAGMODE == MODE_KANGAROO)	{
+		free(aux);
+		kangaroo_init();
+	}
+	if(FLAGMODE == MODE_BSGS )	{
 		BSGS_N.SetInt32(0);
 		BSGS_M.SetInt32(0);
 		
@@ -1218,24 +1778,12 @@ int main(int argc, char **argv)	{
 		bloom_bP_checksums = (struct checksumsha256*)calloc(256,sizeof(struct checksumsha256));
 		checkpointer((void *)bloom_bP_checksums,__FILE__,"calloc","bloom_bP_checksums" ,__LINE__ -1 );
 		
-#if defined(_WIN64) && !defined(__CYGWIN__)
-		bloom_bP_mutex = (HANDLE*) calloc(256,sizeof(HANDLE));
-		
-#else
-		bloom_bP_mutex = (pthread_mutex_t*) calloc(256,sizeof(pthread_mutex_t));
-#endif
-		checkpointer((void *)bloom_bP_mutex,__FILE__,"calloc","bloom_bP_mutex" ,__LINE__ -1 );
 		
 
 		fflush(stdout);
 		bloom_bP_totalbytes = 0;
 		for(i=0; i< 256; i++)	{
-#if defined(_WIN64) && !defined(__CYGWIN__)
-			bloom_bP_mutex[i] = CreateMutex(NULL, FALSE, NULL);
-#else
-			pthread_mutex_init(&bloom_bP_mutex[i],NULL);
-#endif
-			if(bloom_init2(&bloom_bP[i],itemsbloom,0.000001)	== 1){
+			if(bloom_init3(&bloom_bP[i],itemsbloom,0.000001,BLOOM_KEYED)	== 1){
 				fprintf(stderr,"[E] error bloom_init _ [%" PRIu64 "]\n",i);
 				exit(EXIT_FAILURE);
 			}
@@ -1243,28 +1791,18 @@ int main(int argc, char **argv)	{
 			//if(FLAGDEBUG) bloom_print(&bloom_bP[i]);
 		}
 		printf(": %.2f MB\n",(float)((float)(uint64_t)bloom_bP_totalbytes/(float)(uint64_t)1048576));
+		initPrefilter(&bloom_bP_prefilter,bsgs_m,bloom_bP_totalbytes);
 
 
 		printf("[+] Bloom filter for %" PRIu64 " elements ",bsgs_m2);
 		
-#if defined(_WIN64) && !defined(__CYGWIN__)
-		bloom_bPx2nd_mutex = (HANDLE*) calloc(256,sizeof(HANDLE));
-#else
-		bloom_bPx2nd_mutex = (pthread_mutex_t*) calloc(256,sizeof(pthread_mutex_t));
-#endif
-		checkpointer((void *)bloom_bPx2nd_mutex,__FILE__,"calloc","bloom_bPx2nd_mutex" ,__LINE__ -1 );
 		bloom_bPx2nd = (struct bloom*)calloc(256,sizeof(struct bloom));
 		checkpointer((void *)bloom_bPx2nd,__FILE__,"calloc","bloom_bPx2nd" ,__LINE__ -1 );
 		bloom_bPx2nd_checksums = (struct checksumsha256*) calloc(256,sizeof(struct checksumsha256));
 		checkpointer((void *)bloom_bPx2nd_checksums,__FILE__,"calloc","bloom_bPx2nd_checksums" ,__LINE__ -1 );
 		bloom_bP2_totalbytes = 0;
 		for(i=0; i< 256; i++)	{
-#if defined(_WIN64) && !defined(__CYGWIN__)
-			bloom_bPx2nd_mutex[i] = CreateMutex(NULL, FALSE, NULL);
-#else
-			pthread_mutex_init(&bloom_bPx2nd_mutex[i],NULL);
-#endif
-			if(bloom_init2(&bloom_bPx2nd[i],itemsbloom2,0.000001)	== 1){
+			if(bloom_init3(&bloom_bPx2nd[i],itemsbloom2,0.000001,BLOOM_KEYED)	== 1){
 				fprintf(stderr,"[E] error bloom_init _ [%" PRIu64 "]\n",i);
 				exit(EXIT_FAILURE);
 			}
@@ -1274,12 +1812,6 @@ int main(int argc, char **argv)	{
 		printf(": %.2f MB\n",(float)((float)(uint64_t)bloom_bP2_totalbytes/(float)(uint64_t)1048576));
 		
 
-#if defined(_WIN64) && !defined(__CYGWIN__)
-		bloom_bPx3rd_mutex = (HANDLE*) calloc(256,sizeof(HANDLE));
-#else
-		bloom_bPx3rd_mutex = (pthread_mutex_t*) calloc(256,sizeof(pthread_mutex_t));
-#endif
-		checkpointer((void *)bloom_bPx3rd_mutex,__FILE__,"calloc","bloom_bPx3rd_mutex" ,__LINE__ -1 );
 		bloom_bPx3rd = (struct bloom*)calloc(256,sizeof(struct bloom));
 		checkpointer((void *)bloom_bPx3rd,__FILE__,"calloc","bloom_bPx3rd" ,__LINE__ -1 );
 		bloom_bPx3rd_checksums = (struct checksumsha256*) calloc(256,sizeof(struct checksumsha256));
@@ -1288,12 +1820,7 @@ int main(int argc, char **argv)	{
 		printf("[+] Bloom filter for %" PRIu64 " elements ",bsgs_m3);
 		bloom_bP3_totalbytes = 0;
 		for(i=0; i< 256; i++)	{
-#if defined(_WIN64) && !defined(__CYGWIN__)
-			bloom_bPx3rd_mutex[i] = CreateMutex(NULL, FALSE, NULL);
-#else
-			pthread_mutex_init(&bloom_bPx3rd_mutex[i],NULL);
-#endif
-			if(bloom_init2(&bloom_bPx3rd[i],itemsbloom3,0.000001)	== 1){
+			if(bloom_init3(&bloom_bPx3rd[i],itemsbloom3,0.000001,BLOOM_KEYED)	== 1){
 				fprintf(stderr,"[E] error bloom_init [%" PRIu64 "]\n",i);
 				exit(EXIT_FAILURE);
 			}
@@ -1315,7 +1842,7 @@ int main(int argc, char **argv)	{
 		
 		BSGS_AMP2.reserve(32);
 		BSGS_AMP3.reserve(32);
-		GSn.reserve(CPU_GRP_SIZE/2);
+		GSn.resize(CPU_GRP_SIZE/2);
 
 		i= 0;
 
@@ -1363,12 +1890,28 @@ int main(int argc, char **argv)	{
 			BSGS_AMP3[i].Reduce();
 		}
 
+		if(bsgs_m3 > BSGS_XINDEX_MAX)	{
+			fprintf(stderr,"[E] Too many bP Points for the bP Table, use a lower -k value\n");
+			exit(EXIT_FAILURE);
+		}
 		bytes = (uint64_t)bsgs_m3 * (uint64_t) sizeof(struct bsgs_xvalue);
-		printf("[+] Allocating %.2f MB for %" PRIu64  " bP Points\n",(double)(bytes/1048576),bsgs_m3);
-		
-		bPtable = (struct bsgs_xvalue*) malloc(bytes);
-		checkpointer((void *)bPtable,__FILE__,"malloc","bPtable" ,__LINE__ -1 );
-		memset(bPtable,0,bytes);
+		bPtable = NULL;
+		if(FLAGDISKTABLE)	{
+			if(!FLAGSAVEREADFILE)	{
+				fprintf(stderr,"[E] The option --disk-table needs -S to save the bP Table file\n");
+				exit(EXIT_FAILURE);
+			}
+			snprintf(buffer_bloom_file,1024,"keyhunt_bsgs_8_%" PRIu64 ".tbl",bsgs_m3);
+			if(bsgs_disktable_open(buffer_bloom_file))	{
+				FLAGREADEDFILE3 = 1;
+			}
+		}
+		if(bPtable_blocks == 0)	{
+			printf("[+] Allocating %.2f MB for %" PRIu64  " bP Points\n",(double)(bytes/1048576),bsgs_m3);
+			bPtable = (struct bsgs_xvalue*) malloc(bytes);
+			checkpointer((void *)bPtable,__FILE__,"malloc","bPtable" ,__LINE__ -1 );
+			memset(bPtable,0,bytes);
+		}
 		
 		if(FLAGSAVEREADFILE)	{
 			/*Reading file for 1st bloom filter */
@@ -1442,6 +1985,7 @@ int main(int argc, char **argv)	{
 						}
 						memcpy(&bloom_bP[i],&oldbloom_bP,sizeof(struct bloom));//We only need to copy the part data to the new bloom size, not from the old size
 						bloom_bP[i].bf = (uint8_t*)bf_ptr;	/* Restoring the bf pointer*/
+						bloom_bP[i].mode = BLOOM_HASHED;	/* The old files are always hashed, their byte of the mode is cleared by oldbloom_init but the old format doesn't define it */
 						
 						readed = fread(bloom_bP[i].bf,bloom_bP[i].bytes,1,fd_aux1);
 						if(readed != 1)	{
@@ -1475,6 +2019,15 @@ int main(int argc, char **argv)	{
 				}
 			}
 			
+			/* The prefilter is made with the 1st bloom filter, it can't be made from its file */
+			if(FLAGREADEDFILE1 && bloom_bP_prefilter.ready)	{
+				snprintf(buffer_bloom_file,1024,"keyhunt_bsgs_9_%" PRIu64 ".blm",bsgs_m);
+				if(!readPrefilterFile(&bloom_bP_prefilter,buffer_bloom_file))	{
+					printf("[W] Without the file %s the prefilter is disabled, delete the bloom filter files to make it\n",buffer_bloom_file);
+					bloom_prefilter_free(&bloom_bP_prefilter);
+				}
+			}
+			
 			/*Reading file for 2nd bloom filter */
 			snprintf(buffer_bloom_file,1024,"keyhunt_bsgs_6_%" PRIu64 ".blm",bsgs_m2);
 			fd_aux2 = fopen(buffer_bloom_file,"rb");
@@ -1534,9 +2087,9 @@ int main(int argc, char **argv)	{
 				FLAGREADEDFILE2 = 0;
 			}
 			
-			/*Reading file for bPtable */
-			snprintf(buffer_bloom_file,1024,"keyhunt_bsgs_2_%" PRIu64 ".tbl",bsgs_m3);
-			fd_aux3 = fopen(buffer_bloom_file,"rb");
+			/*Reading file for bPtable, with --disk-table it is already open */
+			snprintf(buffer_bloom_file,1024,"keyhunt_bsgs_8_%" PRIu64 ".tbl",bsgs_m3);
+			fd_aux3 = (bPtable != NULL) ? fopen(buffer_bloom_file,"rb") : NULL;
 			if(fd_aux3 != NULL)	{
 				printf("[+] Reading bP Table from file %s .",buffer_bloom_file);
 				fflush(stdout);
@@ -1561,8 +2114,54 @@ int main(int argc, char **argv)	{
 				fclose(fd_aux3);
 				FLAGREADEDFILE3 = 1;
 			}
-			else	{
+			else if(bPtable != NULL)	{
 				FLAGREADEDFILE3 = 0;
+				/* Old bP Table with 16 bytes per entry, it is converted to the packed layout */
+				snprintf(buffer_bloom_file,1024,"keyhunt_bsgs_2_%" PRIu64 ".tbl",bsgs_m3);
+				fd_aux3 = fopen(buffer_bloom_file,"rb");
+				if(fd_aux3 != NULL)	{
+					struct bsgs_xvalue_v2 *oldbPtable;
+					uint64_t oldchunk,oldread,oldj;
+					CSHA256 oldsha;
+					printf("[+] Reading old bP Table from file %s .",buffer_bloom_file);
+					fflush(stdout);
+					oldbPtable = (struct bsgs_xvalue_v2*) malloc(THREADBPWORKLOAD * sizeof(struct bsgs_xvalue_v2));
+					checkpointer((void *)oldbPtable,__FILE__,"malloc","oldbPtable" ,__LINE__ -1 );
+					oldread = 0;
+					while(oldread < bsgs_m3)	{
+						oldchunk = (bsgs_m3 - oldread > THREADBPWORKLOAD) ? THREADBPWORKLOAD : bsgs_m3 - oldread;
+						rsize = fread(oldbPtable,oldchunk * sizeof(struct bsgs_xvalue_v2),1,fd_aux3);
+						if(rsize != 1)	{
+							fprintf(stderr,"[E] Error reading the file %s\n",buffer_bloom_file);
+							exit(EXIT_FAILURE);
+						}
+						oldsha.Write((unsigned char*)oldbPtable,oldchunk * sizeof(struct bsgs_xvalue_v2));
+						for(oldj = 0; oldj < oldchunk; oldj++)	{
+							memcpy(bPtable[oldread + oldj].value,oldbPtable[oldj].value,BSGS_XVALUE_RAM);
+							bsgs_setindex(&bPtable[oldread + oldj],oldbPtable[oldj].index);
+						}
+						oldread += oldchunk;
+					}
+					free(oldbPtable);
+					oldsha.Finalize((unsigned char*)checksum_backup);
+					rsize = fread(checksum,32,1,fd_aux3);
+					if(rsize != 1)	{
+						fprintf(stderr,"[E] Error reading the file %s\n",buffer_bloom_file);
+						exit(EXIT_FAILURE);
+					}
+					if(FLAGSKIPCHECKSUM == 0)	{
+						if(memcmp(checksum,checksum_backup,32) != 0)	{
+							fprintf(stderr,"[E] Error checksum file mismatch! %s\n",buffer_bloom_file);
+							exit(EXIT_FAILURE);
+						}
+					}
+					sha256((uint8_t*)bPtable,bytes,(uint8_t*)checksum);
+					memcpy(checksum_backup,checksum,32);
+					printf("... Done!\n");
+					fclose(fd_aux3);
+					FLAGUPDATEFILE3 = 1;	/* Flag to migrate the data to the new File keyhunt_bsgs_8_ */
+					FLAGREADEDFILE3 = 1;
+				}
 			}
 			
 			/*Reading file for 3rd bloom filter */
@@ -1747,6 +2346,20 @@ int main(int argc, char **argv)	{
 					//if(FLAGDEBUG) printf("[D] PERTHREAD_R: %lu\n",PERTHREAD_R);
 				}
 				
+				/* Chunks of THREADBPWORKLOAD points already done, with -S they are saved to continue after a crash */
+				bP_done = (uint8_t*) calloc((THREADCYCLES + 7) / 8,1);
+				checkpointer((void *)bP_done,__FILE__,"calloc","bP_done" ,__LINE__ -1 );
+				if(FLAGSAVEREADFILE && bsgs_progress_load(bP_done,THREADCYCLES))	{
+					for(i = 0; i < THREADCYCLES; i++)	{
+						if(bP_done[i >> 3] & (1 << (i & 7)))	{
+							FINISHED_THREADS_COUNTER++;
+							FINISHED_ITEMS += THREADBPWORKLOAD;
+						}
+					}
+					printf("[+] Continue the bP table generation, %" PRIu64 " of %" PRIu64 " chunks were done\n",FINISHED_THREADS_COUNTER,THREADCYCLES);
+				}
+				progress_time = time(NULL);
+				
 				printf("\r[+] processing %lu/%lu bP points : %i%%\r",FINISHED_ITEMS,bsgs_m,(int) (((double)FINISHED_ITEMS/(double)bsgs_m)*100));
 				fflush(stdout);
 				
@@ -1780,6 +2393,14 @@ int main(int argc, char **argv)	{
 					for(j = 0; j < NTHREADS && !salir; j++)	{
 
 						if(bPload_threads_available[j] && !salir)	{
+							while(THREADCOUNTER < THREADCYCLES && (bP_done[THREADCOUNTER >> 3] & (1 << (THREADCOUNTER & 7))))	{
+								BASE+=THREADBPWORKLOAD;
+								THREADCOUNTER++;
+							}
+							if(THREADCOUNTER == THREADCYCLES)	{
+								salir = 1;
+								break;
+							}
 							bPload_threads_available[j] = 0;
 							bPload_temp_ptr[j].from = BASE;
 							bPload_temp_ptr[j].threadid = j;
@@ -1827,9 +2448,13 @@ int main(int argc, char **argv)	{
 							bPload_threads_available[j] = 1;
 							FINISHED_ITEMS += bPload_temp_ptr[j].workload;
 							FINISHED_THREADS_COUNTER++;
+							bP_done[(bPload_temp_ptr[j].from / THREADBPWORKLOAD) >> 3] |= 1 << ((bPload_temp_ptr[j].from / THREADBPWORKLOAD) & 7);
 						}
 					}
-					
+					if(FLAGSAVEREADFILE && FINISHED_THREADS_COUNTER < THREADCYCLES && (uint64_t)(time(NULL) - progress_time) >= (FLAGCHECKPOINT ? CHECKPOINT_SECONDS : BSGS_PROGRESS_SECONDS))	{
+						bsgs_progress_save(bP_done,THREADCYCLES);
+						progress_time = time(NULL);
+					}
 				}while(FINISHED_THREADS_COUNTER < THREADCYCLES);
 				printf("\r[+] processing %lu/%lu bP points : 100%%     \n",bsgs_m,bsgs_m);
 				
@@ -1837,6 +2462,7 @@ int main(int argc, char **argv)	{
 				free(bPload_mutex);
 				free(bPload_temp_ptr);
 				free(bPload_threads_available);
+				free(bP_done);
 			}
 		}
 		
@@ -1878,7 +2504,7 @@ int main(int argc, char **argv)	{
 			printf("Done!\n");
 			fflush(stdout);
 		}
-		if(FLAGSAVEREADFILE || FLAGUPDATEFILE1 )	{
+		if(FLAGSAVEREADFILE || FLAGUPDATEFILE1 || FLAGUPDATEFILE3)	{
 			if(!FLAGREADEDFILE1 || FLAGUPDATEFILE1)	{
 				snprintf(buffer_bloom_file,1024,"keyhunt_bsgs_4_%" PRIu64 ".blm",bsgs_m);
 				
@@ -1920,6 +2546,10 @@ int main(int argc, char **argv)	{
 					fprintf(stderr,"[E] Error can't create the file %s\n",buffer_bloom_file);
 					exit(EXIT_FAILURE);
 				}
+				if(!FLAGREADEDFILE1 && bloom_bP_prefilter.ready)	{
+					snprintf(buffer_bloom_file,1024,"keyhunt_bsgs_9_%" PRIu64 ".blm",bsgs_m);
+					writePrefilterFile(&bloom_bP_prefilter,buffer_bloom_file);
+				}
 			}
 			if(!FLAGREADEDFILE2  )	{
 				
@@ -1960,9 +2590,12 @@ int main(int argc, char **argv)	{
 				}
 			}
 			
-			if(!FLAGREADEDFILE3)	{
+			if(!FLAGREADEDFILE3 || FLAGUPDATEFILE3)	{
 				/* Writing file for bPtable */
-				snprintf(buffer_bloom_file,1024,"keyhunt_bsgs_2_%" PRIu64 ".tbl",bsgs_m3);
+				if(FLAGUPDATEFILE3)	{
+					printf("[W] Updating old file into a new one\n");
+				}
+				snprintf(buffer_bloom_file,1024,"keyhunt_bsgs_8_%" PRIu64 ".tbl",bsgs_m3);
 				fd_aux3 = fopen(buffer_bloom_file,"wb");
 				if(fd_aux3 != NULL)	{
 					printf("[+] Writing bP Table to file %s .. ",buffer_bloom_file);
@@ -1979,6 +2612,9 @@ int main(int argc, char **argv)	{
 					}
 					printf("Done!\n");
 					fclose(fd_aux3);	
+					if(FLAGUPDATEFILE3)	{
+						printf("[W] Unused file detected keyhunt_bsgs_2_%" PRIu64 ".tbl you can delete it without worry\n",bsgs_m3);
+					}
 				}
 				else	{
 					fprintf(stderr,"[E] Error can't create the file %s\n",buffer_bloom_file);
@@ -2022,15 +2658,36 @@ int main(int argc, char **argv)	{
 					exit(EXIT_FAILURE);
 				}
 			}
+			/* All the files are written, the progress of the generation is not needed anymore */
+			snprintf(buffer_bloom_file,1024,"keyhunt_bsgs_%" PRIu64 ".progress",bsgs_m);
+			remove(buffer_bloom_file);
+		}
+		if(FLAGDISKTABLE && bPtable != NULL)	{
+			/* The bP Table was made or migrated in RAM, now that it is in the file the RAM is released */
+			free(bPtable);
+			bPtable = NULL;
+			snprintf(buffer_bloom_file,1024,"keyhunt_bsgs_8_%" PRIu64 ".tbl",bsgs_m3);
+			if(!bsgs_disktable_open(buffer_bloom_file))	{
+				fprintf(stderr,"[E] Can't open the file %s\n",buffer_bloom_file);
+				exit(EXIT_FAILURE);
+			}
 		}
+#ifdef BSGS_TABLES
+		printf("[+] BSGS tables for %" PRIu64 " bP points are ready\n",bsgs_m);
+		exit(EXIT_SUCCESS);
+#endif
 
 
 		i = 0;
 
-		steps = (uint64_t *) calloc(NTHREADS,sizeof(uint64_t));
-		checkpointer((void *)steps,__FILE__,"calloc","steps" ,__LINE__ -1 );
-		ends = (unsigned int *) calloc(NTHREADS,sizeof(int));
-		checkpointer((void *)ends,__FILE__,"calloc","ends" ,__LINE__ -1 );
+		if(FLAGCHECKPOINT)	{
+			init_checkpoint(fileName,&BSGS_N_double);
+		}
+		WORKER_CHUNK.Set(&BSGS_N_double);
+		BSGS_TOP.Set(&n_range_end);
+		workers = new struct worker_context[NTHREADS]();
+		worker_place();
+		results_begin();
 #if defined(_WIN64) && !defined(__CYGWIN__)
 		tid = (HANDLE*)calloc(NTHREADS, sizeof(HANDLE));
 #else
@@ -2042,7 +2699,6 @@ int main(int argc, char **argv)	{
 			tt = (tothread*) malloc(sizeof(struct tothread));
 			checkpointer((void *)tt,__FILE__,"malloc","tt" ,__LINE__ -1 );
 			tt->nt = j;
-			steps[j] = 0;
 			s = 0;
 			switch(FLAGBSGSMODE)	{
 #if defined(_WIN64) && !defined(__CYGWIN__)
@@ -2092,10 +2748,16 @@ int main(int argc, char **argv)	{
 		free(aux);
 	}
 	if(FLAGMODE != MODE_BSGS)	{
-		steps = (uint64_t *) calloc(NTHREADS,sizeof(uint64_t));
-		checkpointer((void *)steps,__FILE__,"calloc","steps" ,__LINE__ -1 );
-		ends = (unsigned int *) calloc(NTHREADS,sizeof(int));
-		checkpointer((void *)ends,__FILE__,"calloc","ends" ,__LINE__ -1 );
+		if(FLAGCHECKPOINT)	{
+			aux_chunk.SetInt64(N_SEQUENTIAL_MAX);
+			init_checkpoint(fileName,&aux_chunk);
+		}
+		WORKER_CHUNK.SetInt64(N_SEQUENTIAL_MAX);
+		RANGE_CURRENT.Set(&n_range_start);
+		search_thread = thread_process_select();
+		workers = new struct worker_context[NTHREADS]();
+		worker_place();
+		results_begin();
 #if defined(_WIN64) && !defined(__CYGWIN__)
 		tid = (HANDLE*)calloc(NTHREADS, sizeof(HANDLE));
 #else
@@ -2106,14 +2768,13 @@ int main(int argc, char **argv)	{
 			tt = (tothread*) malloc(sizeof(struct tothread));
 			checkpointer((void *)tt,__FILE__,"malloc","tt" ,__LINE__ -1 );
 			tt->nt = j;
-			steps[j] = 0;
 			s = 0;
 			switch(FLAGMODE)	{
 #if defined(_WIN64) && !defined(__CYGWIN__)
 				case MODE_ADDRESS:
 				case MODE_XPOINT:
 				case MODE_RMD160:
-					tid[j] = CreateThread(NULL, 0, thread_process, (void*)tt, 0, &s);
+					tid[j] = CreateThread(NULL, 0, search_thread, (void*)tt, 0, &s);
 				break;
 				case MODE_MINIKEYS:
 					tid[j] = CreateThread(NULL, 0, thread_process_minikeys, (void*)tt, 0, &s);
@@ -2121,11 +2782,14 @@ int main(int argc, char **argv)	{
 				case MODE_VANITY:
 					tid[j] = CreateThread(NULL, 0, thread_process_vanity, (void*)tt, 0, &s);
 				break;
+				case MODE_KANGAROO:
+					tid[j] = CreateThread(NULL, 0, thread_process_kangaroo, (void*)tt, 0, &s);
+				break;
 #else
 				case MODE_ADDRESS:
 				case MODE_XPOINT:
 				case MODE_RMD160:
-					s = pthread_create(&tid[j],NULL,thread_process,(void *)tt);
+					s = pthread_create(&tid[j],NULL,search_thread,(void *)tt);
 				break;
 				case MODE_MINIKEYS:
 					s = pthread_create(&tid[j],NULL,thread_process_minikeys,(void *)tt);
@@ -2133,6 +2797,9 @@ int main(int argc, char **argv)	{
 				case MODE_VANITY:
 					s = pthread_create(&tid[j],NULL,thread_process_vanity,(void *)tt);
 				break;
+				case MODE_KANGAROO:
+					s = pthread_create(&tid[j],NULL,thread_process_kangaroo,(void *)tt);
+				break;
 #endif
 			}
 			if(s != 0)	{
@@ -2142,120 +2809,87 @@ int main(int argc, char **argv)	{
 		}
 	}
 	
-	for(j =0; j < 7; j++)	{
-		int_limits[j].SetBase10((char*)str_limits[j]);
+	memset(&snapshot,0,sizeof(snapshot));
+	snapshot.mode = modes[FLAGMODE];
+	snapshot.threads = NTHREADS;
+	snapshot.thread_rate = (double*) calloc(NTHREADS,sizeof(double));
+	checkpointer((void *)snapshot.thread_rate,__FILE__,"calloc","thread_rate" ,__LINE__ -1 );
+	stats_previous = (uint64_t*) calloc(NTHREADS,sizeof(uint64_t));
+	checkpointer((void *)stats_previous,__FILE__,"calloc","stats_previous" ,__LINE__ -1 );
+	if(!FLAGRANDOM && !FLAGWORKER && FLAGMODE != MODE_MINIKEYS && FLAGMODE != MODE_KANGAROO && !(FLAGMODE == MODE_BSGS && FLAGBSGSMODE > 2) && n_range_end.IsGreater(&n_range_start))	{
+		int_aux.Set(&n_range_end);
+		int_aux.Sub(&n_range_start);
+		stats_range = metrics_double(&int_aux);
 	}
+	metrics_seconds = OUTPUTSECONDS.IsZero() ? METRICS_FILE_DEFAULT_SECONDS : OUTPUTSECONDS.GetInt64();
 	
 	continue_flag = 1;
 	total.SetInt32(0);
-	pretotal.SetInt32(0);
-	debugcount_mpz.Set(&BSGS_N);
 	seconds.SetInt32(0);
 	do	{
 		sleep_ms(1000);
 		seconds.AddOne();
+		if(FLAGBENCHRUN)	{
+			bench_report(seconds.GetInt64());
+		}
 		check_flag = 1;
 		for(j = 0; j <NTHREADS && check_flag; j++) {
-			check_flag &= ends[j];
+			check_flag &= workers[j].end.load(std::memory_order_relaxed);
 		}
 		if(check_flag)	{
 			continue_flag = 0;
 		}
-		if(OUTPUTSECONDS.IsGreater(&ZERO) ){
-			MPZAUX.Set(&seconds);
+		stats_collect(&snapshot,seconds.GetInt64(),&total);
+		metrics_publish(&snapshot);
+		if(metrics_file != NULL && snapshot.seconds % metrics_seconds == 0)	{
+			metrics_jsonline(&snapshot,metrics_file);
+		}
+		MPZAUX.Set(&seconds);
+		if(OUTPUTSECONDS.IsGreater(&ZERO))	{
 			MPZAUX.Mod(&OUTPUTSECONDS);
-			if(MPZAUX.IsZero()) {
-				total.SetInt32(0);
-				for(j = 0; j < NTHREADS; j++) {
-					pretotal.Set(&debugcount_mpz);
-					pretotal.Mult(steps[j]);					
-					total.Add(&pretotal);
-				}
-				
-				if(FLAGENDOMORPHISM)	{
-					if(FLAGMODE == MODE_XPOINT)	{
-						total.Mult(3);
-					}
-					else	{
-						total.Mult(6);
-					}
-				}
-				else	{
-					if(FLAGSEARCH == SEARCH_COMPRESS)	{
-						total.Mult(2);
-					}
-				}
-				
-#ifdef _WIN64
-				WaitForSingleObject(bsgs_thread, INFINITE);
-#else
-				pthread_mutex_lock(&bsgs_thread);
-#endif			
-				pretotal.Set(&total);
-				pretotal.Div(&seconds);
-				str_seconds = seconds.GetBase10();
-				str_pretotal = pretotal.GetBase10();
-				str_total = total.GetBase10();
-				
-				
-				if(pretotal.IsLower(&int_limits[0]))	{
-					if(FLAGMATRIX)	{
-						sprintf(buffer,"[+] Total %s keys in %s seconds: %s keys/s\n",str_total,str_seconds,str_pretotal);
-					}
-					else	{
-						sprintf(buffer,"\r[+] Total %s keys in %s seconds: %s keys/s\r",str_total,str_seconds,str_pretotal);
-					}
-				}
-				else	{
-					i = 0;
-					salir = 0;
-					while( i < 6 && !salir)	{
-						if(pretotal.IsLower(&int_limits[i+1]))	{
-							salir = 1;
-						}
-						else	{
-							i++;
-						}
-					}
-
-					div_pretotal.Set(&pretotal);
-					div_pretotal.Div(&int_limits[salir ? i : i-1]);
-					str_divpretotal = div_pretotal.GetBase10();
-					if(FLAGMATRIX)	{
-						sprintf(buffer,"[+] Total %s keys in %s seconds: ~%s %s (%s keys/s)\n",str_total,str_seconds,str_divpretotal,str_limits_prefixs[salir ? i : i-1],str_pretotal);
-					}
-					else	{
-						if(THREADOUTPUT == 1)	{
-							sprintf(buffer,"\r[+] Total %s keys in %s seconds: ~%s %s (%s keys/s)\r",str_total,str_seconds,str_divpretotal,str_limits_prefixs[salir ? i : i-1],str_pretotal);
-						}
-						else	{
-							sprintf(buffer,"\r[+] Total %s keys in %s seconds: ~%s %s (%s keys/s)\r",str_total,str_seconds,str_divpretotal,str_limits_prefixs[salir ? i : i-1],str_pretotal);
-						}
-					}
-					free(str_divpretotal);
-
-				}
-				printf("%s",buffer);
-				fflush(stdout);
-				THREADOUTPUT = 0;			
-#ifdef _WIN64
-				ReleaseMutex(bsgs_thread);
-#else
-				pthread_mutex_unlock(&bsgs_thread);
-#endif
-
-				free(str_seconds);
-				free(str_pretotal);
-				free(str_total);
+		}
+		if(OUTPUTSECONDS.IsGreater(&ZERO) && MPZAUX.IsZero())	{
+			stats_print(&snapshot);
+			if(FLAGPROFILE)	{
+				printf("\n");
+				profile_print();
 			}
+			fflush(stdout);
+		}
+		else if(!FLAGQUIET && !FLAGMATRIX)	{
+			stats_printbase();
+		}
+		if(FLAGMODE == MODE_KANGAROO && FLAGSAVEREADFILE && seconds.GetInt64() % KANGAROO_SAVE_SECONDS == 0)	{
+			kangaroo_savefile();
+		}
+		if(FLAGCHECKPOINT && seconds.GetInt64() % CHECKPOINT_SECONDS == 0)	{
+			save_checkpoint();
+		}
+		if(FLAGWORKER && seconds.GetInt64() % CLUSTER_HEARTBEAT_SECONDS == 0)	{
+			get_total_keys(&total);
+			cluster_heartbeat(&keyhunt_worker,&total);
 		}
 	}while(continue_flag);
+	if(FLAGCHECKPOINT)	{
+		save_checkpoint();
+	}
+	if(FLAGPROFILE)	{
+		printf("\n");
+		profile_print();
+	}
+	if(metrics_file != NULL)	{
+		metrics_jsonline(&snapshot,metrics_file);
+		fclose(metrics_file);
+	}
+	results_stop(&results,NULL);
 	printf("\nEnd\n");
 #ifdef _WIN64
 	CloseHandle(write_keys);
 	CloseHandle(write_random);
 	CloseHandle(bsgs_thread);
+	CloseHandle(kangaroo_save);
 #endif
+	return 0;
 }
 
 void pubkeytopubaddress_dst(char *pkey,int length,char *dst)	{
@@ -2311,6 +2945,7 @@ char *pubkeytopubaddress(char *pkey,int length)	{
 int searchbinary(struct address_value *buffer,char *data,int64_t array_length) {
 	int64_t half,min,max,current;
 	int r = 0,rcmp;
+	uint64_t profile_time = profile_tsc();
 	min = 0;
 	current = 0;
 	max = array_length;
@@ -2331,6 +2966,12 @@ int searchbinary(struct address_value *buffer,char *data,int64_t array_length) {
 			current = min;
 		}
 	}
+	/* Only called after a hit of the bloom filter */
+	stats_count(METRICS_HIT_BLOOM);
+	if(r)	{
+		stats_count(METRICS_HIT_TABLE);
+	}
+	profile_stage(PROFILE_SEARCH,&profile_time);
 	return r;
 }
 
@@ -2343,19 +2984,26 @@ void *thread_process_minikeys(void *vargp)	{
 	Point publickey[4];
 	Int key_mpz[4];
 	struct tothread *tt;
+	struct worker_context *ctx;
 	uint64_t count;
 	char publickeyhashrmd160_uncompress[4][20];
 	char public_key_uncompressed_hex[131];
-	char address[4][40],minikey[4][24],minikeys[8][24],buffer_b58[21],minikey2check[24],rawvalue[4][32];
+	char address[4][40],minikey[8][24],minikeys[12][24],buffer_b58[21],minikey2check[24],rawvalue[8][32];
 	char *hextemp,*rawbuffer;
 	int r,thread_number,continue_flag = 1,k,j,count_valid;
 	Int counter;
 	tt = (struct tothread *)vargp;
 	thread_number = tt->nt;
+	ctx = &workers[thread_number];
+	worker_pin(ctx);
+	/* Tables of the NUMA node of the thread */
+	Secp256K1 *secp = ctx->tables->secp;
+	stats_thread = &ctx->stats;
+	results_thread = &results.rings[thread_number];
 	free(tt);
 	rawbuffer = (char*) &counter.bits64;
 	count_valid = 0;
-	for(k = 0; k < 4; k++)	{
+	for(k = 0; k < 8; k++)	{
 		minikey[k][0] = 'S';
 		minikey[k][22] = '?';
 		minikey[k][23] = 0x00;
@@ -2435,24 +3083,20 @@ void *thread_process_minikeys(void *vargp)	{
 							memcpy(minikeys[k],minikeys[4+k],22);
 						}
 					}
-					do	{
-						increment_minikey_index(minikey2check+1,buffer_b58,20);
-						memcpy(minikey[0]+1,minikey2check+1,21);
-						increment_minikey_index(minikey2check+1,buffer_b58,20);
-						memcpy(minikey[1]+1,minikey2check+1,21);
-						increment_minikey_index(minikey2check+1,buffer_b58,20);
-						memcpy(minikey[2]+1,minikey2check+1,21);
-						increment_minikey_index(minikey2check+1,buffer_b58,20);
-						memcpy(minikey[3]+1,minikey2check+1,21);
-						
-						sha256sse_23((uint8_t*)minikey[0],(uint8_t*)minikey[1],(uint8_t*)minikey[2],(uint8_t*)minikey[3],(uint8_t*)rawvalue[0],(uint8_t*)rawvalue[1],(uint8_t*)rawvalue[2],(uint8_t*)rawvalue[3]);
-						for(k = 0; k < 4; k++){
+					/* 8 candidates per check, up to 7 valid minikeys are kept for the next round */
+					while(count_valid < 4)	{
+						for(k = 0; k < 8; k++)	{
+							increment_minikey_index(minikey2check+1,buffer_b58,20);
+							memcpy(minikey[k]+1,minikey2check+1,21);
+						}
+						sha256sse_23((uint8_t*)minikey[0],(uint8_t*)minikey[1],(uint8_t*)minikey[2],(uint8_t*)minikey[3],(uint8_t*)minikey[4],(uint8_t*)minikey[5],(uint8_t*)minikey[6],(uint8_t*)minikey[7],(uint8_t*)rawvalue[0],(uint8_t*)rawvalue[1],(uint8_t*)rawvalue[2],(uint8_t*)rawvalue[3],(uint8_t*)rawvalue[4],(uint8_t*)rawvalue[5],(uint8_t*)rawvalue[6],(uint8_t*)rawvalue[7]);
+						for(k = 0; k < 8; k++){
 							if(rawvalue[k][0] == 0x00)	{
 								memcpy(minikeys[count_valid],minikey[k],22);
 								count_valid++;
 							}
 						}
-					}while(count_valid < 4);
+					}
 					count_valid-=4;				
 					sha256sse_22((uint8_t*)minikeys[0],(uint8_t*)minikeys[1],(uint8_t*)minikeys[2],(uint8_t*)minikeys[3],(uint8_t*)rawvalue[0],(uint8_t*)rawvalue[1],(uint8_t*)rawvalue[2],(uint8_t*)rawvalue[3]);
 					
@@ -2464,7 +3108,7 @@ void *thread_process_minikeys(void *vargp)	{
 					secp->GetHash160(P2PKH,false,publickey[0],publickey[1],publickey[2],publickey[3],(uint8_t*)publickeyhashrmd160_uncompress[0],(uint8_t*)publickeyhashrmd160_uncompress[1],(uint8_t*)publickeyhashrmd160_uncompress[2],(uint8_t*)publickeyhashrmd160_uncompress[3]);
 					
 					for(k = 0; k < 4; k++)	{
-						r = bloom_check(&bloom,publickeyhashrmd160_uncompress[k],20);
+						r = bloom_check_prefiltered(&bloom_prefilter,&bloom,publickeyhashrmd160_uncompress[k],20);
 						if(r) {
 							r = searchbinary(addressTable,publickeyhashrmd160_uncompress[k],N);
 							if(r) {
@@ -2496,7 +3140,7 @@ void *thread_process_minikeys(void *vargp)	{
 						}
 					}
 				}
-				steps[thread_number]++;
+				metrics_add(&ctx->stats.steps,1);
 				count+=1024;
 			}while(count < N_SEQUENTIAL_MAX && continue_flag);
 		}
@@ -2505,91 +3149,186 @@ void *thread_process_minikeys(void *vargp)	{
 }
 
 
+/*
+	Points startP - (CPU_GRP_SIZE/2)*G ... startP + (CPU_GRP_SIZE/2 - 1)*G of the
+	batch with the inverses of dx, only the coordinates are written (there is
+	no copy of startP for each point), y only if Y is true. The i*G and the
+	next start point are the same for the callers, so they are not here
+*/
+template<bool Y>
+static inline void group_points(Point &startP,std::vector<Point> &G,Int *dx,Int *x,Int *y)	{
+	Int dy,_s,_p;
+	int i,pp,pn;
+	x[CPU_GRP_SIZE / 2].Set(&startP.x);	// center point
+	if(Y)	{
+		y[CPU_GRP_SIZE / 2].Set(&startP.y);
+	}
+	for(i = 0; i < CPU_GRP_SIZE / 2; i++)	{
+		pp = CPU_GRP_SIZE / 2 + (i + 1);
+		pn = CPU_GRP_SIZE / 2 - (i + 1);
+		if(i < CPU_GRP_SIZE / 2 - 1)	{
+			// P = startP + i*G
+			dy.ModSub(&G[i].y,&startP.y);
+			_s.ModMulK1(&dy,&dx[i]);	// s = (p2.y-p1.y)*inverse(p2.x-p1.x);
+			_p.ModSquareK1(&_s);		// _p = pow2(s)
+			x[pp].ModSub(&_p,&startP.x);
+			x[pp].ModSub(&G[i].x);		// rx = pow2(s) - p1.x - p2.x;
+			if(Y)	{
+				y[pp].ModSub(&G[i].x,&x[pp]);
+				y[pp].ModMulK1(&_s);
+				y[pp].ModSub(&G[i].y);	// ry = - p2.y - s*(ret.x-p2.x);
+			}
+		}
+		// P = startP - i*G  , if (x,y) = i*G then (x,-y) = -i*G, the last one is the first point
+		dy.Set(&G[i].y);
+		dy.ModNeg();
+		dy.ModSub(&startP.y);
+		_s.ModMulK1(&dy,&dx[i]);
+		_p.ModSquareK1(&_s);
+		x[pn].ModSub(&_p,&startP.x);
+		x[pn].ModSub(&G[i].x);
+		if(Y)	{
+			y[pn].ModSub(&G[i].x,&x[pn]);
+			y[pn].ModMulK1(&_s);
+			y[pn].ModAdd(&G[i].y);
+		}
+	}
+}
+
+/* Points of four x and y of the buffers for the hash functions that take Point, negated if negate */
+static inline void group_quad(Point *quad,Int *x,Int *y,bool negate)	{
+	for(int i = 0; i < 4; i++)	{
+		quad[i].x.Set(&x[i]);
+		quad[i].y.Set(&y[i]);
+		if(negate)	{
+			quad[i].y.ModNeg();
+		}
+	}
+}
+
+/*
+	Search of the address, rmd160 and xpoint modes. There is one instance for
+	each valid combination of the flags (rmd160 is MODE_ADDRESS here), so the
+	loops only have the hashes, checks and buffers of that combination, the
+	instance is selected once by thread_process_select()
+*/
+template<int MODE,int CRYPTO,int SEARCH,bool ENDOMORPHISM,bool EXACT>
 #if defined(_WIN64) && !defined(__CYGWIN__)
 DWORD WINAPI thread_process(LPVOID vargp) {
 #else
 void *thread_process(void *vargp)	{
 #endif
+	const bool COMPRESS = MODE == MODE_ADDRESS && CRYPTO == CRYPTO_BTC && SEARCH != SEARCH_UNCOMPRESS;
+	const bool UNCOMPRESS = MODE == MODE_ADDRESS && CRYPTO == CRYPTO_BTC && SEARCH != SEARCH_COMPRESS;
+	const bool ETH = MODE == MODE_ADDRESS && CRYPTO == CRYPTO_ETH;
+	/* The y is only needed by the uncompressed publickeys and the parity of --exact-range */
+	const bool calculate_y = UNCOMPRESS || ETH || EXACT;
+	const int compress_prefixes = EXACT ? 1 : 2;	// Only the prefix of the parity of y with --exact-range
+	/* Hashes 0 to 5 are compressed (or eth) and 6 to 11 uncompressed with endomorphism */
+	const int hashes = ENDOMORPHISM ? 12 : 2;
 	struct tothread *tt;
-	Point pts[CPU_GRP_SIZE];
-	Point endomorphism_beta[CPU_GRP_SIZE];
-	Point endomorphism_beta2[CPU_GRP_SIZE];
+	struct worker_context *ctx;
+	/* x of the group, of the beta and beta^2 points with endomorphism, the y is the same for the three */
+	Int *x,*y,*beta_x,*beta2_x;
+	Point quad[4];
 	Point endomorphism_negeted_point[4];
-	
-	Int dx[CPU_GRP_SIZE / 2 + 1];
-	IntGroup *grp = new IntGroup(CPU_GRP_SIZE / 2 + 1);
+
+	Int *dx;
+	IntGroup *grp;
 	Point startP;
 	Int dy;
-	Int dyn;
 	Int _s;
 	Int _p;
 	Point pp;
-	Point pn;
-	int i,l,pp_offset,pn_offset,hLength = (CPU_GRP_SIZE / 2 - 1);
-	uint64_t j,count;
+	int i,l,hLength = (CPU_GRP_SIZE / 2 - 1);
+	uint64_t j;
 	Point R,temporal,publickey;
-	int r,thread_number,continue_flag = 1,k;
+	int r,thread_number,continue_flag = 1,k,rescan = 0;
 	char *hextemp = NULL;
 	
 	char publickeyhashrmd160[20];
 	char publickeyhashrmd160_uncompress[4][20];
 	char rawvalue[32];
 	
-	char publickeyhashrmd160_endomorphism[12][4][20];
-	
-	bool calculate_y = FLAGSEARCH == SEARCH_UNCOMPRESS || FLAGSEARCH == SEARCH_BOTH || FLAGCRYPTO  == CRYPTO_ETH;
-	Int key_mpz,keyfound,temp_stride;
+	char publickeyhashrmd160_endomorphism[hashes][4][20];
+
+	Int key_mpz,keyfound,chunk_base;
+	struct group_walker walker;
+	uint64_t lease = 0;
 	tt = (struct tothread *)vargp;
 	thread_number = tt->nt;
+	ctx = &workers[thread_number];
+	worker_pin(ctx);
+	/* Tables of the NUMA node of the thread */
+	Secp256K1 *secp = ctx->tables->secp;
+	std::vector<Point> &Gn = *ctx->tables->Gn;
+	Point &_2Gn = *ctx->tables->_2Gn;
+	stats_thread = &ctx->stats;
+	results_thread = &results.rings[thread_number];
+	worker_alloc(ctx,CPU_GRP_SIZE / 2 + 1,0,0);
+	worker_alloc_xy(ctx,ENDOMORPHISM ? 3 * CPU_GRP_SIZE : CPU_GRP_SIZE,calculate_y);
+	grp = ctx->grp;
+	dx = ctx->dx;
+	x = ctx->x;
+	y = ctx->y;
+	beta_x = x + CPU_GRP_SIZE;
+	beta2_x = x + 2 * CPU_GRP_SIZE;
 	free(tt);
-	grp->Set(dx);
+	profile_thread = FLAGPROFILE ? &ctx->profile : NULL;
+	uint64_t profile_time = 0;
 			
 	do {
-		if(FLAGRANDOM){
-			key_mpz.Rand(&n_range_start,&n_range_end);
+		if(rescan)	{
+			key_mpz.Set(&chunk_base);	/* The same chunk again after a point mismatch */
+		}
+		else if(FLAGRANDOM){
+			if(FLAGCHECKPOINT)	{
+				if(!checkpoint_random(&keyhunt_checkpoint,&key_mpz))	{
+					continue_flag = 0;
+				}
+			}
+			else	{
+				key_mpz.Rand(&n_range_start,&n_range_end);
+			}
 		}
 		else	{
-			if(n_range_start.IsLower(&n_range_end))	{
+			if(FLAGWORKER)	{
+				if(!cluster_nextchunk(&keyhunt_worker,&WORKER_CHUNK,&key_mpz,&lease))	{
+					continue_flag = 0;
+				}
+			}
+			else if(RANGE_CURRENT.IsLower(&n_range_end))	{
 #if defined(_WIN64) && !defined(__CYGWIN__)
 				WaitForSingleObject(write_random, INFINITE);
-				key_mpz.Set(&n_range_start);
-				n_range_start.Add(N_SEQUENTIAL_MAX);
+				key_mpz.Set(&RANGE_CURRENT);
+				RANGE_CURRENT.Add(N_SEQUENTIAL_MAX);
 				ReleaseMutex(write_random);
 #else
 				pthread_mutex_lock(&write_random);
-				key_mpz.Set(&n_range_start);
-				n_range_start.Add(N_SEQUENTIAL_MAX);
+				key_mpz.Set(&RANGE_CURRENT);
+				RANGE_CURRENT.Add(N_SEQUENTIAL_MAX);
 				pthread_mutex_unlock(&write_random);
 #endif
+				if(FLAGCHECKPOINT && checkpoint_isdone(&keyhunt_checkpoint,&key_mpz))	{
+					continue;	/* This chunk was done before the last stop */
+				}
 			}
 			else	{
 				continue_flag = 0;
 			}
 		}
 		if(continue_flag)	{
-			count = 0;
+			chunk_base.Set(&key_mpz);
+			walker_start(&walker,&key_mpz,&startP);
 			if(FLAGMATRIX)	{
 					hextemp = key_mpz.GetBase16();
 					printf("Base key: %s thread %i\n",hextemp,thread_number);
 					fflush(stdout);
 					free(hextemp);
 			}
-			else	{
-				if(FLAGQUIET == 0){
-					hextemp = key_mpz.GetBase16();
-					printf("\rBase key: %s     \r",hextemp);
-					fflush(stdout);
-					free(hextemp);
-					THREADOUTPUT = 1;
-				}
-			}
+			metrics_setbase(&ctx->stats,&key_mpz);
 			do {
-				temp_stride.SetInt32(CPU_GRP_SIZE / 2);
-				temp_stride.Mult(&stride);
-				key_mpz.Add(&temp_stride);
-	 			startP = secp->ComputePublicKey(&key_mpz);
-				key_mpz.Sub(&temp_stride);
-
+				profile_time = profile_tsc();
 				for(i = 0; i < hLength; i++) {
 					dx[i].ModSub(&Gn[i].x,&startP.x);
 				}
@@ -2597,209 +3336,112 @@ void *thread_process(void *vargp)	{
 				dx[i].ModSub(&Gn[i].x,&startP.x);  // For the first point
 				dx[i + 1].ModSub(&_2Gn.x,&startP.x); // For the next center point
 				grp->ModInv();
+				profile_stage(PROFILE_INVERSION,&profile_time);
 
-				pts[CPU_GRP_SIZE / 2] = startP;
-
-				for(i = 0; i<hLength; i++) {
-					pp = startP;
-					pn = startP;
-
-					// P = startP + i*G
-					dy.ModSub(&Gn[i].y,&pp.y);
-
-					_s.ModMulK1(&dy,&dx[i]);        // s = (p2.y-p1.y)*inverse(p2.x-p1.x);
-					_p.ModSquareK1(&_s);            // _p = pow2(s)
-
-					pp.x.ModNeg();
-					pp.x.ModAdd(&_p);
-					pp.x.ModSub(&Gn[i].x);           // rx = pow2(s) - p1.x - p2.x;
-
-					if(calculate_y)	{
-						pp.y.ModSub(&Gn[i].x,&pp.x);
-						pp.y.ModMulK1(&_s);
-						pp.y.ModSub(&Gn[i].y);           // ry = - p2.y - s*(ret.x-p2.x);
-					}
-
-					// P = startP - i*G  , if (x,y) = i*G then (x,-y) = -i*G
-					dyn.Set(&Gn[i].y);
-					dyn.ModNeg();
-					dyn.ModSub(&pn.y);
-
-					_s.ModMulK1(&dyn,&dx[i]);      // s = (p2.y-p1.y)*inverse(p2.x-p1.x);
-					_p.ModSquareK1(&_s);            // _p = pow2(s)
-					pn.x.ModNeg();
-					pn.x.ModAdd(&_p);
-					pn.x.ModSub(&Gn[i].x);          // rx = pow2(s) - p1.x - p2.x;
-
-					if(calculate_y)	{
-						pn.y.ModSub(&Gn[i].x,&pn.x);
-						pn.y.ModMulK1(&_s);
-						pn.y.ModAdd(&Gn[i].y);          // ry = - p2.y - s*(ret.x-p2.x);
-					}
-
-					pp_offset = CPU_GRP_SIZE / 2 + (i + 1);
-					pn_offset = CPU_GRP_SIZE / 2 - (i + 1);
-
-					pts[pp_offset] = pp;
-					pts[pn_offset] = pn;
-					
-					if(FLAGENDOMORPHISM)	{
-						/*
-							Q = (x,y)
-							For any point Q
-							Q*lambda = (x*beta mod p ,y)
-							Q*lambda is a Scalar Multiplication
-							x*beta is just a Multiplication (Very fast)
-						*/
-						
-						if( calculate_y  )	{
-							endomorphism_beta[pp_offset].y.Set(&pp.y);
-							endomorphism_beta[pn_offset].y.Set(&pn.y);
-							endomorphism_beta2[pp_offset].y.Set(&pp.y);
-							endomorphism_beta2[pn_offset].y.Set(&pn.y);
-						}
-						endomorphism_beta[pp_offset].x.ModMulK1(&pp.x, &beta);
-						endomorphism_beta[pn_offset].x.ModMulK1(&pn.x, &beta);
-						endomorphism_beta2[pp_offset].x.ModMulK1(&pp.x, &beta2);
-						endomorphism_beta2[pn_offset].x.ModMulK1(&pn.x, &beta2);
-					}
-				}
-				/*
-					Half point for endomorphism because pts[CPU_GRP_SIZE / 2] was not calcualte in the previous cycle
-				*/
-				if(FLAGENDOMORPHISM)	{
-					if( calculate_y  )	{
-
-						endomorphism_beta[CPU_GRP_SIZE / 2].y.Set(&pts[CPU_GRP_SIZE / 2].y);
-						endomorphism_beta2[CPU_GRP_SIZE / 2].y.Set(&pts[CPU_GRP_SIZE / 2].y);
-					}
-					endomorphism_beta[CPU_GRP_SIZE / 2].x.ModMulK1(&pts[CPU_GRP_SIZE / 2].x, &beta);
-					endomorphism_beta2[CPU_GRP_SIZE / 2].x.ModMulK1(&pts[CPU_GRP_SIZE / 2].x, &beta2);
-				}
-
-				// First point (startP - (GRP_SZIE/2)*G)
-				pn = startP;
-				dyn.Set(&Gn[i].y);
-				dyn.ModNeg();
-				dyn.ModSub(&pn.y);
-
-				_s.ModMulK1(&dyn,&dx[i]);
-				_p.ModSquareK1(&_s);
-
-				pn.x.ModNeg();
-				pn.x.ModAdd(&_p);
-				pn.x.ModSub(&Gn[i].x);
-				
-				if(calculate_y)	{
-					pn.y.ModSub(&Gn[i].x,&pn.x);
-					pn.y.ModMulK1(&_s);
-					pn.y.ModAdd(&Gn[i].y);
-				}
-
-				pts[0] = pn;
-				
-				/*
-					First point for endomorphism because pts[0] was not calcualte previously
-				*/
-				if(FLAGENDOMORPHISM)	{
-					if( calculate_y  )	{
-						endomorphism_beta[0].y.Set(&pn.y);
-						endomorphism_beta2[0].y.Set(&pn.y);
+				group_points<calculate_y>(startP,Gn,dx,x,y);
+				if(ENDOMORPHISM)	{
+					/*
+						Q = (x,y)
+						For any point Q
+						Q*lambda = (x*beta mod p ,y)
+						Q*lambda is a Scalar Multiplication
+						x*beta is just a Multiplication (Very fast)
+					*/
+					for(l = 0; l < CPU_GRP_SIZE; l++)	{	// i stays in hLength for the next center point
+						beta_x[l].ModMulK1(&x[l],&beta);
+						beta2_x[l].ModMulK1(&x[l],&beta2);
 					}
-					endomorphism_beta[0].x.ModMulK1(&pn.x, &beta);
-					endomorphism_beta2[0].x.ModMulK1(&pn.x, &beta2);
 				}
-								
+				profile_stage(PROFILE_POINTS,&profile_time);
 				for(j = 0; j < CPU_GRP_SIZE/4;j++){
-					switch(FLAGMODE)	{
-						case MODE_RMD160:
+					switch(MODE)	{
 						case MODE_ADDRESS:
-							if(FLAGCRYPTO == CRYPTO_BTC){
+							if(CRYPTO == CRYPTO_BTC){
 								
-								if(FLAGSEARCH == SEARCH_COMPRESS || FLAGSEARCH == SEARCH_BOTH ){
-									if(FLAGENDOMORPHISM)	{
-										secp->GetHash160_fromX(P2PKH,0x02,&pts[(j*4)].x,&pts[(j*4)+1].x,&pts[(j*4)+2].x,&pts[(j*4)+3].x,(uint8_t*)publickeyhashrmd160_endomorphism[0][0],(uint8_t*)publickeyhashrmd160_endomorphism[0][1],(uint8_t*)publickeyhashrmd160_endomorphism[0][2],(uint8_t*)publickeyhashrmd160_endomorphism[0][3]);
-										secp->GetHash160_fromX(P2PKH,0x03,&pts[(j*4)].x,&pts[(j*4)+1].x,&pts[(j*4)+2].x,&pts[(j*4)+3].x,(uint8_t*)publickeyhashrmd160_endomorphism[1][0],(uint8_t*)publickeyhashrmd160_endomorphism[1][1],(uint8_t*)publickeyhashrmd160_endomorphism[1][2],(uint8_t*)publickeyhashrmd160_endomorphism[1][3]);
+								if(COMPRESS){
+									if(ENDOMORPHISM)	{
+										secp->GetHash160_fromX(P2PKH,&x[(j*4)],&x[(j*4)+1],&x[(j*4)+2],&x[(j*4)+3],(uint8_t*)publickeyhashrmd160_endomorphism[0][0],(uint8_t*)publickeyhashrmd160_endomorphism[0][1],(uint8_t*)publickeyhashrmd160_endomorphism[0][2],(uint8_t*)publickeyhashrmd160_endomorphism[0][3],(uint8_t*)publickeyhashrmd160_endomorphism[1][0],(uint8_t*)publickeyhashrmd160_endomorphism[1][1],(uint8_t*)publickeyhashrmd160_endomorphism[1][2],(uint8_t*)publickeyhashrmd160_endomorphism[1][3]);
 
-										secp->GetHash160_fromX(P2PKH,0x02,&endomorphism_beta[(j*4)].x,&endomorphism_beta[(j*4)+1].x,&endomorphism_beta[(j*4)+2].x,&endomorphism_beta[(j*4)+3].x,(uint8_t*)publickeyhashrmd160_endomorphism[2][0],(uint8_t*)publickeyhashrmd160_endomorphism[2][1],(uint8_t*)publickeyhashrmd160_endomorphism[2][2],(uint8_t*)publickeyhashrmd160_endomorphism[2][3]);
-										secp->GetHash160_fromX(P2PKH,0x03,&endomorphism_beta[(j*4)].x,&endomorphism_beta[(j*4)+1].x,&endomorphism_beta[(j*4)+2].x,&endomorphism_beta[(j*4)+3].x,(uint8_t*)publickeyhashrmd160_endomorphism[3][0],(uint8_t*)publickeyhashrmd160_endomorphism[3][1],(uint8_t*)publickeyhashrmd160_endomorphism[3][2],(uint8_t*)publickeyhashrmd160_endomorphism[3][3]);
+										secp->GetHash160_fromX(P2PKH,&beta_x[(j*4)],&beta_x[(j*4)+1],&beta_x[(j*4)+2],&beta_x[(j*4)+3],(uint8_t*)publickeyhashrmd160_endomorphism[2][0],(uint8_t*)publickeyhashrmd160_endomorphism[2][1],(uint8_t*)publickeyhashrmd160_endomorphism[2][2],(uint8_t*)publickeyhashrmd160_endomorphism[2][3],(uint8_t*)publickeyhashrmd160_endomorphism[3][0],(uint8_t*)publickeyhashrmd160_endomorphism[3][1],(uint8_t*)publickeyhashrmd160_endomorphism[3][2],(uint8_t*)publickeyhashrmd160_endomorphism[3][3]);
 
-										secp->GetHash160_fromX(P2PKH,0x02,&endomorphism_beta2[(j*4)].x,&endomorphism_beta2[(j*4)+1].x,&endomorphism_beta2[(j*4)+2].x,&endomorphism_beta2[(j*4)+3].x,(uint8_t*)publickeyhashrmd160_endomorphism[4][0],(uint8_t*)publickeyhashrmd160_endomorphism[4][1],(uint8_t*)publickeyhashrmd160_endomorphism[4][2],(uint8_t*)publickeyhashrmd160_endomorphism[4][3]);
-										secp->GetHash160_fromX(P2PKH,0x03,&endomorphism_beta2[(j*4)].x,&endomorphism_beta2[(j*4)+1].x,&endomorphism_beta2[(j*4)+2].x,&endomorphism_beta2[(j*4)+3].x,(uint8_t*)publickeyhashrmd160_endomorphism[5][0],(uint8_t*)publickeyhashrmd160_endomorphism[5][1],(uint8_t*)publickeyhashrmd160_endomorphism[5][2],(uint8_t*)publickeyhashrmd160_endomorphism[5][3]);
+										secp->GetHash160_fromX(P2PKH,&beta2_x[(j*4)],&beta2_x[(j*4)+1],&beta2_x[(j*4)+2],&beta2_x[(j*4)+3],(uint8_t*)publickeyhashrmd160_endomorphism[4][0],(uint8_t*)publickeyhashrmd160_endomorphism[4][1],(uint8_t*)publickeyhashrmd160_endomorphism[4][2],(uint8_t*)publickeyhashrmd160_endomorphism[4][3],(uint8_t*)publickeyhashrmd160_endomorphism[5][0],(uint8_t*)publickeyhashrmd160_endomorphism[5][1],(uint8_t*)publickeyhashrmd160_endomorphism[5][2],(uint8_t*)publickeyhashrmd160_endomorphism[5][3]);
+									}
+									else if(EXACT)	{
+										group_quad(quad,&x[(j*4)],&y[(j*4)],false);
+									secp->GetHash160(P2PKH,true,quad[0],quad[1],quad[2],quad[3],(uint8_t*)publickeyhashrmd160_endomorphism[0][0],(uint8_t*)publickeyhashrmd160_endomorphism[0][1],(uint8_t*)publickeyhashrmd160_endomorphism[0][2],(uint8_t*)publickeyhashrmd160_endomorphism[0][3]);
 									}
 									else	{
-										secp->GetHash160_fromX(P2PKH,0x02,&pts[(j*4)].x,&pts[(j*4)+1].x,&pts[(j*4)+2].x,&pts[(j*4)+3].x,(uint8_t*)publickeyhashrmd160_endomorphism[0][0],(uint8_t*)publickeyhashrmd160_endomorphism[0][1],(uint8_t*)publickeyhashrmd160_endomorphism[0][2],(uint8_t*)publickeyhashrmd160_endomorphism[0][3]);
-										secp->GetHash160_fromX(P2PKH,0x03,&pts[(j*4)].x,&pts[(j*4)+1].x,&pts[(j*4)+2].x,&pts[(j*4)+3].x,(uint8_t*)publickeyhashrmd160_endomorphism[1][0],(uint8_t*)publickeyhashrmd160_endomorphism[1][1],(uint8_t*)publickeyhashrmd160_endomorphism[1][2],(uint8_t*)publickeyhashrmd160_endomorphism[1][3]);
+										secp->GetHash160_fromX(P2PKH,&x[(j*4)],&x[(j*4)+1],&x[(j*4)+2],&x[(j*4)+3],(uint8_t*)publickeyhashrmd160_endomorphism[0][0],(uint8_t*)publickeyhashrmd160_endomorphism[0][1],(uint8_t*)publickeyhashrmd160_endomorphism[0][2],(uint8_t*)publickeyhashrmd160_endomorphism[0][3],(uint8_t*)publickeyhashrmd160_endomorphism[1][0],(uint8_t*)publickeyhashrmd160_endomorphism[1][1],(uint8_t*)publickeyhashrmd160_endomorphism[1][2],(uint8_t*)publickeyhashrmd160_endomorphism[1][3]);
 									}
 									
 								}
-								if(FLAGSEARCH == SEARCH_UNCOMPRESS || FLAGSEARCH == SEARCH_BOTH){
-									if(FLAGENDOMORPHISM)	{
-										for(l = 0; l < 4; l++)	{
-											endomorphism_negeted_point[l] = secp->Negation(pts[(j*4)+l]);
-										}
-										secp->GetHash160(P2PKH,false, pts[(j*4)], pts[(j*4)+1], pts[(j*4)+2], pts[(j*4)+3],(uint8_t*)publickeyhashrmd160_endomorphism[6][0],(uint8_t*)publickeyhashrmd160_endomorphism[6][1],(uint8_t*)publickeyhashrmd160_endomorphism[6][2],(uint8_t*)publickeyhashrmd160_endomorphism[6][3]);
-										secp->GetHash160(P2PKH,false,endomorphism_negeted_point[0] ,endomorphism_negeted_point[1],endomorphism_negeted_point[2],endomorphism_negeted_point[3],(uint8_t*)publickeyhashrmd160_endomorphism[7][0],(uint8_t*)publickeyhashrmd160_endomorphism[7][1],(uint8_t*)publickeyhashrmd160_endomorphism[7][2],(uint8_t*)publickeyhashrmd160_endomorphism[7][3]);
-										for(l = 0; l < 4; l++)	{
-											endomorphism_negeted_point[l] = secp->Negation(endomorphism_beta[(j*4)+l]);
-										}
-										secp->GetHash160(P2PKH,false,endomorphism_beta[(j*4)],  endomorphism_beta[(j*4)+1], endomorphism_beta[(j*4)+2], endomorphism_beta[(j*4)+3] ,(uint8_t*)publickeyhashrmd160_endomorphism[8][0],(uint8_t*)publickeyhashrmd160_endomorphism[8][1],(uint8_t*)publickeyhashrmd160_endomorphism[8][2],(uint8_t*)publickeyhashrmd160_endomorphism[8][3]);
-										secp->GetHash160(P2PKH,false,endomorphism_negeted_point[0],endomorphism_negeted_point[1],endomorphism_negeted_point[2],endomorphism_negeted_point[3],(uint8_t*)publickeyhashrmd160_endomorphism[9][0],(uint8_t*)publickeyhashrmd160_endomorphism[9][1],(uint8_t*)publickeyhashrmd160_endomorphism[9][2],(uint8_t*)publickeyhashrmd160_endomorphism[9][3]);
-
-										for(l = 0; l < 4; l++)	{
-											endomorphism_negeted_point[l] = secp->Negation(endomorphism_beta2[(j*4)+l]);
-										}
-										secp->GetHash160(P2PKH,false, endomorphism_beta2[(j*4)],  endomorphism_beta2[(j*4)+1] ,  endomorphism_beta2[(j*4)+2] ,  endomorphism_beta2[(j*4)+3] ,(uint8_t*)publickeyhashrmd160_endomorphism[10][0],(uint8_t*)publickeyhashrmd160_endomorphism[10][1],(uint8_t*)publickeyhashrmd160_endomorphism[10][2],(uint8_t*)publickeyhashrmd160_endomorphism[10][3]);
-										secp->GetHash160(P2PKH,false, endomorphism_negeted_point[0], endomorphism_negeted_point[1],   endomorphism_negeted_point[2],endomorphism_negeted_point[3],(uint8_t*)publickeyhashrmd160_endomorphism[11][0],(uint8_t*)publickeyhashrmd160_endomorphism[11][1],(uint8_t*)publickeyhashrmd160_endomorphism[11][2],(uint8_t*)publickeyhashrmd160_endomorphism[11][3]);
+								if(UNCOMPRESS){
+									if(ENDOMORPHISM)	{
+										group_quad(quad,&x[(j*4)],&y[(j*4)],false);
+										group_quad(endomorphism_negeted_point,&x[(j*4)],&y[(j*4)],true);
+										secp->GetHash160(P2PKH,false,quad[0],quad[1],quad[2],quad[3],endomorphism_negeted_point[0],endomorphism_negeted_point[1],endomorphism_negeted_point[2],endomorphism_negeted_point[3],(uint8_t*)publickeyhashrmd160_endomorphism[6][0],(uint8_t*)publickeyhashrmd160_endomorphism[6][1],(uint8_t*)publickeyhashrmd160_endomorphism[6][2],(uint8_t*)publickeyhashrmd160_endomorphism[6][3],(uint8_t*)publickeyhashrmd160_endomorphism[7][0],(uint8_t*)publickeyhashrmd160_endomorphism[7][1],(uint8_t*)publickeyhashrmd160_endomorphism[7][2],(uint8_t*)publickeyhashrmd160_endomorphism[7][3]);
+										group_quad(quad,&beta_x[(j*4)],&y[(j*4)],false);
+										group_quad(endomorphism_negeted_point,&beta_x[(j*4)],&y[(j*4)],true);
+										secp->GetHash160(P2PKH,false,quad[0],quad[1],quad[2],quad[3],endomorphism_negeted_point[0],endomorphism_negeted_point[1],endomorphism_negeted_point[2],endomorphism_negeted_point[3],(uint8_t*)publickeyhashrmd160_endomorphism[8][0],(uint8_t*)publickeyhashrmd160_endomorphism[8][1],(uint8_t*)publickeyhashrmd160_endomorphism[8][2],(uint8_t*)publickeyhashrmd160_endomorphism[8][3],(uint8_t*)publickeyhashrmd160_endomorphism[9][0],(uint8_t*)publickeyhashrmd160_endomorphism[9][1],(uint8_t*)publickeyhashrmd160_endomorphism[9][2],(uint8_t*)publickeyhashrmd160_endomorphism[9][3]);
+
+										group_quad(quad,&beta2_x[(j*4)],&y[(j*4)],false);
+										group_quad(endomorphism_negeted_point,&beta2_x[(j*4)],&y[(j*4)],true);
+										secp->GetHash160(P2PKH,false,quad[0],quad[1],quad[2],quad[3],endomorphism_negeted_point[0],endomorphism_negeted_point[1],endomorphism_negeted_point[2],endomorphism_negeted_point[3],(uint8_t*)publickeyhashrmd160_endomorphism[10][0],(uint8_t*)publickeyhashrmd160_endomorphism[10][1],(uint8_t*)publickeyhashrmd160_endomorphism[10][2],(uint8_t*)publickeyhashrmd160_endomorphism[10][3],(uint8_t*)publickeyhashrmd160_endomorphism[11][0],(uint8_t*)publickeyhashrmd160_endomorphism[11][1],(uint8_t*)publickeyhashrmd160_endomorphism[11][2],(uint8_t*)publickeyhashrmd160_endomorphism[11][3]);
 
 									}
 									else	{
-										secp->GetHash160(P2PKH,false,pts[(j*4)],pts[(j*4)+1],pts[(j*4)+2],pts[(j*4)+3],(uint8_t*)publickeyhashrmd160_uncompress[0],(uint8_t*)publickeyhashrmd160_uncompress[1],(uint8_t*)publickeyhashrmd160_uncompress[2],(uint8_t*)publickeyhashrmd160_uncompress[3]);
+										group_quad(quad,&x[(j*4)],&y[(j*4)],false);
+										secp->GetHash160(P2PKH,false,quad[0],quad[1],quad[2],quad[3],(uint8_t*)publickeyhashrmd160_uncompress[0],(uint8_t*)publickeyhashrmd160_uncompress[1],(uint8_t*)publickeyhashrmd160_uncompress[2],(uint8_t*)publickeyhashrmd160_uncompress[3]);
 										
 									}
 								}
 							}								
-							else if(FLAGCRYPTO == CRYPTO_ETH){
-								if(FLAGENDOMORPHISM)	{
+							else if(CRYPTO == CRYPTO_ETH){
+								if(ENDOMORPHISM)	{
+									group_quad(quad,&x[(j*4)],&y[(j*4)],false);
+									group_quad(endomorphism_negeted_point,&x[(j*4)],&y[(j*4)],true);
 									for(k = 0; k < 4;k++)	{
-										endomorphism_negeted_point[k] = secp->Negation(pts[(j*4)+k]);
-										generate_binaddress_eth(pts[(4*j)+k],(uint8_t*)publickeyhashrmd160_endomorphism[0][k]);
+										generate_binaddress_eth(quad[k],(uint8_t*)publickeyhashrmd160_endomorphism[0][k]);
 										generate_binaddress_eth(endomorphism_negeted_point[k],(uint8_t*)publickeyhashrmd160_endomorphism[1][k]);
-										endomorphism_negeted_point[k] = secp->Negation(endomorphism_beta[(j*4)+k]);
-										generate_binaddress_eth(endomorphism_beta[(4*j)+k],(uint8_t*)publickeyhashrmd160_endomorphism[2][k]);
+									}
+									group_quad(quad,&beta_x[(j*4)],&y[(j*4)],false);
+									group_quad(endomorphism_negeted_point,&beta_x[(j*4)],&y[(j*4)],true);
+									for(k = 0; k < 4;k++)	{
+										generate_binaddress_eth(quad[k],(uint8_t*)publickeyhashrmd160_endomorphism[2][k]);
 										generate_binaddress_eth(endomorphism_negeted_point[k],(uint8_t*)publickeyhashrmd160_endomorphism[3][k]);
-										endomorphism_negeted_point[k] = secp->Negation(endomorphism_beta2[(j*4)+k]);
-										generate_binaddress_eth(endomorphism_beta[(4*j)+k],(uint8_t*)publickeyhashrmd160_endomorphism[4][k]);
+									}
+									group_quad(quad,&beta2_x[(j*4)],&y[(j*4)],false);
+									group_quad(endomorphism_negeted_point,&beta2_x[(j*4)],&y[(j*4)],true);
+									for(k = 0; k < 4;k++)	{
+										generate_binaddress_eth(quad[k],(uint8_t*)publickeyhashrmd160_endomorphism[4][k]);
 										generate_binaddress_eth(endomorphism_negeted_point[k],(uint8_t*)publickeyhashrmd160_endomorphism[5][k]);
 									}
 								}
 								else	{
+									group_quad(quad,&x[(j*4)],&y[(j*4)],false);
 									for(k = 0; k < 4;k++)	{
-										generate_binaddress_eth(pts[(4*j)+k],(uint8_t*)publickeyhashrmd160_uncompress[k]);
+										generate_binaddress_eth(quad[k],(uint8_t*)publickeyhashrmd160_uncompress[k]);
 									}
 								}
 								
 							}
 						break;
 					}
+					profile_stage(PROFILE_HASH,&profile_time);
 
-
-					switch(FLAGMODE)	{
-						case MODE_RMD160:
+					switch(MODE)	{
 						case MODE_ADDRESS:
-							if( FLAGCRYPTO  == CRYPTO_BTC) {
+							if(CRYPTO == CRYPTO_BTC) {
 								
 								for(k = 0; k < 4;k++)	{
-									if(FLAGSEARCH == SEARCH_COMPRESS || FLAGSEARCH == SEARCH_BOTH){
-										if(FLAGENDOMORPHISM)	{
+									if(COMPRESS){
+										if(ENDOMORPHISM)	{
 											for(l = 0;l < 6; l++)	{
-												r = bloom_check(&bloom,publickeyhashrmd160_endomorphism[l][k],MAXLENGTHADDRESS);
+												r = bloom_check_prefiltered(&bloom_prefilter,&bloom,publickeyhashrmd160_endomorphism[l][k],MAXLENGTHADDRESS);
 												if(r) {
 													r = searchbinary(addressTable,publickeyhashrmd160_endomorphism[l][k],N);
 													if(r) {
-														keyfound.SetInt32(k);
-														keyfound.Mult(&stride);
-														keyfound.Add(&key_mpz);
+														walker_key(&walker,k,&keyfound);
 														publickey = secp->ComputePublicKey(&keyfound);
 														switch(l)	{
 															case 0:	//Original point, prefix 02
@@ -2855,14 +3497,12 @@ void *thread_process(void *vargp)	{
 											}
 										}
 										else	{
-											for(l = 0;l < 2; l++)	{
-												r = bloom_check(&bloom,publickeyhashrmd160_endomorphism[l][k],MAXLENGTHADDRESS);
+											for(l = 0;l < compress_prefixes; l++)	{
+												r = bloom_check_prefiltered(&bloom_prefilter,&bloom,publickeyhashrmd160_endomorphism[l][k],MAXLENGTHADDRESS);
 												if(r) {
 													r = searchbinary(addressTable,publickeyhashrmd160_endomorphism[l][k],N);
 													if(r) {
-														keyfound.SetInt32(k);
-														keyfound.Mult(&stride);
-														keyfound.Add(&key_mpz);
+														walker_key(&walker,k,&keyfound);
 														
 														publickey = secp->ComputePublicKey(&keyfound);
 														secp->GetHash160(P2PKH,true,publickey,(uint8_t*)publickeyhashrmd160);
@@ -2877,16 +3517,14 @@ void *thread_process(void *vargp)	{
 										}
 									}
 
-									if(FLAGSEARCH == SEARCH_UNCOMPRESS || FLAGSEARCH == SEARCH_BOTH)	{
-										if(FLAGENDOMORPHISM)	{
+									if(UNCOMPRESS)	{
+										if(ENDOMORPHISM)	{
 											for(l = 6;l < 12; l++)	{	//We check the array from 6 to 12(excluded) because we save the uncompressed information there
-												r = bloom_check(&bloom,publickeyhashrmd160_endomorphism[l][k],MAXLENGTHADDRESS);	//Check in Bloom filter
+												r = bloom_check_prefiltered(&bloom_prefilter,&bloom,publickeyhashrmd160_endomorphism[l][k],MAXLENGTHADDRESS);	//Check in Bloom filter
 												if(r) {
 													r = searchbinary(addressTable,publickeyhashrmd160_endomorphism[l][k],N);		//Check in Array using Binary search
 													if(r) {
-														keyfound.SetInt32(k);
-														keyfound.Mult(&stride);
-														keyfound.Add(&key_mpz);
+														walker_key(&walker,k,&keyfound);
 														switch(l)	{
 															case 6:
 															case 7:
@@ -2924,13 +3562,11 @@ void *thread_process(void *vargp)	{
 											}
 										}
 										else	{
-											r = bloom_check(&bloom,publickeyhashrmd160_uncompress[k],MAXLENGTHADDRESS);
+											r = bloom_check_prefiltered(&bloom_prefilter,&bloom,publickeyhashrmd160_uncompress[k],MAXLENGTHADDRESS);
 											if(r) {
 												r = searchbinary(addressTable,publickeyhashrmd160_uncompress[k],N);
 												if(r) {
-													keyfound.SetInt32(k);
-													keyfound.Mult(&stride);
-													keyfound.Add(&key_mpz);
+													walker_key(&walker,k,&keyfound);
 													writekey(false,&keyfound);
 												}
 											}
@@ -2938,17 +3574,15 @@ void *thread_process(void *vargp)	{
 									}
 								}
 							}
-							else if( FLAGCRYPTO == CRYPTO_ETH) {
-								if(FLAGENDOMORPHISM)	{
+							else if(CRYPTO == CRYPTO_ETH) {
+								if(ENDOMORPHISM)	{
 									for(k = 0; k < 4;k++)	{
 										for(l = 0;l < 6; l++)	{
-											r = bloom_check(&bloom,publickeyhashrmd160_endomorphism[l][k],MAXLENGTHADDRESS);
+											r = bloom_check_prefiltered(&bloom_prefilter,&bloom,publickeyhashrmd160_endomorphism[l][k],MAXLENGTHADDRESS);
 											if(r) {
 												r = searchbinary(addressTable,publickeyhashrmd160_endomorphism[l][k],N);
 												if(r) {												
-													keyfound.SetInt32(k);
-													keyfound.Mult(&stride);
-													keyfound.Add(&key_mpz);
+													walker_key(&walker,k,&keyfound);
 													switch(l)	{
 														case 0:
 														case 1:
@@ -2988,13 +3622,11 @@ void *thread_process(void *vargp)	{
 								}
 								else	{
 									for(k = 0; k < 4;k++)	{
-										r = bloom_check(&bloom,publickeyhashrmd160_uncompress[k],MAXLENGTHADDRESS);
+										r = bloom_check_prefiltered(&bloom_prefilter,&bloom,publickeyhashrmd160_uncompress[k],MAXLENGTHADDRESS);
 										if(r) {
 											r = searchbinary(addressTable,publickeyhashrmd160_uncompress[k],N);
 											if(r) {
-												keyfound.SetInt32(k);
-												keyfound.Mult(&stride);
-												keyfound.Add(&key_mpz);
+												walker_key(&walker,k,&keyfound);
 												writekeyeth(&keyfound);
 											}
 										}
@@ -3004,55 +3636,47 @@ void *thread_process(void *vargp)	{
 						break;
 						case MODE_XPOINT:
 							for(k = 0; k < 4;k++)	{
-								if(FLAGENDOMORPHISM)	{
-									pts[(4*j)+k].x.Get32Bytes((unsigned char *)rawvalue);
-									r = bloom_check(&bloom,rawvalue,MAXLENGTHADDRESS);
+								if(ENDOMORPHISM)	{
+									x[(4*j)+k].Get32Bytes((unsigned char *)rawvalue);
+									r = bloom_check_prefiltered(&bloom_prefilter,&bloom,rawvalue,MAXLENGTHADDRESS);
 									if(r) {
 										r = searchbinary(addressTable,rawvalue,N);
 										if(r) {
-											keyfound.SetInt32(k);
-											keyfound.Mult(&stride);
-											keyfound.Add(&key_mpz);
+											walker_key(&walker,k,&keyfound);
 											
 											writekey(false,&keyfound);
 										}
 									}
-									endomorphism_beta[(j*4)+k].x.Get32Bytes((unsigned char *)rawvalue);
-									r = bloom_check(&bloom,rawvalue,MAXLENGTHADDRESS);
+									beta_x[(j*4)+k].Get32Bytes((unsigned char *)rawvalue);
+									r = bloom_check_prefiltered(&bloom_prefilter,&bloom,rawvalue,MAXLENGTHADDRESS);
 									if(r) {
 										r = searchbinary(addressTable,rawvalue,N);
 										if(r) {
-											keyfound.SetInt32(k);
-											keyfound.Mult(&stride);
-											keyfound.Add(&key_mpz);
+											walker_key(&walker,k,&keyfound);
 											keyfound.ModMulK1order(&lambda);
 											
 											writekey(false,&keyfound);
 										}
 									}
 									
-									endomorphism_beta2[(j*4)+k].x.Get32Bytes((unsigned char *)rawvalue);
-									r = bloom_check(&bloom,rawvalue,MAXLENGTHADDRESS);
+									beta2_x[(j*4)+k].Get32Bytes((unsigned char *)rawvalue);
+									r = bloom_check_prefiltered(&bloom_prefilter,&bloom,rawvalue,MAXLENGTHADDRESS);
 									if(r) {
 										r = searchbinary(addressTable,rawvalue,N);
 										if(r) {
-											keyfound.SetInt32(k);
-											keyfound.Mult(&stride);
-											keyfound.Add(&key_mpz);
+											walker_key(&walker,k,&keyfound);
 											keyfound.ModMulK1order(&lambda2);
 											writekey(false,&keyfound);
 										}
 									}
 								}
 								else	{
-									pts[(4*j)+k].x.Get32Bytes((unsigned char *)rawvalue);
-									r = bloom_check(&bloom,rawvalue,MAXLENGTHADDRESS);
+									x[(4*j)+k].Get32Bytes((unsigned char *)rawvalue);
+									r = bloom_check_prefiltered(&bloom_prefilter,&bloom,rawvalue,MAXLENGTHADDRESS);
 									if(r) {
 										r = searchbinary(addressTable,rawvalue,N);
 										if(r) {
-											keyfound.SetInt32(k);
-											keyfound.Mult(&stride);
-											keyfound.Add(&key_mpz);
+											walker_key(&walker,k,&keyfound);
 											
 											writekey(false,&keyfound);
 										}
@@ -3061,10 +3685,8 @@ void *thread_process(void *vargp)	{
 							}
 						break;
 					}
-					count+=4;
-					temp_stride.SetInt32(4);
-					temp_stride.Mult(&stride);
-					key_mpz.Add(&temp_stride);
+					profile_stage(PROFILE_BLOOM,&profile_time);
+					walker.offset+=4;
 				}
 				/*
 				if(FLAGDEBUG) {
@@ -3073,7 +3695,7 @@ void *thread_process(void *vargp)	{
 				}
 				*/
 
-				steps[thread_number]++;
+				metrics_add(&ctx->stats.steps,1);
 
 				// Next start point (startP + GRP_SIZE*G)
 				pp = startP;
@@ -3091,28 +3713,83 @@ void *thread_process(void *vargp)	{
 				pp.y.ModMulK1(&_s);
 				pp.y.ModSub(&_2Gn.y);
 				startP = pp;
-			}while(count < N_SEQUENTIAL_MAX && continue_flag);
+			}while(walker.offset < N_SEQUENTIAL_MAX && continue_flag);
+			/* A chunk with a point mismatch is checked again, it is never marked as done */
+			if(!walker_check(&walker,&startP))	{
+				if(rescan)	{
+					fprintf(stderr,"[E] Point mismatch again at the end of the chunk, thread %i\n",thread_number);
+					results_stop(&results,NULL);
+					exit(EXIT_FAILURE);
+				}
+				fprintf(stderr,"[W] Point mismatch at the end of the chunk, thread %i, checking it again\n",thread_number);
+				rescan = 1;
+				continue;
+			}
+			rescan = 0;
+			if(FLAGCHECKPOINT && walker.offset >= N_SEQUENTIAL_MAX)	{
+				checkpoint_done(&keyhunt_checkpoint,&chunk_base);
+			}
+			if(FLAGWORKER && walker.offset >= N_SEQUENTIAL_MAX)	{
+				cluster_chunkdone(&keyhunt_worker,lease);
+			}
 		}
 	} while(continue_flag);
-	ends[thread_number] = 1;
+	ctx->end.store(1,std::memory_order_relaxed);
 	return NULL;
 }
 
 
+/* Instance of thread_process for the flags of the command line */
+thread_function thread_process_select()	{
+	if(FLAGMODE == MODE_XPOINT)	{
+		if(FLAGENDOMORPHISM)	{
+			return thread_process<MODE_XPOINT,CRYPTO_NONE,SEARCH_COMPRESS,true,false>;
+		}
+		return thread_process<MODE_XPOINT,CRYPTO_NONE,SEARCH_COMPRESS,false,false>;
+	}
+	if(FLAGCRYPTO == CRYPTO_ETH)	{
+		if(FLAGENDOMORPHISM)	{
+			return thread_process<MODE_ADDRESS,CRYPTO_ETH,SEARCH_UNCOMPRESS,true,false>;
+		}
+		return thread_process<MODE_ADDRESS,CRYPTO_ETH,SEARCH_UNCOMPRESS,false,false>;
+	}
+	switch(FLAGSEARCH)	{
+		case SEARCH_COMPRESS:
+			if(FLAGENDOMORPHISM)	{
+				return thread_process<MODE_ADDRESS,CRYPTO_BTC,SEARCH_COMPRESS,true,false>;
+			}
+			if(FLAGEXACTRANGE)	{
+				return thread_process<MODE_ADDRESS,CRYPTO_BTC,SEARCH_COMPRESS,false,true>;
+			}
+			return thread_process<MODE_ADDRESS,CRYPTO_BTC,SEARCH_COMPRESS,false,false>;
+		case SEARCH_UNCOMPRESS:
+			if(FLAGENDOMORPHISM)	{
+				return thread_process<MODE_ADDRESS,CRYPTO_BTC,SEARCH_UNCOMPRESS,true,false>;
+			}
+			return thread_process<MODE_ADDRESS,CRYPTO_BTC,SEARCH_UNCOMPRESS,false,false>;
+	}
+	if(FLAGENDOMORPHISM)	{
+		return thread_process<MODE_ADDRESS,CRYPTO_BTC,SEARCH_BOTH,true,false>;
+	}
+	return thread_process<MODE_ADDRESS,CRYPTO_BTC,SEARCH_BOTH,false,false>;
+}
+
+
 #if defined(_WIN64) && !defined(__CYGWIN__)
 DWORD WINAPI thread_process_vanity(LPVOID vargp) {
 #else
 void *thread_process_vanity(void *vargp)	{
 #endif
 	struct tothread *tt;
-	Point pts[CPU_GRP_SIZE];
+	struct worker_context *ctx;
+	Point *pts;
 	Point endomorphism_beta[CPU_GRP_SIZE];
 	Point endomorphism_beta2[CPU_GRP_SIZE];
 	Point endomorphism_negeted_point[4];
 		
-	Int dx[CPU_GRP_SIZE / 2 + 1];
+	Int *dx;
 	
-	IntGroup *grp = new IntGroup(CPU_GRP_SIZE / 2 + 1);
+	IntGroup *grp;
 	Point startP;
 	Int dy;
 	Int dyn;
@@ -3121,20 +3798,33 @@ void *thread_process_vanity(void *vargp)	{
 	Point pp;	//point positive
 	Point pn;	//point negative
 	int l,pp_offset,pn_offset,i,hLength = (CPU_GRP_SIZE / 2 - 1);
-	uint64_t j,count;
+	uint64_t j;
 	Point R,temporal,publickey;
-	int thread_number,continue_flag = 1,k;
+	int thread_number,continue_flag = 1,k,rescan = 0;
 	char *hextemp = NULL;
 	char publickeyhashrmd160[20];
 	char publickeyhashrmd160_uncompress[4][20];
 	
 	char publickeyhashrmd160_endomorphism[12][4][20];
 	
-	Int key_mpz,temp_stride,keyfound;
+	Int key_mpz,keyfound,chunk_base;
+	struct group_walker walker;
+	uint64_t lease = 0;
 	tt = (struct tothread *)vargp;
 	thread_number = tt->nt;
+	ctx = &workers[thread_number];
+	worker_pin(ctx);
+	/* Tables of the NUMA node of the thread */
+	Secp256K1 *secp = ctx->tables->secp;
+	std::vector<Point> &Gn = *ctx->tables->Gn;
+	Point &_2Gn = *ctx->tables->_2Gn;
+	stats_thread = &ctx->stats;
+	results_thread = &results.rings[thread_number];
+	worker_alloc(ctx,CPU_GRP_SIZE / 2 + 1,CPU_GRP_SIZE,0);
+	grp = ctx->grp;
+	dx = ctx->dx;
+	pts = ctx->pts;
 	free(tt);
-	grp->Set(dx);
 	
 	
 	//if FLAGENDOMORPHISM  == 1 and only compress search is enabled then there is no need to calculate the Y value value					
@@ -3155,51 +3845,56 @@ void *thread_process_vanity(void *vargp)	{
 	
 
 	do {
-		if(FLAGRANDOM){
-			key_mpz.Rand(&n_range_start,&n_range_end);
+		if(rescan)	{
+			key_mpz.Set(&chunk_base);	/* The same chunk again after a point mismatch */
+		}
+		else if(FLAGRANDOM){
+			if(FLAGCHECKPOINT)	{
+				if(!checkpoint_random(&keyhunt_checkpoint,&key_mpz))	{
+					continue_flag = 0;
+				}
+			}
+			else	{
+				key_mpz.Rand(&n_range_start,&n_range_end);
+			}
 		}
 		else	{
-			if(n_range_start.IsLower(&n_range_end))	{
+			if(FLAGWORKER)	{
+				if(!cluster_nextchunk(&keyhunt_worker,&WORKER_CHUNK,&key_mpz,&lease))	{
+					continue_flag = 0;
+				}
+			}
+			else if(RANGE_CURRENT.IsLower(&n_range_end))	{
 #if defined(_WIN64) && !defined(__CYGWIN__)
 				WaitForSingleObject(write_random, INFINITE);
-				key_mpz.Set(&n_range_start);
-				n_range_start.Add(N_SEQUENTIAL_MAX);
+				key_mpz.Set(&RANGE_CURRENT);
+				RANGE_CURRENT.Add(N_SEQUENTIAL_MAX);
 				ReleaseMutex(write_random);
 #else
 				pthread_mutex_lock(&write_random);
-				key_mpz.Set(&n_range_start);
-				n_range_start.Add(N_SEQUENTIAL_MAX);
+				key_mpz.Set(&RANGE_CURRENT);
+				RANGE_CURRENT.Add(N_SEQUENTIAL_MAX);
 				pthread_mutex_unlock(&write_random);
 #endif
+				if(FLAGCHECKPOINT && checkpoint_isdone(&keyhunt_checkpoint,&key_mpz))	{
+					continue;	/* This chunk was done before the last stop */
+				}
 			}
 			else	{
 				continue_flag = 0;
 			}
 		}
 		if(continue_flag)	{
-			count = 0;
+			chunk_base.Set(&key_mpz);
+			walker_start(&walker,&key_mpz,&startP);
 			if(FLAGMATRIX)	{
 					hextemp = key_mpz.GetBase16();
 					printf("Base key: %s thread %i\n",hextemp,thread_number);
 					fflush(stdout);
 					free(hextemp);
 			}
-			else	{
-				if(FLAGQUIET == 0)	{
-					hextemp = key_mpz.GetBase16();
-					printf("\rBase key: %s     \r",hextemp);
-					fflush(stdout);
-					free(hextemp);
-					THREADOUTPUT = 1;
-				}
-			}
+			metrics_setbase(&ctx->stats,&key_mpz);
 			do {
-				temp_stride.SetInt32(CPU_GRP_SIZE / 2);
-				temp_stride.Mult(&stride);
-				key_mpz.Add(&temp_stride);
-	 			startP = secp->ComputePublicKey(&key_mpz);
-				key_mpz.Sub(&temp_stride);
-
 				for(i = 0; i < hLength; i++) {
 					dx[i].ModSub(&Gn[i].x,&startP.x);
 				}
@@ -3321,19 +4016,15 @@ void *thread_process_vanity(void *vargp)	{
 				for(j = 0; j < CPU_GRP_SIZE/4;j++)	{
 					if(FLAGSEARCH == SEARCH_COMPRESS || FLAGSEARCH == SEARCH_BOTH ){
 						if(FLAGENDOMORPHISM)	{
-							secp->GetHash160_fromX(P2PKH,0x02,&pts[(j*4)].x,&pts[(j*4)+1].x,&pts[(j*4)+2].x,&pts[(j*4)+3].x,(uint8_t*)publickeyhashrmd160_endomorphism[0][0],(uint8_t*)publickeyhashrmd160_endomorphism[0][1],(uint8_t*)publickeyhashrmd160_endomorphism[0][2],(uint8_t*)publickeyhashrmd160_endomorphism[0][3]);
-							secp->GetHash160_fromX(P2PKH,0x03,&pts[(j*4)].x,&pts[(j*4)+1].x,&pts[(j*4)+2].x,&pts[(j*4)+3].x,(uint8_t*)publickeyhashrmd160_endomorphism[1][0],(uint8_t*)publickeyhashrmd160_endomorphism[1][1],(uint8_t*)publickeyhashrmd160_endomorphism[1][2],(uint8_t*)publickeyhashrmd160_endomorphism[1][3]);
+							secp->GetHash160_fromX(P2PKH,&pts[(j*4)].x,&pts[(j*4)+1].x,&pts[(j*4)+2].x,&pts[(j*4)+3].x,(uint8_t*)publickeyhashrmd160_endomorphism[0][0],(uint8_t*)publickeyhashrmd160_endomorphism[0][1],(uint8_t*)publickeyhashrmd160_endomorphism[0][2],(uint8_t*)publickeyhashrmd160_endomorphism[0][3],(uint8_t*)publickeyhashrmd160_endomorphism[1][0],(uint8_t*)publickeyhashrmd160_endomorphism[1][1],(uint8_t*)publickeyhashrmd160_endomorphism[1][2],(uint8_t*)publickeyhashrmd160_endomorphism[1][3]);
 
-							secp->GetHash160_fromX(P2PKH,0x02,&endomorphism_beta[(j*4)].x,&endomorphism_beta[(j*4)+1].x,&endomorphism_beta[(j*4)+2].x,&endomorphism_beta[(j*4)+3].x,(uint8_t*)publickeyhashrmd160_endomorphism[2][0],(uint8_t*)publickeyhashrmd160_endomorphism[2][1],(uint8_t*)publickeyhashrmd160_endomorphism[2][2],(uint8_t*)publickeyhashrmd160_endomorphism[2][3]);
-							secp->GetHash160_fromX(P2PKH,0x03,&endomorphism_beta[(j*4)].x,&endomorphism_beta[(j*4)+1].x,&endomorphism_beta[(j*4)+2].x,&endomorphism_beta[(j*4)+3].x,(uint8_t*)publickeyhashrmd160_endomorphism[3][0],(uint8_t*)publickeyhashrmd160_endomorphism[3][1],(uint8_t*)publickeyhashrmd160_endomorphism[3][2],(uint8_t*)publickeyhashrmd160_endomorphism[3][3]);
+							secp->GetHash160_fromX(P2PKH,&endomorphism_beta[(j*4)].x,&endomorphism_beta[(j*4)+1].x,&endomorphism_beta[(j*4)+2].x,&endomorphism_beta[(j*4)+3].x,(uint8_t*)publickeyhashrmd160_endomorphism[2][0],(uint8_t*)publickeyhashrmd160_endomorphism[2][1],(uint8_t*)publickeyhashrmd160_endomorphism[2][2],(uint8_t*)publickeyhashrmd160_endomorphism[2][3],(uint8_t*)publickeyhashrmd160_endomorphism[3][0],(uint8_t*)publickeyhashrmd160_endomorphism[3][1],(uint8_t*)publickeyhashrmd160_endomorphism[3][2],(uint8_t*)publickeyhashrmd160_endomorphism[3][3]);
 
-							secp->GetHash160_fromX(P2PKH,0x02,&endomorphism_beta2[(j*4)].x,&endomorphism_beta2[(j*4)+1].x,&endomorphism_beta2[(j*4)+2].x,&endomorphism_beta2[(j*4)+3].x,(uint8_t*)publickeyhashrmd160_endomorphism[4][0],(uint8_t*)publickeyhashrmd160_endomorphism[4][1],(uint8_t*)publickeyhashrmd160_endomorphism[4][2],(uint8_t*)publickeyhashrmd160_endomorphism[4][3]);
-							secp->GetHash160_fromX(P2PKH,0x03,&endomorphism_beta2[(j*4)].x,&endomorphism_beta2[(j*4)+1].x,&endomorphism_beta2[(j*4)+2].x,&endomorphism_beta2[(j*4)+3].x,(uint8_t*)publickeyhashrmd160_endomorphism[5][0],(uint8_t*)publickeyhashrmd160_endomorphism[5][1],(uint8_t*)publickeyhashrmd160_endomorphism[5][2],(uint8_t*)publickeyhashrmd160_endomorphism[5][3]);
+							secp->GetHash160_fromX(P2PKH,&endomorphism_beta2[(j*4)].x,&endomorphism_beta2[(j*4)+1].x,&endomorphism_beta2[(j*4)+2].x,&endomorphism_beta2[(j*4)+3].x,(uint8_t*)publickeyhashrmd160_endomorphism[4][0],(uint8_t*)publickeyhashrmd160_endomorphism[4][1],(uint8_t*)publickeyhashrmd160_endomorphism[4][2],(uint8_t*)publickeyhashrmd160_endomorphism[4][3],(uint8_t*)publickeyhashrmd160_endomorphism[5][0],(uint8_t*)publickeyhashrmd160_endomorphism[5][1],(uint8_t*)publickeyhashrmd160_endomorphism[5][2],(uint8_t*)publickeyhashrmd160_endomorphism[5][3]);
 
 						}
 						else	{
-							secp->GetHash160_fromX(P2PKH,0x02,&pts[(j*4)].x,&pts[(j*4)+1].x,&pts[(j*4)+2].x,&pts[(j*4)+3].x,(uint8_t*)publickeyhashrmd160_endomorphism[0][0],(uint8_t*)publickeyhashrmd160_endomorphism[0][1],(uint8_t*)publickeyhashrmd160_endomorphism[0][2],(uint8_t*)publickeyhashrmd160_endomorphism[0][3]);
-							secp->GetHash160_fromX(P2PKH,0x03,&pts[(j*4)].x,&pts[(j*4)+1].x,&pts[(j*4)+2].x,&pts[(j*4)+3].x,(uint8_t*)publickeyhashrmd160_endomorphism[1][0],(uint8_t*)publickeyhashrmd160_endomorphism[1][1],(uint8_t*)publickeyhashrmd160_endomorphism[1][2],(uint8_t*)publickeyhashrmd160_endomorphism[1][3]);
+							secp->GetHash160_fromX(P2PKH,&pts[(j*4)].x,&pts[(j*4)+1].x,&pts[(j*4)+2].x,&pts[(j*4)+3].x,(uint8_t*)publickeyhashrmd160_endomorphism[0][0],(uint8_t*)publickeyhashrmd160_endomorphism[0][1],(uint8_t*)publickeyhashrmd160_endomorphism[0][2],(uint8_t*)publickeyhashrmd160_endomorphism[0][3],(uint8_t*)publickeyhashrmd160_endomorphism[1][0],(uint8_t*)publickeyhashrmd160_endomorphism[1][1],(uint8_t*)publickeyhashrmd160_endomorphism[1][2],(uint8_t*)publickeyhashrmd160_endomorphism[1][3]);
 						}
 					}
 					if(FLAGSEARCH == SEARCH_UNCOMPRESS || FLAGSEARCH == SEARCH_BOTH)	{
@@ -3341,19 +4032,16 @@ void *thread_process_vanity(void *vargp)	{
 							for(l = 0; l < 4; l++)	{
 								endomorphism_negeted_point[l] = secp->Negation(pts[(j*4)+l]);
 							}
-							secp->GetHash160(P2PKH,false, pts[(j*4)], pts[(j*4)+1], pts[(j*4)+2], pts[(j*4)+3],(uint8_t*)publickeyhashrmd160_endomorphism[6][0],(uint8_t*)publickeyhashrmd160_endomorphism[6][1],(uint8_t*)publickeyhashrmd160_endomorphism[6][2],(uint8_t*)publickeyhashrmd160_endomorphism[6][3]);
-							secp->GetHash160(P2PKH,false,endomorphism_negeted_point[0] ,endomorphism_negeted_point[1],endomorphism_negeted_point[2],endomorphism_negeted_point[3],(uint8_t*)publickeyhashrmd160_endomorphism[7][0],(uint8_t*)publickeyhashrmd160_endomorphism[7][1],(uint8_t*)publickeyhashrmd160_endomorphism[7][2],(uint8_t*)publickeyhashrmd160_endomorphism[7][3]);
+							secp->GetHash160(P2PKH,false,pts[(j*4)],pts[(j*4)+1],pts[(j*4)+2],pts[(j*4)+3],endomorphism_negeted_point[0],endomorphism_negeted_point[1],endomorphism_negeted_point[2],endomorphism_negeted_point[3],(uint8_t*)publickeyhashrmd160_endomorphism[6][0],(uint8_t*)publickeyhashrmd160_endomorphism[6][1],(uint8_t*)publickeyhashrmd160_endomorphism[6][2],(uint8_t*)publickeyhashrmd160_endomorphism[6][3],(uint8_t*)publickeyhashrmd160_endomorphism[7][0],(uint8_t*)publickeyhashrmd160_endomorphism[7][1],(uint8_t*)publickeyhashrmd160_endomorphism[7][2],(uint8_t*)publickeyhashrmd160_endomorphism[7][3]);
 							for(l = 0; l < 4; l++)	{
 								endomorphism_negeted_point[l] = secp->Negation(endomorphism_beta[(j*4)+l]);
 							}
-							secp->GetHash160(P2PKH,false,endomorphism_beta[(j*4)],  endomorphism_beta[(j*4)+1], endomorphism_beta[(j*4)+2], endomorphism_beta[(j*4)+3] ,(uint8_t*)publickeyhashrmd160_endomorphism[8][0],(uint8_t*)publickeyhashrmd160_endomorphism[8][1],(uint8_t*)publickeyhashrmd160_endomorphism[8][2],(uint8_t*)publickeyhashrmd160_endomorphism[8][3]);
-							secp->GetHash160(P2PKH,false,endomorphism_negeted_point[0],endomorphism_negeted_point[1],endomorphism_negeted_point[2],endomorphism_negeted_point[3],(uint8_t*)publickeyhashrmd160_endomorphism[9][0],(uint8_t*)publickeyhashrmd160_endomorphism[9][1],(uint8_t*)publickeyhashrmd160_endomorphism[9][2],(uint8_t*)publickeyhashrmd160_endomorphism[9][3]);
+							secp->GetHash160(P2PKH,false,endomorphism_beta[(j*4)],endomorphism_beta[(j*4)+1],endomorphism_beta[(j*4)+2],endomorphism_beta[(j*4)+3],endomorphism_negeted_point[0],endomorphism_negeted_point[1],endomorphism_negeted_point[2],endomorphism_negeted_point[3],(uint8_t*)publickeyhashrmd160_endomorphism[8][0],(uint8_t*)publickeyhashrmd160_endomorphism[8][1],(uint8_t*)publickeyhashrmd160_endomorphism[8][2],(uint8_t*)publickeyhashrmd160_endomorphism[8][3],(uint8_t*)publickeyhashrmd160_endomorphism[9][0],(uint8_t*)publickeyhashrmd160_endomorphism[9][1],(uint8_t*)publickeyhashrmd160_endomorphism[9][2],(uint8_t*)publickeyhashrmd160_endomorphism[9][3]);
 
 							for(l = 0; l < 4; l++)	{
 								endomorphism_negeted_point[l] = secp->Negation(endomorphism_beta2[(j*4)+l]);
 							}
-							secp->GetHash160(P2PKH,false, endomorphism_beta2[(j*4)],  endomorphism_beta2[(j*4)+1] ,  endomorphism_beta2[(j*4)+2] ,  endomorphism_beta2[(j*4)+3] ,(uint8_t*)publickeyhashrmd160_endomorphism[10][0],(uint8_t*)publickeyhashrmd160_endomorphism[10][1],(uint8_t*)publickeyhashrmd160_endomorphism[10][2],(uint8_t*)publickeyhashrmd160_endomorphism[10][3]);
-							secp->GetHash160(P2PKH,false, endomorphism_negeted_point[0], endomorphism_negeted_point[1],   endomorphism_negeted_point[2],endomorphism_negeted_point[3],(uint8_t*)publickeyhashrmd160_endomorphism[11][0],(uint8_t*)publickeyhashrmd160_endomorphism[11][1],(uint8_t*)publickeyhashrmd160_endomorphism[11][2],(uint8_t*)publickeyhashrmd160_endomorphism[11][3]);
+							secp->GetHash160(P2PKH,false,endomorphism_beta2[(j*4)],endomorphism_beta2[(j*4)+1],endomorphism_beta2[(j*4)+2],endomorphism_beta2[(j*4)+3],endomorphism_negeted_point[0],endomorphism_negeted_point[1],endomorphism_negeted_point[2],endomorphism_negeted_point[3],(uint8_t*)publickeyhashrmd160_endomorphism[10][0],(uint8_t*)publickeyhashrmd160_endomorphism[10][1],(uint8_t*)publickeyhashrmd160_endomorphism[10][2],(uint8_t*)publickeyhashrmd160_endomorphism[10][3],(uint8_t*)publickeyhashrmd160_endomorphism[11][0],(uint8_t*)publickeyhashrmd160_endomorphism[11][1],(uint8_t*)publickeyhashrmd160_endomorphism[11][2],(uint8_t*)publickeyhashrmd160_endomorphism[11][3]);
 						}
 						else	{
 							secp->GetHash160(P2PKH,false,pts[(j*4)],pts[(j*4)+1],pts[(j*4)+2],pts[(j*4)+3],(uint8_t*)publickeyhashrmd160_uncompress[0],(uint8_t*)publickeyhashrmd160_uncompress[1],(uint8_t*)publickeyhashrmd160_uncompress[2],(uint8_t*)publickeyhashrmd160_uncompress[3]);
@@ -3368,9 +4056,7 @@ void *thread_process_vanity(void *vargp)	{
 										// Here the given publickeyhashrmd160 match againts one of the vanity targets
 										// We need to check which of the cases is it.
 
-										keyfound.SetInt32(k);
-										keyfound.Mult(&stride);
-										keyfound.Add(&key_mpz);
+										walker_key(&walker,k,&keyfound);
 										publickey = secp->ComputePublicKey(&keyfound);
 										
 										switch(l)	{
@@ -3428,9 +4114,7 @@ void *thread_process_vanity(void *vargp)	{
 							else	{
 								for(l = 0;l < 2; l++)	{
 									if(vanityrmdmatch((uint8_t*)publickeyhashrmd160_endomorphism[l][k]))	{
-										keyfound.SetInt32(k);
-										keyfound.Mult(&stride);
-										keyfound.Add(&key_mpz);
+										walker_key(&walker,k,&keyfound);
 										
 										publickey = secp->ComputePublicKey(&keyfound);
 										secp->GetHash160(P2PKH,true,publickey,(uint8_t*)publickeyhashrmd160);
@@ -3452,9 +4136,7 @@ void *thread_process_vanity(void *vargp)	{
 										// We need to check which of the cases is it.
 
 										//rmd160toaddress_dst(publickeyhashrmd160_endomorphism[l][k],address);
-										keyfound.SetInt32(k);
-										keyfound.Mult(&stride);
-										keyfound.Add(&key_mpz);
+										walker_key(&walker,k,&keyfound);
 										
 										
 										switch(l)	{
@@ -3495,9 +4177,7 @@ void *thread_process_vanity(void *vargp)	{
 							}
 							else	{
 								if(vanityrmdmatch((uint8_t*)publickeyhashrmd160_uncompress[k]))	{
-									keyfound.SetInt32(k);
-									keyfound.Mult(&stride);
-									keyfound.Add(&key_mpz);
+									walker_key(&walker,k,&keyfound);
 									writevanitykey(false,&keyfound);
 								}
 							}
@@ -3505,12 +4185,9 @@ void *thread_process_vanity(void *vargp)	{
 						
 					}
 
-					count+=4;
-					temp_stride.SetInt32(4);
-					temp_stride.Mult(&stride);
-					key_mpz.Add(&temp_stride);
+					walker.offset+=4;
 				}
-				steps[thread_number]++;
+				metrics_add(&ctx->stats.steps,1);
 
 				// Next start point (startP + GRP_SIZE*G)
 				pp = startP;
@@ -3528,10 +4205,28 @@ void *thread_process_vanity(void *vargp)	{
 				pp.y.ModMulK1(&_s);
 				pp.y.ModSub(&_2Gn.y);
 				startP = pp;
-			}while(count < N_SEQUENTIAL_MAX && continue_flag);
+			}while(walker.offset < N_SEQUENTIAL_MAX && continue_flag);
+			/* A chunk with a point mismatch is checked again, it is never marked as done */
+			if(!walker_check(&walker,&startP))	{
+				if(rescan)	{
+					fprintf(stderr,"[E] Point mismatch again at the end of the chunk, thread %i\n",thread_number);
+					results_stop(&results,NULL);
+					exit(EXIT_FAILURE);
+				}
+				fprintf(stderr,"[W] Point mismatch at the end of the chunk, thread %i, checking it again\n",thread_number);
+				rescan = 1;
+				continue;
+			}
+			rescan = 0;
+			if(FLAGCHECKPOINT && walker.offset >= N_SEQUENTIAL_MAX)	{
+				checkpoint_done(&keyhunt_checkpoint,&chunk_base);
+			}
+			if(FLAGWORKER && walker.offset >= N_SEQUENTIAL_MAX)	{
+				cluster_chunkdone(&keyhunt_worker,lease);
+			}
 		}
 	} while(continue_flag);
-	ends[thread_number] = 1;
+	ctx->end.store(1,std::memory_order_relaxed);
 	return NULL;
 }
 
@@ -3756,7 +4451,7 @@ int bsgs_searchbinary(struct bsgs_xvalue *buffer,char *data,int64_t array_length
 		half = (max - min)/2;
 		rcmp = memcmp(data+16,buffer[current+half].value,BSGS_XVALUE_RAM);
 		if(rcmp == 0)	{
-			*r_value = buffer[current+half].index;
+			*r_value = bsgs_getindex(&buffer[current+half]);
 			r = 1;
 		}
 		else	{
@@ -3772,40 +4467,73 @@ int bsgs_searchbinary(struct bsgs_xvalue *buffer,char *data,int64_t array_length
 	return r;
 }
 
+void bsgs_setindex(struct bsgs_xvalue *entry,uint64_t index)	{
+	int k;
+	for(k = 0; k < BSGS_XINDEX_BYTES; k++)	{
+		entry->index[k] = (uint8_t)(index >> (8*k));
+	}
+}
+
+uint64_t bsgs_getindex(struct bsgs_xvalue *entry)	{
+	uint64_t index = 0;
+	int k;
+	for(k = 0; k < BSGS_XINDEX_BYTES; k++)	{
+		index |= (uint64_t)entry->index[k] << (8*k);
+	}
+	return index;
+}
+
 #if defined(_WIN64) && !defined(__CYGWIN__)
 DWORD WINAPI thread_process_bsgs(LPVOID vargp) {
 #else
 void *thread_process_bsgs(void *vargp)	{
 #endif
 	// File-related variables
-	FILE* filekey;
 	struct tothread* tt;
+	struct worker_context *ctx;
 
 	// Character variables
-	char xpoint_raw[32], *aux_c, *hextemp;
+	char xpoint_raw[32], *aux_c;
+	uint32_t *bsgs_queue,candidates;
 
 	// Integer variables
 	Int base_key, keyfound;
-	IntGroup* grp = new IntGroup(CPU_GRP_SIZE / 2 + 1);
-	Int dx[CPU_GRP_SIZE / 2 + 1];
-	Int dy, dyn, _s, _p, km, intaux;
+	IntGroup *grp;
+	Int *dx;
+	Int dy, _s, _p, km, intaux;
 
 	// Point variables
-	Point base_point, point_aux, point_found;
+	Point base_point, point_aux;
 	Point startP;
-	Point pp, pn;
-	Point pts[CPU_GRP_SIZE];
+	Point pp;
+	Int *x;		/* x of the batch */
 
 	// Unsigned integer variables
-	uint32_t k, l, r, salir, thread_number, cycles;
+	uint32_t k, r, thread_number, cycles;
+	uint64_t lease = 0;
 
 	// Other variables
 	int hLength = (CPU_GRP_SIZE / 2 - 1);
-	grp->Set(dx);
+	uint64_t profile_time = 0;
 
 	tt = (struct tothread *)vargp;
 	thread_number = tt->nt;
+	ctx = &workers[thread_number];
+	worker_pin(ctx);
+	/* Tables of the NUMA node of the thread */
+	Secp256K1 *secp = ctx->tables->secp;
+	std::vector<Point> &GSn = *ctx->tables->GSn;
+	Point &_2GSn = *ctx->tables->_2GSn;
+	stats_thread = &ctx->stats;
+	results_thread = &results.rings[thread_number];
+	worker_alloc(ctx,CPU_GRP_SIZE / 2 + 1,0,CPU_GRP_SIZE);
+	worker_alloc_xy(ctx,CPU_GRP_SIZE,false);
+	grp = ctx->grp;
+	dx = ctx->dx;
+	x = ctx->x;
+	bsgs_queue = ctx->queue;
 	free(tt);
+	profile_thread = FLAGPROFILE ? &ctx->profile : NULL;
 	
 	cycles = bsgs_aux / 1024;
 	if(bsgs_aux % 1024 != 0)	{
@@ -3821,27 +4549,36 @@ void *thread_process_bsgs(void *vargp)	{
 		We do this in an atomic pthread_mutex operation to not affect others threads
 		so BSGS_CURRENT is never the same between threads
 	*/
+		if(FLAGWORKER)	{
+			if(!cluster_nextchunk(&keyhunt_worker,&WORKER_CHUNK,&base_key,&lease))
+				break;
+		}
+		else	{
 #if defined(_WIN64) && !defined(__CYGWIN__)
-		WaitForSingleObject(bsgs_thread, INFINITE);
+			WaitForSingleObject(bsgs_thread, INFINITE);
 #else
-		pthread_mutex_lock(&bsgs_thread);
+			pthread_mutex_lock(&bsgs_thread);
 #endif
 
-		base_key.Set(&BSGS_CURRENT);	/* we need to set our base_key to the current BSGS_CURRENT value*/
-		BSGS_CURRENT.Add(&BSGS_N_double);		/*Then add 2*BSGS_N to BSGS_CURRENT*/
-		/*
-		BSGS_CURRENT.Add(&BSGS_N);		//Then add BSGS_N to BSGS_CURRENT
-		BSGS_CURRENT.Add(&BSGS_N);		//Then add BSGS_N to BSGS_CURRENT
-		*/
-		
+			base_key.Set(&BSGS_CURRENT);	/* we need to set our base_key to the current BSGS_CURRENT value*/
+			BSGS_CURRENT.Add(&BSGS_N_double);		/*Then add 2*BSGS_N to BSGS_CURRENT*/
+			/*
+			BSGS_CURRENT.Add(&BSGS_N);		//Then add BSGS_N to BSGS_CURRENT
+			BSGS_CURRENT.Add(&BSGS_N);		//Then add BSGS_N to BSGS_CURRENT
+			*/
+			
 #if defined(_WIN64) && !defined(__CYGWIN__)
-		ReleaseMutex(bsgs_thread);
+			ReleaseMutex(bsgs_thread);
 #else
-		pthread_mutex_unlock(&bsgs_thread);
+			pthread_mutex_unlock(&bsgs_thread);
 #endif
 
-		if(base_key.IsGreaterOrEqual(&n_range_end))
-			break;
+			if(base_key.IsGreaterOrEqual(&n_range_end))
+				break;
+		}
+		if(FLAGCHECKPOINT && checkpoint_isdone(&keyhunt_checkpoint,&base_key))	{
+			continue;	/* This chunk was done before the last stop */
+		}
 		
 		if(FLAGMATRIX)	{
 			aux_c = base_key.GetBase16();
@@ -3849,15 +4586,7 @@ void *thread_process_bsgs(void *vargp)	{
 			fflush(stdout);
 			free(aux_c);
 		}
-		else	{
-			if(FLAGQUIET == 0){
-				aux_c = base_key.GetBase16();
-				printf("\r[+] Thread 0x%s   \r",aux_c);
-				fflush(stdout);
-				free(aux_c);
-				THREADOUTPUT = 1;
-			}
-		}
+		metrics_setbase(&ctx->stats,&base_key);
 		base_point = secp->ComputePublicKey(&base_key);
 		km.Set(&base_key);
 		km.Neg();
@@ -3870,6 +4599,7 @@ void *thread_process_bsgs(void *vargp)	{
 				uint32_t j = 0;
 				while( j < cycles && bsgs_found[k]== 0 )	{
 					int i;
+					profile_time = profile_tsc();
 					for(i = 0; i < hLength; i++) {
 						dx[i].ModSub(&GSn[i].x,&startP.x);
 					}
@@ -3877,111 +4607,28 @@ void *thread_process_bsgs(void *vargp)	{
 					dx[i+1].ModSub(&_2GSn.x,&startP.x); // For the next center point
 					// Grouped ModInv
 					grp->ModInv();
+					profile_stage(PROFILE_INVERSION,&profile_time);
 					/*
 					We use the fact that P + i*G and P - i*G has the same deltax, so the same inverse
 					We compute key in the positive and negative way from the center of the group
 					*/
 					// center point
-					pts[CPU_GRP_SIZE / 2] = startP;
-					for(i = 0; i<hLength; i++) {
-						pp = startP;
-						pn = startP;
-
-						// P = startP + i*G
-						dy.ModSub(&GSn[i].y,&pp.y);
-
-						_s.ModMulK1(&dy,&dx[i]);        // s = (p2.y-p1.y)*inverse(p2.x-p1.x);
-						_p.ModSquareK1(&_s);            // _p = pow2(s)
-
-						pp.x.ModNeg();
-						pp.x.ModAdd(&_p);
-						pp.x.ModSub(&GSn[i].x);           // rx = pow2(s) - p1.x - p2.x;
-#if 0
-  pp.y.ModSub(&GSn[i].x,&pp.x);
-  pp.y.ModMulK1(&_s);
-  pp.y.ModSub(&GSn[i].y);           // ry = - p2.y - s*(ret.x-p2.x);  
-#endif
-						// P = startP - i*G  , if (x,y) = i*G then (x,-y) = -i*G
-						dyn.Set(&GSn[i].y);
-						dyn.ModNeg();
-						dyn.ModSub(&pn.y);
-
-						_s.ModMulK1(&dyn,&dx[i]);       // s = (p2.y-p1.y)*inverse(p2.x-p1.x);
-						_p.ModSquareK1(&_s);            // _p = pow2(s)
-
-						pn.x.ModNeg();
-						pn.x.ModAdd(&_p);
-						pn.x.ModSub(&GSn[i].x);          // rx = pow2(s) - p1.x - p2.x;
-
-#if 0
-  pn.y.ModSub(&GSn[i].x,&pn.x);
-  pn.y.ModMulK1(&_s);
-  pn.y.ModAdd(&GSn[i].y);          // ry = - p2.y - s*(ret.x-p2.x);  
-#endif
-
-						pts[CPU_GRP_SIZE / 2 + (i + 1)] = pp;
-						pts[CPU_GRP_SIZE / 2 - (i + 1)] = pn;
+					group_points<false>(startP,GSn,dx,x,NULL);
+					profile_stage(PROFILE_POINTS,&profile_time);
+					candidates = 0;
+					for(int i = 0; i<CPU_GRP_SIZE; i++) {
+						x[i].Get32Bytes((unsigned char*)xpoint_raw);
+						if(bloom_check_prefiltered(&bloom_bP_prefilter,&bloom_bP[((unsigned char)xpoint_raw[0])],xpoint_raw,32)) {
+							bsgs_queue[candidates++] = (j*1024) + i;
+						}
 					}
-					// First point (startP - (GRP_SZIE/2)*G)
-					pn = startP;
-					dyn.Set(&GSn[i].y);
-					dyn.ModNeg();
-					dyn.ModSub(&pn.y);
-
-					_s.ModMulK1(&dyn,&dx[i]);
-					_p.ModSquareK1(&_s);
-
-					pn.x.ModNeg();
-					pn.x.ModAdd(&_p);
-					pn.x.ModSub(&GSn[i].x);
-
-#if 0
-pn.y.ModSub(&GSn[i].x,&pn.x);
-pn.y.ModMulK1(&_s);
-pn.y.ModAdd(&GSn[i].y);
-#endif
-					pts[0] = pn;
-					for(int i = 0; i<CPU_GRP_SIZE && bsgs_found[k]== 0; i++) {
-						pts[i].x.Get32Bytes((unsigned char*)xpoint_raw);
-						r = bloom_check(&bloom_bP[((unsigned char)xpoint_raw[0])],xpoint_raw,32);
-						if(r) {
-							r = bsgs_secondcheck(&base_key,((j*1024) + i),k,&keyfound);
-							if(r)	{
-								hextemp = keyfound.GetBase16();
-								printf("[+] Thread Key found privkey %s   \n",hextemp);
-								point_found = secp->ComputePublicKey(&keyfound);
-								aux_c = secp->GetPublicKeyHex(OriginalPointsBSGScompressed[k],point_found);
-								printf("[+] Publickey %s\n",aux_c);
-#if defined(_WIN64) && !defined(__CYGWIN__)
-								WaitForSingleObject(write_keys, INFINITE);
-#else
-								pthread_mutex_lock(&write_keys);
-#endif
-
-								filekey = fopen("KEYFOUNDKEYFOUND.txt","a");
-								if(filekey != NULL)	{
-									fprintf(filekey,"Key found privkey %s\nPublickey %s\n",hextemp,aux_c);
-									fclose(filekey);
-								}
-								free(hextemp);
-								free(aux_c);
-#if defined(_WIN64) && !defined(__CYGWIN__)
-				ReleaseMutex(write_keys);
-#else
-				pthread_mutex_unlock(&write_keys);
-#endif
-								bsgs_found[k] = 1;
-								salir = 1;
-								for(l = 0; l < bsgs_point_number && salir; l++)	{
-									salir &= bsgs_found[l];
-								}
-								if(salir)	{
-									printf("All points were found\n");
-									exit(EXIT_FAILURE);
-								}
-							} //End if second check
-						}//End if first check
-					}// For for pts variable
+					if(candidates > 0) {
+						r = bsgs_checkqueue(ctx,&base_key,bsgs_queue,candidates,k,&keyfound);
+						if(r)	{
+							bsgs_foundkey(&keyfound,k);
+						} //End if second check
+					}//End if first check
+					profile_stage(PROFILE_BLOOM,&profile_time);
 					// Next start point (startP += (bsSize*GRP_SIZE).G)
 					pp = startP;
 					dy.ModSub(&_2GSn.y,&pp.y);
@@ -4002,9 +4649,15 @@ pn.y.ModAdd(&GSn[i].y);
 				} // end while
 			}// End if 
 		}
-		steps[thread_number]+=2;
+		if(FLAGCHECKPOINT)	{
+			checkpoint_done(&keyhunt_checkpoint,&base_key);
+		}
+		if(FLAGWORKER)	{
+			cluster_chunkdone(&keyhunt_worker,lease);
+		}
+		metrics_add(&ctx->stats.steps,2);
 	}while(1);
-	ends[thread_number] = 1;
+	ctx->end.store(1,std::memory_order_relaxed);
 	return NULL;
 }
 
@@ -4014,34 +4667,48 @@ DWORD WINAPI thread_process_bsgs_random(LPVOID vargp) {
 void *thread_process_bsgs_random(void *vargp)	{
 #endif
 
-	FILE *filekey;
 	struct tothread *tt;
-	char xpoint_raw[32],*aux_c,*hextemp;
+	struct worker_context *ctx;
+	char xpoint_raw[32],*aux_c;
+	uint32_t *bsgs_queue,candidates;
 	Int base_key,keyfound,n_range_random;
-	Point base_point,point_aux,point_found;
-	uint32_t l,k,r,salir,thread_number,cycles;
+	Point base_point,point_aux;
+	uint32_t k,r,thread_number,cycles,entrar = 1;
 	
-	IntGroup *grp = new IntGroup(CPU_GRP_SIZE / 2 + 1);
+	IntGroup *grp;
 	Point startP;
 	
 	int hLength = (CPU_GRP_SIZE / 2 - 1);
 	
-	Int dx[CPU_GRP_SIZE / 2 + 1];
-	Point pts[CPU_GRP_SIZE];
+	Int *dx;
+	Int *x;		/* x of the batch */
 
 	Int dy;
-	Int dyn;
 	Int _s;
 	Int _p;
 	Int km,intaux;
 	Point pp;
-	Point pn;
-	grp->Set(dx);
+	uint64_t profile_time = 0;
 
 
 	tt = (struct tothread *)vargp;
 	thread_number = tt->nt;
+	ctx = &workers[thread_number];
+	worker_pin(ctx);
+	/* Tables of the NUMA node of the thread */
+	Secp256K1 *secp = ctx->tables->secp;
+	std::vector<Point> &GSn = *ctx->tables->GSn;
+	Point &_2GSn = *ctx->tables->_2GSn;
+	stats_thread = &ctx->stats;
+	results_thread = &results.rings[thread_number];
+	worker_alloc(ctx,CPU_GRP_SIZE / 2 + 1,0,CPU_GRP_SIZE);
+	worker_alloc_xy(ctx,CPU_GRP_SIZE,false);
+	grp = ctx->grp;
+	dx = ctx->dx;
+	x = ctx->x;
+	bsgs_queue = ctx->queue;
 	free(tt);
+	profile_thread = FLAGPROFILE ? &ctx->profile : NULL;
 	
 	cycles = bsgs_aux / 1024;
 	if(bsgs_aux % 1024 != 0)	{
@@ -4066,12 +4733,19 @@ void *thread_process_bsgs_random(void *vargp)	{
 		pthread_mutex_lock(&bsgs_thread);
 #endif
 
-		base_key.Rand(&n_range_start,&n_range_end);
+		if(FLAGCHECKPOINT)	{
+			entrar = checkpoint_random(&keyhunt_checkpoint,&base_key);
+		}
+		else	{
+			base_key.Rand(&n_range_start,&n_range_end);
+		}
 #if defined(_WIN64) && !defined(__CYGWIN__)
 		ReleaseMutex(bsgs_thread);
 #else
 		pthread_mutex_unlock(&bsgs_thread);
 #endif
+		if(entrar == 0)
+			break;
 
 		if(FLAGMATRIX)	{
 				aux_c = base_key.GetBase16();
@@ -4079,15 +4753,7 @@ void *thread_process_bsgs_random(void *vargp)	{
 				fflush(stdout);
 				free(aux_c);
 		}
-		else{
-			if(FLAGQUIET == 0){
-				aux_c = base_key.GetBase16();
-				printf("\r[+] Thread 0x%s  \r",aux_c);
-				fflush(stdout);
-				free(aux_c);
-				THREADOUTPUT = 1;
-			}
-		}
+		metrics_setbase(&ctx->stats,&base_key);
 		base_point = secp->ComputePublicKey(&base_key);
 
 		km.Set(&base_key);
@@ -4107,6 +4773,7 @@ void *thread_process_bsgs_random(void *vargp)	{
 				while( j < cycles && bsgs_found[k]== 0 )	{
 				
 					int i;
+					profile_time = profile_tsc();
 					for(i = 0; i < hLength; i++) {
 						dx[i].ModSub(&GSn[i].x,&startP.x);
 					}
@@ -4115,6 +4782,7 @@ void *thread_process_bsgs_random(void *vargp)	{
 
 					// Grouped ModInv
 					grp->ModInv();
+					profile_stage(PROFILE_INVERSION,&profile_time);
 					
 					/*
 					We use the fact that P + i*G and P - i*G has the same deltax, so the same inverse
@@ -4122,117 +4790,23 @@ void *thread_process_bsgs_random(void *vargp)	{
 					*/
 
 					// center point
-					pts[CPU_GRP_SIZE / 2] = startP;
+					group_points<false>(startP,GSn,dx,x,NULL);
 					
-					for(i = 0; i<hLength; i++) {
-
-						pp = startP;
-						pn = startP;
-
-						// P = startP + i*G
-						dy.ModSub(&GSn[i].y,&pp.y);
-
-						_s.ModMulK1(&dy,&dx[i]);        // s = (p2.y-p1.y)*inverse(p2.x-p1.x);
-						_p.ModSquareK1(&_s);            // _p = pow2(s)
-
-						pp.x.ModNeg();
-						pp.x.ModAdd(&_p);
-						pp.x.ModSub(&GSn[i].x);           // rx = pow2(s) - p1.x - p2.x;
-						
-#if 0
-  pp.y.ModSub(&GSn[i].x,&pp.x);
-  pp.y.ModMulK1(&_s);
-  pp.y.ModSub(&GSn[i].y);           // ry = - p2.y - s*(ret.x-p2.x);  
-#endif
-
-						// P = startP - i*G  , if (x,y) = i*G then (x,-y) = -i*G
-						dyn.Set(&GSn[i].y);
-						dyn.ModNeg();
-						dyn.ModSub(&pn.y);
-
-						_s.ModMulK1(&dyn,&dx[i]);       // s = (p2.y-p1.y)*inverse(p2.x-p1.x);
-						_p.ModSquareK1(&_s);            // _p = pow2(s)
-
-						pn.x.ModNeg();
-						pn.x.ModAdd(&_p);
-						pn.x.ModSub(&GSn[i].x);          // rx = pow2(s) - p1.x - p2.x;
-
-#if 0
-  pn.y.ModSub(&GSn[i].x,&pn.x);
-  pn.y.ModMulK1(&_s);
-  pn.y.ModAdd(&GSn[i].y);          // ry = - p2.y - s*(ret.x-p2.x);  
-#endif
-
-
-						pts[CPU_GRP_SIZE / 2 + (i + 1)] = pp;
-						pts[CPU_GRP_SIZE / 2 - (i + 1)] = pn;
-
+					profile_stage(PROFILE_POINTS,&profile_time);
+					candidates = 0;
+					for(int i = 0; i<CPU_GRP_SIZE; i++) {
+						x[i].Get32Bytes((unsigned char*)xpoint_raw);
+						if(bloom_check_prefiltered(&bloom_bP_prefilter,&bloom_bP[((unsigned char)xpoint_raw[0])],xpoint_raw,32)) {
+							bsgs_queue[candidates++] = (j*1024) + i;
+						}
 					}
-
-					// First point (startP - (GRP_SZIE/2)*G)
-					pn = startP;
-					dyn.Set(&GSn[i].y);
-					dyn.ModNeg();
-					dyn.ModSub(&pn.y);
-
-					_s.ModMulK1(&dyn,&dx[i]);
-					_p.ModSquareK1(&_s);
-
-					pn.x.ModNeg();
-					pn.x.ModAdd(&_p);
-					pn.x.ModSub(&GSn[i].x);
-
-#if 0
-pn.y.ModSub(&GSn[i].x,&pn.x);
-pn.y.ModMulK1(&_s);
-pn.y.ModAdd(&GSn[i].y);
-#endif
-
-					pts[0] = pn;
-					
-					for(int i = 0; i<CPU_GRP_SIZE && bsgs_found[k]== 0; i++) {
-						pts[i].x.Get32Bytes((unsigned char*)xpoint_raw);
-						r = bloom_check(&bloom_bP[((unsigned char)xpoint_raw[0])],xpoint_raw,32);
-						if(r) {
-							r = bsgs_secondcheck(&base_key,((j*1024) + i),k,&keyfound);
-							if(r)	{
-								hextemp = keyfound.GetBase16();
-								printf("[+] Thread Key found privkey %s    \n",hextemp);
-								point_found = secp->ComputePublicKey(&keyfound);
-								aux_c = secp->GetPublicKeyHex(OriginalPointsBSGScompressed[k],point_found);
-								printf("[+] Publickey %s\n",aux_c);
-#if defined(_WIN64) && !defined(__CYGWIN__)
-								WaitForSingleObject(write_keys, INFINITE);
-#else
-								pthread_mutex_lock(&write_keys);
-#endif
-
-								filekey = fopen("KEYFOUNDKEYFOUND.txt","a");
-								if(filekey != NULL)	{
-									fprintf(filekey,"Key found privkey %s\nPublickey %s\n",hextemp,aux_c);
-									fclose(filekey);
-								}
-								free(hextemp);
-								free(aux_c);
-#if defined(_WIN64) && !defined(__CYGWIN__)
-								ReleaseMutex(write_keys);
-#else
-								pthread_mutex_unlock(&write_keys);
-#endif
-
-								bsgs_found[k] = 1;
-								salir = 1;
-								for(l = 0; l < bsgs_point_number && salir; l++)	{
-									salir &= bsgs_found[l];
-								}
-								if(salir)	{
-									printf("All points were found\n");
-									exit(EXIT_FAILURE);
-								}
-							} //End if second check
-						}//End if first check
-						
-					}// For for pts variable
+					if(candidates > 0) {
+						r = bsgs_checkqueue(ctx,&base_key,bsgs_queue,candidates,k,&keyfound);
+						if(r)	{
+							bsgs_foundkey(&keyfound,k);
+						} //End if second check
+					}//End if first check
+					profile_stage(PROFILE_BLOOM,&profile_time);
 					
 					// Next start point (startP += (bsSize*GRP_SIZE).G)
 					
@@ -4257,58 +4831,139 @@ pn.y.ModAdd(&GSn[i].y);
 			}	//End if
 		} // End for with k bsgs_point_number
 
-		steps[thread_number]+=2;
+		if(FLAGCHECKPOINT)	{
+			checkpoint_done(&keyhunt_checkpoint,&base_key);
+		}
+		metrics_add(&ctx->stats.steps,2);
 	}while(1);
-	ends[thread_number] = 1;
+	ctx->end.store(1,std::memory_order_relaxed);
 	return NULL;
 }
 
 
+/* The key of the target k was found, the program ends when all the targets are found */
+void bsgs_foundkey(Int *keyfound,uint32_t k)	{
+	uint32_t l,salir = 1;
+	results_hit(RESULTS_BSGS,false,keyfound,k);
+	bsgs_found[k] = 1;
+	for(l = 0; l < bsgs_point_number && salir; l++)	{
+		salir &= bsgs_found[l];
+	}
+	if(salir)	{
+		results_stop(&results,"All points were found\n");
+		exit(EXIT_FAILURE);
+	}
+}
+
+/*
+	bsgs_checkqueue drain the first bloom filter hits of one group of points,
+	the 32 points of the second check of BSGS_BATCH candidates are made with
+	one inversion, then each one is checked with bsgs_secondcheck until some
+	key is found.
+*/
+int bsgs_checkqueue(struct worker_context *ctx,Int *start_range,uint32_t *queue,uint32_t length,uint32_t k_index,Int *privatekey)	{
+	Int base_key[BSGS_BATCH];
+	Point BSGS_Q[BSGS_BATCH];
+	Point point_aux;
+	uint32_t i,c,n;
+	int found = 0;
+	uint64_t profile_time = profile_tsc();
+	for(i = 0; i < length && !found; i += n)	{
+		n = (length - i < BSGS_BATCH) ? length - i : BSGS_BATCH;
+		for(c = 0; c < n; c++)	{
+			stats_count(METRICS_HIT_BLOOM);
+			/*
+				BSGS_Q = Q - base_key
+						 Q is the target Key
+				base_key is the Start range + a*BSGS_M
+			*/
+			base_key[c].Set(&BSGS_M_double);
+			base_key[c].Mult((uint64_t) queue[i+c]);
+			base_key[c].Add(start_range);
+			point_aux = ctx->tables->secp->ComputePublicKey(&base_key[c]);
+			point_aux = ctx->tables->secp->Negation(point_aux);
+			BSGS_Q[c] = ctx->tables->secp->AddDirect(OriginalPointsBSGS[k_index],point_aux);
+		}
+		bsgs_batchx(ctx->grp2,ctx->dx2,BSGS_Q,n,BSGS_BATCH,BSGS_AMP2,ctx->x2,ctx->equal2);
+		for(c = 0; c < n && !found; c++)	{
+			found = bsgs_secondcheck(ctx,&base_key[c],&ctx->x2[c*32],&ctx->equal2[c*32],k_index,privatekey);
+		}
+	}
+	profile_stage(PROFILE_SEARCH,&profile_time);
+	return found;
+}
+
+/*
+	X values of Q[c] + AMP[i] for the 32 AMP points of the n points Q, all
+	the slopes share one inversion of the group of 'size' * 32 dx of the
+	worker, the dx after n are 1. If Q[c].x is equal to AMP[i].x the sum is
+	the infinity or 2Q, those are marked in equal[c*32+i] and the x is not
+	valid.
+*/
+void bsgs_batchx(IntGroup *grp,Int *dx,Point *Q,int n,int size,std::vector<Point> &AMP,Int *x,bool *equal)	{
+	Int dy,_s,_p;
+	int c,i,j;
+	for(c = 0; c < n; c++)	{
+		for(i = 0; i < 32; i++)	{
+			j = c*32 + i;
+			dx[j].ModSub(&AMP[i].x,&Q[c].x);
+			equal[j] = dx[j].IsZero();
+			if(equal[j])	{
+				dx[j].SetInt32(1);	// Keep the batch inversion valid
+			}
+		}
+	}
+	for(j = n*32; j < size*32; j++)	{
+		dx[j].SetInt32(1);
+	}
+	grp->ModInv();
+	for(c = 0; c < n; c++)	{
+		for(i = 0; i < 32; i++)	{
+			j = c*32 + i;
+			dy.ModSub(&AMP[i].y,&Q[c].y);
+			_s.ModMulK1(&dy,&dx[j]);		// s = (p2.y-p1.y)*inverse(p2.x-p1.x);
+			_p.ModSquareK1(&_s);			// _p = pow2(s)
+			x[j].Set(&_p);
+			x[j].ModSub(&Q[c].x);
+			x[j].ModSub(&AMP[i].x);			// rx = pow2(s) - p1.x - p2.x;
+		}
+	}
+}
+
 /*
 	The bsgs_secondcheck function is made to perform a second BSGS search in a Range of less size.
 	This funtion is made with the especific purpouse to USE a smaller bPtable in RAM.
+	x and equal are the 32 points of base_key made by bsgs_checkqueue.
 */
-int bsgs_secondcheck(Int *start_range,uint32_t a,uint32_t k_index,Int *privatekey)	{
+int bsgs_secondcheck(struct worker_context *ctx,Int *base_key,Int *x,bool *equal,uint32_t k_index,Int *privatekey)	{
 	int i = 0,found = 0,r = 0;
-	Int base_key;
-	Point base_point,point_aux;
-	Point BSGS_Q, BSGS_S,BSGS_Q_AMP;
 	char xpoint_raw[32];
 
-
-	base_key.Set(&BSGS_M_double);
-	base_key.Mult((uint64_t) a);
-	base_key.Add(start_range);
-
-	base_point = secp->ComputePublicKey(&base_key);
-	point_aux = secp->Negation(base_point);
-
-	/*
-		BSGS_S = Q - base_key
-				 Q is the target Key
-		base_key is the Start range + a*BSGS_M
-	*/
-	BSGS_S = secp->AddDirect(OriginalPointsBSGS[k_index],point_aux);
-	BSGS_Q.Set(BSGS_S);
 	do {
-		BSGS_Q_AMP = secp->AddDirect(BSGS_Q,BSGS_AMP2[i]);
-		BSGS_S.Set(BSGS_Q_AMP);
-		BSGS_S.x.Get32Bytes((unsigned char *) xpoint_raw);
-		r = bloom_check(&bloom_bPx2nd[(uint8_t) xpoint_raw[0]],xpoint_raw,32);
+		if(equal[i])	{
+			r = 1;	// Special case, let the third check find it
+		}
+		else	{
+			x[i].Get32Bytes((unsigned char *) xpoint_raw);
+			r = bloom_check(&bloom_bPx2nd[(uint8_t) xpoint_raw[0]],xpoint_raw,32);
+		}
 		if(r)	{
-			found = bsgs_thirdcheck(&base_key,i,k_index,privatekey);
+			stats_count(METRICS_HIT_BLOOM2);
+			found = bsgs_thirdcheck(ctx,base_key,i,k_index,privatekey);
 		}
 		i++;
 	}while(i < 32 && !found);
 	return found;
 }
 
-int bsgs_thirdcheck(Int *start_range,uint32_t a,uint32_t k_index,Int *privatekey)	{
+int bsgs_thirdcheck(struct worker_context *ctx,Int *start_range,uint32_t a,uint32_t k_index,Int *privatekey)	{
 	uint64_t j = 0;
 	int i = 0,found = 0,r = 0;
 	Int base_key,calculatedkey;
+	Int x[32];
+	bool equal[32];
 	Point base_point,point_aux;
-	Point BSGS_Q, BSGS_S,BSGS_Q_AMP;
+	Point BSGS_Q;
 	char xpoint_raw[32];
 
 	base_key.SetInt32(a);
@@ -4318,52 +4973,61 @@ int bsgs_thirdcheck(Int *start_range,uint32_t a,uint32_t k_index,Int *privatekey
 	base_point = secp->ComputePublicKey(&base_key);
 	point_aux = secp->Negation(base_point);
 	
-	BSGS_S = secp->AddDirect(OriginalPointsBSGS[k_index],point_aux);
-	BSGS_Q.Set(BSGS_S);
+	BSGS_Q = secp->AddDirect(OriginalPointsBSGS[k_index],point_aux);
+	bsgs_batchx(ctx->grp3,ctx->dx3,&BSGS_Q,1,1,BSGS_AMP3,x,equal);
 	
 	do {
-		BSGS_Q_AMP = secp->AddDirect(BSGS_Q,BSGS_AMP3[i]);
-		BSGS_S.Set(BSGS_Q_AMP);
-		BSGS_S.x.Get32Bytes((unsigned char *)xpoint_raw);
-		r = bloom_check(&bloom_bPx3rd[(uint8_t)xpoint_raw[0]],xpoint_raw,32);
-		if(r)	{
-			r = bsgs_searchbinary(bPtable,xpoint_raw,bsgs_m3,&j);
-			if(r)	{
+		if(equal[i])	{
+			/*
+				The sum of the negated values of each other is the infinity,
+				so Q is the key of this step
+			*/
+			if(BSGS_Q.y.IsEqual(&BSGS_AMP3[i].y) == false)	{
 				calcualteindex(i,&calculatedkey);
 				privatekey->Set(&calculatedkey);
-				privatekey->Add((uint64_t)(j+1));
 				privatekey->Add(&base_key);
-				point_aux = secp->ComputePublicKey(privatekey);
-				if(point_aux.x.IsEqual(&OriginalPointsBSGS[k_index].x))	{
-					found = 1;
+				found = 1;
+			}
+		}
+		else	{
+			x[i].Get32Bytes((unsigned char *)xpoint_raw);
+			r = bloom_check(&bloom_bPx3rd[(uint8_t)xpoint_raw[0]],xpoint_raw,32);
+			if(r)	{
+				stats_count(METRICS_HIT_BLOOM3);
+				if(bPtable != NULL)	{
+					r = bsgs_searchbinary(bPtable,xpoint_raw,bsgs_m3,&j);
 				}
 				else	{
+					r = bsgs_searchdisk(xpoint_raw,&j);
+				}
+				if(r)	{
+					stats_count(METRICS_HIT_TABLE);
 					calcualteindex(i,&calculatedkey);
 					privatekey->Set(&calculatedkey);
-					privatekey->Sub((uint64_t)(j+1));
+					privatekey->Add((uint64_t)(j+1));
 					privatekey->Add(&base_key);
 					point_aux = secp->ComputePublicKey(privatekey);
 					if(point_aux.x.IsEqual(&OriginalPointsBSGS[k_index].x))	{
 						found = 1;
 					}
+					else	{
+						calcualteindex(i,&calculatedkey);
+						privatekey->Set(&calculatedkey);
+						privatekey->Sub((uint64_t)(j+1));
+						privatekey->Add(&base_key);
+						point_aux = secp->ComputePublicKey(privatekey);
+						if(point_aux.x.IsEqual(&OriginalPointsBSGS[k_index].x))	{
+							found = 1;
+						}
+					}
 				}
 			}
 		}
-		else	{
-			/*
-				For some reason the AddDirect don't return 000000... value when the publickeys are the negated values from each other
-				Why JLP?
-				This is is an special case
-			*/
-			if(BSGS_Q.x.IsEqual(&BSGS_AMP3[i].x))	{
-				calcualteindex(i,&calculatedkey);
-				privatekey->Set(&calculatedkey);
-				privatekey->Add(&base_key);
-				found = 1;
-			}
-		}
 		i++;
 	}while(i < 32 && !found);
+	if(found)	{
+		stats_count(METRICS_HIT_KEY);
+	}
 	return found;
 }
 
@@ -4383,11 +5047,48 @@ void sleep_ms(int milliseconds)	{ // cross-platform sleep function
 }
 
 
+/*
+	Start the walk of the chunk from base, center is the point of the middle
+	of the first group of CPU_GRP_SIZE keys
+*/
+void walker_start(struct group_walker *w,Int *base,Point *center)	{
+	Int key;
+	w->base.Set(base);
+	w->offset = 0;
+	key.SetInt32(CPU_GRP_SIZE / 2);
+	key.Mult(&stride);
+	key.Add(base);
+	*center = secp->ComputePublicKey(&key);
+}
+
+/*
+	Private key of the point k of the current group of 4 points
+*/
+void walker_key(struct group_walker *w,uint64_t k,Int *key)	{
+	key->SetInt64(w->offset + k);
+	key->Mult(&stride);
+	key->Add(&w->base);
+}
+
+/*
+	Compare the center point reached with additions against the scalar
+	multiplication, only done at the end of the chunk
+*/
+bool walker_check(struct group_walker *w,Point *center)	{
+	Int key;
+	Point expected;
+	key.SetInt64(w->offset + CPU_GRP_SIZE / 2);
+	key.Mult(&stride);
+	key.Add(&w->base);
+	expected = secp->ComputePublicKey(&key);
+	return expected.x.IsEqual(&center->x) && expected.y.IsEqual(&center->y);
+}
+
 void init_generator()	{
 	Point G = secp->ComputePublicKey(&stride);
 	Point g;
 	g.Set(G);
-	Gn.reserve(CPU_GRP_SIZE / 2);
+	Gn.resize(CPU_GRP_SIZE / 2);
 	Gn[0] = g;
 	g = secp->DoubleDirect(g);
 	Gn[1] = g;
@@ -4411,9 +5112,9 @@ void *thread_bPload(void *vargp)	{
 	IntGroup *grp = new IntGroup(CPU_GRP_SIZE / 2 + 1);
 	Point startP;
 	Int dx[CPU_GRP_SIZE / 2 + 1];
-	Point pts[CPU_GRP_SIZE];
-	Int dy,dyn,_s,_p;
-	Point pp,pn;
+	alignas(METRICS_CACHE_LINE) Int x[CPU_GRP_SIZE];
+	Int dy,_s,_p;
+	Point pp;
 	
 	int i,bloom_bP_index,hLength = (CPU_GRP_SIZE / 2 - 1) ,threadid;
 	tt = (struct bPload *)vargp;
@@ -4447,72 +5148,9 @@ void *thread_bPload(void *vargp)	{
 		// We compute key in the positive and negative way from the center of the group
 		// center point
 		
-		pts[CPU_GRP_SIZE / 2] = startP;	//Center point
-
-		for(i = 0; i<hLength; i++) {
-			pp = startP;
-			pn = startP;
-
-			// P = startP + i*G
-			dy.ModSub(&Gn[i].y,&pp.y);
-
-			_s.ModMulK1(&dy,&dx[i]);        // s = (p2.y-p1.y)*inverse(p2.x-p1.x);
-			_p.ModSquareK1(&_s);            // _p = pow2(s)
-
-			pp.x.ModNeg();
-			pp.x.ModAdd(&_p);
-			pp.x.ModSub(&Gn[i].x);           // rx = pow2(s) - p1.x - p2.x;
-
-#if 0
-			pp.y.ModSub(&Gn[i].x,&pp.x);
-			pp.y.ModMulK1(&_s);
-			pp.y.ModSub(&Gn[i].y);           // ry = - p2.y - s*(ret.x-p2.x);
-#endif
-
-			// P = startP - i*G  , if (x,y) = i*G then (x,-y) = -i*G
-			dyn.Set(&Gn[i].y);
-			dyn.ModNeg();
-			dyn.ModSub(&pn.y);
-
-			_s.ModMulK1(&dyn,&dx[i]);      // s = (p2.y-p1.y)*inverse(p2.x-p1.x);
-			_p.ModSquareK1(&_s);            // _p = pow2(s)
-
-			pn.x.ModNeg();
-			pn.x.ModAdd(&_p);
-			pn.x.ModSub(&Gn[i].x);          // rx = pow2(s) - p1.x - p2.x;
-
-#if 0
-			pn.y.ModSub(&Gn[i].x,&pn.x);
-			pn.y.ModMulK1(&_s);
-			pn.y.ModAdd(&Gn[i].y);          // ry = - p2.y - s*(ret.x-p2.x);
-#endif
-
-			pts[CPU_GRP_SIZE / 2 + (i + 1)] = pp;
-			pts[CPU_GRP_SIZE / 2 - (i + 1)] = pn;
-		}
-
-		// First point (startP - (GRP_SZIE/2)*G)
-		pn = startP;
-		dyn.Set(&Gn[i].y);
-		dyn.ModNeg();
-		dyn.ModSub(&pn.y);
-
-		_s.ModMulK1(&dyn,&dx[i]);
-		_p.ModSquareK1(&_s);
-
-		pn.x.ModNeg();
-		pn.x.ModAdd(&_p);
-		pn.x.ModSub(&Gn[i].x);
-
-#if 0
-		pn.y.ModSub(&Gn[i].x,&pn.x);
-		pn.y.ModMulK1(&_s);
-		pn.y.ModAdd(&Gn[i].y);
-#endif
-
-		pts[0] = pn;
+		group_points<false>(startP,Gn,dx,x,NULL);
 		for(j=0;j<CPU_GRP_SIZE;j++)	{
-			pts[j].x.Get32Bytes((unsigned char*)rawvalue);
+			x[j].Get32Bytes((unsigned char*)rawvalue);
 			bloom_bP_index = (uint8_t)rawvalue[0];
 			/*
 			if(FLAGDEBUG){
@@ -4523,41 +5161,20 @@ void *thread_bPload(void *vargp)	{
 			if(i_counter < bsgs_m3)	{
 				if(!FLAGREADEDFILE3)	{
 					memcpy(bPtable[i_counter].value,rawvalue+16,BSGS_XVALUE_RAM);
-					bPtable[i_counter].index = i_counter;
+					bsgs_setindex(&bPtable[i_counter],i_counter);
 				}
 				if(!FLAGREADEDFILE4)	{
-#if defined(_WIN64) && !defined(__CYGWIN__)
-					WaitForSingleObject(bloom_bPx3rd_mutex[bloom_bP_index], INFINITE);
-					bloom_add(&bloom_bPx3rd[bloom_bP_index], rawvalue, BSGS_BUFFERXPOINTLENGTH);
-					ReleaseMutex(bloom_bPx3rd_mutex[bloom_bP_index]);
-#else
-					pthread_mutex_lock(&bloom_bPx3rd_mutex[bloom_bP_index]);
-					bloom_add(&bloom_bPx3rd[bloom_bP_index], rawvalue, BSGS_BUFFERXPOINTLENGTH);
-					pthread_mutex_unlock(&bloom_bPx3rd_mutex[bloom_bP_index]);
-#endif
+					bloom_add_atomic(&bloom_bPx3rd[bloom_bP_index], rawvalue, BSGS_BUFFERXPOINTLENGTH);
 				}
 			}
 			if(i_counter < bsgs_m2 && !FLAGREADEDFILE2)	{
-#if defined(_WIN64) && !defined(__CYGWIN__)
-				WaitForSingleObject(bloom_bPx2nd_mutex[bloom_bP_index], INFINITE);
-				bloom_add(&bloom_bPx2nd[bloom_bP_index], rawvalue, BSGS_BUFFERXPOINTLENGTH);
-				ReleaseMutex(bloom_bPx2nd_mutex[bloom_bP_index]);
-#else
-				pthread_mutex_lock(&bloom_bPx2nd_mutex[bloom_bP_index]);
-				bloom_add(&bloom_bPx2nd[bloom_bP_index], rawvalue, BSGS_BUFFERXPOINTLENGTH);
-				pthread_mutex_unlock(&bloom_bPx2nd_mutex[bloom_bP_index]);
-#endif	
+				bloom_add_atomic(&bloom_bPx2nd[bloom_bP_index], rawvalue, BSGS_BUFFERXPOINTLENGTH);
 			}
 			if(i_counter < to && !FLAGREADEDFILE1 )	{
-#if defined(_WIN64) && !defined(__CYGWIN__)
-				WaitForSingleObject(bloom_bP_mutex[bloom_bP_index], INFINITE);
-				bloom_add(&bloom_bP[bloom_bP_index], rawvalue ,BSGS_BUFFERXPOINTLENGTH);
-				ReleaseMutex(bloom_bP_mutex[bloom_bP_index);
-#else
-				pthread_mutex_lock(&bloom_bP_mutex[bloom_bP_index]);
-				bloom_add(&bloom_bP[bloom_bP_index], rawvalue ,BSGS_BUFFERXPOINTLENGTH);
-				pthread_mutex_unlock(&bloom_bP_mutex[bloom_bP_index]);
-#endif
+				if(bloom_bP_prefilter.ready)	{
+					bloom_prefilter_add(&bloom_bP_prefilter, rawvalue, BSGS_BUFFERXPOINTLENGTH);
+				}
+				bloom_add_atomic(&bloom_bP[bloom_bP_index], rawvalue, BSGS_BUFFERXPOINTLENGTH);
 			}
 			i_counter++;
 		}
@@ -4602,9 +5219,9 @@ void *thread_bPload_2blooms(void *vargp)	{
 	IntGroup *grp = new IntGroup(CPU_GRP_SIZE / 2 + 1);
 	Point startP;
 	Int dx[CPU_GRP_SIZE / 2 + 1];
-	Point pts[CPU_GRP_SIZE];
-	Int dy,dyn,_s,_p;
-	Point pp,pn;
+	alignas(METRICS_CACHE_LINE) Int x[CPU_GRP_SIZE];
+	Int dy,_s,_p;
+	Point pp;
 	int i,bloom_bP_index,hLength = (CPU_GRP_SIZE / 2 - 1) ,threadid;
 	tt = (struct bPload *)vargp;
 	Int km((uint64_t)(tt->from +1 ));
@@ -4636,109 +5253,30 @@ void *thread_bPload_2blooms(void *vargp)	{
 		// We compute key in the positive and negative way from the center of the group
 		// center point
 		
-		pts[CPU_GRP_SIZE / 2] = startP;	//Center point
-
-		for(i = 0; i<hLength; i++) {
-			pp = startP;
-			pn = startP;
+		group_points<false>(startP,Gn,dx,x,NULL);
+		for(j=0;j<CPU_GRP_SIZE;j++)	{
+			x[j].Get32Bytes((unsigned char*)rawvalue);
+			bloom_bP_index = (uint8_t)rawvalue[0];
+			if(i_counter < bsgs_m3)	{
+				if(!FLAGREADEDFILE3)	{
+					memcpy(bPtable[i_counter].value,rawvalue+16,BSGS_XVALUE_RAM);
+					bsgs_setindex(&bPtable[i_counter],i_counter);
+				}
+				if(!FLAGREADEDFILE4)	{
+					bloom_add_atomic(&bloom_bPx3rd[bloom_bP_index], rawvalue, BSGS_BUFFERXPOINTLENGTH);
+				}
+			}
+			if(i_counter < bsgs_m2 && !FLAGREADEDFILE2)	{
+					bloom_add_atomic(&bloom_bPx2nd[bloom_bP_index], rawvalue, BSGS_BUFFERXPOINTLENGTH);
+			}
+			i_counter++;
+		}
+		// Next start point (startP + GRP_SIZE*G)
+		pp = startP;
+		dy.ModSub(&_2Gn.y,&pp.y);
 
-			// P = startP + i*G
-			dy.ModSub(&Gn[i].y,&pp.y);
-
-			_s.ModMulK1(&dy,&dx[i]);        // s = (p2.y-p1.y)*inverse(p2.x-p1.x);
-			_p.ModSquareK1(&_s);            // _p = pow2(s)
-
-			pp.x.ModNeg();
-			pp.x.ModAdd(&_p);
-			pp.x.ModSub(&Gn[i].x);           // rx = pow2(s) - p1.x - p2.x;
-
-#if 0
-			pp.y.ModSub(&Gn[i].x,&pp.x);
-			pp.y.ModMulK1(&_s);
-			pp.y.ModSub(&Gn[i].y);           // ry = - p2.y - s*(ret.x-p2.x);
-#endif
-
-			// P = startP - i*G  , if (x,y) = i*G then (x,-y) = -i*G
-			dyn.Set(&Gn[i].y);
-			dyn.ModNeg();
-			dyn.ModSub(&pn.y);
-
-			_s.ModMulK1(&dyn,&dx[i]);      // s = (p2.y-p1.y)*inverse(p2.x-p1.x);
-			_p.ModSquareK1(&_s);            // _p = pow2(s)
-
-			pn.x.ModNeg();
-			pn.x.ModAdd(&_p);
-			pn.x.ModSub(&Gn[i].x);          // rx = pow2(s) - p1.x - p2.x;
-
-#if 0
-			pn.y.ModSub(&Gn[i].x,&pn.x);
-			pn.y.ModMulK1(&_s);
-			pn.y.ModAdd(&Gn[i].y);          // ry = - p2.y - s*(ret.x-p2.x);
-#endif
-
-			pts[CPU_GRP_SIZE / 2 + (i + 1)] = pp;
-			pts[CPU_GRP_SIZE / 2 - (i + 1)] = pn;
-		}
-
-		// First point (startP - (GRP_SZIE/2)*G)
-		pn = startP;
-		dyn.Set(&Gn[i].y);
-		dyn.ModNeg();
-		dyn.ModSub(&pn.y);
-
-		_s.ModMulK1(&dyn,&dx[i]);
-		_p.ModSquareK1(&_s);
-
-		pn.x.ModNeg();
-		pn.x.ModAdd(&_p);
-		pn.x.ModSub(&Gn[i].x);
-
-#if 0
-		pn.y.ModSub(&Gn[i].x,&pn.x);
-		pn.y.ModMulK1(&_s);
-		pn.y.ModAdd(&Gn[i].y);
-#endif
-
-		pts[0] = pn;
-		for(j=0;j<CPU_GRP_SIZE;j++)	{
-			pts[j].x.Get32Bytes((unsigned char*)rawvalue);
-			bloom_bP_index = (uint8_t)rawvalue[0];
-			if(i_counter < bsgs_m3)	{
-				if(!FLAGREADEDFILE3)	{
-					memcpy(bPtable[i_counter].value,rawvalue+16,BSGS_XVALUE_RAM);
-					bPtable[i_counter].index = i_counter;
-				}
-				if(!FLAGREADEDFILE4)	{
-#if defined(_WIN64) && !defined(__CYGWIN__)
-					WaitForSingleObject(bloom_bPx3rd_mutex[bloom_bP_index], INFINITE);
-					bloom_add(&bloom_bPx3rd[bloom_bP_index], rawvalue, BSGS_BUFFERXPOINTLENGTH);
-					ReleaseMutex(bloom_bPx3rd_mutex[bloom_bP_index]);
-#else
-					pthread_mutex_lock(&bloom_bPx3rd_mutex[bloom_bP_index]);
-					bloom_add(&bloom_bPx3rd[bloom_bP_index], rawvalue, BSGS_BUFFERXPOINTLENGTH);
-					pthread_mutex_unlock(&bloom_bPx3rd_mutex[bloom_bP_index]);
-#endif
-				}
-			}
-			if(i_counter < bsgs_m2 && !FLAGREADEDFILE2)	{
-#if defined(_WIN64) && !defined(__CYGWIN__)
-					WaitForSingleObject(bloom_bPx2nd_mutex[bloom_bP_index], INFINITE);
-					bloom_add(&bloom_bPx2nd[bloom_bP_index], rawvalue, BSGS_BUFFERXPOINTLENGTH);
-					ReleaseMutex(bloom_bPx2nd_mutex[bloom_bP_index]);
-#else
-					pthread_mutex_lock(&bloom_bPx2nd_mutex[bloom_bP_index]);
-					bloom_add(&bloom_bPx2nd[bloom_bP_index], rawvalue, BSGS_BUFFERXPOINTLENGTH);
-					pthread_mutex_unlock(&bloom_bPx2nd_mutex[bloom_bP_index]);
-#endif			
-			}
-			i_counter++;
-		}
-		// Next start point (startP + GRP_SIZE*G)
-		pp = startP;
-		dy.ModSub(&_2Gn.y,&pp.y);
-
-		_s.ModMulK1(&dy,&dx[i + 1]);
-		_p.ModSquareK1(&_s);
+		_s.ModMulK1(&dy,&dx[i + 1]);
+		_p.ModSquareK1(&_s);
 
 		pp.x.ModNeg();
 		pp.x.ModAdd(&_p);
@@ -4794,22 +5332,38 @@ DWORD WINAPI thread_process_bsgs_dance(LPVOID vargp) {
 void *thread_process_bsgs_dance(void *vargp)	{
 #endif
 
-	Point pts[CPU_GRP_SIZE];
-	Int dx[CPU_GRP_SIZE / 2 + 1];
-	Point pp,pn,startP,base_point,point_aux,point_found;
-	FILE *filekey;
+	Int *x;		/* x of the batch */
+	Int *dx;
+	Point pp,startP,base_point,point_aux;
 	struct tothread *tt;
-	char xpoint_raw[32],*aux_c,*hextemp;
-	Int base_key,keyfound,dy,dyn,_s,_p,km,intaux;
-	IntGroup *grp = new IntGroup(CPU_GRP_SIZE / 2 + 1);
-	uint32_t k,l,r,salir,thread_number,entrar,cycles;
+	struct worker_context *ctx;
+	char xpoint_raw[32],*aux_c;
+	uint32_t *bsgs_queue,candidates;
+	Int base_key,keyfound,dy,_s,_p,km,intaux;
+	IntGroup *grp;
+	uint32_t k,r,thread_number,entrar,cycles;
 	int hLength = (CPU_GRP_SIZE / 2 - 1);	
 
-	grp->Set(dx);
+	uint64_t profile_time = 0;
 	
 	tt = (struct tothread *)vargp;
 	thread_number = tt->nt;
+	ctx = &workers[thread_number];
+	worker_pin(ctx);
+	/* Tables of the NUMA node of the thread */
+	Secp256K1 *secp = ctx->tables->secp;
+	std::vector<Point> &GSn = *ctx->tables->GSn;
+	Point &_2GSn = *ctx->tables->_2GSn;
+	stats_thread = &ctx->stats;
+	results_thread = &results.rings[thread_number];
+	worker_alloc(ctx,CPU_GRP_SIZE / 2 + 1,0,CPU_GRP_SIZE);
+	worker_alloc_xy(ctx,CPU_GRP_SIZE,false);
+	grp = ctx->grp;
+	dx = ctx->dx;
+	x = ctx->x;
+	bsgs_queue = ctx->queue;
 	free(tt);
+	profile_thread = FLAGPROFILE ? &ctx->profile : NULL;
 	
 	cycles = bsgs_aux / 1024;
 	if(bsgs_aux % 1024 != 0)	{
@@ -4835,17 +5389,17 @@ void *thread_process_bsgs_dance(void *vargp)	{
 #endif
 	switch(r)	{
 		case 0:	//TOP
-			if(n_range_end.IsGreater(&BSGS_CURRENT))	{
+			if(BSGS_TOP.IsGreater(&BSGS_CURRENT))	{
 				/*
-					n_range_end.Sub(&BSGS_N);
-					n_range_end.Sub(&BSGS_N);
+					BSGS_TOP.Sub(&BSGS_N);
+					BSGS_TOP.Sub(&BSGS_N);
 				*/
-					n_range_end.Sub(&BSGS_N_double);
-					if(n_range_end.IsLower(&BSGS_CURRENT))	{
+					BSGS_TOP.Sub(&BSGS_N_double);
+					if(BSGS_TOP.IsLower(&BSGS_CURRENT))	{
 						base_key.Set(&BSGS_CURRENT);
 					}
 					else	{
-						base_key.Set(&n_range_end);
+						base_key.Set(&BSGS_TOP);
 					}
 			}
 			else	{
@@ -4853,7 +5407,7 @@ void *thread_process_bsgs_dance(void *vargp)	{
 			}
 		break;
 		case 1: //BOTTOM
-			if(BSGS_CURRENT.IsLower(&n_range_end))	{
+			if(BSGS_CURRENT.IsLower(&BSGS_TOP))	{
 				base_key.Set(&BSGS_CURRENT);
 				//BSGS_N_double
 				BSGS_CURRENT.Add(&BSGS_N_double);
@@ -4867,7 +5421,7 @@ void *thread_process_bsgs_dance(void *vargp)	{
 			}
 		break;
 		case 2: //random - middle
-			base_key.Rand(&BSGS_CURRENT,&n_range_end);
+			base_key.Rand(&BSGS_CURRENT,&BSGS_TOP);
 		break;
 	}
 #if defined(_WIN64) && !defined(__CYGWIN__)
@@ -4878,6 +5432,9 @@ void *thread_process_bsgs_dance(void *vargp)	{
 
 		if(entrar == 0)
 			break;
+		if(FLAGCHECKPOINT && checkpoint_isdone(&keyhunt_checkpoint,&base_key))	{
+			continue;	/* This chunk was done before the last stop */
+		}
 			
 		if(FLAGMATRIX)	{
 			aux_c = base_key.GetBase16();
@@ -4885,15 +5442,7 @@ void *thread_process_bsgs_dance(void *vargp)	{
 			fflush(stdout);
 			free(aux_c);
 		}
-		else	{
-			if(FLAGQUIET == 0){
-				aux_c = base_key.GetBase16();
-				printf("\r[+] Thread 0x%s   \r",aux_c);
-				fflush(stdout);
-				free(aux_c);
-				THREADOUTPUT = 1;
-			}
-		}
+		metrics_setbase(&ctx->stats,&base_key);
 		
 		base_point = secp->ComputePublicKey(&base_key);
 
@@ -4912,6 +5461,7 @@ void *thread_process_bsgs_dance(void *vargp)	{
 				
 					int i;
 					
+					profile_time = profile_tsc();
 					for(i = 0; i < hLength; i++) {
 						dx[i].ModSub(&GSn[i].x,&startP.x);
 					}
@@ -4920,6 +5470,7 @@ void *thread_process_bsgs_dance(void *vargp)	{
 
 					// Grouped ModInv
 					grp->ModInv();
+					profile_stage(PROFILE_INVERSION,&profile_time);
 					
 					/*
 					We use the fact that P + i*G and P - i*G has the same deltax, so the same inverse
@@ -4927,117 +5478,23 @@ void *thread_process_bsgs_dance(void *vargp)	{
 					*/
 
 					// center point
-					pts[CPU_GRP_SIZE / 2] = startP;
+					group_points<false>(startP,GSn,dx,x,NULL);
 					
-					for(i = 0; i<hLength; i++) {
-
-						pp = startP;
-						pn = startP;
-
-						// P = startP + i*G
-						dy.ModSub(&GSn[i].y,&pp.y);
-
-						_s.ModMulK1(&dy,&dx[i]);        // s = (p2.y-p1.y)*inverse(p2.x-p1.x);
-						_p.ModSquareK1(&_s);            // _p = pow2(s)
-
-						pp.x.ModNeg();
-						pp.x.ModAdd(&_p);
-						pp.x.ModSub(&GSn[i].x);           // rx = pow2(s) - p1.x - p2.x;
-						
-#if 0
-  pp.y.ModSub(&GSn[i].x,&pp.x);
-  pp.y.ModMulK1(&_s);
-  pp.y.ModSub(&GSn[i].y);           // ry = - p2.y - s*(ret.x-p2.x);  
-#endif
-
-						// P = startP - i*G  , if (x,y) = i*G then (x,-y) = -i*G
-						dyn.Set(&GSn[i].y);
-						dyn.ModNeg();
-						dyn.ModSub(&pn.y);
-
-						_s.ModMulK1(&dyn,&dx[i]);       // s = (p2.y-p1.y)*inverse(p2.x-p1.x);
-						_p.ModSquareK1(&_s);            // _p = pow2(s)
-
-						pn.x.ModNeg();
-						pn.x.ModAdd(&_p);
-						pn.x.ModSub(&GSn[i].x);          // rx = pow2(s) - p1.x - p2.x;
-
-#if 0
-  pn.y.ModSub(&GSn[i].x,&pn.x);
-  pn.y.ModMulK1(&_s);
-  pn.y.ModAdd(&GSn[i].y);          // ry = - p2.y - s*(ret.x-p2.x);  
-#endif
-
-
-						pts[CPU_GRP_SIZE / 2 + (i + 1)] = pp;
-						pts[CPU_GRP_SIZE / 2 - (i + 1)] = pn;
-
+					profile_stage(PROFILE_POINTS,&profile_time);
+					candidates = 0;
+					for(int i = 0; i<CPU_GRP_SIZE; i++) {
+						x[i].Get32Bytes((unsigned char*)xpoint_raw);
+						if(bloom_check_prefiltered(&bloom_bP_prefilter,&bloom_bP[((unsigned char)xpoint_raw[0])],xpoint_raw,32)) {
+							bsgs_queue[candidates++] = (j*1024) + i;
+						}
 					}
-
-					// First point (startP - (GRP_SZIE/2)*G)
-					pn = startP;
-					dyn.Set(&GSn[i].y);
-					dyn.ModNeg();
-					dyn.ModSub(&pn.y);
-
-					_s.ModMulK1(&dyn,&dx[i]);
-					_p.ModSquareK1(&_s);
-
-					pn.x.ModNeg();
-					pn.x.ModAdd(&_p);
-					pn.x.ModSub(&GSn[i].x);
-
-#if 0
-pn.y.ModSub(&GSn[i].x,&pn.x);
-pn.y.ModMulK1(&_s);
-pn.y.ModAdd(&GSn[i].y);
-#endif
-
-					pts[0] = pn;
-					
-					for(int i = 0; i<CPU_GRP_SIZE && bsgs_found[k]== 0; i++) {
-						pts[i].x.Get32Bytes((unsigned char*)xpoint_raw);
-						r = bloom_check(&bloom_bP[((unsigned char)xpoint_raw[0])],xpoint_raw,32);
-						if(r) {
-							r = bsgs_secondcheck(&base_key,((j*1024) + i),k,&keyfound);
-							if(r)	{
-								hextemp = keyfound.GetBase16();
-								printf("[+] Thread Key found privkey %s   \n",hextemp);
-								point_found = secp->ComputePublicKey(&keyfound);
-								aux_c = secp->GetPublicKeyHex(OriginalPointsBSGScompressed[k],point_found);
-								printf("[+] Publickey %s\n",aux_c);
-#if defined(_WIN64) && !defined(__CYGWIN__)
-								WaitForSingleObject(write_keys, INFINITE);
-#else
-								pthread_mutex_lock(&write_keys);
-#endif
-
-								filekey = fopen("KEYFOUNDKEYFOUND.txt","a");
-								if(filekey != NULL)	{
-									fprintf(filekey,"Key found privkey %s\nPublickey %s\n",hextemp,aux_c);
-									fclose(filekey);
-								}
-								free(hextemp);
-								free(aux_c);
-#if defined(_WIN64) && !defined(__CYGWIN__)
-								ReleaseMutex(write_keys);
-#else
-								pthread_mutex_unlock(&write_keys);
-#endif
-
-								bsgs_found[k] = 1;
-								salir = 1;
-								for(l = 0; l < bsgs_point_number && salir; l++)	{
-									salir &= bsgs_found[l];
-								}
-								if(salir)	{
-									printf("All points were found\n");
-									exit(EXIT_FAILURE);
-								}
-							} //End if second check
-						}//End if first check
-						
-					}// For for pts variable
+					if(candidates > 0) {
+						r = bsgs_checkqueue(ctx,&base_key,bsgs_queue,candidates,k,&keyfound);
+						if(r)	{
+							bsgs_foundkey(&keyfound,k);
+						} //End if second check
+					}//End if first check
+					profile_stage(PROFILE_BLOOM,&profile_time);
 					
 					// Next start point (startP += (bsSize*GRP_SIZE).G)
 					
@@ -5060,9 +5517,12 @@ pn.y.ModAdd(&GSn[i].y);
 				}//while all the aMP points
 			}// End if 
 		}
-		steps[thread_number]+=2;
+		if(FLAGCHECKPOINT)	{
+			checkpoint_done(&keyhunt_checkpoint,&base_key);
+		}
+		metrics_add(&ctx->stats.steps,2);
 	}while(1);
-	ends[thread_number] = 1;
+	ctx->end.store(1,std::memory_order_relaxed);
 	return NULL;
 }
 
@@ -5071,33 +5531,47 @@ DWORD WINAPI thread_process_bsgs_backward(LPVOID vargp) {
 #else
 void *thread_process_bsgs_backward(void *vargp)	{
 #endif
-	FILE *filekey;
 	struct tothread *tt;
-	char xpoint_raw[32],*aux_c,*hextemp;
+	struct worker_context *ctx;
+	char xpoint_raw[32],*aux_c;
+	uint32_t *bsgs_queue,candidates;
 	Int base_key,keyfound;
-	Point base_point,point_aux,point_found;
-	uint32_t k,l,r,salir,thread_number,entrar,cycles;
+	Point base_point,point_aux;
+	uint32_t k,r,thread_number,entrar,cycles;
 	
-	IntGroup *grp = new IntGroup(CPU_GRP_SIZE / 2 + 1);
+	IntGroup *grp;
 	Point startP;
 	
 	int hLength = (CPU_GRP_SIZE / 2 - 1);
 	
-	Int dx[CPU_GRP_SIZE / 2 + 1];
-	Point pts[CPU_GRP_SIZE];
+	Int *dx;
+	Int *x;		/* x of the batch */
 
 	Int dy;
-	Int dyn;
 	Int _s;
 	Int _p;
 	Int km,intaux;
 	Point pp;
-	Point pn;
-	grp->Set(dx);
+	uint64_t profile_time = 0;
 
 	tt = (struct tothread *)vargp;
 	thread_number = tt->nt;
+	ctx = &workers[thread_number];
+	worker_pin(ctx);
+	/* Tables of the NUMA node of the thread */
+	Secp256K1 *secp = ctx->tables->secp;
+	std::vector<Point> &GSn = *ctx->tables->GSn;
+	Point &_2GSn = *ctx->tables->_2GSn;
+	stats_thread = &ctx->stats;
+	results_thread = &results.rings[thread_number];
+	worker_alloc(ctx,CPU_GRP_SIZE / 2 + 1,0,CPU_GRP_SIZE);
+	worker_alloc_xy(ctx,CPU_GRP_SIZE,false);
+	grp = ctx->grp;
+	dx = ctx->dx;
+	x = ctx->x;
+	bsgs_queue = ctx->queue;
 	free(tt);
+	profile_thread = FLAGPROFILE ? &ctx->profile : NULL;
 
 	cycles = bsgs_aux / 1024;
 	if(bsgs_aux % 1024 != 0)	{
@@ -5119,13 +5593,13 @@ void *thread_process_bsgs_backward(void *vargp)	{
 #else
 		pthread_mutex_lock(&bsgs_thread);
 #endif
-		if(n_range_end.IsGreater(&n_range_start))	{
-			n_range_end.Sub(&BSGS_N_double);
-			if(n_range_end.IsLower(&n_range_start))	{
+		if(BSGS_TOP.IsGreater(&n_range_start))	{
+			BSGS_TOP.Sub(&BSGS_N_double);
+			if(BSGS_TOP.IsLower(&n_range_start))	{
 				base_key.Set(&n_range_start);
 			}
 			else	{
-				base_key.Set(&n_range_end);
+				base_key.Set(&BSGS_TOP);
 			}
 		}
 		else	{
@@ -5138,6 +5612,9 @@ void *thread_process_bsgs_backward(void *vargp)	{
 #endif
 		if(entrar == 0)
 			break;
+		if(FLAGCHECKPOINT && checkpoint_isdone(&keyhunt_checkpoint,&base_key))	{
+			continue;	/* This chunk was done before the last stop */
+		}
 		
 		if(FLAGMATRIX)	{
 			aux_c = base_key.GetBase16();
@@ -5145,15 +5622,7 @@ void *thread_process_bsgs_backward(void *vargp)	{
 			fflush(stdout);
 			free(aux_c);
 		}
-		else	{
-			if(FLAGQUIET == 0){
-				aux_c = base_key.GetBase16();
-				printf("\r[+] Thread 0x%s   \r",aux_c);
-				fflush(stdout);
-				free(aux_c);
-				THREADOUTPUT = 1;
-			}
-		}
+		metrics_setbase(&ctx->stats,&base_key);
 		
 		base_point = secp->ComputePublicKey(&base_key);
 
@@ -5170,6 +5639,7 @@ void *thread_process_bsgs_backward(void *vargp)	{
 				uint32_t j = 0;
 				while( j < cycles && bsgs_found[k]== 0 )	{
 					int i;
+					profile_time = profile_tsc();
 					for(i = 0; i < hLength; i++) {
 						dx[i].ModSub(&GSn[i].x,&startP.x);
 					}
@@ -5178,6 +5648,7 @@ void *thread_process_bsgs_backward(void *vargp)	{
 
 					// Grouped ModInv
 					grp->ModInv();
+					profile_stage(PROFILE_INVERSION,&profile_time);
 					
 					/*
 					We use the fact that P + i*G and P - i*G has the same deltax, so the same inverse
@@ -5185,117 +5656,23 @@ void *thread_process_bsgs_backward(void *vargp)	{
 					*/
 
 					// center point
-					pts[CPU_GRP_SIZE / 2] = startP;
+					group_points<false>(startP,GSn,dx,x,NULL);
 					
-					for(i = 0; i<hLength; i++) {
-
-						pp = startP;
-						pn = startP;
-
-						// P = startP + i*G
-						dy.ModSub(&GSn[i].y,&pp.y);
-
-						_s.ModMulK1(&dy,&dx[i]);        // s = (p2.y-p1.y)*inverse(p2.x-p1.x);
-						_p.ModSquareK1(&_s);            // _p = pow2(s)
-
-						pp.x.ModNeg();
-						pp.x.ModAdd(&_p);
-						pp.x.ModSub(&GSn[i].x);           // rx = pow2(s) - p1.x - p2.x;
-						
-#if 0
-  pp.y.ModSub(&GSn[i].x,&pp.x);
-  pp.y.ModMulK1(&_s);
-  pp.y.ModSub(&GSn[i].y);           // ry = - p2.y - s*(ret.x-p2.x);  
-#endif
-
-						// P = startP - i*G  , if (x,y) = i*G then (x,-y) = -i*G
-						dyn.Set(&GSn[i].y);
-						dyn.ModNeg();
-						dyn.ModSub(&pn.y);
-
-						_s.ModMulK1(&dyn,&dx[i]);       // s = (p2.y-p1.y)*inverse(p2.x-p1.x);
-						_p.ModSquareK1(&_s);            // _p = pow2(s)
-
-						pn.x.ModNeg();
-						pn.x.ModAdd(&_p);
-						pn.x.ModSub(&GSn[i].x);          // rx = pow2(s) - p1.x - p2.x;
-
-#if 0
-  pn.y.ModSub(&GSn[i].x,&pn.x);
-  pn.y.ModMulK1(&_s);
-  pn.y.ModAdd(&GSn[i].y);          // ry = - p2.y - s*(ret.x-p2.x);  
-#endif
-
-
-						pts[CPU_GRP_SIZE / 2 + (i + 1)] = pp;
-						pts[CPU_GRP_SIZE / 2 - (i + 1)] = pn;
-
+					profile_stage(PROFILE_POINTS,&profile_time);
+					candidates = 0;
+					for(int i = 0; i<CPU_GRP_SIZE; i++) {
+						x[i].Get32Bytes((unsigned char*)xpoint_raw);
+						if(bloom_check_prefiltered(&bloom_bP_prefilter,&bloom_bP[((unsigned char)xpoint_raw[0])],xpoint_raw,32)) {
+							bsgs_queue[candidates++] = (j*1024) + i;
+						}
 					}
-
-					// First point (startP - (GRP_SZIE/2)*G)
-					pn = startP;
-					dyn.Set(&GSn[i].y);
-					dyn.ModNeg();
-					dyn.ModSub(&pn.y);
-
-					_s.ModMulK1(&dyn,&dx[i]);
-					_p.ModSquareK1(&_s);
-
-					pn.x.ModNeg();
-					pn.x.ModAdd(&_p);
-					pn.x.ModSub(&GSn[i].x);
-
-#if 0
-pn.y.ModSub(&GSn[i].x,&pn.x);
-pn.y.ModMulK1(&_s);
-pn.y.ModAdd(&GSn[i].y);
-#endif
-
-					pts[0] = pn;
-					
-					for(int i = 0; i<CPU_GRP_SIZE && bsgs_found[k]== 0; i++) {
-						pts[i].x.Get32Bytes((unsigned char*)xpoint_raw);
-						r = bloom_check(&bloom_bP[((unsigned char)xpoint_raw[0])],xpoint_raw,32);
-						if(r) {
-							r = bsgs_secondcheck(&base_key,((j*1024) + i),k,&keyfound);
-							if(r)	{
-								hextemp = keyfound.GetBase16();
-								printf("[+] Thread Key found privkey %s   \n",hextemp);
-								point_found = secp->ComputePublicKey(&keyfound);
-								aux_c = secp->GetPublicKeyHex(OriginalPointsBSGScompressed[k],point_found);
-								printf("[+] Publickey %s\n",aux_c);
-#if defined(_WIN64) && !defined(__CYGWIN__)
-								WaitForSingleObject(write_keys, INFINITE);
-#else
-								pthread_mutex_lock(&write_keys);
-#endif
-
-								filekey = fopen("KEYFOUNDKEYFOUND.txt","a");
-								if(filekey != NULL)	{
-									fprintf(filekey,"Key found privkey %s\nPublickey %s\n",hextemp,aux_c);
-									fclose(filekey);
-								}
-								free(hextemp);
-								free(aux_c);
-#if defined(_WIN64) && !defined(__CYGWIN__)
-								ReleaseMutex(write_keys);
-#else
-								pthread_mutex_unlock(&write_keys);
-#endif
-
-								bsgs_found[k] = 1;
-								salir = 1;
-								for(l = 0; l < bsgs_point_number && salir; l++)	{
-									salir &= bsgs_found[l];
-								}
-								if(salir)	{
-									printf("All points were found\n");
-									exit(EXIT_FAILURE);
-								}
-							} //End if second check
-						}//End if first check
-						
-					}// For for pts variable
+					if(candidates > 0) {
+						r = bsgs_checkqueue(ctx,&base_key,bsgs_queue,candidates,k,&keyfound);
+						if(r)	{
+							bsgs_foundkey(&keyfound,k);
+						} //End if second check
+					}//End if first check
+					profile_stage(PROFILE_BLOOM,&profile_time);
 					
 					// Next start point (startP += (bsSize*GRP_SIZE).G)
 					
@@ -5317,9 +5694,12 @@ pn.y.ModAdd(&GSn[i].y);
 				}//while all the aMP points
 			}// End if 
 		}
-		steps[thread_number]+=2;
+		if(FLAGCHECKPOINT)	{
+			checkpoint_done(&keyhunt_checkpoint,&base_key);
+		}
+		metrics_add(&ctx->stats.steps,2);
 	}while(1);
-	ends[thread_number] = 1;
+	ctx->end.store(1,std::memory_order_relaxed);
 	return NULL;
 }
 
@@ -5328,34 +5708,48 @@ DWORD WINAPI thread_process_bsgs_both(LPVOID vargp) {
 #else
 void *thread_process_bsgs_both(void *vargp)	{
 #endif
-	FILE *filekey;
 	struct tothread *tt;
-	char xpoint_raw[32],*aux_c,*hextemp;
+	struct worker_context *ctx;
+	char xpoint_raw[32],*aux_c;
+	uint32_t *bsgs_queue,candidates;
 	Int base_key,keyfound;
-	Point base_point,point_aux,point_found;
-	uint32_t k,l,r,salir,thread_number,entrar,cycles;
+	Point base_point,point_aux;
+	uint32_t k,r,thread_number,entrar,cycles;
 	
-	IntGroup *grp = new IntGroup(CPU_GRP_SIZE / 2 + 1);
+	IntGroup *grp;
 	Point startP;
 	
 	int hLength = (CPU_GRP_SIZE / 2 - 1);
 	
-	Int dx[CPU_GRP_SIZE / 2 + 1];
-	Point pts[CPU_GRP_SIZE];
+	Int *dx;
+	Int *x;		/* x of the batch */
 
 	Int dy;
-	Int dyn;
 	Int _s;
 	Int _p;
 	Int km,intaux;
 	Point pp;
-	Point pn;
-	grp->Set(dx);
+	uint64_t profile_time = 0;
 
 	
 	tt = (struct tothread *)vargp;
 	thread_number = tt->nt;
+	ctx = &workers[thread_number];
+	worker_pin(ctx);
+	/* Tables of the NUMA node of the thread */
+	Secp256K1 *secp = ctx->tables->secp;
+	std::vector<Point> &GSn = *ctx->tables->GSn;
+	Point &_2GSn = *ctx->tables->_2GSn;
+	stats_thread = &ctx->stats;
+	results_thread = &results.rings[thread_number];
+	worker_alloc(ctx,CPU_GRP_SIZE / 2 + 1,0,CPU_GRP_SIZE);
+	worker_alloc_xy(ctx,CPU_GRP_SIZE,false);
+	grp = ctx->grp;
+	dx = ctx->dx;
+	x = ctx->x;
+	bsgs_queue = ctx->queue;
 	free(tt);
+	profile_thread = FLAGPROFILE ? &ctx->profile : NULL;
 	
 	cycles = bsgs_aux / 1024;
 	if(bsgs_aux % 1024 != 0)	{
@@ -5381,17 +5775,17 @@ void *thread_process_bsgs_both(void *vargp)	{
 #endif
 		switch(r)	{
 			case 0:	//TOP
-				if(n_range_end.IsGreater(&BSGS_CURRENT))	{
-						n_range_end.Sub(&BSGS_N_double);
+				if(BSGS_TOP.IsGreater(&BSGS_CURRENT))	{
+						BSGS_TOP.Sub(&BSGS_N_double);
 						/*
-						n_range_end.Sub(&BSGS_N);
-						n_range_end.Sub(&BSGS_N);
+						BSGS_TOP.Sub(&BSGS_N);
+						BSGS_TOP.Sub(&BSGS_N);
 						*/
-						if(n_range_end.IsLower(&BSGS_CURRENT))	{
+						if(BSGS_TOP.IsLower(&BSGS_CURRENT))	{
 							base_key.Set(&BSGS_CURRENT);
 						}
 						else	{
-							base_key.Set(&n_range_end);
+							base_key.Set(&BSGS_TOP);
 						}
 				}
 				else	{
@@ -5399,7 +5793,7 @@ void *thread_process_bsgs_both(void *vargp)	{
 				}
 			break;
 			case 1: //BOTTOM
-				if(BSGS_CURRENT.IsLower(&n_range_end))	{
+				if(BSGS_CURRENT.IsLower(&BSGS_TOP))	{
 					base_key.Set(&BSGS_CURRENT);
 					//BSGS_N_double
 					BSGS_CURRENT.Add(&BSGS_N_double);
@@ -5421,6 +5815,9 @@ void *thread_process_bsgs_both(void *vargp)	{
 
 		if(entrar == 0)
 			break;
+		if(FLAGCHECKPOINT && checkpoint_isdone(&keyhunt_checkpoint,&base_key))	{
+			continue;	/* This chunk was done before the last stop */
+		}
 
 		
 		if(FLAGMATRIX)	{
@@ -5429,15 +5826,7 @@ void *thread_process_bsgs_both(void *vargp)	{
 			fflush(stdout);
 			free(aux_c);
 		}
-		else	{
-			if(FLAGQUIET == 0){
-				aux_c = base_key.GetBase16();
-				printf("\r[+] Thread 0x%s   \r",aux_c);
-				fflush(stdout);
-				free(aux_c);
-				THREADOUTPUT = 1;
-			}
-		}
+		metrics_setbase(&ctx->stats,&base_key);
 		
 		base_point = secp->ComputePublicKey(&base_key);
 
@@ -5454,6 +5843,7 @@ void *thread_process_bsgs_both(void *vargp)	{
 					uint32_t j = 0;
 					while( j < cycles && bsgs_found[k]== 0 )	{
 						int i;
+						profile_time = profile_tsc();
 						for(i = 0; i < hLength; i++) {
 							dx[i].ModSub(&GSn[i].x,&startP.x);
 						}
@@ -5462,6 +5852,7 @@ void *thread_process_bsgs_both(void *vargp)	{
 
 						// Grouped ModInv
 						grp->ModInv();
+						profile_stage(PROFILE_INVERSION,&profile_time);
 						
 						/*
 						We use the fact that P + i*G and P - i*G has the same deltax, so the same inverse
@@ -5469,117 +5860,23 @@ void *thread_process_bsgs_both(void *vargp)	{
 						*/
 
 						// center point
-						pts[CPU_GRP_SIZE / 2] = startP;
+						group_points<false>(startP,GSn,dx,x,NULL);
 						
-						for(i = 0; i<hLength; i++) {
-
-							pp = startP;
-							pn = startP;
-
-							// P = startP + i*G
-							dy.ModSub(&GSn[i].y,&pp.y);
-
-							_s.ModMulK1(&dy,&dx[i]);        // s = (p2.y-p1.y)*inverse(p2.x-p1.x);
-							_p.ModSquareK1(&_s);            // _p = pow2(s)
-
-							pp.x.ModNeg();
-							pp.x.ModAdd(&_p);
-							pp.x.ModSub(&GSn[i].x);           // rx = pow2(s) - p1.x - p2.x;
-							
-#if 0
-	  pp.y.ModSub(&GSn[i].x,&pp.x);
-	  pp.y.ModMulK1(&_s);
-	  pp.y.ModSub(&GSn[i].y);           // ry = - p2.y - s*(ret.x-p2.x);  
-#endif
-
-							// P = startP - i*G  , if (x,y) = i*G then (x,-y) = -i*G
-							dyn.Set(&GSn[i].y);
-							dyn.ModNeg();
-							dyn.ModSub(&pn.y);
-
-							_s.ModMulK1(&dyn,&dx[i]);       // s = (p2.y-p1.y)*inverse(p2.x-p1.x);
-							_p.ModSquareK1(&_s);            // _p = pow2(s)
-
-							pn.x.ModNeg();
-							pn.x.ModAdd(&_p);
-							pn.x.ModSub(&GSn[i].x);          // rx = pow2(s) - p1.x - p2.x;
-
-#if 0
-	  pn.y.ModSub(&GSn[i].x,&pn.x);
-	  pn.y.ModMulK1(&_s);
-	  pn.y.ModAdd(&GSn[i].y);          // ry = - p2.y - s*(ret.x-p2.x);  
-#endif
-
-
-							pts[CPU_GRP_SIZE / 2 + (i + 1)] = pp;
-							pts[CPU_GRP_SIZE / 2 - (i + 1)] = pn;
-
+						profile_stage(PROFILE_POINTS,&profile_time);
+						candidates = 0;
+						for(int i = 0; i<CPU_GRP_SIZE; i++) {
+							x[i].Get32Bytes((unsigned char*)xpoint_raw);
+							if(bloom_check_prefiltered(&bloom_bP_prefilter,&bloom_bP[((unsigned char)xpoint_raw[0])],xpoint_raw,32)) {
+								bsgs_queue[candidates++] = (j*1024) + i;
+							}
 						}
-
-						// First point (startP - (GRP_SZIE/2)*G)
-						pn = startP;
-						dyn.Set(&GSn[i].y);
-						dyn.ModNeg();
-						dyn.ModSub(&pn.y);
-
-						_s.ModMulK1(&dyn,&dx[i]);
-						_p.ModSquareK1(&_s);
-
-						pn.x.ModNeg();
-						pn.x.ModAdd(&_p);
-						pn.x.ModSub(&GSn[i].x);
-
-#if 0
-	pn.y.ModSub(&GSn[i].x,&pn.x);
-	pn.y.ModMulK1(&_s);
-	pn.y.ModAdd(&GSn[i].y);
-#endif
-
-						pts[0] = pn;
-						
-						for(int i = 0; i<CPU_GRP_SIZE && bsgs_found[k]== 0; i++) {
-							pts[i].x.Get32Bytes((unsigned char*)xpoint_raw);
-							r = bloom_check(&bloom_bP[((unsigned char)xpoint_raw[0])],xpoint_raw,32);
-							if(r) {
-								r = bsgs_secondcheck(&base_key,((j*1024) + i),k,&keyfound);
-								if(r)	{
-									hextemp = keyfound.GetBase16();
-									printf("[+] Thread Key found privkey %s   \n",hextemp);
-									point_found = secp->ComputePublicKey(&keyfound);
-									aux_c = secp->GetPublicKeyHex(OriginalPointsBSGScompressed[k],point_found);
-									printf("[+] Publickey %s\n",aux_c);
-#if defined(_WIN64) && !defined(__CYGWIN__)
-									WaitForSingleObject(write_keys, INFINITE);
-#else
-									pthread_mutex_lock(&write_keys);
-#endif
-
-									filekey = fopen("KEYFOUNDKEYFOUND.txt","a");
-									if(filekey != NULL)	{
-										fprintf(filekey,"Key found privkey %s\nPublickey %s\n",hextemp,aux_c);
-										fclose(filekey);
-									}
-									free(hextemp);
-									free(aux_c);
-#if defined(_WIN64) && !defined(__CYGWIN__)
-									ReleaseMutex(write_keys);
-#else
-									pthread_mutex_unlock(&write_keys);
-#endif
-
-									bsgs_found[k] = 1;
-									salir = 1;
-									for(l = 0; l < bsgs_point_number && salir; l++)	{
-										salir &= bsgs_found[l];
-									}
-									if(salir)	{
-										printf("All points were found\n");
-										exit(EXIT_FAILURE);
-									}
-								} //End if second check
-							}//End if first check
-							
-						}// For for pts variable
+						if(candidates > 0) {
+							r = bsgs_checkqueue(ctx,&base_key,bsgs_queue,candidates,k,&keyfound);
+							if(r)	{
+								bsgs_foundkey(&keyfound,k);
+							} //End if second check
+						}//End if first check
+						profile_stage(PROFILE_BLOOM,&profile_time);
 						
 						// Next start point (startP += (bsSize*GRP_SIZE).G)
 						
@@ -5602,9 +5899,12 @@ void *thread_process_bsgs_both(void *vargp)	{
 					}//while all the aMP points
 			}// End if 
 		}
-		steps[thread_number]+=2;	
+		if(FLAGCHECKPOINT)	{
+			checkpoint_done(&keyhunt_checkpoint,&base_key);
+		}
+		metrics_add(&ctx->stats.steps,2);	
 	}while(1);
-	ends[thread_number] = 1;
+	ctx->end.store(1,std::memory_order_relaxed);
 	return NULL;
 }
 
@@ -5704,7 +6004,7 @@ void sha256sse_22(uint8_t *src0, uint8_t *src1, uint8_t *src2, uint8_t *src3, ui
   BUFFMINIKEY(b1, src1);
   BUFFMINIKEY(b2, src2);
   BUFFMINIKEY(b3, src3);
-  sha256sse_1B(b0, b1, b2, b3, dst0, dst1, dst2, dst3);
+  sha256_1B(b0, b1, b2, b3, dst0, dst1, dst2, dst3);
 }
 
 
@@ -5726,16 +6026,24 @@ void sha256sse_22(uint8_t *src0, uint8_t *src1, uint8_t *src2, uint8_t *src3, ui
 (buff)[14] = 0; \
 (buff)[15] = 0xB8;	//184 bits => 23 BYTES
 
-void sha256sse_23(uint8_t *src0, uint8_t *src1, uint8_t *src2, uint8_t *src3, uint8_t *dst0, uint8_t *dst1, uint8_t *dst2, uint8_t *dst3)	{
+void sha256sse_23(uint8_t *src0, uint8_t *src1, uint8_t *src2, uint8_t *src3, uint8_t *src4, uint8_t *src5, uint8_t *src6, uint8_t *src7, uint8_t *dst0, uint8_t *dst1, uint8_t *dst2, uint8_t *dst3, uint8_t *dst4, uint8_t *dst5, uint8_t *dst6, uint8_t *dst7)	{
   uint32_t b0[16];
   uint32_t b1[16];
   uint32_t b2[16];
   uint32_t b3[16];
+  uint32_t b4[16];
+  uint32_t b5[16];
+  uint32_t b6[16];
+  uint32_t b7[16];
   BUFFMINIKEYCHECK(b0, src0);
   BUFFMINIKEYCHECK(b1, src1);
   BUFFMINIKEYCHECK(b2, src2);
   BUFFMINIKEYCHECK(b3, src3);
-  sha256sse_1B(b0, b1, b2, b3, dst0, dst1, dst2, dst3);
+  BUFFMINIKEYCHECK(b4, src4);
+  BUFFMINIKEYCHECK(b5, src5);
+  BUFFMINIKEYCHECK(b6, src6);
+  BUFFMINIKEYCHECK(b7, src7);
+  sha256_8_1B(b0, b1, b2, b3, b4, b5, b6, b7, dst0, dst1, dst2, dst3, dst4, dst5, dst6, dst7);
 }
 
 void menu() {
@@ -5745,13 +6053,14 @@ void menu() {
 	printf("-b bits     For some puzzles you only need some numbers of bits in the test keys.\n");
 	printf("-c crypto   Search for specific crypto. <btc, eth> valid only w/ -m address\n");
 	printf("-C mini     Set the minikey Base only 22 character minikeys, ex: SRPqx8QiwnW4WNWnTVa2W5\n");
+	printf("-D bits     Number of zero bits of a distinguished point, only for kangaroo mode, default: auto\n");
 	printf("-8 alpha    Set the bas58 alphabet for minikeys\n");
 	printf("-e          Enable endomorphism search (Only for address, rmd160 and vanity)\n");
 	printf("-f file     Specify file name with addresses or xpoints or uncompressed public keys\n");
 	printf("-I stride   Stride for xpoint, rmd160 and address, this option don't work with bsgs\n");
 	printf("-k value    Use this only with bsgs mode, k value is factor for M, more speed but more RAM use wisely\n");
 	printf("-l look     What type of address/hash160 are you looking for <compress, uncompress, both> Only for rmd160 and address\n");
-	printf("-m mode     mode of search for cryptos. (bsgs, xpoint, rmd160, address, vanity) default: address\n");
+	printf("-m mode     mode of search for cryptos. (bsgs, kangaroo, xpoint, rmd160, address, vanity) default: address\n");
 	printf("-M          Matrix screen, feel like a h4x0r, but performance will dropped\n");
 	printf("-n number   Check for N sequential numbers before the random chosen, this only works with -R option\n");
 	printf("            Use -n to set the N for the BSGS process. Bigger N more RAM needed\n");
@@ -5759,11 +6068,25 @@ void menu() {
 	printf("-r SR:EN    StarRange:EndRange, the end range can be omitted for search from start range to N-1 ECC value\n");
 	printf("-R          Random, this is the default behavior\n");
 	printf("-s ns       Number of seconds for the stats output, 0 to omit output.\n");
-	printf("-S          S is for SAVING in files BSGS data (Bloom filters and bPtable)\n");
+	printf("-S          S is for SAVING in files BSGS data (Bloom filters and bPtable) or the kangaroo DP table\n");
 	printf("-6          to skip sha256 Checksum on data files");
 	printf("-t tn       Threads number, must be a positive integer\n");
 	printf("-v value    Search for vanity Address, only with -m vanity\n");
 	printf("-z value    Bloom size multiplier, only address,rmd160,vanity, xpoint, value >= 1\n");
+	printf("--checkpoint ns  Save the work done every ns seconds in a checkpoint file, default: %i\n",CHECKPOINT_DEFAULT_SECONDS);
+	printf("--resume    Continue the work of the checkpoint file of the same search\n");
+	printf("--worker ep Take the ranges from the coordinator in host:port or unix:/path instead of -r/-b\n");
+	printf("--exact-range  Only hash the compressed publickey of the keys in the range, requires -l compress\n");
+	printf("--prefilter MB Size of the prefilter checked before the big bloom filters, 1 to %i, 0 to disable, default: %i when the bloom is bigger than %i MB\n",PREFILTER_MAX_MB,PREFILTER_DEFAULT_MB,PREFILTER_DEFAULT_MB*16);
+	printf("--disk-table   Keep the bP Table in its file instead of the RAM, only for bsgs with -S\n");
+	printf("--bench mode[,seconds]  Speed of mode (address, rmd160, xpoint, bsgs, minikeys, vanity, eth) with 1, 2, 4 ... -t threads\n");
+	printf("--profile      Print the cycles of each stage of the search (inversion, points, hash, bloom, search) with the stats\n");
+	printf("--metrics host:port|unix:/path  Serve the stats of the threads in Prometheus text format over HTTP\n");
+	printf("--metrics-file file  Append the stats as JSON lines every -s seconds (%i with -s 0)\n",METRICS_FILE_DEFAULT_SECONDS);
+	printf("--autotune         Measure the threads, plan -k with the free memory and the prefilter with the cache\n");
+	printf("--autotune-file file  Load the tuning of this host and mode from the file, tune and save it if it isn't there\n");
+	printf("--affinity policy  Pin the threads to the CPUs: compact, scatter, cores (one per physical core) or a list like 0,2,4-7\n");
+	printf("--hits-file file   Append the keys found as JSON lines, besides KEYFOUNDKEYFOUND.txt and VANITYKEYFOUND.txt\n");
 	printf("\nExample:\n\n");
 	printf("./keyhunt -m rmd160 -f tests/unsolvedpuzzles.rmd -b 66 -l compress -R -q -t 8\n\n");
 	printf("This line runs the program with 8 threads from the range 20000000000000000 to 40000000000000000 without stats output\n\n");
@@ -5801,36 +6124,7 @@ bool vanityrmdmatch(unsigned char *rmdhash)	{
 }
 
 void writevanitykey(bool compressed,Int *key)	{
-	Point publickey;
-	FILE *keys;
-	char *hextemp,*hexrmd,public_key_hex[131],address[50],rmdhash[20];
-	hextemp = key->GetBase16();
-	publickey = secp->ComputePublicKey(key);
-	secp->GetPublicKeyHex(compressed,publickey,public_key_hex);
-	
-	secp->GetHash160(P2PKH,compressed,publickey,(uint8_t*)rmdhash);
-	hexrmd = tohex(rmdhash,20);
-	rmd160toaddress_dst(rmdhash,address);
-	
-#if defined(_WIN64) && !defined(__CYGWIN__)
-	WaitForSingleObject(write_keys, INFINITE);
-#else
-	pthread_mutex_lock(&write_keys);
-#endif
-	keys = fopen("VANITYKEYFOUND.txt","a+");
-	if(keys != NULL)	{
-		fprintf(keys,"Vanity Private Key: %s\npubkey: %s\nAddress %s\nrmd160 %s\n",hextemp,public_key_hex,address,hexrmd);
-		fclose(keys);
-	}
-	printf("\nVanity Private Key: %s\npubkey: %s\nAddress %s\nrmd160 %s\n",hextemp,public_key_hex,address,hexrmd);
-	
-#if defined(_WIN64) && !defined(__CYGWIN__)
-	ReleaseMutex(write_keys);
-#else
-	pthread_mutex_unlock(&write_keys);
-#endif
-	free(hextemp);
-	free(hexrmd);
+	results_hit(RESULTS_VANITY,compressed,key,0);
 }
 
 
@@ -5987,66 +6281,89 @@ void checkpointer(void *ptr,const char *file,const char *function,const  char *n
 }
 
 void writekey(bool compressed,Int *key)	{
-	Point publickey;
-	FILE *keys;
-	char *hextemp,*hexrmd,public_key_hex[132],address[50],rmdhash[20];
-	memset(address,0,50);
-	memset(public_key_hex,0,132);
-	hextemp = key->GetBase16();
-	publickey = secp->ComputePublicKey(key);
-	secp->GetPublicKeyHex(compressed,publickey,public_key_hex);
-	secp->GetHash160(P2PKH,compressed,publickey,(uint8_t*)rmdhash);
-	hexrmd = tohex(rmdhash,20);
-	rmd160toaddress_dst(rmdhash,address);
+	results_hit(RESULTS_ADDRESS,compressed,key,0);
+	stats_count(METRICS_HIT_KEY);
+}
 
-#if defined(_WIN64) && !defined(__CYGWIN__)
-	WaitForSingleObject(write_keys, INFINITE);
-#else
-	pthread_mutex_lock(&write_keys);
-#endif
-	keys = fopen("KEYFOUNDKEYFOUND.txt","a+");
-	if(keys != NULL)	{
-		fprintf(keys,"Private Key: %s\npubkey: %s\nAddress %s\nrmd160 %s\n",hextemp,public_key_hex,address,hexrmd);
-		fclose(keys);
-	}
-	printf("\nHit! Private Key: %s\npubkey: %s\nAddress %s\nrmd160 %s\n",hextemp,public_key_hex,address,hexrmd);
-	
-#if defined(_WIN64) && !defined(__CYGWIN__)
-	ReleaseMutex(write_keys);
-#else
-	pthread_mutex_unlock(&write_keys);
-#endif
-	free(hextemp);
-	free(hexrmd);
+void writekeyeth(Int *key)	{
+	results_hit(RESULTS_ETH,false,key,0);
+	stats_count(METRICS_HIT_KEY);
 }
 
-void writekeyeth(Int *key)	{
-	Point publickey;
-	FILE *keys;
-	char *hextemp,address[43],hash[20];
-	hextemp = key->GetBase16();
-	publickey = secp->ComputePublicKey(key);
-	generate_binaddress_eth(publickey,(unsigned char*)hash);
-	address[0] = '0';
-	address[1] = 'x';
-	tohex_dst(hash,20,address+2);
+void results_begin()	{
+	if(results_start(&results,NTHREADS,"KEYFOUNDKEYFOUND.txt","VANITYKEYFOUND.txt",str_hitsfile,results_text) != 0)	{
+		fprintf(stderr,"[E] Can't start the writer of the keys found, check the file %s\n",str_hitsfile != NULL ? str_hitsfile : "KEYFOUNDKEYFOUND.txt");
+		exit(EXIT_FAILURE);
+	}
+}
 
-#if defined(_WIN64) && !defined(__CYGWIN__)
-	WaitForSingleObject(write_keys, INFINITE);
-#else
-	pthread_mutex_lock(&write_keys);
-#endif
-	keys = fopen("KEYFOUNDKEYFOUND.txt","a+");
-	if(keys != NULL)	{
-		fprintf(keys,"Private Key: %s\naddress: %s\n",hextemp,address);
-		fclose(keys);
+/* Only the copy of the key, the thread doesn't wait for the files */
+void results_hit(int kind,bool compressed,Int *key,uint32_t target)	{
+	struct results_record record;
+	for(int i = 0; i < 4; i++)	{
+		record.key[i] = key->bits64[i];
+	}
+	record.target = target;
+	record.kind = kind;
+	record.compressed = compressed;
+	results_push(&results,results_thread,&record);
+}
+
+/*
+	Called by the writer thread for each record, the same text of the files
+	and the output that the threads wrote before
+*/
+void results_text(struct results_record *record,struct results_output *output)	{
+	Point publickey;
+	Int key;
+	char *hextemp,*hexrmd,*aux_c,public_key_hex[132],address[50],hash[20];
+	key.SetInt32(0);
+	for(int i = 0; i < 4; i++)	{
+		key.bits64[i] = record->key[i];
+	}
+	hextemp = key.GetBase16();
+	publickey = secp->ComputePublicKey(&key);
+	switch(record->kind)	{
+		case RESULTS_ADDRESS:
+		case RESULTS_VANITY:
+			memset(address,0,50);
+			memset(public_key_hex,0,132);
+			secp->GetPublicKeyHex(record->compressed,publickey,public_key_hex);
+			secp->GetHash160(P2PKH,record->compressed,publickey,(uint8_t*)hash);
+			hexrmd = tohex(hash,20);
+			rmd160toaddress_dst(hash,address);
+			if(record->kind == RESULTS_VANITY)	{
+				output->file = RESULTS_VANITYKEYS;
+				snprintf(output->text,RESULTS_TEXT,"Vanity Private Key: %s\npubkey: %s\nAddress %s\nrmd160 %s\n",hextemp,public_key_hex,address,hexrmd);
+				snprintf(output->console,RESULTS_TEXT,"\nVanity Private Key: %s\npubkey: %s\nAddress %s\nrmd160 %s\n",hextemp,public_key_hex,address,hexrmd);
+			}
+			else	{
+				snprintf(output->text,RESULTS_TEXT,"Private Key: %s\npubkey: %s\nAddress %s\nrmd160 %s\n",hextemp,public_key_hex,address,hexrmd);
+				snprintf(output->console,RESULTS_TEXT,"\nHit! Private Key: %s\npubkey: %s\nAddress %s\nrmd160 %s\n",hextemp,public_key_hex,address,hexrmd);
+			}
+			snprintf(output->json,RESULTS_TEXT,"\"kind\":\"%s\",\"key\":\"%s\",\"pubkey\":\"%s\",\"address\":\"%s\",\"rmd160\":\"%s\"",results_kinds[record->kind],hextemp,public_key_hex,address,hexrmd);
+			free(hexrmd);
+		break;
+		case RESULTS_ETH:
+			generate_binaddress_eth(publickey,(unsigned char*)hash);
+			address[0] = '0';
+			address[1] = 'x';
+			tohex_dst(hash,20,address+2);
+			snprintf(output->text,RESULTS_TEXT,"Private Key: %s\naddress: %s\n",hextemp,address);
+			snprintf(output->console,RESULTS_TEXT,"\n Hit!!!! Private Key: %s\naddress: %s\n",hextemp,address);
+			snprintf(output->json,RESULTS_TEXT,"\"kind\":\"eth\",\"key\":\"%s\",\"address\":\"%s\"",hextemp,address);
+		break;
+		case RESULTS_BSGS:
+			aux_c = secp->GetPublicKeyHex(OriginalPointsBSGScompressed[record->target],publickey);
+			snprintf(output->text,RESULTS_TEXT,"Key found privkey %s\nPublickey %s\n",hextemp,aux_c);
+			snprintf(output->console,RESULTS_TEXT,"[+] Thread Key found privkey %s   \n[+] Publickey %s\n",hextemp,aux_c);
+			snprintf(output->json,RESULTS_TEXT,"\"kind\":\"bsgs\",\"key\":\"%s\",\"pubkey\":\"%s\"",hextemp,aux_c);
+			free(aux_c);
+		break;
+	}
+	if(FLAGWORKER)	{
+		cluster_found(&keyhunt_worker,&key);
 	}
-	printf("\n Hit!!!! Private Key: %s\naddress: %s\n",hextemp,address);
-#if defined(_WIN64) && !defined(__CYGWIN__)
-	ReleaseMutex(write_keys);
-#else
-	pthread_mutex_unlock(&write_keys);
-#endif
 	free(hextemp);
 }
 
@@ -6073,7 +6390,7 @@ bool processOneVanity()	{
 		return false;
 	}
 
-	if(!initBloomFilter(vanity_bloom, vanity_rmd_total))
+	if(!initBloomFilter(vanity_bloom, vanity_rmd_total,BLOOM_HASHED))
 		return false;
 	
 	for(i = 0; i < vanity_rmd_targets;i++)	{
@@ -6117,7 +6434,7 @@ bool readFileVanity(char *fileName)	{
 	}
 	
 	N = vanity_rmd_total;
-	if(!initBloomFilter(vanity_bloom,N))
+	if(!initBloomFilter(vanity_bloom,N,BLOOM_HASHED))
 		return false;
 	
 	for(i = 0; i < vanity_rmd_targets ; i++)	{
@@ -6331,7 +6648,7 @@ bool forceReadFileAddress(char *fileName)	{
 	addressTable = (struct address_value*) malloc(sizeof(struct address_value)*numberItems);
 	checkpointer((void *)addressTable,__FILE__,"malloc","addressTable" ,__LINE__ -1 );
 		
-	if(!initBloomFilter(&bloom,numberItems))
+	if(!initBloomFilter(&bloom,numberItems,BLOOM_KEYED))
 		return false;
 
 	i = 0;
@@ -6406,7 +6723,7 @@ bool forceReadFileAddressEth(char *fileName)	{
 	checkpointer((void *)addressTable,__FILE__,"malloc","addressTable" ,__LINE__ -1 );
 	
 	
-	if(!initBloomFilter(&bloom,N))
+	if(!initBloomFilter(&bloom,N,BLOOM_KEYED))
 		return false;
 	
 	i = 0;
@@ -6486,7 +6803,7 @@ bool forceReadFileXPoint(char *fileName)	{
 	
 	N = numberItems;
 	
-	if(!initBloomFilter(&bloom,N))
+	if(!initBloomFilter(&bloom,N,BLOOM_KEYED))
 		return false;
 	
 	i= 0;
@@ -6556,17 +6873,17 @@ bool forceReadFileXPoint(char *fileName)	{
 	I write this as a function because i have the same segment of code in 3 different functions
 */
 
-bool initBloomFilter(struct bloom *bloom_arg,uint64_t items_bloom)	{
+bool initBloomFilter(struct bloom *bloom_arg,uint64_t items_bloom,uint8_t mode)	{
 	bool r = true;
 	printf("[+] Bloom filter for %" PRIu64 " elements.\n",items_bloom);
 	if(items_bloom <= 10000)	{
-		if(bloom_init2(bloom_arg,10000,0.000001) == 1){
+		if(bloom_init3(bloom_arg,10000,0.000001,mode) == 1){
 			fprintf(stderr,"[E] error bloom_init for 10000 elements.\n");
 			r = false;
 		}
 	}
 	else	{
-		if(bloom_init2(bloom_arg,FLAGBLOOMMULTIPLIER*items_bloom,0.000001)	== 1){
+		if(bloom_init3(bloom_arg,FLAGBLOOMMULTIPLIER*items_bloom,0.000001,mode)	== 1){
 			fprintf(stderr,"[E] error bloom_init for %" PRIu64 " elements.\n",items_bloom);
 			r = false;
 		}
@@ -6575,6 +6892,264 @@ bool initBloomFilter(struct bloom *bloom_arg,uint64_t items_bloom)	{
 	return r;
 }
 
+/*
+	The prefilter is only worth when the filter behind it doesn't fit in the cache
+*/
+bool initPrefilter(struct bloom_prefilter *prefilter_arg,uint64_t items,uint64_t filter_bytes)	{
+	uint64_t prefilter_bytes;
+	double bpe;
+	memset(prefilter_arg,0,sizeof(struct bloom_prefilter));
+	if(PREFILTER_MB == 0 || (PREFILTER_MB < 0 && PREFILTER_AUTO_MB == 0) || items == 0)	{
+		return false;
+	}
+	prefilter_bytes = (uint64_t)(PREFILTER_MB > 0 ? PREFILTER_MB : PREFILTER_AUTO_MB) * 1048576;
+	if(PREFILTER_MB < 0 && filter_bytes < prefilter_bytes * 16)	{
+		return false;
+	}
+	if(prefilter_bytes * 8 < items * BLOOM_PREFILTER_MIN_BITS)	{
+		printf("[W] The prefilter of %" PRIu64 " MB is too small for %" PRIu64 " elements, it needs %" PRIu64 " MB and the max is %i MB\n",prefilter_bytes/1048576,items,(items * BLOOM_PREFILTER_MIN_BITS / 8 + 1048575)/1048576,PREFILTER_MAX_MB);
+		return false;
+	}
+	if(bloom_prefilter_init(prefilter_arg,items,prefilter_bytes) == 1)	{
+		fprintf(stderr,"[E] error bloom_prefilter_init for %" PRIu64 " elements\n",items);
+		exit(EXIT_FAILURE);
+	}
+	bpe = (double)(prefilter_arg->bytes*8)/(double)items;
+	printf("[+] Prefilter of %.2f MB, %.1f bits per element, about %.1f%% of the checks pass to the bloom filter\n",(double)prefilter_arg->bytes/(double)1048576,bpe,100 * pow(1 - exp(-prefilter_arg->hashes / bpe),prefilter_arg->hashes));
+	return true;
+}
+
+/*
+	Progress of the bP table generation: the chunks of THREADBPWORKLOAD points
+	already done, and the bloom filters, prefilter and bP table made with them.
+	It is written every BSGS_PROGRESS_SECONDS (or --checkpoint seconds) while
+	the threads keep working, the bitmap is copied before the data so all the
+	chunks marked as done are in the file, the extra bits of the chunks in
+	progress are harmless because those chunks are made again.
+*/
+struct bsgs_progress_header	{
+	char magic[8];
+	uint64_t bsgs_m;
+	uint64_t bsgs_m2;
+	uint64_t bsgs_m3;
+	uint64_t workload;
+	uint64_t chunks;
+	uint64_t prefilter_bytes;
+	uint64_t table_bytes;
+};
+
+/* Read or write one block of the progress file with its checksum, the block is copied first because the threads are still writing it */
+static bool bsgs_progress_block(FILE *fd_progress,CSHA256 *sha,uint8_t *data,uint64_t size,bool write,uint8_t *copy)	{
+	uint64_t offset,length;
+	for(offset = 0; offset < size; offset += length)	{
+		length = (size - offset > BSGS_PROGRESS_BLOCK) ? BSGS_PROGRESS_BLOCK : size - offset;
+		if(write)	{
+			memcpy(copy,data + offset,length);
+			sha->Write(copy,length);
+			if(fwrite(copy,length,1,fd_progress) != 1)	{
+				return false;
+			}
+		}
+		else	{
+			if(fread(data + offset,length,1,fd_progress) != 1)	{
+				return false;
+			}
+			sha->Write(data + offset,length);
+		}
+	}
+	return true;
+}
+
+static bool bsgs_progress_data(FILE *fd_progress,CSHA256 *sha,bool write,uint8_t *copy)	{
+	int k;
+	bool r = true;
+	for(k = 0; k < 256 && r; k++)	{
+		r = bsgs_progress_block(fd_progress,sha,bloom_bP[k].bf,bloom_bP[k].bytes,write,copy)
+			&& bsgs_progress_block(fd_progress,sha,bloom_bPx2nd[k].bf,bloom_bPx2nd[k].bytes,write,copy)
+			&& bsgs_progress_block(fd_progress,sha,bloom_bPx3rd[k].bf,bloom_bPx3rd[k].bytes,write,copy);
+	}
+	if(r && bloom_bP_prefilter.ready)	{
+		r = bsgs_progress_block(fd_progress,sha,(uint8_t*)bloom_bP_prefilter.bf,bloom_bP_prefilter.bytes,write,copy);
+	}
+	if(r && bPtable != NULL)	{
+		r = bsgs_progress_block(fd_progress,sha,(uint8_t*)bPtable,bsgs_m3 * sizeof(struct bsgs_xvalue),write,copy);
+	}
+	return r;
+}
+
+static void bsgs_progress_fill(struct bsgs_progress_header *header,uint64_t chunks)	{
+	memset(header,0,sizeof(struct bsgs_progress_header));
+	memcpy(header->magic,BSGS_PROGRESS_MAGIC,8);
+	header->bsgs_m = bsgs_m;
+	header->bsgs_m2 = bsgs_m2;
+	header->bsgs_m3 = bsgs_m3;
+	header->workload = THREADBPWORKLOAD;
+	header->chunks = chunks;
+	header->prefilter_bytes = bloom_bP_prefilter.ready ? bloom_bP_prefilter.bytes : 0;
+	header->table_bytes = (bPtable != NULL) ? bsgs_m3 * sizeof(struct bsgs_xvalue) : 0;
+}
+
+bool bsgs_progress_load(uint8_t *done,uint64_t chunks)	{
+	struct bsgs_progress_header header,expected;
+	uint8_t checksum_file[32],checksum_data[32];
+	char name[1024];
+	FILE *fd_progress;
+	CSHA256 sha;
+	snprintf(name,1024,"keyhunt_bsgs_%" PRIu64 ".progress",bsgs_m);
+	fd_progress = fopen(name,"rb");
+	if(fd_progress == NULL)	{
+		return false;
+	}
+	printf("[+] Reading the progress of the bP table from file %s\n",name);
+	bsgs_progress_fill(&expected,chunks);
+	if(fread(&header,sizeof(struct bsgs_progress_header),1,fd_progress) != 1 || memcmp(&header,&expected,sizeof(struct bsgs_progress_header)) != 0)	{
+		fclose(fd_progress);
+		fprintf(stderr,"[W] The file %s is for other parameters, ignoring it\n",name);
+		return false;
+	}
+	sha.Write((unsigned char*)&header,sizeof(struct bsgs_progress_header));
+	if(!bsgs_progress_block(fd_progress,&sha,done,(chunks + 7) / 8,false,NULL) || !bsgs_progress_data(fd_progress,&sha,false,NULL) || fread(checksum_file,32,1,fd_progress) != 1)	{
+		fprintf(stderr,"[E] Error reading the file %s, delete it to start again\n",name);
+		exit(EXIT_FAILURE);
+	}
+	fclose(fd_progress);
+	sha.Finalize(checksum_data);
+	if(memcmp(checksum_file,checksum_data,32) != 0)	{
+		fprintf(stderr,"[E] Error checksum file mismatch! %s, delete it to start again\n",name);
+		exit(EXIT_FAILURE);
+	}
+	return true;
+}
+
+void bsgs_progress_save(uint8_t *done,uint64_t chunks)	{
+	struct bsgs_progress_header header;
+	uint8_t *done_copy,*copy,checksum[32];
+	char name[1024],tmpname[1040];
+	FILE *fd_progress;
+	CSHA256 sha;
+	bool r;
+	snprintf(name,1024,"keyhunt_bsgs_%" PRIu64 ".progress",bsgs_m);
+	snprintf(tmpname,1040,"%s.tmp",name);
+	fd_progress = fopen(tmpname,"wb");
+	if(fd_progress == NULL)	{
+		fprintf(stderr,"[W] Can't create the file %s\n",tmpname);
+		return;
+	}
+	/* The bitmap is only updated by this thread, it is saved as it is now */
+	done_copy = (uint8_t*) malloc((chunks + 7) / 8);
+	copy = (uint8_t*) malloc(BSGS_PROGRESS_BLOCK);
+	checkpointer((void *)done_copy,__FILE__,"malloc","done_copy" ,__LINE__ -2 );
+	checkpointer((void *)copy,__FILE__,"malloc","copy" ,__LINE__ -2 );
+	memcpy(done_copy,done,(chunks + 7) / 8);
+	bsgs_progress_fill(&header,chunks);
+	sha.Write((unsigned char*)&header,sizeof(struct bsgs_progress_header));
+	r = fwrite(&header,sizeof(struct bsgs_progress_header),1,fd_progress) == 1
+		&& bsgs_progress_block(fd_progress,&sha,done_copy,(chunks + 7) / 8,true,copy)
+		&& bsgs_progress_data(fd_progress,&sha,true,copy);
+	sha.Finalize(checksum);
+	r = r && fwrite(checksum,32,1,fd_progress) == 1;
+	r = r && syncfile(fd_progress) == 0;
+	r = (fclose(fd_progress) == 0) && r;
+	free(done_copy);
+	free(copy);
+	if(!r)	{
+		fprintf(stderr,"[W] Error writing the file %s\n",tmpname);
+		remove(tmpname);
+		return;
+	}
+#if defined(_WIN64) && !defined(__CYGWIN__)
+	remove(name);
+#endif
+	if(rename(tmpname,name) != 0 || syncdir(name) != 0)	{
+		fprintf(stderr,"[W] Can't rename the file %s\n",tmpname);
+	}
+}
+
+/*
+	Header of the prefilter file, the fields of struct bloom_prefilter without
+	its pointer, followed by the bits and the checksum of the bits
+*/
+struct prefilter_header	{
+	char magic[8];
+	uint64_t entries;
+	uint64_t lines;
+	uint64_t bytes;
+	uint8_t hashes;
+	uint8_t reserved[7];
+};
+
+bool readPrefilterFile(struct bloom_prefilter *prefilter_arg,const char *fileName)	{
+	struct prefilter_header header;
+	struct checksumsha256 checksum_file;
+	uint8_t rawchecksum[32];
+	FILE *fd_prefilter;
+	fd_prefilter = fopen(fileName,"rb");
+	if(fd_prefilter == NULL)	{
+		return false;
+	}
+	printf("[+] Reading prefilter from file %s\n",fileName);
+	if(fread(&header,sizeof(struct prefilter_header),1,fd_prefilter) != 1)	{
+		fprintf(stderr,"[E] Error reading the file %s\n",fileName);
+		exit(EXIT_FAILURE);
+	}
+	if(memcmp(header.magic,PREFILTER_MAGIC,8) != 0)	{
+		printf("[W] The file %s was made by an older version\n",fileName);
+		fclose(fd_prefilter);
+		return false;
+	}
+	/* The size can be of other --prefilter value, but never more than PREFILTER_MAX_MB for the same elements */
+	if(header.entries != prefilter_arg->entries || header.bytes < BLOOM_PREFILTER_LINE || header.bytes > (uint64_t)PREFILTER_MAX_MB * 1048576 || header.lines * BLOOM_PREFILTER_LINE != header.bytes || header.bytes * 8 < header.entries * BLOOM_PREFILTER_MIN_BITS)	{
+		printf("[W] The prefilter of the file %s is not for this bloom filter\n",fileName);
+		fclose(fd_prefilter);
+		return false;
+	}
+	if(header.bytes != prefilter_arg->bytes)	{
+		bloom_prefilter_free(prefilter_arg);
+		if(bloom_prefilter_init(prefilter_arg,header.entries,header.bytes) == 1)	{
+			fprintf(stderr,"[E] error bloom_prefilter_init for %" PRIu64 " elements\n",header.entries);
+			exit(EXIT_FAILURE);
+		}
+	}
+	if(header.hashes != prefilter_arg->hashes || fread(prefilter_arg->bf,prefilter_arg->bytes,1,fd_prefilter) != 1 || fread(&checksum_file,sizeof(struct checksumsha256),1,fd_prefilter) != 1)	{
+		fprintf(stderr,"[E] Error reading the file %s\n",fileName);
+		exit(EXIT_FAILURE);
+	}
+	fclose(fd_prefilter);
+	if(FLAGSKIPCHECKSUM == 0)	{
+		sha256((uint8_t*)prefilter_arg->bf,prefilter_arg->bytes,rawchecksum);
+		if(memcmp(checksum_file.data,rawchecksum,32) != 0 || memcmp(checksum_file.backup,rawchecksum,32) != 0)	{
+			fprintf(stderr,"[E] Error checksum file mismatch! %s\n",fileName);
+			exit(EXIT_FAILURE);
+		}
+	}
+	return true;
+}
+
+void writePrefilterFile(struct bloom_prefilter *prefilter_arg,const char *fileName)	{
+	struct prefilter_header header;
+	struct checksumsha256 checksum_file;
+	FILE *fd_prefilter;
+	memset(&header,0,sizeof(struct prefilter_header));
+	memcpy(header.magic,PREFILTER_MAGIC,8);
+	header.entries = prefilter_arg->entries;
+	header.lines = prefilter_arg->lines;
+	header.bytes = prefilter_arg->bytes;
+	header.hashes = prefilter_arg->hashes;
+	sha256((uint8_t*)prefilter_arg->bf,prefilter_arg->bytes,(uint8_t*)checksum_file.data);
+	memcpy(checksum_file.backup,checksum_file.data,32);
+	fd_prefilter = fopen(fileName,"wb");
+	if(fd_prefilter == NULL)	{
+		fprintf(stderr,"[E] Error can't create the file %s\n",fileName);
+		exit(EXIT_FAILURE);
+	}
+	printf("[+] Writing prefilter to file %s\n",fileName);
+	if(fwrite(&header,sizeof(struct prefilter_header),1,fd_prefilter) != 1 || fwrite(prefilter_arg->bf,prefilter_arg->bytes,1,fd_prefilter) != 1 || fwrite(&checksum_file,sizeof(struct checksumsha256),1,fd_prefilter) != 1)	{
+		fprintf(stderr,"[E] Error writing the file %s please delete it\n",fileName);
+		exit(EXIT_FAILURE);
+	}
+	fclose(fd_prefilter);
+}
+
 void writeFileIfNeeded(const char *fileName)	{
 	//printf("[D] FLAGSAVEREADFILE %i, FLAGREADEDFILE1 %i\n",FLAGSAVEREADFILE,FLAGREADEDFILE1);
 	if(FLAGSAVEREADFILE && !FLAGREADEDFILE1)	{
@@ -6687,3 +7262,1164 @@ void calcualteindex(int i,Int *key)	{
 		key->Add(&BSGS_M3);
 	}
 }
+
+/*
+	Pollard kangaroo with distinguished points.
+	Everything is computed in a range moved to zero: a tame kangaroo with distance d is at d*G,
+	a wild kangaroo with distance d is at (Target - range_start*G) + d*G, when both land on the
+	same point the private key is range_start + d_tame - d_wild.
+	Tame points don't depend of the target, so the tame part of the DP table is useful for
+	every target and for every run with the same DP bits and jumps.
+*/
+void kangaroo_init()	{
+	Int modulo,start;
+	Point startP,minusstart;
+	uint8_t hash[32];
+	uint32_t i,rangebits,herdbits,jumpbits;
+	int dpbits;
+	uint64_t expected;
+	double dexpected;
+	int r;
+
+	rangebits = n_range_diff.GetBitLength();
+	if(rangebits < 16)	{
+		fprintf(stderr,"[E] The range is too small for kangaroo mode\n");
+		exit(EXIT_FAILURE);
+	}
+	if(rangebits > KANGAROO_MAX_RANGEBITS)	{
+		fprintf(stderr,"[E] The range of %u bits is too big for kangaroo mode, the max is %i bits\n",rangebits,KANGAROO_MAX_RANGEBITS);
+		exit(EXIT_FAILURE);
+	}
+	herdbits = 0;
+	while(((uint64_t)1 << herdbits) < (uint64_t)NTHREADS * CPU_GRP_SIZE)	{
+		herdbits++;
+	}
+	/* Mean jump close to kangaroos * sqrt(range) / 4 */
+	jumpbits = rangebits/2 + herdbits - 2;
+	if(jumpbits > rangebits)	{
+		jumpbits = rangebits;
+	}
+	if(!FLAGDPBITS)	{
+		dpbits = (int)(rangebits/2) - (int)herdbits - 2;
+		if(dpbits > KANGAROO_MAX_DPBITS)	{
+			dpbits = KANGAROO_MAX_DPBITS;
+		}
+		KANGAROO_DPBITS = (dpbits > 0) ? dpbits : 0;
+	}
+	KANGAROO_DPMASK = (KANGAROO_DPBITS > 0) ? (~(uint64_t)0 << (64 - KANGAROO_DPBITS)) : 0;
+
+	/* About 2*sqrt(range) jumps are expected, one of each 2^dpbits is stored */
+	dexpected = pow(2.0,rangebits/2.0 + 1.0 - KANGAROO_DPBITS) + (double)NTHREADS * CPU_GRP_SIZE;
+	if(dexpected > (double)((uint64_t)1 << 28))	{
+		fprintf(stderr,"[W] The DP table will be full before the end, use a bigger -D value\n");
+		dexpected = (double)((uint64_t)1 << 28);
+	}
+	expected = (uint64_t)dexpected;
+	if(dptable_init(&kangaroo_dptable,expected,KANGAROO_DPBITS,jumpbits))	{
+		fprintf(stderr,"[E] error dptable_init for %" PRIu64 " elements.\n",expected);
+		exit(EXIT_FAILURE);
+	}
+	printf("[+] Kangaroo DP bits %u, jump bits %u, %u kangaroos\n",KANGAROO_DPBITS,jumpbits,NTHREADS * CPU_GRP_SIZE);
+	printf("[+] DP table for %" PRIu64 " elements : %.2f MB\n",kangaroo_dptable.limit,(double)(kangaroo_dptable.slots * sizeof(struct dpentry))/1048576);
+
+	/* The jumps are the same in every run, so saved DP tables can be merged */
+	modulo.SetInt32(1);
+	modulo.ShiftL(jumpbits);
+	for(i = 0; i < KANGAROO_JUMPS; i++)	{
+		sha256((uint8_t*)&i,sizeof(uint32_t),hash);
+		KANGAROO_JUMPD[i].Set32Bytes(hash);
+		KANGAROO_JUMPD[i].Mod(&modulo);
+		if(KANGAROO_JUMPD[i].IsZero())	{
+			KANGAROO_JUMPD[i].AddOne();
+		}
+		KANGAROO_JUMPP[i] = secp->ComputePublicKey(&KANGAROO_JUMPD[i]);
+	}
+	KANGAROO_HALF.Set(&n_range_diff);
+	KANGAROO_HALF.ShiftR(1);
+
+	start.Set(&n_range_start);
+	startP = secp->ComputePublicKey(&start);
+	minusstart = secp->Negation(startP);
+	KangarooWildStart.resize(bsgs_point_number);
+	kangaroo_wild_id = (uint64_t*) calloc(bsgs_point_number,sizeof(uint64_t));
+	checkpointer((void *)kangaroo_wild_id,__FILE__,"calloc","kangaroo_wild_id" ,__LINE__ -1 );
+	for(i = 0; i < bsgs_point_number; i++)	{
+		if(OriginalPointsBSGS[i].x.IsEqual(&startP.x))	{
+			fprintf(stderr,"[E] The target %u is the start of the range, use a different range\n",i);
+			exit(EXIT_FAILURE);
+		}
+		KangarooWildStart[i] = secp->AddDirect(OriginalPointsBSGS[i],minusstart);
+		kangaroo_wild_id[i] = (KangarooWildStart[i].x.bits64[0] << 2) | 2;	/* Never 0 or DPTABLE_TAME */
+	}
+
+	if(FLAGSAVEREADFILE)	{
+		snprintf(kangaroo_file,1024,"keyhunt_kangaroo_%u_%u.dp",KANGAROO_DPBITS,jumpbits);
+		printf("[+] Reading DP table from file %s ",kangaroo_file);
+		fflush(stdout);
+		r = dptable_load(&kangaroo_dptable,kangaroo_file,kangaroo_loadentry);
+		switch(r)	{
+			case 0:
+				printf("... Done! %" PRIu64 " points loaded\n",kangaroo_dptable.entries);
+			break;
+			case 1:
+				printf("... not found, it will be created\n");
+			break;
+			default:
+				fprintf(stderr,"\n[E] Error reading the file %s (%i)\n",kangaroo_file,r);
+				exit(EXIT_FAILURE);
+			break;
+		}
+	}
+}
+
+/*
+	Move a kangaroo to a new random start, target -1 is for a tame kangaroo
+*/
+void kangaroo_spawn(Point *kangaroo,Int *distance,int target)	{
+	Point point_aux;
+#if defined(_WIN64) && !defined(__CYGWIN__)
+	WaitForSingleObject(bsgs_thread, INFINITE);
+#else
+	pthread_mutex_lock(&bsgs_thread);
+#endif
+	if(target < 0)	{
+		distance->Rand(&ONE,&n_range_diff);
+	}
+	else	{
+		distance->Rand(&ZERO,&KANGAROO_HALF);
+	}
+#if defined(_WIN64) && !defined(__CYGWIN__)
+	ReleaseMutex(bsgs_thread);
+#else
+	pthread_mutex_unlock(&bsgs_thread);
+#endif
+	if(target < 0)	{
+		*kangaroo = secp->ComputePublicKey(distance);
+	}
+	else	{
+		if(distance->IsZero())	{
+			*kangaroo = KangarooWildStart[target];
+		}
+		else	{
+			point_aux = secp->ComputePublicKey(distance);
+			*kangaroo = secp->AddDirect(KangarooWildStart[target],point_aux);
+		}
+	}
+}
+
+int kangaroo_target(uint64_t owner)	{
+	uint32_t i;
+	for(i = 0; i < bsgs_point_number; i++)	{
+		if(kangaroo_wild_id[i] == owner && !bsgs_found[i])	{
+			return i;
+		}
+	}
+	return -1;
+}
+
+/*
+	Store a distinguished point and check it against the previous ones.
+	Return 1 if the kangaroo is walking the path of other kangaroo of its own herd and need a new start.
+*/
+int kangaroo_dp(uint64_t x,uint64_t owner,Int *distance)	{
+	struct dpentry collision;
+	Int tame,wild;
+	int target;
+	switch(dptable_add(&kangaroo_dptable,x,owner,distance->bits64,&collision))	{
+		case DPTABLE_ADDED:
+			return 0;
+		case DPTABLE_FULL:
+			if(!FLAGDPFULL)	{
+				FLAGDPFULL = 1;
+				fprintf(stderr,"\n[W] The DP table is full, new distinguished points are not stored, use a bigger -D value\n");
+			}
+			return 0;
+	}
+	if(collision.owner == owner)	{
+		return 1;
+	}
+	tame.SetInt32(0);
+	wild.SetInt32(0);
+	if(owner == DPTABLE_TAME)	{
+		memcpy(tame.bits64,distance->bits64,sizeof(collision.distance));
+		memcpy(wild.bits64,collision.distance,sizeof(collision.distance));
+		target = kangaroo_target(collision.owner);
+	}
+	else	{
+		if(collision.owner != DPTABLE_TAME)	{
+			return 0;	/* Wild kangaroo of other target */
+		}
+		memcpy(tame.bits64,collision.distance,sizeof(collision.distance));
+		memcpy(wild.bits64,distance->bits64,sizeof(collision.distance));
+		target = kangaroo_target(owner);
+	}
+	if(target >= 0)	{
+		kangaroo_solve(&tame,&wild,target);
+	}
+	return 0;
+}
+
+bool kangaroo_solve(Int *tame,Int *wild,int target)	{
+	FILE *filekey;
+	Int keyfound;
+	Point point_found;
+	char *hextemp,*aux_c;
+	uint32_t l,salir;
+	if(tame->IsLower(wild))	{
+		return false;
+	}
+	keyfound.Set(tame);
+	keyfound.Sub(wild);
+	keyfound.Add(&n_range_start);
+	point_found = secp->ComputePublicKey(&keyfound);
+	if(!point_found.x.IsEqual(&OriginalPointsBSGS[target].x) || !point_found.y.IsEqual(&OriginalPointsBSGS[target].y))	{
+		return false;
+	}
+#if defined(_WIN64) && !defined(__CYGWIN__)
+	WaitForSingleObject(write_keys, INFINITE);
+#else
+	pthread_mutex_lock(&write_keys);
+#endif
+	if(bsgs_found[target] == 0)	{
+		hextemp = keyfound.GetBase16();
+		aux_c = secp->GetPublicKeyHex(OriginalPointsBSGScompressed[target],point_found);
+		printf("\n[+] Thread Key found privkey %s   \n",hextemp);
+		printf("[+] Publickey %s\n",aux_c);
+		filekey = fopen("KEYFOUNDKEYFOUND.txt","a");
+		if(filekey != NULL)	{
+			fprintf(filekey,"Key found privkey %s\nPublickey %s\n",hextemp,aux_c);
+			fclose(filekey);
+		}
+		free(hextemp);
+		free(aux_c);
+		bsgs_found[target] = 1;
+		salir = 1;
+		for(l = 0; l < bsgs_point_number && salir; l++)	{
+			salir &= bsgs_found[l];
+		}
+		if(salir)	{
+			if(FLAGSAVEREADFILE)	{
+				kangaroo_savefile();
+			}
+			printf("All points were found\n");
+			exit(EXIT_SUCCESS);
+		}
+		l = KANGAROO_TARGET;
+		while(bsgs_found[l])	{
+			l++;
+		}
+		KANGAROO_TARGET = l;	/* The wild kangaroos of all threads go for the next target */
+	}
+#if defined(_WIN64) && !defined(__CYGWIN__)
+	ReleaseMutex(write_keys);
+#else
+	pthread_mutex_unlock(&write_keys);
+#endif
+	return true;
+}
+
+void kangaroo_loadentry(struct dpentry *entry)	{
+	Int distance;
+	if(entry->owner != DPTABLE_TAME && kangaroo_target(entry->owner) < 0)	{
+		return;	/* Wild points of targets that we are not looking for */
+	}
+	distance.SetInt32(0);
+	memcpy(distance.bits64,entry->distance,sizeof(entry->distance));
+	kangaroo_dp(entry->x,entry->owner,&distance);
+}
+
+/* Called by the stats of main and by the thread that solves the last target, both write the same .tmp file */
+void kangaroo_savefile()	{
+#if defined(_WIN64) && !defined(__CYGWIN__)
+	WaitForSingleObject(kangaroo_save, INFINITE);
+#else
+	pthread_mutex_lock(&kangaroo_save);
+#endif
+	if(dptable_save(&kangaroo_dptable,kangaroo_file) != 0)	{
+		fprintf(stderr,"\n[E] Error writing the file %s\n",kangaroo_file);
+	}
+#if defined(_WIN64) && !defined(__CYGWIN__)
+	ReleaseMutex(kangaroo_save);
+#else
+	pthread_mutex_unlock(&kangaroo_save);
+#endif
+}
+
+#if defined(_WIN64) && !defined(__CYGWIN__)
+DWORD WINAPI thread_process_kangaroo(LPVOID vargp) {
+#else
+void *thread_process_kangaroo(void *vargp)	{
+#endif
+	struct tothread *tt;
+	struct worker_context *ctx;
+	IntGroup *grp;
+	Point *herd;
+	Int *distance;
+	Int *dx;
+	Int dy,_s,_p;
+	uint32_t i,j,thread_number,target;
+
+	tt = (struct tothread *)vargp;
+	thread_number = tt->nt;
+	ctx = &workers[thread_number];
+	worker_pin(ctx);
+	stats_thread = &ctx->stats;
+	results_thread = &results.rings[thread_number];
+	worker_alloc(ctx,CPU_GRP_SIZE,0,0);
+	herd = new Point[CPU_GRP_SIZE];
+	distance = new Int[CPU_GRP_SIZE];
+	grp = ctx->grp;
+	dx = ctx->dx;
+	free(tt);
+
+	/* Even kangaroos are tame, odd kangaroos are wild, all of them share the same ModInv */
+	target = KANGAROO_TARGET;
+	for(i = 0; i < CPU_GRP_SIZE; i++)	{
+		kangaroo_spawn(&herd[i],&distance[i],(i & 1) ? (int)target : -1);
+	}
+	for(;;)	{
+		if(target != KANGAROO_TARGET)	{
+			target = KANGAROO_TARGET;
+			for(i = 1; i < CPU_GRP_SIZE; i += 2)	{
+				kangaroo_spawn(&herd[i],&distance[i],target);
+			}
+		}
+		for(i = 0; i < CPU_GRP_SIZE; i++)	{
+			j = herd[i].x.bits64[0] % KANGAROO_JUMPS;
+			dx[i].ModSub(&KANGAROO_JUMPP[j].x,&herd[i].x);
+		}
+		grp->ModInv();
+		for(i = 0; i < CPU_GRP_SIZE; i++)	{
+			j = herd[i].x.bits64[0] % KANGAROO_JUMPS;
+
+			dy.ModSub(&KANGAROO_JUMPP[j].y,&herd[i].y);
+			_s.ModMulK1(&dy,&dx[i]);				// s = (p2.y-p1.y)*inverse(p2.x-p1.x);
+			_p.ModSquareK1(&_s);					// _p = pow2(s)
+			_p.ModSub(&herd[i].x);
+			_p.ModSub(&KANGAROO_JUMPP[j].x);		// rx = pow2(s) - p1.x - p2.x;
+
+			dy.ModSub(&herd[i].x,&_p);
+			dy.ModMulK1(&_s);
+			herd[i].y.ModSub(&dy,&herd[i].y);		// ry = s*(p1.x-rx) - p1.y;
+			herd[i].x.Set(&_p);
+
+			distance[i].Add(&KANGAROO_JUMPD[j]);
+
+			if((herd[i].x.bits64[3] & KANGAROO_DPMASK) == 0)	{
+				if(kangaroo_dp(herd[i].x.bits64[1],(i & 1) ? kangaroo_wild_id[target] : DPTABLE_TAME,&distance[i]))	{
+					kangaroo_spawn(&herd[i],&distance[i],(i & 1) ? (int)target : -1);
+				}
+			}
+		}
+		metrics_add(&ctx->stats.steps,1);
+	}
+	return NULL;
+}
+
+void init_checkpoint(const char *fileName,Int *chunk)	{
+	char filename[1024];
+	char *str_total;
+	unsigned char raw[32],digest[32];
+	uint32_t settings[7];
+	Int total;
+	CSHA256 sha;
+	int rv;
+	if(FLAGMODE == MODE_MINIKEYS)	{
+		fprintf(stderr,"[W] Checkpoint is not supported in minikeys mode\n");
+		FLAGCHECKPOINT = 0;
+		return;
+	}
+	if(FLAGMODE == MODE_KANGAROO)	{
+		fprintf(stderr,"[W] Kangaroo mode keeps its work in the DP table, use -S instead of a checkpoint\n");
+		FLAGCHECKPOINT = 0;
+		return;
+	}
+	/*
+		The name of the file depends on all the values that change the work done
+		so a different search never resume from the wrong file
+	*/
+	settings[0] = FLAGMODE;
+	settings[1] = (FLAGMODE == MODE_BSGS) ? FLAGBSGSMODE : FLAGRANDOM;
+	settings[2] = FLAGSEARCH;
+	settings[3] = FLAGCRYPTO;
+	settings[4] = FLAGENDOMORPHISM;
+	settings[5] = FLAGSTRIDE;
+	settings[6] = KFACTOR;
+	sha.Write((unsigned char*)settings,sizeof(settings));
+	n_range_start.Get32Bytes(raw);
+	sha.Write(raw,32);
+	n_range_end.Get32Bytes(raw);
+	sha.Write(raw,32);
+	chunk->Get32Bytes(raw);
+	sha.Write(raw,32);
+	if(FLAGSTRIDE)	{
+		stride.Get32Bytes(raw);
+		sha.Write(raw,32);
+	}
+	sha.Write((const unsigned char*)fileName,strlen(fileName));
+	sha.Finalize(digest);
+	snprintf(filename,1024,"keyhunt_checkpoint_%.2x%.2x%.2x%.2x.dat",digest[0],digest[1],digest[2],digest[3]);
+	
+	rv = checkpoint_init(&keyhunt_checkpoint,filename,&n_range_start,&n_range_end,chunk,(FLAGMODE == MODE_BSGS) ? FLAGBSGSMODE == 3 : FLAGRANDOM);
+	if(rv != 0)	{
+		fprintf(stderr,"[E] Can't allocate the checkpoint bitmap\n");
+		exit(EXIT_FAILURE);
+	}
+	if(keyhunt_checkpoint.random && keyhunt_checkpoint.chunks == 0)	{
+		fprintf(stderr,"[W] The range is too big to record the visited chunks, only the random keys are checked\n");
+	}
+	if(FLAGRESUME)	{
+		rv = checkpoint_load(&keyhunt_checkpoint);
+		switch(rv)	{
+			case 0:
+				checkpoint_total(&keyhunt_checkpoint,&total);
+				str_total = total.GetBase10();
+				printf("[+] Resuming from %s, %s keys already done\n",filename,str_total);
+				free(str_total);
+			break;
+			case 1:
+				fprintf(stderr,"[W] Checkpoint file %s not found, starting from the beginning\n",filename);
+			break;
+			default:
+				fprintf(stderr,"[E] Checkpoint file %s is corrupted or doesn't match this search\n",filename);
+				exit(EXIT_FAILURE);
+			break;
+		}
+	}
+	else	{
+		printf("[+] Checkpoint file %s\n",filename);
+	}
+}
+
+void save_checkpoint()	{
+	if(checkpoint_save(&keyhunt_checkpoint) != 0)	{
+		fprintf(stderr,"[E] Can't save the checkpoint file %s\n",keyhunt_checkpoint.filename);
+	}
+}
+
+/*
+	Total of keys checked by all the threads, each step is BSGS_N keys
+	(DEBUGCOUNT in the non BSGS modes)
+*/
+void get_total_keys(Int *total)	{
+	uint64_t total_steps = 0;
+	for(int j = 0; j < NTHREADS; j++) {
+		total_steps += workers[j].stats.steps.load(std::memory_order_relaxed);
+	}
+	get_step_keys(total);
+	total->Mult(total_steps);
+}
+
+/* Keys checked in each step of a thread */
+void get_step_keys(Int *keys)	{
+	keys->Set(&BSGS_N);
+	if(FLAGMODE == MODE_KANGAROO)	{
+		/* Each step is one jump of one kangaroo */
+	}
+	else if(FLAGENDOMORPHISM)	{
+		if(FLAGMODE == MODE_XPOINT)	{
+			keys->Mult(3);
+		}
+		else	{
+			keys->Mult(6);
+		}
+	}
+	else	{
+		if(FLAGSEARCH == SEARCH_COMPRESS && !FLAGEXACTRANGE)	{
+			keys->Mult(2);
+		}
+	}
+}
+
+/*
+	Child of --bench, the steps of the threads are taken after the warmup and
+	BENCH_SECONDS later, the line [BENCH] is the only output read by the parent.
+	The seconds in the line are measured between both snapshots, the loop of
+	main sleeps one second plus the time of its own work
+*/
+void bench_report(uint64_t second)	{
+	Int step_keys;
+	char *str_step_keys;
+	double elapsed;
+	int j;
+	if(second == BENCH_WARMUP)	{
+		bench_steps = (uint64_t*) calloc(NTHREADS,sizeof(uint64_t));
+		checkpointer((void *)bench_steps,__FILE__,"calloc","bench_steps" ,__LINE__ -1 );
+		bench_start = std::chrono::steady_clock::now();
+		for(j = 0; j < NTHREADS; j++)	{
+			bench_steps[j] = workers[j].stats.steps.load(std::memory_order_relaxed);
+		}
+	}
+	if(second == BENCH_WARMUP + (uint64_t)BENCH_SECONDS)	{
+		for(j = 0; j < NTHREADS; j++)	{
+			bench_steps[j] = workers[j].stats.steps.load(std::memory_order_relaxed) - bench_steps[j];
+		}
+		elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - bench_start).count();
+		get_step_keys(&step_keys);
+		str_step_keys = step_keys.GetBase10();
+		printf("\n[BENCH] %.6f %s",elapsed,str_step_keys);
+		for(j = 0; j < NTHREADS; j++)	{
+			printf(" %" PRIu64,bench_steps[j]);
+		}
+		printf("\n");
+		fflush(stdout);
+		exit(EXIT_SUCCESS);
+	}
+}
+
+const struct bench_mode *bench_find(const char *name)	{
+	for(int i = 0; bench_modes[i].name != NULL; i++)	{
+		if(strcmp(bench_modes[i].name,name) == 0)	{
+			return &bench_modes[i];
+		}
+	}
+	return NULL;
+}
+
+/* Run a --bench-run child with the threads and read the keys/s of each thread */
+bool bench_measure(const struct bench_mode *bench,const char *program,int threads,int seconds,double *thread_rate)	{
+	char command[2048],line[4096],*token;
+	double step_keys = 0,elapsed = 0;
+	int count = 0;
+	bool readed = false;
+	FILE *fd_bench;
+	snprintf(command,2048,"\"%s\" %s -t %i -q -s 0 --bench-run %i",program,bench->args,threads,seconds);
+#if defined(_WIN64) && !defined(__CYGWIN__)
+	fd_bench = _popen(command,"r");
+#else
+	fd_bench = popen(command,"r");
+#endif
+	if(fd_bench == NULL)	{
+		fprintf(stderr,"[E] Can't run %s\n",command);
+		exit(EXIT_FAILURE);
+	}
+	while(fgets(line,4096,fd_bench) != NULL)	{
+		if(strncmp(line,"[BENCH] ",8) == 0)	{
+			/* Measured seconds of the child, the requested ones are only the number of ticks */
+			token = strtok(line + 8," \r\n");
+			if(token != NULL)	{
+				elapsed = strtod(token,NULL);
+				token = strtok(NULL," \r\n");
+			}
+			if(token != NULL)	{
+				step_keys = strtod(token,NULL);
+				token = strtok(NULL," \r\n");
+			}
+			while(token != NULL && count < threads && elapsed > 0)	{
+				thread_rate[count++] = strtod(token,NULL) * step_keys / elapsed;
+				token = strtok(NULL," \r\n");
+			}
+			readed = (count == threads);
+		}
+	}
+#if defined(_WIN64) && !defined(__CYGWIN__)
+	_pclose(fd_bench);
+#else
+	pclose(fd_bench);
+#endif
+	return readed;
+}
+
+/* Unit of str_limits_prefixs for the rate */
+double bench_scale(double rate,int *prefix)	{
+	double unit = 1000000;
+	*prefix = 0;
+	while(*prefix < 6 && rate >= unit * 1000)	{
+		(*prefix)++;
+		unit *= 1000;
+	}
+	return unit;
+}
+
+/*
+	Run the mode with 1, 2, 4 ... threads up to -t (all the CPUs by default),
+	the scaling is the speed against the speed of one thread multiplied by the
+	threads and the deviation is between the threads of the same run
+*/
+void bench_sweep(const char *program,const char *mode)	{
+	const struct bench_mode *bench = NULL;
+	char name[64],*token;
+	double rate,single_rate = 0,mean,deviation,unit,thread_rate[1024];
+	int i,prefix,threads,max_threads,seconds = BENCH_DEFAULT_SECONDS;
+	FILE *fd_bench;
+
+	snprintf(name,64,"%s",mode);
+	token = strchr(name,',');
+	if(token != NULL)	{
+		*token = '\0';
+		seconds = strtol(token + 1,NULL,10);
+		if(seconds <= 0)	{
+			fprintf(stderr,"[E] Invalid benchmark seconds: %s\n",token + 1);
+			exit(EXIT_FAILURE);
+		}
+	}
+	bench = bench_find(name);
+	if(bench == NULL)	{
+		fprintf(stderr,"[E] Unknow benchmark mode %s, valid modes: address, rmd160, xpoint, bsgs, minikeys, vanity, eth\n",name);
+		exit(EXIT_FAILURE);
+	}
+	fd_bench = fopen(bench->file,"r");
+	if(fd_bench == NULL)	{
+		fprintf(stderr,"[E] The benchmark needs the file %s, run it from the keyhunt directory\n",bench->file);
+		exit(EXIT_FAILURE);
+	}
+	fclose(fd_bench);
+	if(FLAGTHREADS)	{
+		max_threads = NTHREADS;
+	}
+	else	{
+#if defined(_WIN64) && !defined(__CYGWIN__)
+		SYSTEM_INFO sysinfo;
+		GetSystemInfo(&sysinfo);
+		max_threads = sysinfo.dwNumberOfProcessors;
+#else
+		max_threads = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+	}
+	if(max_threads > 1024)	{
+		max_threads = 1024;
+	}
+	printf("[+] Benchmark of %s, %i seconds per run up to %i threads\n",bench->name,seconds,max_threads);
+	threads = 1;
+	while(threads <= max_threads)	{
+		if(!bench_measure(bench,program,threads,seconds,thread_rate))	{
+			fprintf(stderr,"[E] The benchmark of %s with %i threads failed\n",bench->name,threads);
+			exit(EXIT_FAILURE);
+		}
+		rate = 0;
+		for(i = 0; i < threads; i++)	{
+			rate += thread_rate[i];
+		}
+		mean = rate / threads;
+		deviation = 0;
+		for(i = 0; i < threads; i++)	{
+			deviation += (thread_rate[i] - mean) * (thread_rate[i] - mean);
+		}
+		deviation = (mean > 0) ? sqrt(deviation / threads) * 100 / mean : 0;
+		if(threads == 1)	{
+			single_rate = rate;
+		}
+		unit = bench_scale(rate,&prefix);
+		printf("[+] %s %i thread%s: %.3f %s, scaling %.1f%%, thread deviation %.1f%%\n",bench->name,threads,(threads > 1) ? "s" : "",rate / unit,str_limits_prefixs[prefix],(single_rate > 0) ? rate * 100 / (single_rate * threads) : 0,deviation);
+		fflush(stdout);
+		if(threads == max_threads)	{
+			break;
+		}
+		threads = (threads * 2 > max_threads) ? max_threads : threads * 2;
+	}
+}
+
+/* Name of the mode in the profile file, the same of --bench when it has one */
+const char *autotune_mode()	{
+	switch(FLAGMODE)	{
+		case MODE_ADDRESS:
+			return (FLAGCRYPTO == CRYPTO_ETH) ? "eth" : "address";
+		case MODE_RMD160:
+			return "rmd160";
+		case MODE_XPOINT:
+			return "xpoint";
+		case MODE_BSGS:
+			return "bsgs";
+		case MODE_MINIKEYS:
+			return "minikeys";
+		case MODE_VANITY:
+			return "vanity";
+		case MODE_KANGAROO:
+			return "kangaroo";
+	}
+	return "pub2rmd";
+}
+
+/*
+	Fastest number of threads between 1, 2, 4 ..., the physical cores and all
+	the CPUs, all the CPUs if the mode can't be measured
+*/
+int autotune_threads(const char *program,struct autotune_host *host,double *best_rate)	{
+	const struct bench_mode *bench = bench_find(autotune_mode());
+	struct affinity_topology cpus;
+	std::vector<int> candidates;
+	double rate,unit,thread_rate[1024];
+	int i,prefix,cores = 0,best = host->cpus,max_threads = (host->cpus > 1024) ? 1024 : host->cpus;
+	FILE *fd_bench;
+	*best_rate = 0;
+	if(bench == NULL)	{
+		printf("[W] The mode %s can't be measured, using %i threads\n",autotune_mode(),host->cpus);
+		return host->cpus;
+	}
+	fd_bench = fopen(bench->file,"r");
+	if(fd_bench == NULL)	{
+		printf("[W] Without the file %s the threads are not measured, using %i threads\n",bench->file,host->cpus);
+		return host->cpus;
+	}
+	fclose(fd_bench);
+	for(i = 1; i < max_threads; i *= 2)	{
+		candidates.push_back(i);
+	}
+	if(affinity_read(&cpus) == 0)	{
+		for(i = 0; i < (int)cpus.cpus.size(); i++)	{
+			cores += (cpus.cpus[i].smt == 0);
+		}
+		if(cores > 0 && cores < max_threads && std::find(candidates.begin(),candidates.end(),cores) == candidates.end())	{
+			candidates.push_back(cores);
+			std::sort(candidates.begin(),candidates.end());
+		}
+	}
+	candidates.push_back(max_threads);
+	printf("[+] Autotune %s with %i runs of %i seconds\n",bench->name,(int)candidates.size(),AUTOTUNE_SECONDS);
+	for(size_t j = 0; j < candidates.size(); j++)	{
+		if(!bench_measure(bench,program,candidates[j],AUTOTUNE_SECONDS,thread_rate))	{
+			printf("[W] The run of %s with %i threads failed\n",bench->name,candidates[j]);
+			continue;
+		}
+		rate = 0;
+		for(i = 0; i < candidates[j]; i++)	{
+			rate += thread_rate[i];
+		}
+		unit = bench_scale(rate,&prefix);
+		printf("[+] Autotune %i thread%s: %.3f %s\n",candidates[j],(candidates[j] > 1) ? "s" : "",rate / unit,str_limits_prefixs[prefix]);
+		fflush(stdout);
+		if(rate > *best_rate * (100 + AUTOTUNE_TIE) / 100)	{
+			*best_rate = rate;
+			best = candidates[j];
+		}
+	}
+	return best;
+}
+
+/* Square root of the bsgs N of -n, 0 if it is not valid */
+uint64_t autotune_sqrt_n()	{
+	Int N;
+	if(!FLAG_N)	{
+		N.SetInt64((uint64_t)0x100000000000);
+	}
+	else if(str_N[0] == '0' && str_N[1] == 'x')	{
+		N.SetBase16((char*)(str_N+2));
+	}
+	else	{
+		N.SetBase10(str_N);
+	}
+	return (uint64_t)llround(sqrt(metrics_double(&N)));
+}
+
+/*
+	Plan of the -k of bsgs, the biggest one that fits in AUTOTUNE_MEMORY percent
+	of the available memory with its prefilter, sized for bsgs_m of that -k.
+	With the -k of the user only the plan is shown
+*/
+void autotune_kfactor(struct autotune_host *host,struct autotune_profile *profile)	{
+	struct autotune_bsgs plan;
+	uint64_t budget = host->memory / 100 * AUTOTUNE_MEMORY;
+	uint64_t sqrt_n = autotune_sqrt_n();
+	uint64_t cache = autotune_cache(host);
+	size_t entry = FLAGDISKTABLE ? 0 : sizeof(struct bsgs_xvalue);
+	int fit,k = profile->k;
+	if(sqrt_n == 0)	{
+		return;
+	}
+	fit = autotune_bsgs_fit(sqrt_n,entry,PREFILTER_MB,cache,budget,BSGS_XINDEX_MAX,AUTOTUNE_MAX_K);
+	if(FLAGKFACTOR)	{
+		k = KFACTOR;
+	}
+	else if(k > fit)	{
+		if(fit == 0)	{
+			printf("[W] Not even -k 1 fits in %.2f MB of memory\n",(double)budget/1048576);
+			fit = 1;
+		}
+		k = fit;
+	}
+	autotune_bsgs_plan(sqrt_n,k,entry,PREFILTER_MB,cache,&plan);
+	printf("[+] Autotune bsgs -k %i: bloom %" PRIu64 " elements %.2f MB, bloom2 %" PRIu64 " elements %.2f MB, bloom3 %" PRIu64 " elements %.2f MB, bP table %.2f MB, prefilter %.2f MB\n",k,plan.m,(double)plan.bloom[0]/1048576,plan.m2,(double)plan.bloom[1]/1048576,plan.m3,(double)plan.bloom[2]/1048576,(double)plan.table/1048576,(double)plan.prefilter/1048576);
+	printf("[+] Autotune bsgs memory %.2f MB of %.2f MB, the biggest -k that fits is %i\n",(double)plan.total/1048576,(double)budget/1048576,fit);
+	if(plan.total > budget)	{
+		printf("[W] The bsgs filters and table of -k %i don't fit in %i%% of the available memory\n",k,AUTOTUNE_MEMORY);
+	}
+	profile->k = k;
+	profile->prefilter = (int)(plan.prefilter / 1048576);	/* 0 if bsgs_m is too big for the prefilter */
+}
+
+/*
+	Tune the threads, the -k of bsgs and the prefilter, or load them from
+	--autotune-file, the values of the command line are kept
+*/
+void autotune(const char *program)	{
+	struct autotune_host host;
+	struct autotune_profile profile;
+	char hostname[256];
+	bool loaded = false;
+	if(autotune_probe(&host) != 0)	{
+		printf("[W] Can't read the available memory\n");
+	}
+	autotune_hostname(hostname,256);
+	printf("[+] Autotune %s: %i CPUs, %.2f MB available, page %" PRIu64 " bytes, huge page %" PRIu64 " kB, L2 %" PRIu64 " kB, L3 %" PRIu64 " kB\n",hostname,host.cpus,(double)host.memory/1048576,host.page,host.huge_page/1024,host.l2/1024,host.l3/1024);
+	if(!FLAGAUTOTUNE && autotune_load(str_autotunefile,hostname,autotune_mode(),&profile) == 0)	{
+		printf("[+] Autotune profile of %s %s from %s\n",hostname,autotune_mode(),str_autotunefile);
+		loaded = true;
+	}
+	else	{
+		profile.threads = FLAGTHREADS ? NTHREADS : autotune_threads(program,&host,&profile.rate);
+		if(FLAGTHREADS)	{
+			profile.rate = 0;
+		}
+		/* The number of elements isn't known yet, only the cache limits it */
+		profile.prefilter = autotune_prefilter(UINT64_MAX,autotune_cache(&host));
+		profile.k = AUTOTUNE_MAX_K;
+	}
+	if(FLAGMODE == MODE_BSGS)	{
+		/* A saved -k is checked again with the memory available now, the prefilter is sized for it */
+		autotune_kfactor(&host,&profile);
+	}
+	else	{
+		profile.k = 1;
+	}
+	if(!loaded && str_autotunefile != NULL)	{
+		if(autotune_save(str_autotunefile,hostname,autotune_mode(),&profile) == 0)	{
+			printf("[+] Autotune profile saved in %s\n",str_autotunefile);
+		}
+		else	{
+			printf("[W] Can't save the autotune profile in %s\n",str_autotunefile);
+		}
+	}
+	if(!FLAGTHREADS)	{
+		NTHREADS = profile.threads;
+	}
+	if(FLAGMODE == MODE_BSGS && !FLAGKFACTOR)	{
+		KFACTOR = profile.k;
+	}
+	if(PREFILTER_MB < 0)	{
+		PREFILTER_AUTO_MB = profile.prefilter;
+	}
+	if(FLAGMODE == MODE_BSGS)	{
+		printf("[+] Autotune -t %i -k %i --prefilter %i\n",NTHREADS,KFACTOR,PREFILTER_MB > 0 ? PREFILTER_MB : PREFILTER_AUTO_MB);
+	}
+	else	{
+		printf("[+] Autotune -t %i --prefilter %i\n",NTHREADS,PREFILTER_MB > 0 ? PREFILTER_MB : PREFILTER_AUTO_MB);
+	}
+}
+
+/* Read size bytes of the bP Table file, the threads read at the same time so the offset is given in each read */
+static bool bsgs_disk_read(void *data,uint64_t size,uint64_t offset)	{
+#if defined(_WIN64) && !defined(__CYGWIN__)
+	OVERLAPPED overlapped;
+	DWORD readed;
+	memset(&overlapped,0,sizeof(OVERLAPPED));
+	overlapped.Offset = (DWORD)offset;
+	overlapped.OffsetHigh = (DWORD)(offset >> 32);
+	return ReadFile(bPtable_disk,data,(DWORD)size,&readed,&overlapped) && readed == size;
+#else
+	uint64_t done = 0;
+	ssize_t r;
+	while(done < size)	{
+		r = pread(bPtable_disk,(uint8_t*)data + done,size - done,offset + done);
+		if(r <= 0)	{
+			return false;
+		}
+		done += r;
+	}
+	return true;
+#endif
+}
+
+/*
+	Open the bP Table file for --disk-table, the whole file is read once to
+	check the checksum and take the first value of each block
+*/
+bool bsgs_disktable_open(const char *fileName)	{
+	uint8_t *buffer,checksum[32],checksum_file[32];
+	uint64_t blocks,bytes,offset,length,i;
+	CSHA256 sha;
+#if defined(_WIN64) && !defined(__CYGWIN__)
+	LARGE_INTEGER filesize;
+	bPtable_disk = CreateFileA(fileName,GENERIC_READ,FILE_SHARE_READ,NULL,OPEN_EXISTING,FILE_FLAG_RANDOM_ACCESS,NULL);
+	if(bPtable_disk == INVALID_HANDLE_VALUE)	{
+		return false;
+	}
+	GetFileSizeEx(bPtable_disk,&filesize);
+	bytes = filesize.QuadPart;
+#else
+	bPtable_disk = open(fileName,O_RDONLY);
+	if(bPtable_disk < 0)	{
+		return false;
+	}
+	bytes = lseek(bPtable_disk,0,SEEK_END);
+#endif
+	if(bytes != bsgs_m3 * sizeof(struct bsgs_xvalue) + 32)	{
+		fprintf(stderr,"[E] The file %s is not a bP Table of %" PRIu64 " elements\n",fileName,bsgs_m3);
+		exit(EXIT_FAILURE);
+	}
+	bytes -= 32;
+	blocks = (bsgs_m3 + BSGS_DISK_BLOCK - 1) / BSGS_DISK_BLOCK;
+	printf("[+] Reading bP Table blocks from file %s, %.2f MB on disk and %.2f MB in RAM\n",fileName,(double)bytes/1048576,(double)(blocks * BSGS_XVALUE_RAM)/1048576);
+	bPtable_fence = (uint8_t*) malloc(blocks * BSGS_XVALUE_RAM);
+	buffer = (uint8_t*) malloc(BSGS_DISK_BLOCK * sizeof(struct bsgs_xvalue) * 256);
+	checkpointer((void *)bPtable_fence,__FILE__,"malloc","bPtable_fence" ,__LINE__ -2 );
+	checkpointer((void *)buffer,__FILE__,"malloc","buffer" ,__LINE__ -2 );
+	/* Every read is 256 complete blocks, only the last one can be shorter */
+	for(offset = 0,i = 0; offset < bytes; offset += length)	{
+		length = (bytes - offset > BSGS_DISK_BLOCK * sizeof(struct bsgs_xvalue) * 256) ? BSGS_DISK_BLOCK * sizeof(struct bsgs_xvalue) * 256 : bytes - offset;
+		if(!bsgs_disk_read(buffer,length,offset))	{
+			fprintf(stderr,"[E] Error reading the file %s\n",fileName);
+			exit(EXIT_FAILURE);
+		}
+		if(FLAGSKIPCHECKSUM == 0)	{
+			sha.Write(buffer,length);
+		}
+		for(; i < blocks && i * BSGS_DISK_BLOCK * sizeof(struct bsgs_xvalue) < offset + length; i++)	{
+			memcpy(bPtable_fence + i * BSGS_XVALUE_RAM,buffer + (i * BSGS_DISK_BLOCK * sizeof(struct bsgs_xvalue) - offset),BSGS_XVALUE_RAM);
+		}
+	}
+	free(buffer);
+	if(FLAGSKIPCHECKSUM == 0)	{
+		sha.Finalize(checksum);
+		if(!bsgs_disk_read(checksum_file,32,bytes) || memcmp(checksum,checksum_file,32) != 0)	{
+			fprintf(stderr,"[E] Error checksum file mismatch! %s\n",fileName);
+			exit(EXIT_FAILURE);
+		}
+	}
+	bPtable_blocks = blocks;
+	return true;
+}
+
+/* Same of bsgs_searchbinary but only the pages of the file with the block that can have the value are read */
+int bsgs_searchdisk(char *data,uint64_t *r_value)	{
+	alignas(BSGS_DISK_PAGE) uint8_t window[2 * BSGS_DISK_PAGE];
+	uint64_t min,max,half,first,count,start,end,filesize;
+	/* Last block with its first value lower or equal than the value */
+	min = 0;
+	max = bPtable_blocks - 1;
+	while(min < max)	{
+		half = (min + max + 1) / 2;
+		if(memcmp(bPtable_fence + half * BSGS_XVALUE_RAM,data+16,BSGS_XVALUE_RAM) <= 0)	{
+			min = half;
+		}
+		else	{
+			max = half - 1;
+		}
+	}
+	first = min * BSGS_DISK_BLOCK;
+	count = (bsgs_m3 - first > BSGS_DISK_BLOCK) ? BSGS_DISK_BLOCK : bsgs_m3 - first;
+	/* The block is smaller than a page so the window is one or two pages, the last one ends with the file */
+	filesize = bsgs_m3 * sizeof(struct bsgs_xvalue) + 32;
+	start = (first * sizeof(struct bsgs_xvalue)) & ~((uint64_t)BSGS_DISK_PAGE - 1);
+	end = ((first + count) * sizeof(struct bsgs_xvalue) + BSGS_DISK_PAGE - 1) & ~((uint64_t)BSGS_DISK_PAGE - 1);
+	if(end > filesize)	{
+		end = filesize;
+	}
+	if(!bsgs_disk_read(window,end - start,start))	{
+		fprintf(stderr,"[E] Error reading the bP Table from the disk\n");
+		exit(EXIT_FAILURE);
+	}
+	return bsgs_searchbinary((struct bsgs_xvalue*)(window + (first * sizeof(struct bsgs_xvalue) - start)),data,count,r_value);
+}
+
+/*
+	Sum of the counters of all threads, the bloom stage includes the binary
+	search and the second and third bloom filters of bsgs, so the search is
+	subtracted from it
+*/
+void profile_print()	{
+	const char *names[PROFILE_STAGES] = {"inversion","points","hash","bloom","search"};
+	uint64_t cycles[PROFILE_STAGES],hits[METRICS_HITS],total = 0;
+	int i,j;
+	memset(cycles,0,sizeof(cycles));
+	memset(hits,0,sizeof(hits));
+	for(i = 0; i < NTHREADS; i++)	{
+		for(j = 0; j < PROFILE_STAGES; j++)	{
+			cycles[j] += workers[i].profile.cycles[j].load(std::memory_order_relaxed);
+		}
+		for(j = 0; j < METRICS_HITS; j++)	{
+			hits[j] += workers[i].stats.hits[j].load(std::memory_order_relaxed);
+		}
+	}
+	if(cycles[PROFILE_BLOOM] >= cycles[PROFILE_SEARCH])	{
+		cycles[PROFILE_BLOOM] -= cycles[PROFILE_SEARCH];
+	}
+	for(j = 0; j < PROFILE_STAGES; j++)	{
+		total += cycles[j];
+	}
+	if(total == 0)	{
+		return;
+	}
+	printf("[P] Cycles:");
+	for(j = 0; j < PROFILE_STAGES; j++)	{
+		printf(" %s %.1f%%",names[j],(double)cycles[j] * 100.0 / (double)total);
+	}
+	printf(" (%.3g cycles)\n",(double)total);
+	printf("[P] Hits: bloom %" PRIu64 ", bloom2 %" PRIu64 ", bloom3 %" PRIu64 ", table %" PRIu64 ", keys %" PRIu64 "\n",hits[METRICS_HIT_BLOOM],hits[METRICS_HIT_BLOOM2],hits[METRICS_HIT_BLOOM3],hits[METRICS_HIT_TABLE],hits[METRICS_HIT_KEY]);
+}
+
+/*
+	Snapshot of the counters of the threads, the workers are never locked, the
+	rate of each thread is the one of the last second
+*/
+void stats_collect(struct metrics_snapshot *snapshot,uint64_t second,Int *total)	{
+	Int step_keys;
+	char *str_total;
+	double keys_step;
+	uint64_t current,total_steps = 0;
+	int i,j;
+	get_step_keys(&step_keys);
+	keys_step = metrics_double(&step_keys);
+	memset(snapshot->hits,0,sizeof(snapshot->hits));
+	for(i = 0; i < NTHREADS; i++)	{
+		current = workers[i].stats.steps.load(std::memory_order_relaxed);
+		snapshot->thread_rate[i] = (double)(current - stats_previous[i]) * keys_step;
+		stats_previous[i] = current;
+		total_steps += current;
+		for(j = 0; j < METRICS_HITS; j++)	{
+			snapshot->hits[j] += workers[i].stats.hits[j].load(std::memory_order_relaxed);
+		}
+	}
+	total->Set(&step_keys);
+	total->Mult(total_steps);
+	str_total = total->GetBase10();
+	snprintf(snapshot->keys,sizeof(snapshot->keys),"%s",str_total);
+	free(str_total);
+	snapshot->seconds = second;
+	snapshot->rate = metrics_double(total) / (double)second;
+	snapshot->progress = -1;
+	if(stats_range > 0)	{
+		/* Each step is BSGS_N keys of the range */
+		snapshot->progress = (double)total_steps * metrics_double(&BSGS_N) / stats_range;
+		if(snapshot->progress > 1)	{
+			snapshot->progress = 1;
+		}
+	}
+	snapshot->memory = metrics_memory();
+}
+
+void stats_print(struct metrics_snapshot *snapshot)	{
+	double unit = 1000000;
+	int i = 0;
+	const char *begin = FLAGMATRIX ? "" : "\r";
+	const char *end = FLAGMATRIX ? "\n" : "\r";
+	if(snapshot->rate < unit)	{
+		printf("%s[+] Total %s keys in %" PRIu64 " seconds: %.0f keys/s%s",begin,snapshot->keys,snapshot->seconds,floor(snapshot->rate),end);
+	}
+	else	{
+		while(i < 6 && snapshot->rate >= unit * 1000)	{
+			unit *= 1000;
+			i++;
+		}
+		printf("%s[+] Total %s keys in %" PRIu64 " seconds: ~%.0f %s (%.0f keys/s)%s",begin,snapshot->keys,snapshot->seconds,floor(snapshot->rate / unit),str_limits_prefixs[i],floor(snapshot->rate),end);
+	}
+}
+
+/* Base key of the most advanced thread, the workers only store it in their stats */
+void stats_printbase()	{
+	Int base,max;
+	char *hextemp;
+	max.SetInt32(0);
+	for(int i = 0; i < NTHREADS; i++)	{
+		metrics_getbase(&workers[i].stats,&base);
+		if(base.IsGreater(&max))	{
+			max.Set(&base);
+		}
+	}
+	if(!max.IsZero())	{
+		hextemp = max.GetBase16();
+		printf("\r[+] Base key: 0x%s     \r",hextemp);
+		fflush(stdout);
+		free(hextemp);
+	}
+}
+
+/*
+	Called by each thread for its own context, group is the size of the batch
+	inversion, points the size of the buffer of points and queue the size of
+	the queue of candidates, 0 if it doesn't use them
+*/
+void worker_alloc(struct worker_context *ctx,int group,int points,int queue)	{
+	ctx->grp = new IntGroup(group);
+	ctx->dx = new Int[group];
+	ctx->grp->Set(ctx->dx);
+	ctx->pts = (points > 0) ? new Point[points] : NULL;
+	ctx->queue = (queue > 0) ? new uint32_t[queue] : NULL;
+	if(queue > 0)	{
+		/* Only bsgs has the queue of candidates for its second and third check */
+		ctx->grp2 = new IntGroup(BSGS_BATCH*32);
+		ctx->dx2 = new Int[BSGS_BATCH*32];
+		ctx->grp2->Set(ctx->dx2);
+		ctx->x2 = new Int[BSGS_BATCH*32];
+		ctx->equal2 = new bool[BSGS_BATCH*32];
+		ctx->grp3 = new IntGroup(32);
+		ctx->dx3 = new Int[32];
+		ctx->grp3->Set(ctx->dx3);
+	}
+}
+
+/*
+	Buffers of the x and y of the batch, aligned to the cache line, y is
+	only allocated if the thread uses it (uncompressed, eth, --exact-range)
+*/
+void worker_alloc_xy(struct worker_context *ctx,int points,bool with_y)	{
+	size_t bytes = sizeof(Int) * points;
+	Int **buffers[2] = {&ctx->x,&ctx->y};
+	ctx->y = NULL;
+	for(int i = 0; i < (with_y ? 2 : 1); i++)	{
+#if defined(_WIN64) && !defined(__CYGWIN__)
+		*buffers[i] = (Int*) _aligned_malloc(bytes,METRICS_CACHE_LINE);
+		if(*buffers[i] == NULL)	{
+#else
+		if(posix_memalign((void**)buffers[i],METRICS_CACHE_LINE,bytes) != 0)	{
+#endif
+			fprintf(stderr,"[E] error worker_alloc_xy\n");
+			exit(EXIT_FAILURE);
+		}
+		memset((void*)*buffers[i],0,bytes);
+	}
+}
+
+/*
+	CPU and tables of each thread, the copies of the tables of each node are
+	made by the main thread pinned in that node, so the pages are in the node
+*/
+void worker_place()	{
+	struct affinity_cpu *cpu;
+	struct node_tables *node;
+	std::vector<int> first;		/* First CPU of each node with threads, -1 without threads */
+	int j,nodes = 0;
+	tables.assign(1,{&Gn,&_2Gn,&GSn,&_2GSn,secp});
+	if(!affinity_cpus.empty())	{
+		first.assign(topology.nodes,-1);
+		for(j = 0; j < NTHREADS; j++)	{
+			cpu = affinity_find(&topology,affinity_cpus[j]);
+			if(first[cpu->node] < 0)	{
+				first[cpu->node] = cpu->cpu;
+				nodes++;
+			}
+		}
+		if(nodes > 1)	{
+			tables.resize(topology.nodes);
+			for(j = 0; j < topology.nodes; j++)	{
+				if(first[j] < 0)	{
+					continue;
+				}
+				affinity_pin(first[j]);
+				node = &tables[j];
+				node->Gn = new std::vector<Point>(Gn);
+				node->_2Gn = new Point(_2Gn);
+				if(FLAGMODE == MODE_BSGS)	{	/* GSn is only made by bsgs */
+					node->GSn = new std::vector<Point>(GSn);
+					node->_2GSn = new Point(_2GSn);
+				}
+				node->secp = new Secp256K1(*secp);
+			}
+			affinity_unpin(&topology);
+			printf("[+] Tables copied to %i NUMA nodes\n",nodes);
+		}
+	}
+	for(j = 0; j < NTHREADS; j++)	{
+		workers[j].cpu = affinity_cpus.empty() ? -1 : affinity_cpus[j];
+		workers[j].tables = &tables[0];
+		if(tables.size() > 1)	{
+			workers[j].tables = &tables[affinity_find(&topology,affinity_cpus[j])->node];
+		}
+	}
+}
+
+/* Before any allocation of the thread, so its buffers are in its node */
+void worker_pin(struct worker_context *ctx)	{
+	if(ctx->cpu >= 0 && affinity_pin(ctx->cpu) != 0)	{
+		fprintf(stderr,"[W] Can't pin the thread to the CPU %i\n",ctx->cpu);
+	}
+}
@@ -0,0 +1,229 @@
+/*
+ * Stats of the keyhunt threads without locks
+ *
+ * Refer to metrics.h for documentation on the public interfaces.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#if defined(_WIN64) && !defined(__CYGWIN__)
+#include <windows.h>
+#else
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#endif
+
+#include "metrics.h"
+#if !defined(_WIN64) || defined(__CYGWIN__)
+#include "../cluster/cluster.h"
+#endif
+
+#define METRICS_TIMEOUT_SECONDS 2   // A client that doesn't send the request can't stop the endpoint
+#define METRICS_RETRY_SECONDS 1     // Wait of accept when there are no descriptors or memory
+
+static const char *metrics_hit_names[METRICS_HITS] = {"bloom", "bloom2", "bloom3", "table", "key"};
+
+#if !defined(_WIN64) || defined(__CYGWIN__)
+static pthread_mutex_t metrics_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct metrics_snapshot metrics_last;
+static int metrics_fd = -1;
+#endif
+
+void metrics_setbase(struct metrics_thread *thread, Int *base)
+{
+  uint64_t seq = thread->base_seq.load(std::memory_order_relaxed);
+  thread->base_seq.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  for (int i = 0; i < 4; i++) {
+    thread->base[i].store(base->bits64[i], std::memory_order_relaxed);
+  }
+  thread->base_seq.store(seq + 2, std::memory_order_release);
+}
+
+void metrics_getbase(struct metrics_thread *thread, Int *base)
+{
+  uint64_t seq;
+  base->SetInt32(0);
+  do {
+    seq = thread->base_seq.load(std::memory_order_acquire);
+    for (int i = 0; i < 4; i++) {
+      base->bits64[i] = thread->base[i].load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+  } while ((seq & 1) || seq != thread->base_seq.load(std::memory_order_relaxed));
+}
+
+double metrics_double(Int *value)
+{
+  double r = 0;
+  for (int i = NB64BLOCK - 1; i >= 0; i--) {
+    r = r * 18446744073709551616.0 + (double)value->bits64[i];
+  }
+  return r;
+}
+
+uint64_t metrics_memory()
+{
+#if defined(_WIN64) && !defined(__CYGWIN__)
+  return 0;
+#else
+  unsigned long long size, resident;
+  FILE *statm = fopen("/proc/self/statm", "r");
+  if (statm == NULL) {
+    return 0;
+  }
+  if (fscanf(statm, "%llu %llu", &size, &resident) != 2) {
+    resident = 0;
+  }
+  fclose(statm);
+  return (uint64_t)resident * sysconf(_SC_PAGESIZE);
+#endif
+}
+
+int metrics_prometheus(struct metrics_snapshot *s, char *buffer, int length)
+{
+  int n = 0, i;
+#define METRICS_PRINT(...) if (n < length) n += snprintf(buffer + n, length - n, __VA_ARGS__)
+  METRICS_PRINT("# TYPE keyhunt_uptime_seconds counter\nkeyhunt_uptime_seconds{mode=\"%s\"} %" PRIu64 "\n", s->mode, s->seconds);
+  METRICS_PRINT("# TYPE keyhunt_keys_total counter\nkeyhunt_keys_total{mode=\"%s\"} %s\n", s->mode, s->keys);
+  METRICS_PRINT("# TYPE keyhunt_keys_per_second gauge\nkeyhunt_keys_per_second{mode=\"%s\"} %.0f\n", s->mode, s->rate);
+  METRICS_PRINT("# TYPE keyhunt_thread_keys_per_second gauge\n");
+  for (i = 0; i < s->threads; i++) {
+    METRICS_PRINT("keyhunt_thread_keys_per_second{mode=\"%s\",thread=\"%i\"} %.0f\n", s->mode, i, s->thread_rate[i]);
+  }
+  if (s->progress >= 0) {
+    METRICS_PRINT("# TYPE keyhunt_range_progress gauge\nkeyhunt_range_progress{mode=\"%s\"} %.9f\n", s->mode, s->progress);
+  }
+  METRICS_PRINT("# TYPE keyhunt_hits_total counter\n");
+  for (i = 0; i < METRICS_HITS; i++) {
+    METRICS_PRINT("keyhunt_hits_total{mode=\"%s\",stage=\"%s\"} %" PRIu64 "\n", s->mode, metrics_hit_names[i], s->hits[i]);
+  }
+  if (s->hits[METRICS_HIT_BLOOM] > 0) {
+    METRICS_PRINT("# TYPE keyhunt_bloom_false_positive_ratio gauge\nkeyhunt_bloom_false_positive_ratio{mode=\"%s\"} %.6f\n", s->mode,
+                  1.0 - (double)s->hits[METRICS_HIT_TABLE] / (double)s->hits[METRICS_HIT_BLOOM]);
+  }
+  METRICS_PRINT("# TYPE keyhunt_memory_bytes gauge\nkeyhunt_memory_bytes %" PRIu64 "\n", s->memory);
+#undef METRICS_PRINT
+  return n < length ? n : length - 1;
+}
+
+void metrics_jsonline(struct metrics_snapshot *s, FILE *file)
+{
+  int i;
+  fprintf(file, "{\"seconds\":%" PRIu64 ",\"mode\":\"%s\",\"keys\":\"%s\",\"keys_per_second\":%.0f,\"threads\":[", s->seconds, s->mode, s->keys, s->rate);
+  for (i = 0; i < s->threads; i++) {
+    fprintf(file, "%s%.0f", i ? "," : "", s->thread_rate[i]);
+  }
+  fprintf(file, "]");
+  if (s->progress >= 0) {
+    fprintf(file, ",\"progress\":%.9f", s->progress);
+  }
+  for (i = 0; i < METRICS_HITS; i++) {
+    fprintf(file, ",\"hits_%s\":%" PRIu64, metrics_hit_names[i], s->hits[i]);
+  }
+  fprintf(file, ",\"memory\":%" PRIu64 "}\n", s->memory);
+  fflush(file);
+}
+
+#if defined(_WIN64) && !defined(__CYGWIN__)
+/* The endpoint uses the POSIX sockets of the cluster, there is no endpoint on Windows */
+void metrics_publish(struct metrics_snapshot *snapshot)
+{
+  (void)snapshot;
+}
+
+int metrics_server_start(const char *endpoint, int threads)
+{
+  (void)endpoint;
+  (void)threads;
+  fprintf(stderr, "[E] The metrics endpoint is not available on Windows\n");
+  return 1;
+}
+#else
+void metrics_publish(struct metrics_snapshot *snapshot)
+{
+  double *thread_rate;
+  if (metrics_fd < 0) {
+    return;   // There is no endpoint
+  }
+  pthread_mutex_lock(&metrics_mutex);
+  thread_rate = metrics_last.thread_rate;
+  metrics_last = *snapshot;
+  metrics_last.thread_rate = thread_rate;
+  memcpy(thread_rate, snapshot->thread_rate, snapshot->threads * sizeof(double));
+  pthread_mutex_unlock(&metrics_mutex);
+}
+
+static void *metrics_serve(void *vargp)
+{
+  char request[CLUSTER_LINE], header[256], *body;
+  struct timeval timeout = {METRICS_TIMEOUT_SECONDS, 0};
+  int fd, length, body_length;
+  (void)vargp;
+  length = 4096 + metrics_last.threads * 128;
+  body = (char *)malloc(length);
+  if (body == NULL) {
+    fprintf(stderr, "[E] Can't allocate the buffer of the metrics endpoint\n");
+    return NULL;
+  }
+  for (;;) {
+    fd = accept(metrics_fd, NULL, NULL);
+    if (fd < 0) {
+      if (errno == EINTR || errno == ECONNABORTED) {
+        continue;
+      }
+      if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM) {
+        sleep(METRICS_RETRY_SECONDS);
+        continue;
+      }
+      fprintf(stderr, "[E] The metrics endpoint stopped: %s\n", strerror(errno));
+      break;
+    }
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    /* Only one read, any request gets the metrics */
+    if (recv(fd, request, sizeof(request), 0) > 0) {
+      pthread_mutex_lock(&metrics_mutex);
+      body_length = metrics_prometheus(&metrics_last, body, length);
+      pthread_mutex_unlock(&metrics_mutex);
+      snprintf(header, sizeof(header), "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: %i\r\nConnection: close\r\n\r\n", body_length);
+      if (send(fd, header, strlen(header), MSG_NOSIGNAL) > 0) {
+        send(fd, body, body_length, MSG_NOSIGNAL);
+      }
+    }
+    close(fd);
+  }
+  free(body);
+  return NULL;
+}
+
+int metrics_server_start(const char *endpoint, int threads)
+{
+  pthread_t tid;
+  memset(&metrics_last, 0, sizeof(metrics_last));
+  metrics_last.mode = "";
+  metrics_last.keys[0] = '0';
+  metrics_last.threads = threads;
+  metrics_last.progress = -1;
+  metrics_last.thread_rate = (double *)calloc(threads, sizeof(double));
+  if (metrics_last.thread_rate == NULL) {
+    return 1;
+  }
+  metrics_fd = cluster_listen(endpoint);
+  if (metrics_fd < 0) {
+    return 1;
+  }
+  if (pthread_create(&tid, NULL, metrics_serve, NULL) != 0) {
+    close(metrics_fd);
+    return 1;
+  }
+  pthread_detach(tid);
+  return 0;
+}
+#endif
@@ -0,0 +1,94 @@
+/*
+ * Stats of the keyhunt threads without locks
+ *
+ * Every thread has its own counters in a cache line aligned block, only that
+ * thread writes them (plain relaxed stores, no lock prefix) and the stats
+ * thread of main reads them once per second into a snapshot. The console
+ * line, the metrics endpoint and the JSON lines file are made from the last
+ * snapshot, so the workers never take a mutex or print for the stats.
+ *
+ * The endpoint is "host:port" or "unix:/path" like the cluster endpoints and
+ * answers any HTTP request with the Prometheus text format:
+ *
+ *     curl http://127.0.0.1:9100/metrics
+ *     curl --unix-socket /tmp/keyhunt.sock http://localhost/metrics
+ *
+ * The endpoint uses POSIX sockets, on Windows metrics_server_start always
+ * fails and the console line and the JSON lines file are the only output.
+ */
+
+#ifndef _METRICS_H
+#define _METRICS_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <atomic>
+
+#include "../secp256k1/Int.h"
+
+#define METRICS_CACHE_LINE 128    // Two lines, the adjacent line prefetcher fetch them in pairs
+
+#define METRICS_HIT_BLOOM 0       // Candidates of the first bloom filter
+#define METRICS_HIT_BLOOM2 1      // Candidates of the second bloom filter (bsgs)
+#define METRICS_HIT_BLOOM3 2      // Candidates of the third bloom filter (bsgs)
+#define METRICS_HIT_TABLE 3       // Candidates found in the table
+#define METRICS_HIT_KEY 4         // Private keys found
+#define METRICS_HITS 5
+
+struct alignas(METRICS_CACHE_LINE) metrics_thread
+{
+  std::atomic<uint64_t> steps;              // Each step is BSGS_N keys of the range
+  std::atomic<uint64_t> hits[METRICS_HITS];
+  std::atomic<uint64_t> base_seq;           // Odd while the base is written
+  std::atomic<uint64_t> base[4];            // First key of the current chunk
+};
+
+struct metrics_snapshot
+{
+  const char *mode;
+  uint64_t seconds;
+  int threads;
+  char keys[80];          // Total of keys in base 10, it doesn't fit in 64 bits with bsgs
+  double rate;            // keys/s since the start
+  double *thread_rate;    // keys/s of each thread in the last second
+  double progress;        // Fraction of the range, negative in the random modes
+  uint64_t hits[METRICS_HITS];
+  uint64_t memory;        // Resident memory in bytes
+};
+
+/* Only the owner thread writes its counters, so a load and a store are enough */
+static inline void metrics_add(std::atomic<uint64_t> *counter, uint64_t value)
+{
+  counter->store(counter->load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+/* Copy the base key of the thread, the reader retries if it was being written */
+void metrics_setbase(struct metrics_thread *thread, Int *base);
+void metrics_getbase(struct metrics_thread *thread, Int *base);
+
+/* Value of the Int as double, for the rates and the progress */
+double metrics_double(Int *value);
+
+/* Resident memory of the process in bytes, 0 if unknown */
+uint64_t metrics_memory();
+
+/** ***************************************************************************
+ * Listen in the endpoint and serve the last published snapshot from a
+ * detached thread.
+ *
+ * Return:
+ *     0 - on success
+ *     1 - can't listen in the endpoint, or Windows
+ */
+int metrics_server_start(const char *endpoint, int threads);
+
+/* Copy the snapshot for the endpoint */
+void metrics_publish(struct metrics_snapshot *snapshot);
+
+/* Write the snapshot in Prometheus text format, return the length */
+int metrics_prometheus(struct metrics_snapshot *snapshot, char *buffer, int length);
+
+/* Append the snapshot as one JSON line */
+void metrics_jsonline(struct metrics_snapshot *snapshot, FILE *file);
+
+#endif
@@ -0,0 +1,237 @@
+/*
+ * Writer of the keys found by the keyhunt threads
+ *
+ * Refer to results.h for documentation on the public interfaces.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "results.h"
+#include "../util.h"
+
+static void results_sleep(int ms)
+{
+#if defined(_WIN64) && !defined(__CYGWIN__)
+  Sleep(ms);
+#else
+  struct timespec wait = {ms / 1000, (ms % 1000) * 1000000L};
+  nanosleep(&wait, NULL);
+#endif
+}
+
+static void results_sync(FILE *file)
+{
+  if (file != NULL) {
+    syncfile(file);
+  }
+}
+
+static void results_close(struct results_writer *writer)
+{
+  for (int i = 0; i < RESULTS_FILES; i++) {
+    if (writer->files[i] != NULL) {
+      results_sync(writer->files[i]);
+      fclose(writer->files[i]);
+      writer->files[i] = NULL;
+    }
+  }
+  if (writer->json != NULL) {
+    results_sync(writer->json);
+    fclose(writer->json);
+    writer->json = NULL;
+  }
+}
+
+static void results_write(struct results_writer *writer, struct results_record *record)
+{
+  struct results_output output;
+  FILE *file;
+  output.file = RESULTS_KEYS;
+  output.text[0] = output.console[0] = output.json[0] = '\0';
+  writer->format(record, &output);
+  file = writer->files[output.file];
+  if (file == NULL && output.text[0] != '\0') {
+    file = writer->files[output.file] = fopen(writer->names[output.file], "a+");
+    if (file == NULL) {
+      fprintf(stderr, "[E] Can't open the file %s, the key is only in the output\n", writer->names[output.file]);
+    }
+  }
+  if (file != NULL) {
+    fputs(output.text, file);
+  }
+  if (writer->json != NULL && output.json[0] != '\0') {
+    fprintf(writer->json, "{%s}\n", output.json);
+  }
+  fputs(output.console, stdout);
+  writer->records++;
+}
+
+/* Write the records of all rings, return the number of records */
+static int results_drain(struct results_writer *writer)
+{
+  struct results_ring *ring;
+  uint32_t head, tail;
+  int count = 0;
+  for (int i = 0; i < writer->threads; i++) {
+    ring = &writer->rings[i];
+    tail = ring->tail.load(std::memory_order_relaxed);
+    head = ring->head.load(std::memory_order_acquire);
+    while (tail != head) {
+      results_write(writer, &ring->records[tail & (RESULTS_RING_SIZE - 1)]);
+      tail++;
+      count++;
+    }
+    ring->tail.store(tail, std::memory_order_release);
+  }
+  if (count > 0) {
+    for (int i = 0; i < RESULTS_FILES; i++) {
+      if (writer->files[i] != NULL) {
+        fflush(writer->files[i]);
+      }
+    }
+    if (writer->json != NULL) {
+      fflush(writer->json);
+    }
+    fflush(stdout);
+  }
+  return count;
+}
+
+#if defined(_WIN64) && !defined(__CYGWIN__)
+static DWORD WINAPI results_thread(LPVOID arg)
+#else
+static void *results_thread(void *arg)
+#endif
+{
+  struct results_writer *writer = (struct results_writer *)arg;
+  time_t last_sync = time(NULL), now;
+  bool pending = false;
+  while (!writer->stop.load(std::memory_order_acquire)) {
+    if (results_drain(writer) > 0) {
+      pending = true;
+    }
+    else {
+      results_sleep(RESULTS_WAIT_MS);
+    }
+    now = time(NULL);
+    if (pending && now - last_sync >= RESULTS_SYNC_SECONDS) {
+      for (int i = 0; i < RESULTS_FILES; i++) {
+        results_sync(writer->files[i]);
+      }
+      results_sync(writer->json);
+      last_sync = now;
+      pending = false;
+    }
+  }
+#if defined(_WIN64) && !defined(__CYGWIN__)
+  return 0;
+#else
+  return NULL;
+#endif
+}
+
+int results_start(struct results_writer *writer, int threads, const char *keys, const char *vanity,
+                  const char *json, results_format format)
+{
+  memset((void *)writer, 0, sizeof(struct results_writer));
+  writer->rings = new struct results_ring[threads]();
+  writer->threads = threads;
+  writer->names[RESULTS_KEYS] = keys;
+  writer->names[RESULTS_VANITYKEYS] = vanity;
+  writer->json_name = json;
+  writer->format = format;
+#if defined(_WIN64) && !defined(__CYGWIN__)
+  writer->late = CreateMutex(NULL, FALSE, NULL);
+#else
+  pthread_mutex_init(&writer->late, NULL);
+#endif
+  if (json != NULL) {
+    writer->json = fopen(json, "a");
+    if (writer->json == NULL) {
+      return 1;
+    }
+  }
+#if defined(_WIN64) && !defined(__CYGWIN__)
+  writer->tid = CreateThread(NULL, 0, results_thread, writer, 0, NULL);
+  if (writer->tid == NULL) {
+    return 1;
+  }
+#else
+  if (pthread_create(&writer->tid, NULL, results_thread, writer) != 0) {
+    return 1;
+  }
+#endif
+  return 0;
+}
+
+/* Write the records left in the rings after the writer is done, the files are closed again */
+static void results_late(struct results_writer *writer)
+{
+  while (!writer->done.load(std::memory_order_acquire)) {
+    results_sleep(RESULTS_WAIT_MS);
+  }
+#if defined(_WIN64) && !defined(__CYGWIN__)
+  WaitForSingleObject(writer->late, INFINITE);
+#else
+  pthread_mutex_lock(&writer->late);
+#endif
+  if (writer->json_name != NULL && writer->json == NULL) {
+    writer->json = fopen(writer->json_name, "a");
+  }
+  results_drain(writer);
+  results_close(writer);
+#if defined(_WIN64) && !defined(__CYGWIN__)
+  ReleaseMutex(writer->late);
+#else
+  pthread_mutex_unlock(&writer->late);
+#endif
+}
+
+void results_push(struct results_writer *writer, struct results_ring *ring, struct results_record *record)
+{
+  uint32_t head = ring->head.load(std::memory_order_relaxed);
+  /* Only if the writer is behind by the whole ring, the key is never dropped */
+  while (head - ring->tail.load(std::memory_order_acquire) >= RESULTS_RING_SIZE) {
+    if (writer->stop.load(std::memory_order_acquire)) {
+      results_late(writer);
+    }
+    else {
+      results_sleep(1);
+    }
+  }
+  ring->records[head & (RESULTS_RING_SIZE - 1)] = *record;
+  ring->head.store(head + 1, std::memory_order_release);
+  if (writer->stop.load(std::memory_order_acquire)) {
+    /* The last drain of results_stop can be before this record */
+    results_late(writer);
+  }
+}
+
+void results_stop(struct results_writer *writer, const char *line)
+{
+  if (writer->rings == NULL) {
+    return;
+  }
+  if (writer->stop.exchange(1)) {
+    while (!writer->done.load(std::memory_order_acquire)) {
+      results_sleep(RESULTS_WAIT_MS);
+    }
+    return;
+  }
+#if defined(_WIN64) && !defined(__CYGWIN__)
+  WaitForSingleObject(writer->tid, INFINITE);
+  CloseHandle(writer->tid);
+#else
+  pthread_join(writer->tid, NULL);
+#endif
+  results_drain(writer);
+  if (line != NULL) {
+    fputs(line, stdout);
+    fflush(stdout);
+  }
+  results_close(writer);
+  writer->done.store(1, std::memory_order_release);
+}
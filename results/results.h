@@ -0,0 +1,116 @@
+/*
+ * Writer of the keys found by the keyhunt threads
+ *
+ * Each search thread has its own ring of records (one producer, the thread,
+ * and one consumer, the writer thread), so a hit is only a copy of the key
+ * and two stores, the thread never takes the write_keys mutex, opens a file
+ * or makes the public key and the address of the hit.
+ *
+ * The writer thread takes the records of all rings, makes the text with the
+ * format function of keyhunt, and writes it to the files that it keeps open,
+ * with fflush after each batch and fsync every RESULTS_SYNC_SECONDS. The
+ * records pushed after results_stop are written by the thread that pushes
+ * them once the writer is done. With a JSON file each record is also one
+ * line like:
+ *
+ *     {"kind":"address","key":"1d38a","pubkey":"02...","address":"1...","rmd160":"..."}
+ */
+
+#ifndef _RESULTS_H
+#define _RESULTS_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <atomic>
+#if defined(_WIN64) && !defined(__CYGWIN__)
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#define RESULTS_RING_SIZE 1024      // Records of each ring, a power of two
+#define RESULTS_SYNC_SECONDS 1
+#define RESULTS_WAIT_MS 10          // Sleep of the writer when all rings are empty
+
+#define RESULTS_ADDRESS 0           // writekey
+#define RESULTS_ETH 1               // writekeyeth
+#define RESULTS_VANITY 2            // writevanitykey
+#define RESULTS_BSGS 3              // Key of a bsgs target
+
+#define RESULTS_KEYS 0              // Files of the records
+#define RESULTS_VANITYKEYS 1
+#define RESULTS_FILES 2
+
+#define RESULTS_TEXT 1024
+
+struct results_record
+{
+  uint64_t key[4];
+  uint32_t target;        // Index of the bsgs target
+  uint8_t kind;
+  uint8_t compressed;
+};
+
+struct alignas(128) results_ring
+{
+  std::atomic<uint32_t> head;               // Written by the search thread
+  alignas(128) std::atomic<uint32_t> tail;  // Written by the writer thread
+  struct results_record records[RESULTS_RING_SIZE];
+};
+
+/* Text of a record made by the format function */
+struct results_output
+{
+  int file;                     // RESULTS_KEYS or RESULTS_VANITYKEYS
+  char text[RESULTS_TEXT];      // Lines for the file
+  char console[RESULTS_TEXT];   // Lines for stdout
+  char json[RESULTS_TEXT];      // Fields of the JSON line without the braces
+};
+
+typedef void (*results_format)(struct results_record *record, struct results_output *output);
+
+struct results_writer
+{
+  struct results_ring *rings;
+  int threads;
+  const char *names[RESULTS_FILES];
+  FILE *files[RESULTS_FILES];   // Opened with the first record of each one
+  const char *json_name;
+  FILE *json;
+  results_format format;
+  std::atomic<int> stop;
+  std::atomic<int> done;        // The files are closed
+#if defined(_WIN64) && !defined(__CYGWIN__)
+  HANDLE late;                  // Records pushed after the stop
+  HANDLE tid;
+#else
+  pthread_mutex_t late;         // Records pushed after the stop
+  pthread_t tid;
+#endif
+  uint64_t records;             // Records written
+};
+
+/** ***************************************************************************
+ * Make one ring for each thread and start the writer thread.
+ *
+ * Return:
+ *     0 - on success
+ *     1 - can't open the JSON file or start the thread
+ */
+int results_start(struct results_writer *writer, int threads, const char *keys, const char *vanity,
+                  const char *json, results_format format);
+
+/*
+ * Copy the record to the ring of the thread, wait while the ring is full.
+ * After results_stop the record is written here
+ */
+void results_push(struct results_writer *writer, struct results_ring *ring, struct results_record *record);
+
+/*
+ * End the writer thread, write all the pending records and then 'line' (if
+ * it is not NULL) to stdout, sync and close the files. Other callers wait
+ * until it is done
+ */
+void results_stop(struct results_writer *writer, const char *line);
+
+#endif
@@ -22,6 +22,7 @@
 #include "../util.h"
 #include "../hash/sha256.h"
 #include "../hash/ripemd160.h"
+#include "../hash/hash160.h"
 
 Secp256K1::Secp256K1() {
 }
@@ -615,7 +616,7 @@ void Secp256K1::GetHash160(int type,bool compressed,
       KEYBUFFUNCOMP(b2, k2);
       KEYBUFFUNCOMP(b3, k3);
 
-      sha256sse_2B(b0, b1, b2, b3, sh0, sh1, sh2, sh3);
+      sha256_2B(b0, b1, b2, b3, sh0, sh1, sh2, sh3);
       ripemd160sse_32(sh0, sh1, sh2, sh3, h0, h1, h2, h3);
 
     } else {
@@ -630,7 +631,7 @@ void Secp256K1::GetHash160(int type,bool compressed,
       KEYBUFFCOMP(b2, k2);
       KEYBUFFCOMP(b3, k3);
 
-      sha256sse_1B(b0, b1, b2, b3, sh0, sh1, sh2, sh3);
+      sha256_1B(b0, b1, b2, b3, sh0, sh1, sh2, sh3);
       ripemd160sse_32(sh0, sh1, sh2, sh3, h0, h1, h2, h3);
 
     }
@@ -659,7 +660,7 @@ void Secp256K1::GetHash160(int type,bool compressed,
     KEYBUFFSCRIPT(b2, kh2);
     KEYBUFFSCRIPT(b3, kh3);
 
-    sha256sse_1B(b0, b1, b2, b3, sh0, sh1, sh2, sh3);
+    sha256_1B(b0, b1, b2, b3, sh0, sh1, sh2, sh3);
     ripemd160sse_32(sh0, sh1, sh2, sh3, h0, h1, h2, h3);
 
   }
@@ -670,6 +671,61 @@ void Secp256K1::GetHash160(int type,bool compressed,
 
 
 
+void Secp256K1::GetHash160(int type,bool compressed,
+  Point &k0,Point &k1,Point &k2,Point &k3,
+  Point &k4,Point &k5,Point &k6,Point &k7,
+  uint8_t *h0,uint8_t *h1,uint8_t *h2,uint8_t *h3,
+  uint8_t *h4,uint8_t *h5,uint8_t *h6,uint8_t *h7) {
+
+#ifdef WIN64
+  __declspec(align(32)) unsigned char sh[8][64];
+#else
+  unsigned char sh[8][64] __attribute__((aligned(32)));
+#endif
+
+  if (type == P2SH) {
+    GetHash160(type,compressed,k0,k1,k2,k3,h0,h1,h2,h3);
+    GetHash160(type,compressed,k4,k5,k6,k7,h4,h5,h6,h7);
+    return;
+  }
+
+  if (!compressed) {
+
+    uint32_t b[8][32];
+
+    KEYBUFFUNCOMP(b[0], k0);
+    KEYBUFFUNCOMP(b[1], k1);
+    KEYBUFFUNCOMP(b[2], k2);
+    KEYBUFFUNCOMP(b[3], k3);
+    KEYBUFFUNCOMP(b[4], k4);
+    KEYBUFFUNCOMP(b[5], k5);
+    KEYBUFFUNCOMP(b[6], k6);
+    KEYBUFFUNCOMP(b[7], k7);
+
+    sha256_8_2B(b[0], b[1], b[2], b[3], b[4], b[5], b[6], b[7], sh[0], sh[1], sh[2], sh[3], sh[4], sh[5], sh[6], sh[7]);
+    ripemd160_8_32(sh[0], sh[1], sh[2], sh[3], sh[4], sh[5], sh[6], sh[7], h0, h1, h2, h3, h4, h5, h6, h7);
+
+  } else {
+
+    uint64_t *x[8] = { k0.x.bits64, k1.x.bits64, k2.x.bits64, k3.x.bits64, k4.x.bits64, k5.x.bits64, k6.x.bits64, k7.x.bits64 };
+    uint8_t *h[8] = { h0, h1, h2, h3, h4, h5, h6, h7 };
+    uint8_t prefix[8];
+
+    prefix[0] = k0.y.IsEven() ? 0x2 : 0x3;
+    prefix[1] = k1.y.IsEven() ? 0x2 : 0x3;
+    prefix[2] = k2.y.IsEven() ? 0x2 : 0x3;
+    prefix[3] = k3.y.IsEven() ? 0x2 : 0x3;
+    prefix[4] = k4.y.IsEven() ? 0x2 : 0x3;
+    prefix[5] = k5.y.IsEven() ? 0x2 : 0x3;
+    prefix[6] = k6.y.IsEven() ? 0x2 : 0x3;
+    prefix[7] = k7.y.IsEven() ? 0x2 : 0x3;
+    hash160_8_33(x, prefix, h);
+
+  }
+
+}
+
+
 void Secp256K1::GetHash160(int type, bool compressed, Point &pubKey, unsigned char *hash) {
 
   unsigned char shapk[64];
@@ -773,7 +829,7 @@ void Secp256K1::GetHash160_fromX(int type,unsigned char prefix,
       KEYBUFFPREFIX(b2, k2, prefix);
       KEYBUFFPREFIX(b3, k3, prefix);
 
-      sha256sse_1B(b0, b1, b2, b3, sh0, sh1, sh2, sh3);
+      sha256_1B(b0, b1, b2, b3, sh0, sh1, sh2, sh3);
       ripemd160sse_32(sh0, sh1, sh2, sh3, h0, h1, h2, h3);
   }
   break;
@@ -788,3 +844,21 @@ void Secp256K1::GetHash160_fromX(int type,unsigned char prefix,
   }
 }
 
+
+void Secp256K1::GetHash160_fromX(int type,
+  Int *k0,Int *k1,Int *k2,Int *k3,
+  uint8_t *h0,uint8_t *h1,uint8_t *h2,uint8_t *h3,
+  uint8_t *h4,uint8_t *h5,uint8_t *h6,uint8_t *h7) {
+
+  uint64_t *x[8] = { k0->bits64, k1->bits64, k2->bits64, k3->bits64, k0->bits64, k1->bits64, k2->bits64, k3->bits64 };
+  uint8_t *h[8] = { h0, h1, h2, h3, h4, h5, h6, h7 };
+  static const uint8_t prefix[8] = { 0x02, 0x02, 0x02, 0x02, 0x03, 0x03, 0x03, 0x03 };
+
+  if (type != P2PKH) {
+    GetHash160_fromX(type,0x02,k0,k1,k2,k3,h0,h1,h2,h3);
+    GetHash160_fromX(type,0x03,k0,k1,k2,k3,h4,h5,h6,h7);
+    return;
+  }
+  hash160_8_33(x, prefix, h);
+
+}
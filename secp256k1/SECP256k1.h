@@ -52,12 +52,25 @@ public:
     Point &k0, Point &k1, Point &k2, Point &k3,
     uint8_t *h0, uint8_t *h1, uint8_t *h2, uint8_t *h3);
 
+  // 8 keys with the 8 way hash functions
+  void GetHash160(int type,bool compressed,
+    Point &k0, Point &k1, Point &k2, Point &k3,
+    Point &k4, Point &k5, Point &k6, Point &k7,
+    uint8_t *h0, uint8_t *h1, uint8_t *h2, uint8_t *h3,
+    uint8_t *h4, uint8_t *h5, uint8_t *h6, uint8_t *h7);
+
   void GetHash160(int type,bool compressed, Point &pubKey, unsigned char *hash);
   
   void GetHash160_fromX(int type,unsigned char prefix,
   Int *k0,Int *k1,Int *k2,Int *k3,
   uint8_t *h0,uint8_t *h1,uint8_t *h2,uint8_t *h3);
 
+  // Both prefixes with the 8 way hash functions, 0x02 in h0..h3 and 0x03 in h4..h7
+  void GetHash160_fromX(int type,
+  Int *k0,Int *k1,Int *k2,Int *k3,
+  uint8_t *h0,uint8_t *h1,uint8_t *h2,uint8_t *h3,
+  uint8_t *h4,uint8_t *h5,uint8_t *h6,uint8_t *h7);
+
 
   Point Add(Point &p1, Point &p2);
   Point Add2(Point &p1, Point &p2);
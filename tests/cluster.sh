@@ -0,0 +1,61 @@
+#!/bin/sh
+# Two workers and the coordinator over a Unix socket in the range of the
+# puzzle 24, the lease size isn't a multiple of the -n value of the workers
+# so the last chunk of each lease is moved back to end with it.
+#
+#     make && make coordinator && sh tests/cluster.sh
+
+KEYHUNT=${KEYHUNT:-./keyhunt}
+COORDINATOR=${COORDINATOR:-./coordinator}
+TARGETS=$(pwd)/tests/1to32.txt
+KEY=dc2a04
+DIR=$(mktemp -d)
+SOCKET=unix:$DIR/coordinator.sock
+
+cp "$KEYHUNT" "$COORDINATOR" "$DIR" || exit 1
+cd "$DIR" || exit 1
+./coordinator -b 24 -n 0x100000 -e "$SOCKET" -l 30 -s 0 > coordinator.log 2>&1 &
+COORDINATOR_PID=$!
+sleep 1
+./keyhunt -m address -f "$TARGETS" -l compress -t 2 -n 0x30000 -q -s 0 --worker "$SOCKET" > worker1.log 2>&1 &
+WORKER1_PID=$!
+./keyhunt -m address -f "$TARGETS" -l compress -t 2 -n 0x30000 -q -s 0 --worker "$SOCKET" > worker2.log 2>&1 &
+WORKER2_PID=$!
+
+# The coordinator ends when all the leases are done and the workers are disconnected
+for i in $(seq 1 120); do
+  kill -0 $COORDINATOR_PID 2> /dev/null || break
+  sleep 1
+done
+kill $COORDINATOR_PID $WORKER1_PID $WORKER2_PID 2> /dev/null
+
+STATUS=0
+if ! grep -q "All the range was processed" coordinator.log; then
+  echo "[E] The coordinator didn't process all the range"
+  STATUS=1
+fi
+if [ "$(grep -c "completed by worker" coordinator.log)" -ne 8 ]; then
+  echo "[E] Expected 8 leases completed"
+  STATUS=1
+fi
+if [ "$(grep -c "to worker" coordinator.log)" -ne 8 ]; then
+  echo "[E] Some lease was given more than once"
+  STATUS=1
+fi
+if ! grep -qi "found the key 0*$KEY" coordinator.log; then
+  echo "[E] The key $KEY wasn't reported to the coordinator"
+  STATUS=1
+fi
+for log in coordinator.log worker1.log worker2.log; do
+  if grep -q "^\[E\]" $log; then
+    echo "[E] Errors in $log"
+    STATUS=1
+  fi
+done
+if [ $STATUS -ne 0 ]; then
+  tail -n 20 coordinator.log worker1.log worker2.log
+else
+  echo "[+] Cluster test passed"
+  rm -rf "$DIR"
+fi
+exit $STATUS
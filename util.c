@@ -1,6 +1,12 @@
 #include <cstring>
 #include <cstdio>
 #include <cstdlib>
+#if defined(_WIN64) && !defined(__CYGWIN__)
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 #include "util.h"
 
@@ -176,3 +182,37 @@ int isValidHex(char *data)	{
 	}
 	return valid;
 }
+
+int syncfile(FILE *fd)	{
+	if(fflush(fd) != 0)	{
+		return 1;
+	}
+#if defined(_WIN64) && !defined(__CYGWIN__)
+	return _commit(_fileno(fd)) != 0;
+#else
+	return fsync(fileno(fd)) != 0;
+#endif
+}
+
+int syncdir(const char *filename)	{
+#if defined(_WIN64) && !defined(__CYGWIN__)
+	return 0;	/* The directories can't be opened to sync them */
+#else
+	char dir[1024];
+	const char *slash = strrchr(filename,'/');
+	int fd,r;
+	if(slash == NULL)	{
+		snprintf(dir,sizeof(dir),".");
+	}
+	else	{
+		snprintf(dir,sizeof(dir),"%.*s",(int)(slash - filename + 1),filename);
+	}
+	fd = open(dir,O_RDONLY);
+	if(fd < 0)	{
+		return 1;
+	}
+	r = fsync(fd);
+	close(fd);
+	return r != 0;
+#endif
+}
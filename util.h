@@ -1,6 +1,8 @@
 #ifndef CUSTOMUTILH
 #define CUSTOMUTILH
 
+#include <stdio.h>
+
 typedef struct str_list	{
 	int n;
 	char **data;
@@ -30,4 +32,12 @@ int isValidHex(char *data);
 void freetokenizer(Tokenizer *t);
 void stringtokenizer(char *data,Tokenizer *t);
 
+/*
+	Before the rename of a temporary file: syncfile writes the data of the
+	file to the disk and syncdir the directory of the file, so the rename is
+	never seen before the data after a crash. Both return 0 on success
+*/
+int syncfile(FILE *fd);
+int syncdir(const char *filename);
+
 #endif // CUSTOMUTILH